@@ -37,6 +37,7 @@ inline constexpr arch::scalar_register<uint32_t> PCI_DEVICE_FEATURE_SELECT(0);
 inline constexpr arch::scalar_register<uint32_t> PCI_DEVICE_FEATURE_WINDOW(4);
 inline constexpr arch::scalar_register<uint32_t> PCI_DRIVER_FEATURE_SELECT(8);
 inline constexpr arch::scalar_register<uint32_t> PCI_DRIVER_FEATURE_WINDOW(12);
+inline constexpr arch::scalar_register<uint16_t> PCI_NUM_QUEUES(18);
 inline constexpr arch::scalar_register<uint8_t> PCI_DEVICE_STATUS(20);
 inline constexpr arch::scalar_register<uint16_t> PCI_QUEUE_SELECT(22);
 inline constexpr arch::scalar_register<uint16_t> PCI_QUEUE_SIZE(24);
@@ -68,10 +69,18 @@ enum {
 	DEVICE_NEEDS_RESET = 64
 };
 
+// Device-independent feature bits.
+enum {
+	VIRTIO_RING_F_INDIRECT_DESC = 28,
+	VIRTIO_RING_F_EVENT_IDX = 29,
+	VIRTIO_F_VERSION_1 = 32
+};
+
 enum {
 	// Bits of the spec::Descriptor::flags field.
 	VIRTQ_DESC_F_NEXT = 1, // descriptor is part of a chain
 	VIRTQ_DESC_F_WRITE = 2, // buffer is written by device
+	VIRTQ_DESC_F_INDIRECT = 4, // buffer contains a table of descriptors
 
 	// Bits of the spec::UsedRing::flags field.
 	VIRTQ_USED_F_NO_NOTIFY = 1 // no need to notify the device
@@ -141,7 +150,8 @@ struct QueueInfo {
  * Usual initialization works as follows:
  * - Call discover() to obtain a transport.
  * - Negotiate features via Transport::checkDeviceFeature() / acknowledgeDriverFeature().
- * - Call Transport::finalizeFeatures().
+ * - Call Transport::finalizeFeatures(). This also negotiates the ring features
+ *   (VIRTIO_RING_F_EVENT_IDX and VIRTIO_RING_F_INDIRECT_DESC) that the Queue implements.
  * - Call Transport::claimQueues().
  * - Call Transport::setupQueue() for each virtq.
  * - Call Transport::runDevice().
@@ -183,7 +193,7 @@ struct DeviceSpace {
 		} else {
 			static_assert(sizeof(typename RT::rep_type) == 4,
 					"Unsupported size for DeviceSpace::load()");
-			auto v = _transport->loadConfig16(r.offset());
+			auto v = _transport->loadConfig32(r.offset());
 			return static_cast<typename RT::rep_type>(v);
 		}
 	}
@@ -218,6 +228,8 @@ inline constexpr DeviceToHostType deviceToHost;
 
 // Handle to a virtq descriptor.
 struct Handle {
+	friend struct IndirectChain;
+
 	Handle()
 	: _queue{nullptr}, _tableIndex{0} { }
 
@@ -278,6 +290,37 @@ private:
 	Handle _back;
 };
 
+// Helper class to build a chain inside an indirect descriptor table.
+// The whole chain occupies only a single descriptor of the virtq.
+// Requires Queue::supportsIndirect().
+struct IndirectChain {
+	IndirectChain(Handle handle);
+
+	IndirectChain(const IndirectChain &) = delete;
+
+	IndirectChain &operator= (const IndirectChain &) = delete;
+
+	Handle front() {
+		return _handle;
+	}
+
+	size_t size() {
+		return _size;
+	}
+
+	// Note the remarks on Handle::setupBuffer().
+	void append(HostToDeviceType, arch::dma_buffer_view view);
+	void append(DeviceToHostType, arch::dma_buffer_view view);
+
+private:
+	void _append(arch::dma_buffer_view view, uint16_t flags);
+
+	Handle _handle;
+	spec::Descriptor *_table;
+	uintptr_t _tablePhysical;
+	size_t _size = 0;
+};
+
 // Helper functions that obtain descriptor from a queue as needed.
 async::result<void> scatterGather(HostToDeviceType, Chain &chain, Queue *queue,
 		arch::dma_buffer_view view);
@@ -291,9 +334,14 @@ struct Request {
 // Represents a single virtq.
 struct Queue {
 	friend struct Handle;
+	friend struct IndirectChain;
+
+	// Number of descriptors in each indirect table (i.e., a page worth of descriptors).
+	static constexpr size_t maxIndirectDescriptors = 0x1000 / sizeof(spec::Descriptor);
 
 	Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *table,
-			spec::AvailableRing *available, spec::UsedRing *used);
+			spec::AvailableRing *available, spec::UsedRing *used,
+			bool event_index, bool indirect);
 protected:
 	~Queue() = default;
 
@@ -307,6 +355,11 @@ public:
 		return _queueSize;
 	}
 
+	// Returns true if descriptors can refer to an IndirectChain.
+	bool supportsIndirect() {
+		return _useIndirect;
+	}
+
 	// Allocates a single descriptor.
 	// The descriptor is automatically freed when the device returns it.
 	async::result<Handle> obtainDescriptor();
@@ -364,6 +417,20 @@ private:
 
 	// Keeps track of which entries in the used ring have already been processed.
 	uint16_t _progressHead;
+
+	// Set if VIRTIO_RING_F_EVENT_IDX was negotiated.
+	bool _useEventIndex;
+	// Index of the available ring at the time of the last notification.
+	uint16_t _notifiedHead;
+
+	// Set if VIRTIO_RING_F_INDIRECT_DESC was negotiated.
+	bool _useIndirect;
+	// Indirect tables are allocated on first use, one per descriptor of the virtq.
+	struct IndirectTable {
+		spec::Descriptor *table = nullptr;
+		uintptr_t physical = 0;
+	};
+	std::vector<IndirectTable> _indirectTables;
 };
 
 } // namespace virtio_core
@@ -1,5 +1,7 @@
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <unordered_map>
 #include <optional>
@@ -67,6 +69,29 @@ private:
 	size_t _size;
 };
 
+namespace {
+
+struct RingFeatures {
+	bool eventIndex = false;
+	bool indirect = false;
+};
+
+// Negotiates the device-independent ring features that Queue implements.
+RingFeatures negotiateRingFeatures(Transport *transport) {
+	RingFeatures features;
+	if(transport->checkDeviceFeature(VIRTIO_RING_F_EVENT_IDX)) {
+		transport->acknowledgeDriverFeature(VIRTIO_RING_F_EVENT_IDX);
+		features.eventIndex = true;
+	}
+	if(transport->checkDeviceFeature(VIRTIO_RING_F_INDIRECT_DESC)) {
+		transport->acknowledgeDriverFeature(VIRTIO_RING_F_INDIRECT_DESC);
+		features.indirect = true;
+	}
+	return features;
+}
+
+} // anonymous namespace
+
 // --------------------------------------------------------
 // LegacyPciTransport
 // --------------------------------------------------------
@@ -106,6 +131,7 @@ private:
 	protocols::hw::Device _hwDevice;
 	arch::io_space _legacySpace;
 	helix::UniqueDescriptor _irq;
+	RingFeatures _ringFeatures;
 
 	std::vector<std::unique_ptr<LegacyPciQueue>> _queues;
 };
@@ -113,7 +139,8 @@ private:
 struct LegacyPciQueue final : Queue {
 	LegacyPciQueue(LegacyPciTransport *transport,
 			unsigned int queue_index, size_t queue_size,
-			spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used);
+			spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
+			RingFeatures features);
 
 protected:
 	void notifyTransport() override;
@@ -155,7 +182,7 @@ void LegacyPciTransport::acknowledgeDriverFeature(unsigned int feature) {
 }
 
 void LegacyPciTransport::finalizeFeatures() {
-	// Does nothing for now.
+	_ringFeatures = negotiateRingFeatures(this);
 }
 
 void LegacyPciTransport::claimQueues(unsigned int max_index) {
@@ -200,7 +227,7 @@ Queue *LegacyPciTransport::setupQueue(unsigned int queue_index) {
 	auto available = reinterpret_cast<spec::AvailableRing *>((char *)window + available_offset);
 	auto used = reinterpret_cast<spec::UsedRing *>((char *)window + used_offset);
 	_queues[queue_index] = std::make_unique<LegacyPciQueue>(this, queue_index, queue_size,
-			table, available, used);
+			table, available, used, _ringFeatures);
 
 	// Hand the queue to the device.
 	uintptr_t table_physical;
@@ -251,8 +278,11 @@ async::detached LegacyPciTransport::_processIrqs() {
 
 LegacyPciQueue::LegacyPciQueue(LegacyPciTransport *transport,
 		unsigned int queue_index, size_t queue_size,
-		spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used)
-: Queue{queue_index, queue_size, table, available, used}, _transport{transport} { }
+		spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
+		RingFeatures features)
+: Queue{queue_index, queue_size, table, available, used,
+		features.eventIndex, features.indirect},
+		_transport{transport} { }
 
 void LegacyPciQueue::notifyTransport() {
 	_transport->_legacySpace.store(PCI_L_QUEUE_NOTIFY, queueIndex());
@@ -278,7 +308,7 @@ struct StandardPciTransport : Transport {
 			Mapping common_mapping, Mapping notify_mapping,
 			Mapping isr_mapping, Mapping device_mapping,
 			unsigned int notify_multiplier, helix::UniqueDescriptor irq,
-			helix::UniqueDescriptor queueMsi);
+			std::vector<helix::UniqueDescriptor> queueMsis);
 
 	protocols::hw::Device &hwDevice() override {
 		return _hwDevice;
@@ -304,7 +334,7 @@ private:
 	arch::mem_space _deviceSpace() { return arch::mem_space{_deviceMapping.get()}; }
 
 	async::detached _processIrqs();
-	async::detached _processQueueMsi();
+	async::detached _processQueueMsi(size_t vector);
 
 	protocols::hw::Device _hwDevice;
 	bool _useMsi;
@@ -314,8 +344,9 @@ private:
 	Mapping _deviceMapping;
 	unsigned int _notifyMultiplier;
 	helix::UniqueDescriptor _irq;
-	helix::UniqueDescriptor _queueMsi;
-
+	// One MSI-X vector per virtq; queues share vectors if the device has too few of them.
+	std::vector<helix::UniqueDescriptor> _queueMsis;
+	RingFeatures _ringFeatures;
 
 	std::vector<std::unique_ptr<StandardPciQueue>> _queues;
 };
@@ -324,7 +355,7 @@ struct StandardPciQueue final : Queue {
 	StandardPciQueue(StandardPciTransport *transport,
 			unsigned int queue_index, size_t queue_size,
 			spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
-			arch::scalar_register<uint16_t> notify_register);
+			arch::scalar_register<uint16_t> notify_register, RingFeatures features);
 
 protected:
 	void notifyTransport() override;
@@ -339,13 +370,13 @@ StandardPciTransport::StandardPciTransport(protocols::hw::Device hw_device,
 		Mapping common_mapping, Mapping notify_mapping,
 		Mapping isr_mapping, Mapping device_mapping,
 		unsigned int notify_multiplier, helix::UniqueDescriptor irq,
-		helix::UniqueDescriptor queueMsi)
+		std::vector<helix::UniqueDescriptor> queueMsis)
 : _hwDevice{std::move(hw_device)},
 		_useMsi{useMsi},
 		_commonMapping{std::move(common_mapping)}, _notifyMapping{std::move(notify_mapping)},
 		_isrMapping{std::move(isr_mapping)}, _deviceMapping{std::move(device_mapping)},
 		_notifyMultiplier{notify_multiplier}, _irq{std::move(irq)},
-		_queueMsi{std::move(queueMsi)} { }
+		_queueMsis{std::move(queueMsis)} { }
 
 uint8_t StandardPciTransport::loadConfig8(size_t offset) {
 	return _deviceSpace().load(arch::scalar_register<uint8_t>(offset));
@@ -372,8 +403,9 @@ void StandardPciTransport::acknowledgeDriverFeature(unsigned int feature) {
 }
 
 void StandardPciTransport::finalizeFeatures() {
-	assert(checkDeviceFeature(32));
-	acknowledgeDriverFeature(32);
+	assert(checkDeviceFeature(VIRTIO_F_VERSION_1));
+	acknowledgeDriverFeature(VIRTIO_F_VERSION_1);
+	_ringFeatures = negotiateRingFeatures(this);
 
 	_commonSpace().store(PCI_DEVICE_STATUS, _commonSpace().load(PCI_DEVICE_STATUS) | FEATURES_OK);
 	auto confirm = _commonSpace().load(PCI_DEVICE_STATUS);
@@ -424,7 +456,8 @@ Queue *StandardPciTransport::setupQueue(unsigned int queue_index) {
 	auto used = reinterpret_cast<spec::UsedRing *>((char *)window + used_offset);
 	_queues[queue_index] = std::make_unique<StandardPciQueue>(this, queue_index, queue_size,
 			table, available, used,
-			arch::scalar_register<uint16_t>{_notifyMultiplier * notify_index});
+			arch::scalar_register<uint16_t>{_notifyMultiplier * notify_index},
+			_ringFeatures);
 
 	// Hand the queue to the device.
 	uintptr_t table_physical, available_physical, used_physical;
@@ -440,8 +473,9 @@ Queue *StandardPciTransport::setupQueue(unsigned int queue_index) {
 
 	// Setup MSI-X.
 	if(_useMsi) {
-		_commonSpace().store(PCI_QUEUE_MSIX_VECTOR, 0);
-		if(_commonSpace().load(PCI_QUEUE_MSIX_VECTOR) != 0)
+		uint16_t vector = queue_index % _queueMsis.size();
+		_commonSpace().store(PCI_QUEUE_MSIX_VECTOR, vector);
+		if(_commonSpace().load(PCI_QUEUE_MSIX_VECTOR) != vector)
 			throw std::runtime_error("Device failed to allocate MSI-X interrupt");
 	}
 
@@ -455,7 +489,8 @@ void StandardPciTransport::runDevice() {
 	_commonSpace().store(PCI_DEVICE_STATUS, _commonSpace().load(PCI_DEVICE_STATUS) | DRIVER_OK);
 
 	if(_useMsi)
-		_processQueueMsi();
+		for(size_t i = 0; i < _queueMsis.size(); i++)
+			_processQueueMsi(i);
 	_processIrqs();
 }
 
@@ -563,25 +598,29 @@ async::detached StandardPciTransport::_processIrqs() {
 #endif
 }
 
-async::detached StandardPciTransport::_processQueueMsi() {
+async::detached StandardPciTransport::_processQueueMsi(size_t vector) {
+	auto &msi = _queueMsis[vector];
+
 	uint64_t sequence = 0;
 	while(true) {
-		auto await = co_await helix_ng::awaitEvent(_queueMsi, sequence);
+		auto await = co_await helix_ng::awaitEvent(msi, sequence);
 		HEL_CHECK(await.error());
 		sequence = await.sequence();
 
-		HEL_CHECK(helAcknowledgeIrq(_queueMsi.getHandle(), kHelAckAcknowledge, sequence));
+		HEL_CHECK(helAcknowledgeIrq(msi.getHandle(), kHelAckAcknowledge, sequence));
 
-		for(auto &queue : _queues)
-			queue->processInterrupt();
+		// Only process the queues that are routed to this vector.
+		for(size_t i = vector; i < _queues.size(); i += _queueMsis.size())
+			_queues[i]->processInterrupt();
 	}
 }
 
 StandardPciQueue::StandardPciQueue(StandardPciTransport *transport,
 		unsigned int queue_index, size_t queue_size,
 		spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
-		arch::scalar_register<uint16_t> notify_register)
-: Queue{queue_index, queue_size, table, available, used},
+		arch::scalar_register<uint16_t> notify_register, RingFeatures features)
+: Queue{queue_index, queue_size, table, available, used,
+		features.eventIndex, features.indirect},
 		_transport{transport}, _notifyRegister{notify_register} { }
 
 void StandardPciQueue::notifyTransport() {
@@ -661,12 +700,15 @@ discover(protocols::hw::Device hw_device, DiscoverMode mode) {
 			common_space.store(PCI_DEVICE_STATUS, 0);
 			assert(!common_space.load(PCI_DEVICE_STATUS));
 
-			helix::UniqueDescriptor queueMsi;
+			std::vector<helix::UniqueDescriptor> queueMsis;
 
-			// Enable MSI-X.
+			// Enable MSI-X and give each virtq its own vector (as far as the device allows).
 			if (info.numMsis) {
 				co_await hw_device.enableMsi();
-				queueMsi = co_await hw_device.installMsi(0);
+				size_t num_queues = std::max(common_space.load(PCI_NUM_QUEUES), uint16_t{1});
+				size_t num_vectors = std::min(static_cast<size_t>(info.numMsis), num_queues);
+				for(size_t i = 0; i < num_vectors; i++)
+					queueMsis.push_back(co_await hw_device.installMsi(i));
 			}
 
 			// Set the ACKNOWLEDGE and DRIVER bits.
@@ -681,7 +723,7 @@ discover(protocols::hw::Device hw_device, DiscoverMode mode) {
 					info.numMsis,
 					std::move(*common_mapping), std::move(*notify_mapping),
 					std::move(*isr_mapping), std::move(*device_mapping),
-					notify_multiplier, std::move(irq), std::move(queueMsi));
+					notify_multiplier, std::move(irq), std::move(queueMsis));
 		}
 	}
 
@@ -751,6 +793,71 @@ void Handle::setupLink(Handle other) {
 	descriptor->flags.store(descriptor->flags.load() | VIRTQ_DESC_F_NEXT);
 }
 
+// --------------------------------------------------------
+// IndirectChain
+// --------------------------------------------------------
+
+IndirectChain::IndirectChain(Handle handle)
+: _handle{handle} {
+	auto queue = _handle._queue;
+	assert(queue->_useIndirect);
+
+	auto &indirect = queue->_indirectTables[_handle.tableIndex()];
+	if(!indirect.table) {
+		HelHandle memory;
+		void *window;
+		HEL_CHECK(helAllocateMemory(0x1000, kHelAllocContinuous, nullptr, &memory));
+		HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
+				0, 0x1000, kHelMapProtRead | kHelMapProtWrite, &window));
+		HEL_CHECK(helCloseDescriptor(kHelThisUniverse, memory));
+
+		indirect.table = new (window) spec::Descriptor[Queue::maxIndirectDescriptors];
+		HEL_CHECK(helPointerPhysical(window, &indirect.physical));
+	}
+	_table = indirect.table;
+	_tablePhysical = indirect.physical;
+
+	auto descriptor = queue->_table + _handle.tableIndex();
+	descriptor->address.store(_tablePhysical);
+	descriptor->length.store(0);
+	descriptor->flags.store(VIRTQ_DESC_F_INDIRECT);
+}
+
+void IndirectChain::append(HostToDeviceType, arch::dma_buffer_view view) {
+	_append(view, 0);
+}
+
+void IndirectChain::append(DeviceToHostType, arch::dma_buffer_view view) {
+	_append(view, VIRTQ_DESC_F_WRITE);
+}
+
+void IndirectChain::_append(arch::dma_buffer_view view, uint16_t flags) {
+	assert(view.size());
+	assert(_size < Queue::maxIndirectDescriptors);
+
+	uintptr_t physical;
+	HEL_CHECK(helPointerPhysical(view.data(), &physical));
+
+	auto entry = _table + _size;
+	entry->address.store(physical);
+	entry->length.store(view.size());
+	entry->flags.store(flags);
+	entry->next.store(0);
+	if(_size) {
+		auto predecessor = _table + _size - 1;
+		predecessor->next.store(_size);
+		predecessor->flags.store(predecessor->flags.load() | VIRTQ_DESC_F_NEXT);
+	}
+	_size++;
+
+	auto descriptor = _handle._queue->_table + _handle.tableIndex();
+	descriptor->length.store(_size * sizeof(spec::Descriptor));
+}
+
+// --------------------------------------------------------
+// scatterGather()
+// --------------------------------------------------------
+
 async::result<void> scatterGather(HostToDeviceType, Chain &chain, Queue *queue,
 		arch::dma_buffer_view view) {
 	constexpr size_t page_size = 0x1000;
@@ -782,8 +889,10 @@ async::result<void> scatterGather(DeviceToHostType, Chain &chain, Queue *queue,
 // --------------------------------------------------------
 
 Queue::Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *table,
-		spec::AvailableRing *available, spec::UsedRing *used)
-: _queueIndex{queue_index}, _queueSize{queue_size}, _progressHead{0} {
+		spec::AvailableRing *available, spec::UsedRing *used,
+		bool event_index, bool indirect)
+: _queueIndex{queue_index}, _queueSize{queue_size}, _progressHead{0},
+		_useEventIndex{event_index}, _notifiedHead{0}, _useIndirect{indirect} {
 	// Construct the hardware state.
 	_table = new (table) spec::Descriptor[_queueSize];
 	_availableRing = new (available) spec::AvailableRing;
@@ -810,6 +919,8 @@ Queue::Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *tabl
 	for(size_t i = 0; i < _queueSize; i++)
 		_descriptorStack.push_back(i);
 	_activeRequests.resize(_queueSize);
+	if(_useIndirect)
+		_indirectTables.resize(_queueSize);
 }
 
 async::result<Handle> Queue::obtainDescriptor() {
@@ -848,17 +959,39 @@ void Queue::postDescriptor(Handle handle, Request *request,
 }
 
 void Queue::notify() {
-	asm volatile ( "" : : : "memory" );
-	if(!(_usedRing->flags.load() & VIRTQ_USED_F_NO_NOTIFY))
+	// Order the update of the available ring before reading the device's suppression state.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if(_useEventIndex) {
+		auto head = _availableRing->headIndex.load();
+		auto event = _usedExtra->eventIndex.load();
+		uint16_t previous = _notifiedHead;
+		_notifiedHead = head;
+
+		// Only notify if the device asked to be notified about one of the new entries.
+		if(static_cast<uint16_t>(head - event - 1) < static_cast<uint16_t>(head - previous))
+			notifyTransport();
+	}else if(!(_usedRing->flags.load() & VIRTQ_USED_F_NO_NOTIFY)) {
 		notifyTransport();
+	}
 }
 
 void Queue::processInterrupt() {
 	while(true) {
 		auto used_head = _usedRing->headIndex.load();
 
-		if((_progressHead & 0xFFFF) == used_head)
-			break;
+		if((_progressHead & 0xFFFF) == used_head) {
+			if(!_useEventIndex)
+				break;
+
+			// Ask the device to interrupt once it uses the next entry. The device might have
+			// used entries before it saw the update, hence we need to check again.
+			_availableExtra->eventIndex.store(_progressHead);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(_usedRing->headIndex.load() == _progressHead)
+				break;
+			continue;
+		}
 
 		asm volatile ( "" : : : "memory" );
 
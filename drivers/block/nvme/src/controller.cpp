@@ -1,8 +1,14 @@
 #include <arch/bit.hpp>
 #include <helix/timer.hpp>
+#include <algorithm>
+#include <iostream>
 
 #include "controller.hpp"
 
+namespace {
+	constexpr bool logQueues = false;
+} // namespace
+
 namespace regs {
 	constexpr arch::bit_register<uint64_t> cap{0x0};
 	constexpr arch::scalar_register<uint32_t> vs{0x4};
@@ -17,6 +23,7 @@ namespace flags {
 	namespace cap {
 		constexpr arch::field<uint64_t, uint16_t> mqes{0, 16};
 		constexpr arch::field<uint64_t, uint8_t> dstrd{32, 4};
+		constexpr arch::field<uint64_t, uint8_t> mpsmin{48, 4};
 	} // namespace cap
 
 	namespace vs {
@@ -37,15 +44,17 @@ namespace flags {
 } // namespace flags
 
 Controller::Controller(int64_t parentId, protocols::hw::Device hwDevice, helix::Mapping hbaRegs,
-					   helix::UniqueDescriptor, helix::UniqueDescriptor irq)
+					   helix::UniqueDescriptor, std::vector<helix::UniqueDescriptor> irqs)
 	: hwDevice_{std::move(hwDevice)}, regsMapping_{std::move(hbaRegs)},
-	  regs_{regsMapping_.get()}, irq_{std::move(irq)}, parentId_{parentId} {
+	  regs_{regsMapping_.get()}, irqs_{std::move(irqs)}, parentId_{parentId} {
+	assert(!irqs_.empty());
 }
 
 async::detached Controller::run() {
 	co_await hwDevice_.enableBusIrq();
 
-	handleIrqs();
+	for (unsigned int i = 0; i < irqs_.size(); i++)
+		handleIrqs(i);
 
 	co_await reset();
 	co_await scanNamespaces();
@@ -54,23 +63,26 @@ async::detached Controller::run() {
 		ns->run();
 }
 
-async::detached Controller::handleIrqs() {
-	irqSequence_ = 0;
+async::detached Controller::handleIrqs(unsigned int vector) {
+	auto &irq = irqs_[vector];
+	uint64_t sequence = 0;
 
 	while (true) {
-		auto await = co_await helix_ng::awaitEvent(irq_, irqSequence_);
+		auto await = co_await helix_ng::awaitEvent(irq, sequence);
 		HEL_CHECK(await.error());
-		irqSequence_ = await.sequence();
+		sequence = await.sequence();
 
+		// Only poll the completion queues that are routed to this vector.
 		int found = 0;
 		for (auto &q : activeQueues_) {
-			found |= q->handleIrq();
+			if (q->getIrqVector() == vector)
+				found |= q->handleIrq();
 		}
 
 		if (found) {
-			HEL_CHECK(helAcknowledgeIrq(irq_.getHandle(), kHelAckAcknowledge, irqSequence_));
+			HEL_CHECK(helAcknowledgeIrq(irq.getHandle(), kHelAckAcknowledge, sequence));
 		} else {
-			HEL_CHECK(helAcknowledgeIrq(irq_.getHandle(), kHelAckNack, irqSequence_));
+			HEL_CHECK(helAcknowledgeIrq(irq.getHandle(), kHelAckNack, sequence));
 		}
 	}
 }
@@ -104,12 +116,13 @@ async::result<void> Controller::reset() {
 
 	queueDepth_ = std::min((cap & flags::cap::mqes) + 1, IO_QUEUE_DEPTH);
 	dbStride_ = 1 << (cap & flags::cap::dstrd);
+	auto minPageSize = size_t{1} << (12 + (cap & flags::cap::mpsmin));
 
 	version_ = regs_.load(regs::vs);
 
 	co_await disable();
 
-	auto adminQ = std::make_unique<Queue>(0, 32, regs_.subspace(doorbellsOffset));
+	auto adminQ = std::make_unique<Queue>(0, 32, regs_.subspace(doorbellsOffset), dbStride_, 0);
 	adminQ->init();
 
 	uint32_t aqa = (31 << 16) | 31;
@@ -122,15 +135,61 @@ async::result<void> Controller::reset() {
 
 	co_await enable();
 
-	auto ioQ = std::make_unique<Queue>(1, queueDepth_, regs_.subspace(doorbellsOffset + 1 * 8 * dbStride_));
-	ioQ->init();
+	// MDTS is reported in units of the minimum page size; zero means no limit.
+	spec::IdentifyController idCtrl;
+	maxTransferSize_ = 0;
+	if ((co_await identifyController(idCtrl)).first == 0 && idCtrl.mdts)
+		maxTransferSize_ = minPageSize << idCtrl.mdts;
+	if (!maxTransferSize_ || maxTransferSize_ > (size_t{1} << 20))
+		maxTransferSize_ = size_t{1} << 20;
+
+	// Create one I/O queue per interrupt vector (vector 0 is shared with the admin queue).
+	// Without MSI-X, a single I/O queue shares the legacy IRQ with the admin queue.
+	auto desiredQueues = std::clamp(static_cast<unsigned int>(irqs_.size()) - 1, 1u, MAX_IO_QUEUES);
+	auto numQueues = co_await negotiateIoQueues(desiredQueues);
+
+	for (unsigned int i = 1; i <= numQueues; i++) {
+		auto vector = irqs_.size() > 1 ? 1 + (i - 1) % (irqs_.size() - 1) : 0;
+		auto ioQ = std::make_unique<Queue>(i, queueDepth_,
+				regs_.subspace(doorbellsOffset + i * 8 * dbStride_), dbStride_, vector);
+		ioQ->init();
+
+		if (!(co_await setupIoQueue(ioQ.get())))
+			break;
 
-	if (co_await setupIoQueue(ioQ.get())) {
 		ioQ->run();
 		activeQueues_.push_back(std::move(ioQ));
 	}
 
 	assert(activeQueues_.size() >= 2 && "At least need one IO queue");
+	if (logQueues)
+		std::cout << "block/nvme: Using " << activeQueues_.size() - 1 << " I/O queues on "
+				<< irqs_.size() << " interrupt vectors" << std::endl;
+}
+
+async::result<unsigned int> Controller::negotiateIoQueues(unsigned int count) {
+	using arch::convert_endian;
+	using arch::endian;
+
+	auto &adminQ = activeQueues_.front();
+	auto cmd = std::make_unique<Command>();
+	auto &cmdBuf = cmd->getCommandBuffer().common;
+
+	// Both the requested and the allocated counts are zero-based.
+	uint32_t nq = count - 1;
+	cmdBuf.opcode = spec::kSetFeatures;
+	cmdBuf.cdw10 = convert_endian<endian::little, endian::native>(
+		static_cast<uint32_t>(spec::kNumberOfQueues));
+	cmdBuf.cdw11 = convert_endian<endian::little, endian::native>(nq | (nq << 16));
+
+	auto res = co_await adminQ->submitCommand(std::move(cmd));
+	if (res.first != 0)
+		co_return 1;
+
+	auto allocated = convert_endian<endian::little>(res.second.u32);
+	auto nsqa = (allocated & 0xFFFF) + 1;
+	auto ncqa = (allocated >> 16) + 1;
+	co_return std::min({count, nsqa, ncqa});
 }
 
 async::result<bool> Controller::setupIoQueue(Queue *q) {
@@ -160,7 +219,7 @@ async::result<Command::Result> Controller::createCQ(Queue *q) {
 	cmdBuf.cqid = convert_endian<endian::little, endian::native>((uint16_t)q->getQueueId());
 	cmdBuf.qSize = convert_endian<endian::little, endian::native>((uint16_t)q->getQueueDepth() - 1);
 	cmdBuf.cqFlags = convert_endian<endian::little, endian::native>((uint16_t)flags);
-	cmdBuf.irqVector = 0; // TODO: set to MSI vector
+	cmdBuf.irqVector = convert_endian<endian::little, endian::native>((uint16_t)q->getIrqVector());
 
 	return adminQ->submitCommand(std::move(cmd));
 }
@@ -289,7 +348,10 @@ async::result<void> Controller::createNamespace(unsigned int nsid) {
 }
 
 async::result<Command::Result> Controller::submitIoCommand(std::unique_ptr<Command> cmd) {
-	auto &ioQ = activeQueues_.back();
+	// Spread the commands over all I/O queues. The driver runs on a single thread,
+	// hence the submitting CPU says nothing about where the completion is handled.
+	auto &ioQ = activeQueues_[1 + nextIoQueue_];
+	nextIoQueue_ = (nextIoQueue_ + 1) % (activeQueues_.size() - 1);
 
 	return ioQ->submitCommand(std::move(cmd));
 }
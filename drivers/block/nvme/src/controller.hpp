@@ -10,7 +10,7 @@
 
 struct Controller {
 	Controller(int64_t parentId, protocols::hw::Device hwDevice, helix::Mapping hbaRegs,
-			   helix::UniqueDescriptor ahciBar, helix::UniqueDescriptor irq);
+			   helix::UniqueDescriptor ahciBar, std::vector<helix::UniqueDescriptor> irqs);
 
 	async::detached run();
 
@@ -19,23 +19,31 @@ struct Controller {
 	inline int64_t getParentId() const {
 		return parentId_;
 	}
+
+	// Maximum number of bytes that a single I/O command may transfer.
+	inline size_t getMaxTransferSize() const {
+		return maxTransferSize_;
+	}
+
+	static constexpr unsigned int MAX_IO_QUEUES = 16;
 private:
 	static constexpr int IO_QUEUE_DEPTH = 1024;
 
 	protocols::hw::Device hwDevice_;
 	helix::Mapping regsMapping_;
 	arch::mem_space regs_;
-	helix::UniqueDescriptor irq_;
+	std::vector<helix::UniqueDescriptor> irqs_;
 
 	std::vector<std::unique_ptr<Queue>> activeQueues_;
 	std::vector<std::unique_ptr<Namespace>> activeNamespaces_;
+	// Index of the I/O queue that receives the next command (see submitIoCommand()).
+	size_t nextIoQueue_ = 0;
 
 	int64_t parentId_;
 	unsigned int queueDepth_;
 	uint32_t dbStride_;
 	uint32_t version_;
-
-	uint64_t irqSequence_;
+	size_t maxTransferSize_;
 
 	async::result<void> reset();
 	async::result<void> scanNamespaces();
@@ -44,6 +52,7 @@ private:
 	async::result<void> enable();
 	async::result<void> disable();
 
+	async::result<unsigned int> negotiateIoQueues(unsigned int count);
 	async::result<bool> setupIoQueue(Queue *q);
 	async::result<Command::Result> createCQ(Queue *q);
 	async::result<Command::Result> createSQ(Queue *q);
@@ -54,5 +63,5 @@ private:
 
 	async::result<void> createNamespace(unsigned int nsid);
 
-	async::detached handleIrqs();
+	async::detached handleIrqs(unsigned int vector);
 };
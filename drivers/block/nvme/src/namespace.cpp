@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <arch/bit.hpp>
 
 #include "namespace.hpp"
@@ -18,32 +19,56 @@ async::result<void> Namespace::readSectors(uint64_t sector, void *buffer, size_t
 	using arch::convert_endian;
 	using arch::endian;
 
-	auto cmd = std::make_unique<Command>();
-	auto &cmdBuf = cmd->getCommandBuffer().readWrite;
+	// Split transfers that exceed the controller's MDTS into multiple commands.
+	auto maxSectors = controller_->getMaxTransferSize() >> lbaShift_;
+	auto *ptr = (char *)buffer;
 
-	cmdBuf.opcode = spec::kRead;
-	cmdBuf.nsid = convert_endian<endian::little, endian::native>(nsid_);
-	cmdBuf.startLba = convert_endian<endian::little, endian::native>(sector);
-	cmdBuf.length = convert_endian<endian::little, endian::native>((uint16_t)numSectors - 1);
-	cmd->setupBuffer(arch::dma_buffer_view{nullptr, buffer, numSectors << lbaShift_});
+	while (numSectors) {
+		auto chunk = std::min(numSectors, maxSectors);
 
-	co_await controller_->submitIoCommand(std::move(cmd));
+		auto cmd = std::make_unique<Command>();
+		auto &cmdBuf = cmd->getCommandBuffer().readWrite;
+
+		cmdBuf.opcode = spec::kRead;
+		cmdBuf.nsid = convert_endian<endian::little, endian::native>(nsid_);
+		cmdBuf.startLba = convert_endian<endian::little, endian::native>(sector);
+		cmdBuf.length = convert_endian<endian::little, endian::native>((uint16_t)(chunk - 1));
+		cmd->setupBuffer(arch::dma_buffer_view{nullptr, ptr, chunk << lbaShift_});
+
+		co_await controller_->submitIoCommand(std::move(cmd));
+
+		sector += chunk;
+		ptr += chunk << lbaShift_;
+		numSectors -= chunk;
+	}
 }
 
 async::result<void> Namespace::writeSectors(uint64_t sector, const void *buffer, size_t numSectors) {
 	using arch::convert_endian;
 	using arch::endian;
 
-	auto cmd = std::make_unique<Command>();
-	auto &cmdBuf = cmd->getCommandBuffer().readWrite;
+	// Split transfers that exceed the controller's MDTS into multiple commands.
+	auto maxSectors = controller_->getMaxTransferSize() >> lbaShift_;
+	auto *ptr = (const char *)buffer;
+
+	while (numSectors) {
+		auto chunk = std::min(numSectors, maxSectors);
+
+		auto cmd = std::make_unique<Command>();
+		auto &cmdBuf = cmd->getCommandBuffer().readWrite;
+
+		cmdBuf.opcode = spec::kWrite;
+		cmdBuf.nsid = convert_endian<endian::little, endian::native>(nsid_);
+		cmdBuf.startLba = convert_endian<endian::little, endian::native>(sector);
+		cmdBuf.length = convert_endian<endian::little, endian::native>((uint16_t)(chunk - 1));
+		cmd->setupBuffer(arch::dma_buffer_view{nullptr, (char *)ptr, chunk << lbaShift_});
 
-	cmdBuf.opcode = spec::kWrite;
-	cmdBuf.nsid = convert_endian<endian::little, endian::native>(nsid_);
-	cmdBuf.startLba = convert_endian<endian::little, endian::native>(sector);
-	cmdBuf.length = convert_endian<endian::little, endian::native>((uint16_t)numSectors - 1);
-	cmd->setupBuffer(arch::dma_buffer_view{nullptr, (char *)buffer, numSectors << lbaShift_});
+		co_await controller_->submitIoCommand(std::move(cmd));
 
-	co_await controller_->submitIoCommand(std::move(cmd));
+		sector += chunk;
+		ptr += chunk << lbaShift_;
+		numSectors -= chunk;
+	}
 }
 
 async::result<size_t> Namespace::getSize() {
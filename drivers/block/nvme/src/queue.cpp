@@ -5,8 +5,10 @@
 #include "queue.hpp"
 #include "spec.hpp"
 
-Queue::Queue(unsigned int qid, unsigned int depth, arch::mem_space doorbells)
-	: qid_(qid), depth_(depth), doorbells_(doorbells), sqTail_(0), cqHead_(0), cqPhase_(1) {
+Queue::Queue(unsigned int qid, unsigned int depth, arch::mem_space doorbells,
+		uint32_t dbStride, unsigned int irqVector)
+	: qid_(qid), depth_(depth), doorbells_(doorbells), dbStride_(dbStride), irqVector_(irqVector),
+	  sqTail_(0), cqHead_(0), cqPhase_(1), commandsInFlight_(0) {
 	queuedCmds_.resize(depth);
 }
 
@@ -74,7 +76,7 @@ int Queue::handleIrq() {
 	commandsInFlight_ -= found;
 
 	if (found)
-		doorbells_.store(arch::scalar_register<uint32_t>{0x4}, cqHead_);
+		doorbells_.store(arch::scalar_register<uint32_t>{(ptrdiff_t)(4 * dbStride_)}, cqHead_);
 
 	return found;
 }
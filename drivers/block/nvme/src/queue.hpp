@@ -11,7 +11,8 @@
 #include "spec.hpp"
 
 struct Queue {
-	Queue(unsigned int index, unsigned int depth, arch::mem_space doorbells);
+	Queue(unsigned int index, unsigned int depth, arch::mem_space doorbells,
+			uint32_t dbStride, unsigned int irqVector);
 
 	void init();
 	async::detached run();
@@ -22,6 +23,9 @@ struct Queue {
 	unsigned int getQueueDepth() const {
 		return depth_;
 	}
+	unsigned int getIrqVector() const {
+		return irqVector_;
+	}
 
 	uintptr_t getCqPhysAddr() const {
 		return cqPhys_;
@@ -38,6 +42,8 @@ private:
 	unsigned int qid_;
 	unsigned int depth_;
 	arch::mem_space doorbells_;
+	uint32_t dbStride_;
+	unsigned int irqVector_;
 	spec::CompletionEntry *cqes_;
 	void *sqCmds_;
 	uintptr_t cqPhys_;
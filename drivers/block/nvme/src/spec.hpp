@@ -13,6 +13,11 @@ enum AdminOpcode {
 	kDeleteCQ = 0x4,
 	kCreateCQ = 0x5,
 	kIdentify = 0x6,
+	kSetFeatures = 0x9,
+};
+
+enum FeatureId {
+	kNumberOfQueues = 0x7,
 };
 
 enum CommandFlags {
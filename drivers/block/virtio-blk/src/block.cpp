@@ -1,5 +1,6 @@
 
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
 
 #include "block.hpp"
@@ -22,9 +23,13 @@ UserRequest::UserRequest(bool write_, uint64_t sector_, void *buffer_, size_t nu
 
 Device::Device(std::unique_ptr<virtio_core::Transport> transport, int64_t parent_id)
 : blockfs::BlockDevice{512, parent_id}, _transport{std::move(transport)},
-		_requestQueue{nullptr}, _size{0} { }
+		_requestQueue{nullptr}, _segMax{0}, _size{0} { }
 
 void Device::runDevice() {
+	if(_transport->checkDeviceFeature(VIRTIO_BLK_F_SEG_MAX)) {
+		_transport->acknowledgeDriverFeature(VIRTIO_BLK_F_SEG_MAX);
+		_segMax = _transport->space().load(spec::regs::segMax);
+	}
 	_transport->finalizeFeatures();
 	_transport->claimQueues(1);
 	_requestQueue = _transport->setupQueue(0);
@@ -55,8 +60,7 @@ async::result<void> Device::readSectors(uint64_t sector,
 	assert(!((uintptr_t)buffer % 512));
 //	printf("readSectors(%lu, %lu)\n", sector, num_sectors);
 
-	// Limit to ensure that we don't monopolize the device.
-	auto max_sectors = _requestQueue->numDescriptors() / 4;
+	auto max_sectors = _maxSectors();
 	assert(max_sectors >= 1);
 
 	for(size_t progress = 0; progress < num_sectors; progress += max_sectors) {
@@ -76,8 +80,7 @@ async::result<void> Device::writeSectors(uint64_t sector,
 	assert(!((uintptr_t)buffer % 512));
 //	printf("writeSectors(%lu, %lu)\n", sector, num_sectors);
 
-	// Limit to ensure that we don't monopolize the device.
-	auto max_sectors = _requestQueue->numDescriptors() / 4;
+	auto max_sectors = _maxSectors();
 	assert(max_sectors >= 1);
 
 	for(size_t progress = 0; progress < num_sectors; progress += max_sectors) {
@@ -95,6 +98,24 @@ async::result<size_t> Device::getSize() {
 	co_return _size * 512;
 }
 
+size_t Device::_maxSectors() {
+	// With indirect descriptors, each request only occupies a single descriptor of the virtq.
+	// Data is split at page boundaries; reserve descriptors for the header and the status byte.
+	if(_requestQueue->supportsIndirect()) {
+		size_t segments = virtio_core::Queue::maxIndirectDescriptors - 2;
+		if(_segMax)
+			segments = std::min(segments, _segMax);
+		// Unaligned buffers need one more segment than pages.
+		// A single sector never crosses a page boundary, so one segment is always enough for it.
+		if(segments < 2)
+			return 1;
+		return (segments - 1) * (0x1000 / 512);
+	}
+
+	// Limit to ensure that we don't monopolize the device.
+	return _requestQueue->numDescriptors() / 4;
+}
+
 async::detached Device::_processRequests() {
 	while(true) {
 		if(_pendingQueue.empty()) {
@@ -106,6 +127,51 @@ async::detached Device::_processRequests() {
 		_pendingQueue.pop();
 		assert(request->numSectors);
 
+		if(_requestQueue->supportsIndirect()) {
+			auto handle = co_await _requestQueue->obtainDescriptor();
+			virtio_core::IndirectChain chain{handle};
+
+			VirtRequest *header = &virtRequestBuffer[handle.tableIndex()];
+			header->type = request->write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+			header->reserved = 0;
+			header->sector = request->sector;
+			chain.append(virtio_core::hostToDevice, arch::dma_buffer_view{nullptr,
+					header, sizeof(VirtRequest)});
+
+			// Setup one descriptor per page of transfered data.
+			size_t length = 512 * request->numSectors;
+			size_t offset = 0;
+			while(offset < length) {
+				auto address = reinterpret_cast<uintptr_t>(request->buffer) + offset;
+				auto chunk = std::min(length - offset, 0x1000 - (address & 0xFFF));
+				arch::dma_buffer_view view{nullptr, (char *)request->buffer + offset, chunk};
+				if(request->write) {
+					chain.append(virtio_core::hostToDevice, view);
+				}else{
+					chain.append(virtio_core::deviceToHost, view);
+				}
+				offset += chunk;
+			}
+
+			chain.append(virtio_core::deviceToHost, arch::dma_buffer_view{nullptr,
+					&statusBuffer[handle.tableIndex()], 1});
+
+			if(logInitiateRetire)
+				std::cout << "Submitting " << request->numSectors
+						<< " sectors in " << chain.size() << " indirect descriptors" << std::endl;
+
+			_requestQueue->postDescriptor(handle, request,
+					[] (virtio_core::Request *base_request) {
+				auto request = static_cast<UserRequest *>(base_request);
+				if(logInitiateRetire)
+					std::cout << "Retiring " << request->numSectors
+							<< " sectors" << std::endl;
+				request->event.raise();
+			});
+			_requestQueue->notify();
+			continue;
+		}
+
 		// Setup the descriptor for the request header.
 		virtio_core::Chain chain;
 		chain.append(co_await _requestQueue->obtainDescriptor());
@@ -25,10 +25,15 @@ enum {
 	VIRTIO_BLK_T_OUT = 1
 };
 
+enum {
+	VIRTIO_BLK_F_SEG_MAX = 2
+};
+
 namespace spec::regs {
 	inline constexpr arch::scalar_register<uint32_t> capacity[] = {
 			arch::scalar_register<uint32_t>{0},
 			arch::scalar_register<uint32_t>{4}};
+	inline constexpr arch::scalar_register<uint32_t> segMax{12};
 }
 
 struct Device;
@@ -66,6 +71,9 @@ struct Device : blockfs::BlockDevice {
 	async::result<size_t> getSize() override;
 
 private:
+	// Maximal number of sectors per request that is submitted to the device.
+	size_t _maxSectors();
+
 	// Submits requests from _pendingQueue to the device.
 	async::detached _processRequests();
 
@@ -74,6 +82,9 @@ private:
 	// The single virtq of this device.
 	virtio_core::Queue *_requestQueue;
 
+	// Maximal number of data segments per request (or zero if the device has no limit).
+	size_t _segMax;
+
 	// Stores UserRequest objects that have not been submitted yet.
 	std::queue<UserRequest *> _pendingQueue;
 	async::recurring_event _pendingDoorbell;
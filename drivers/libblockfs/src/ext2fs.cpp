@@ -3,12 +3,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <algorithm>
+#include <bit>
+#include <dirent.h>
 #include <iostream>
 #include <sys/stat.h>
 
 #include <async/result.hpp>
 #include <helix/ipc.hpp>
 #include <helix/memory.hpp>
+#include <helix/timer.hpp>
 
 #include <array>
 
@@ -22,6 +25,238 @@ namespace {
 
 	constexpr int pageShift = 12;
 	constexpr size_t pageSize = size_t{1} << pageShift;
+
+	// Directories larger than this get an in-memory name index if they lack an htree.
+	constexpr size_t nameIndexThreshold = 16 * 1024;
+
+	// Granularity at which read windows lock the page cache.
+	constexpr int readChunkShift = 16;
+	constexpr size_t readChunkSize = size_t{1} << readChunkShift;
+
+	// Upper bound on the page cache that read windows keep locked across all inodes.
+	constexpr size_t readWindowBudget = size_t{64} << 20;
+
+	// Before the page cache shrinks, we poll for clients that still read it directly.
+	// Misbehaving clients cannot stall truncation for longer than the total timeout.
+	constexpr uint64_t cacheReaderPollInterval = 1'000'000;
+	constexpr int cacheReaderPolls = 1000;
+
+	DirEntry toDirEntry(const DiskDirEntry *disk_entry) {
+		DirEntry entry;
+		entry.inode = disk_entry->inode;
+
+		switch(disk_entry->fileType) {
+		case EXT2_FT_REG_FILE:
+			entry.fileType = kTypeRegular; break;
+		case EXT2_FT_DIR:
+			entry.fileType = kTypeDirectory; break;
+		case EXT2_FT_SYMLINK:
+			entry.fileType = kTypeSymlink; break;
+		default:
+			entry.fileType = kTypeNone;
+		}
+
+		return entry;
+	}
+
+	// Searches a single directory block for an entry with the given name.
+	const DiskDirEntry *scanDirBlock(const char *block, size_t size, const std::string &name) {
+		size_t offset = 0;
+		while(offset + sizeof(DiskDirEntry) <= size) {
+			auto disk_entry = reinterpret_cast<const DiskDirEntry *>(block + offset);
+			if(!disk_entry->recordLength || offset + disk_entry->recordLength > size)
+				break;
+
+			if(disk_entry->inode
+					&& name.length() == disk_entry->nameLength
+					&& !memcmp(disk_entry->name, name.data(), name.length()))
+				return disk_entry;
+
+			offset += disk_entry->recordLength;
+		}
+		return nullptr;
+	}
+
+	// Returns the index of the first clear bit in [begin, end) or end if there is none.
+	size_t findClearBit(const uint64_t *words, size_t begin, size_t end) {
+		size_t bit = begin;
+		while(bit < end) {
+			auto word = words[bit / 64] | ((uint64_t{1} << (bit % 64)) - 1);
+			if(word != ~uint64_t{0})
+				return std::min((bit & ~size_t{63}) + std::countr_one(word), end);
+			bit = (bit & ~size_t{63}) + 64;
+		}
+		return end;
+	}
+
+	// Returns the number of consecutive clear bits in [begin, end), starting at begin.
+	size_t countClearBits(const uint64_t *words, size_t begin, size_t end) {
+		size_t bit = begin;
+		while(bit < end) {
+			auto word = words[bit / 64] >> (bit % 64);
+			size_t avail = 64 - bit % 64;
+			size_t n = word ? std::countr_zero(word) : avail;
+			bit += n;
+			if(n < avail)
+				break;
+		}
+		return std::min(bit, end) - begin;
+	}
+
+	void setBits(uint64_t *words, size_t begin, size_t count, bool value) {
+		for(size_t bit = begin; bit < begin + count; bit++) {
+			if(value) {
+				words[bit / 64] |= uint64_t{1} << (bit % 64);
+			}else{
+				words[bit / 64] &= ~(uint64_t{1} << (bit % 64));
+			}
+		}
+	}
+
+	// --------------------------------------------------------
+	// htree hash functions (compatible with Linux' fs/ext4/hash.c)
+	// --------------------------------------------------------
+
+	int hashChar(const char *s, size_t i, bool isUnsigned) {
+		if(isUnsigned)
+			return static_cast<unsigned char>(s[i]);
+		return static_cast<signed char>(s[i]);
+	}
+
+	uint32_t dxHackHash(const char *name, size_t len, bool isUnsigned) {
+		uint32_t hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+		for(size_t i = 0; i < len; i++) {
+			uint32_t hash = hash1 + (hash0 ^ static_cast<uint32_t>(hashChar(name, i, isUnsigned) * 7152373));
+			if(hash & 0x80000000)
+				hash -= 0x7fffffff;
+			hash1 = hash0;
+			hash0 = hash;
+		}
+		return hash0 << 1;
+	}
+
+	void strToHashBuf(const char *msg, size_t len, uint32_t *buf, int num, bool isUnsigned) {
+		uint32_t pad = static_cast<uint32_t>(len) | (static_cast<uint32_t>(len) << 8);
+		pad |= pad << 16;
+
+		uint32_t val = pad;
+		if(len > static_cast<size_t>(num) * 4)
+			len = num * 4;
+		for(size_t i = 0; i < len; i++) {
+			val = static_cast<uint32_t>(hashChar(msg, i, isUnsigned)) + (val << 8);
+			if((i % 4) == 3) {
+				*buf++ = val;
+				val = pad;
+				num--;
+			}
+		}
+		if(--num >= 0)
+			*buf++ = val;
+		while(--num >= 0)
+			*buf++ = pad;
+	}
+
+	void halfMd4Transform(uint32_t buf[4], const uint32_t in[8]) {
+		auto f = [] (uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); };
+		auto g = [] (uint32_t x, uint32_t y, uint32_t z) { return (x & y) + ((x ^ y) & z); };
+		auto h = [] (uint32_t x, uint32_t y, uint32_t z) { return x ^ y ^ z; };
+		constexpr uint32_t k2 = 013240474631;
+		constexpr uint32_t k3 = 015666365641;
+
+		uint32_t a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+		auto round = [] (auto fn, uint32_t &a, uint32_t b, uint32_t c, uint32_t d,
+				uint32_t x, int s) {
+			a = std::rotl(a + fn(b, c, d) + x, s);
+		};
+
+		round(f, a, b, c, d, in[0], 3);
+		round(f, d, a, b, c, in[1], 7);
+		round(f, c, d, a, b, in[2], 11);
+		round(f, b, c, d, a, in[3], 19);
+		round(f, a, b, c, d, in[4], 3);
+		round(f, d, a, b, c, in[5], 7);
+		round(f, c, d, a, b, in[6], 11);
+		round(f, b, c, d, a, in[7], 19);
+
+		round(g, a, b, c, d, in[1] + k2, 3);
+		round(g, d, a, b, c, in[3] + k2, 5);
+		round(g, c, d, a, b, in[5] + k2, 9);
+		round(g, b, c, d, a, in[7] + k2, 13);
+		round(g, a, b, c, d, in[0] + k2, 3);
+		round(g, d, a, b, c, in[2] + k2, 5);
+		round(g, c, d, a, b, in[4] + k2, 9);
+		round(g, b, c, d, a, in[6] + k2, 13);
+
+		round(h, a, b, c, d, in[3] + k3, 3);
+		round(h, d, a, b, c, in[7] + k3, 9);
+		round(h, c, d, a, b, in[2] + k3, 11);
+		round(h, b, c, d, a, in[6] + k3, 15);
+		round(h, a, b, c, d, in[1] + k3, 3);
+		round(h, d, a, b, c, in[5] + k3, 9);
+		round(h, c, d, a, b, in[0] + k3, 11);
+		round(h, b, c, d, a, in[4] + k3, 15);
+
+		buf[0] += a;
+		buf[1] += b;
+		buf[2] += c;
+		buf[3] += d;
+	}
+
+	void teaTransform(uint32_t buf[4], const uint32_t in[4]) {
+		uint32_t sum = 0;
+		uint32_t b0 = buf[0], b1 = buf[1];
+		uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+
+		for(int n = 0; n < 16; n++) {
+			sum += 0x9E3779B9;
+			b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+			b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+		}
+
+		buf[0] += b0;
+		buf[1] += b1;
+	}
+
+	// Computes the (major) htree hash of a name.
+	uint32_t dirHash(int version, const uint32_t seed[4], const char *name, size_t len) {
+		uint32_t buf[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+		if(seed[0] || seed[1] || seed[2] || seed[3])
+			memcpy(buf, seed, sizeof(buf));
+
+		uint32_t in[8];
+		uint32_t hash;
+		switch(version) {
+		case EXT2_DX_HASH_LEGACY:
+		case EXT2_DX_HASH_LEGACY_UNSIGNED:
+			hash = dxHackHash(name, len, version == EXT2_DX_HASH_LEGACY_UNSIGNED);
+			break;
+		case EXT2_DX_HASH_HALF_MD4:
+		case EXT2_DX_HASH_HALF_MD4_UNSIGNED:
+			for(size_t i = 0; i < len; i += 32) {
+				strToHashBuf(name + i, len - i, in, 8, version == EXT2_DX_HASH_HALF_MD4_UNSIGNED);
+				halfMd4Transform(buf, in);
+			}
+			hash = buf[1];
+			break;
+		case EXT2_DX_HASH_TEA:
+		case EXT2_DX_HASH_TEA_UNSIGNED:
+			for(size_t i = 0; i < len; i += 16) {
+				strToHashBuf(name + i, len - i, in, 4, version == EXT2_DX_HASH_TEA_UNSIGNED);
+				teaTransform(buf, in);
+			}
+			hash = buf[0];
+			break;
+		default:
+			assert(!"unexpected hash version");
+			abort();
+		}
+
+		// The lowest bit is used to mark hash collisions that continue into the next block.
+		hash &= ~uint32_t{1};
+		if(hash == (uint32_t{0x7FFFFFFF} << 1))
+			hash = uint32_t{0x7FFFFFFE} << 1;
+		return hash;
+	}
 }
 
 // --------------------------------------------------------
@@ -31,9 +266,46 @@ namespace {
 Inode::Inode(FileSystem &fs, uint32_t number)
 : fs(fs), number(number), isReady(false) { }
 
+Inode::~Inode() {
+	if(readWindow.get())
+		fs.evictReadWindow(this);
+}
+
 void Inode::setFileSize(size_t size) {
-	assert(!(size & ~uint64_t(0xFFFFFFFF)));
+	for(auto &page : cacheHeaders)
+		page.header()->seq.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
 	diskInode()->size = size;
+	if((diskInode()->mode & EXT2_S_IFMT) == EXT2_S_IFREG) {
+		diskInode()->sizeHigh = size >> 32;
+	}else{
+		assert(!(size & ~uint64_t(0xFFFFFFFF)));
+	}
+
+	for(auto &page : cacheHeaders) {
+		page.header()->fileSize.store(size, std::memory_order_relaxed);
+		page.header()->seq.fetch_add(1, std::memory_order_release);
+	}
+}
+
+async::result<void> Inode::waitForCacheReaders() {
+	// Pairs with the fence in CachedReader::pread(): readers that start after this point
+	// observe the size that was published by setFileSize().
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for(int i = 0; i < cacheReaderPolls; i++) {
+		// Headers can come and go while we sleep, so walk the list from scratch.
+		bool anyReaders = false;
+		for(auto &page : cacheHeaders) {
+			if(page.header()->readers.load(std::memory_order_acquire))
+				anyReaders = true;
+		}
+		if(!anyReaders)
+			co_return;
+		co_await helix::sleepFor(cacheReaderPollInterval);
+	}
+	std::cout << "\e[31m" "ext2fs: Clients still read the page cache of inode " << number
+			<< ", shrinking it anyway" "\e[39m" << std::endl;
 }
 
 async::result<frg::expected<protocols::fs::Error, std::optional<DirEntry>>>
@@ -52,6 +324,22 @@ Inode::findEntry(std::string name) {
 	co_await submit.async_wait();
 	HEL_CHECK(lock_memory.error());
 
+	// Indexed directories are searched by hash; this only touches one block per level.
+	std::optional<DirEntry> indexedEntry;
+	if(isIndexedDirectory() && lookupIndexed(name, indexedEntry))
+		co_return indexedEntry;
+
+	// Large directories without an index are searched through an in-memory hash table.
+	if(fileSize() >= nameIndexThreshold) {
+		if(!nameIndexValid)
+			buildNameIndex();
+
+		auto it = nameIndex.find(name);
+		if(it == nameIndex.end())
+			co_return std::nullopt;
+		co_return it->second;
+	}
+
 	// Read the directory structure.
 	uintptr_t offset = 0;
 	while(offset < fileSize()) {
@@ -63,29 +351,129 @@ Inode::findEntry(std::string name) {
 
 		if(disk_entry->inode
 				&& name.length() == disk_entry->nameLength
-				&& !memcmp(disk_entry->name, name.data(), name.length())) {
-			DirEntry entry;
-			entry.inode = disk_entry->inode;
+				&& !memcmp(disk_entry->name, name.data(), name.length()))
+			co_return toDirEntry(disk_entry);
 
-			switch(disk_entry->fileType) {
-			case EXT2_FT_REG_FILE:
-				entry.fileType = kTypeRegular; break;
-			case EXT2_FT_DIR:
-				entry.fileType = kTypeDirectory; break;
-			case EXT2_FT_SYMLINK:
-				entry.fileType = kTypeSymlink; break;
-			default:
-				entry.fileType = kTypeNone;
+		offset += disk_entry->recordLength;
+	}
+	assert(offset == fileSize());
+
+	co_return std::nullopt;
+}
+
+bool Inode::isIndexedDirectory() {
+	return fs.dirIndex && (diskInode()->flags & EXT2_INDEX_FL)
+			&& fileSize() >= fs.blockSize;
+}
+
+// Looks up a name through the htree index of this directory.
+// Returns false if the index cannot be used (in which case the caller falls back
+// to a linear search); otherwise, entry is set to the result of the lookup.
+bool Inode::lookupIndexed(const std::string &name, std::optional<DirEntry> &entry) {
+	auto base = reinterpret_cast<const char *>(fileMapping.get());
+	size_t numBlocks = fileSize() >> fs.blockShift;
+
+	// The root block starts with the "." (12 bytes) and ".." (12 bytes) entries.
+	auto info = reinterpret_cast<const DxRootInfo *>(base + 24);
+	if(info->reservedZero || info->infoLength != sizeof(DxRootInfo)
+			|| info->indirectLevels > 2 || info->hashVersion > EXT2_DX_HASH_TEA)
+		return false;
+
+	int version = info->hashVersion;
+	if(fs.unsignedHash)
+		version += EXT2_DX_HASH_LEGACY_UNSIGNED;
+	auto hash = dirHash(version, fs.hashSeed, name.data(), name.length());
+
+	struct Frame {
+		const DxEntry *entries;
+		unsigned int count;
+		unsigned int at;
+	};
+
+	// Reads the index node at ptr and finds the last entry whose hash is <= hash.
+	auto probe = [&] (const char *ptr, Frame &frame) -> bool {
+		auto countLimit = reinterpret_cast<const DxCountLimit *>(ptr);
+		if(!countLimit->count || countLimit->count > countLimit->limit)
+			return false;
+
+		// The first entry has no hash; it stores the DxCountLimit instead.
+		auto entries = reinterpret_cast<const DxEntry *>(ptr);
+		unsigned int lo = 1, hi = countLimit->count;
+		while(lo < hi) {
+			auto mid = lo + (hi - lo) / 2;
+			if(entries[mid].hash > hash) {
+				hi = mid;
+			}else{
+				lo = mid + 1;
 			}
+		}
+
+		frame = Frame{entries, countLimit->count, lo - 1};
+		return (entries[lo - 1].block & 0x0FFFFFFF) < numBlocks;
+	};
 
-			co_return entry;
+	// Interior nodes start with a fake directory entry that spans the whole block.
+	auto nodeOf = [&] (const Frame &frame) {
+		return base + ((frame.entries[frame.at].block & 0x0FFFFFFF) << fs.blockShift) + 8;
+	};
+
+	unsigned int levels = info->indirectLevels + 1;
+	std::array<Frame, 3> path;
+	if(!probe(base + 24 + info->infoLength, path[0]))
+		return false;
+	for(unsigned int i = 1; i < levels; i++) {
+		if(!probe(nodeOf(path[i - 1]), path[i]))
+			return false;
+	}
+
+	while(true) {
+		auto &leaf = path[levels - 1];
+		auto block = leaf.entries[leaf.at].block & 0x0FFFFFFF;
+		auto diskEntry = scanDirBlock(base + (block << fs.blockShift), fs.blockSize, name);
+		if(diskEntry) {
+			entry = toDirEntry(diskEntry);
+			return true;
 		}
 
+		// Names with the same hash can continue into the next leaf.
+		// In that case, the next leaf's hash has the low bit set.
+		int i = levels - 1;
+		while(i >= 0 && path[i].at + 1 >= path[i].count)
+			i--;
+		if(i < 0 || (path[i].entries[path[i].at + 1].hash & ~uint32_t{1}) != hash) {
+			entry = std::nullopt;
+			return true;
+		}
+
+		path[i].at++;
+		for(unsigned int j = i + 1; j < levels; j++) {
+			auto countLimit = reinterpret_cast<const DxCountLimit *>(nodeOf(path[j - 1]));
+			if(!countLimit->count)
+				return false;
+			path[j] = Frame{reinterpret_cast<const DxEntry *>(countLimit),
+					countLimit->count, 0};
+		}
+	}
+}
+
+void Inode::buildNameIndex() {
+	nameIndex.clear();
+
+	uintptr_t offset = 0;
+	while(offset < fileSize()) {
+		auto disk_entry = reinterpret_cast<DiskDirEntry *>(
+				reinterpret_cast<char *>(fileMapping.get()) + offset);
+		assert(disk_entry->recordLength);
+
+		if(disk_entry->inode)
+			nameIndex.emplace(std::string(disk_entry->name, disk_entry->nameLength),
+					toDirEntry(disk_entry));
+
 		offset += disk_entry->recordLength;
 	}
 	assert(offset == fileSize());
 
-	co_return std::nullopt;
+	nameIndexValid = true;
 }
 
 async::result<std::optional<DirEntry>>
@@ -122,6 +510,12 @@ Inode::link(std::string name, int64_t ino, blockfs::FileType type) {
 		}
 		memcpy(diskEntry->name, name.data(), name.length() + 1);
 
+		DirEntry entry;
+		entry.inode = ino;
+		entry.fileType = type;
+		if(nameIndexValid)
+			nameIndex.emplace(name, entry);
+
 		// Flush the data to disk.
 		// TODO: It would be enough to flush only one or two pages here.
 		auto syncDir = co_await helix_ng::synchronizeSpace(
@@ -139,9 +533,6 @@ Inode::link(std::string name, int64_t ino, blockfs::FileType type) {
 				target->diskMapping.get(), fs.inodeSize);
 		HEL_CHECK(syncInode.error());
 
-		DirEntry entry;
-		entry.inode = ino;
-		entry.fileType = type;
 		co_return entry;
 	};
 
@@ -153,6 +544,16 @@ Inode::link(std::string name, int64_t ino, blockfs::FileType type) {
 	co_await submit.async_wait();
 	HEL_CHECK(lock_memory.error());
 
+	// We do not maintain the htree index. Like Linux' ext2 driver, we drop the index
+	// before inserting entries; the index blocks remain valid (empty) directory blocks.
+	if(isIndexedDirectory()) {
+		diskInode()->flags &= ~EXT2_INDEX_FL;
+		auto syncInode = co_await helix_ng::synchronizeSpace(
+				helix::BorrowedDescriptor{kHelNullHandle},
+				diskMapping.get(), fs.inodeSize);
+		HEL_CHECK(syncInode.error());
+	}
+
 	// Space required for the new directory entry.
 	// We use name.size() + 1 for the entry name length to account for the null terminator
 	auto required = (sizeof(DiskDirEntry) + name.size() + 1 + 3) & ~size_t(3);
@@ -186,8 +587,9 @@ Inode::link(std::string name, int64_t ino, blockfs::FileType type) {
 	// If we made it this far, we ran out of space in the directory. Resize it.
 	auto blockOffset = (offset & ~(fs.blockSize - 1)) >> fs.blockShift;
 	auto newSize = (offset + fs.blockSize + 0xFFF) & ~size_t(0xFFF);
+	if(!co_await fs.assignDataBlocks(this, blockOffset, 1))
+		co_return std::nullopt;
 	setFileSize(newSize);
-	co_await fs.assignDataBlocks(this, blockOffset, 1);
 	HEL_CHECK(helResizeMemory(backingMemory, newSize));
 	fileMapping = helix::Mapping{helix::BorrowedDescriptor{frontalMemory},
 			0, newSize,
@@ -240,6 +642,8 @@ async::result<frg::expected<protocols::fs::Error>> Inode::unlink(std::string nam
 			// we can assume that a previous entry exists.
 			assert(previous_entry);
 			previous_entry->recordLength += disk_entry->recordLength;
+			if(nameIndexValid)
+				nameIndex.erase(name);
 
 			// Flush the data to disk.
 			// TODO: It would be enough to flush only one or two pages here.
@@ -275,7 +679,10 @@ async::result<std::optional<DirEntry>> Inode::mkdir(std::string name) {
 	auto dirNode = co_await fs.createDirectory();
 	co_await dirNode->readyJump.wait();
 
-	co_await fs.assignDataBlocks(dirNode.get(), 0, 1);
+	if(!co_await fs.assignDataBlocks(dirNode.get(), 0, 1)) {
+		co_await fs.releaseInode(dirNode.get());
+		co_return std::nullopt;
+	}
 
 	dirNode->setFileSize(fs.blockSize);
 	HEL_CHECK(helResizeMemory(dirNode->backingMemory,
@@ -333,7 +740,18 @@ async::result<std::optional<DirEntry>> Inode::mkdir(std::string name) {
 			dirNode->fileMapping.get(), dirNode->fileSize());
 	HEL_CHECK(syncInode.error());
 
-	co_return co_await link(name, dirNode->number, kTypeDirectory);
+	auto entry = co_await link(name, dirNode->number, kTypeDirectory);
+	if(!entry) {
+		// Drop the link that ".." added and give back the new directory.
+		diskInode()->linksCount--;
+		syncInode = co_await helix_ng::synchronizeSpace(
+				helix::BorrowedDescriptor{kHelNullHandle},
+				diskMapping.get(), fs.inodeSize);
+		HEL_CHECK(syncInode.error());
+
+		co_await fs.releaseInode(dirNode.get());
+	}
+	co_return entry;
 }
 
 async::result<std::optional<DirEntry>> Inode::symlink(std::string name, std::string target) {
@@ -403,11 +821,9 @@ FileSystem::FileSystem(BlockDevice *device)
 }
 
 async::result<void> FileSystem::init() {
-	std::vector<uint8_t> buffer(1024);
-	co_await device->readSectors(2, buffer.data(), 2);
+	co_await device->readSectors(2, &superblock, 2);
 
-	DiskSuperblock sb;
-	memcpy(&sb, buffer.data(), sizeof(DiskSuperblock));
+	auto &sb = superblock;
 	assert(sb.magic == 0xEF53);
 
 	inodeSize = sb.inodeSize;
@@ -419,7 +835,30 @@ async::result<void> FileSystem::init() {
 	inodesPerGroup = sb.inodesPerGroup;
 	blocksCount = sb.blocksCount;
 	inodesCount = sb.inodesCount;
+	firstDataBlock = sb.firstDataBlock;
 	numBlockGroups = (sb.blocksCount + (sb.blocksPerGroup - 1)) / sb.blocksPerGroup;
+	descSize = sizeof(DiskGroupDesc);
+	if(sb.featureIncompat & EXT2_FEATURE_INCOMPAT_64BIT) {
+		// We store block numbers in 32 bits.
+		assert(!sb.blocksCountHi && "ext2fs: File systems with more than 2^32 blocks are not supported");
+		assert(sb.descSize >= sizeof(DiskGroupDesc) + sizeof(DiskGroupDescHi));
+		assert(!(sb.descSize & (sb.descSize - 1)));
+		descSize = sb.descSize;
+	}
+	dirIndex = sb.featureCompat & EXT2_FEATURE_COMPAT_DIR_INDEX;
+	unsignedHash = sb.flags & EXT2_FLAGS_UNSIGNED_HASH;
+	memcpy(hashSeed, sb.hashSeed, sizeof(hashSeed));
+
+	// Writing a file system with features that we do not understand would corrupt it
+	// (e.g., checksums would not be updated). Serve such file systems read-only.
+	auto unsupportedIncompat = sb.featureIncompat & ~uint32_t{EXT2_FEATURE_INCOMPAT_WRITABLE};
+	auto unsupportedRoCompat = sb.featureRoCompat & ~uint32_t{EXT2_FEATURE_RO_COMPAT_WRITABLE};
+	if(unsupportedIncompat || unsupportedRoCompat) {
+		std::cout << "\e[31m" "ext2fs: Unsupported features (r/w-required: " << std::hex
+				<< unsupportedIncompat << ", w-required: " << unsupportedRoCompat << std::dec
+				<< "), file system is read-only" "\e[39m" << std::endl;
+		readOnly = true;
+	}
 
 	if(logSuperblock) {
 		std::cout << "ext2fs: Revision is: " << sb.revLevel << std::endl;
@@ -436,8 +875,8 @@ async::result<void> FileSystem::init() {
 		std::cout << "ext2fs:     Inodes per group: " << inodesPerGroup << std::endl;
 	}
 
-	blockGroupDescriptorBuffer.resize((numBlockGroups * sizeof(DiskGroupDesc) + 511) & ~size_t(511));
-	bgdt = (DiskGroupDesc *)blockGroupDescriptorBuffer.data();
+	blockGroupDescriptorBuffer.resize((numBlockGroups * descSize + 511) & ~size_t(511));
+	blockAllocHints.resize(numBlockGroups, 0);
 
 	auto bgdt_offset = (2048 + blockSize - 1) & ~size_t(blockSize - 1);
 	co_await device->readSectors((bgdt_offset >> blockShift) * sectorsPerBlock,
@@ -478,7 +917,7 @@ async::detached FileSystem::manageBlockBitmap(helix::UniqueDescriptor memory) {
 		HEL_CHECK(manage.error());
 
 		auto bg_idx = manage.offset() >> blockPagesShift;
-		auto block = bgdt[bg_idx].blockBitmap;
+		auto block = blockBitmapOf(bg_idx);
 		assert(block);
 
 		assert(!(manage.offset() & ((1 << blockPagesShift) - 1))
@@ -515,7 +954,7 @@ async::detached FileSystem::manageInodeBitmap(helix::UniqueDescriptor memory) {
 		HEL_CHECK(manage.error());
 
 		auto bg_idx = manage.offset() >> blockPagesShift;
-		auto block = bgdt[bg_idx].inodeBitmap;
+		auto block = inodeBitmapOf(bg_idx);
 		assert(block);
 
 		assert(!(manage.offset() & ((1 << blockPagesShift) - 1))
@@ -557,7 +996,7 @@ async::detached FileSystem::manageInodeTable(helix::UniqueDescriptor memory) {
 		// TODO: Use shifts instead of division.
 		auto bg_idx = manage.offset() / (inodesPerGroup * inodeSize);
 		auto bg_offset = manage.offset() % (inodesPerGroup * inodeSize);
-		auto block = bgdt[bg_idx].inodeTable;
+		auto block = inodeTableOf(bg_idx);
 		assert(block);
 
 		if(manage.type() == kHelManageInitialize) {
@@ -629,6 +1068,8 @@ async::result<std::shared_ptr<Inode>> FileSystem::createRegular() {
 	disk_inode->ctime = time.tv_sec;
 	disk_inode->mtime = time.tv_sec;
 
+	co_await flushBgdt();
+
 	co_return accessInode(ino);
 }
 
@@ -665,8 +1106,8 @@ async::result<std::shared_ptr<Inode>> FileSystem::createDirectory() {
 
 	// update usedDirsCount in the respective bgdt for this inode
 	auto bg_idx = (ino - 1) / inodesPerGroup;
-	bgdt[bg_idx].usedDirsCount++;
-	co_await writebackBgdt();
+	groupDesc(bg_idx).usedDirsCount++;
+	co_await flushBgdt();
 
 	co_return accessInode(ino);
 }
@@ -702,17 +1143,19 @@ async::result<std::shared_ptr<Inode>> FileSystem::createSymlink() {
 	disk_inode->ctime = time.tv_sec;
 	disk_inode->mtime = time.tv_sec;
 
+	co_await flushBgdt();
+
 	co_return accessInode(ino);
 }
 
-async::result<void> FileSystem::write(Inode *inode, uint64_t offset,
+async::result<frg::expected<protocols::fs::Error>> FileSystem::write(Inode *inode, uint64_t offset,
 		const void *buffer, size_t length) {
 	co_await inode->readyJump.wait();
 
 	// Make sure that data blocks are allocated.
 	auto blockOffset = (offset & ~(blockSize - 1)) >> blockShift;
 	auto blockCount = ((offset & (blockSize - 1)) + length + (blockSize - 1)) >> blockShift;
-	co_await assignDataBlocks(inode, blockOffset, blockCount);
+	FRG_CO_TRY(co_await assignDataBlocks(inode, blockOffset, blockCount));
 
 	// Resize the file if necessary.
 	if(offset + length > inode->fileSize()) {
@@ -723,6 +1166,7 @@ async::result<void> FileSystem::write(Inode *inode, uint64_t offset,
 				helix::BorrowedDescriptor{kHelNullHandle},
 				inode->diskMapping.get(), inodeSize);
 		HEL_CHECK(syncInode.error());
+		co_await noteFileSize(offset + length);
 	}
 
 	// TODO: If we *know* that the pages are already available,
@@ -750,6 +1194,7 @@ async::result<void> FileSystem::write(Inode *inode, uint64_t offset,
 			helix::BorrowedDescriptor(inode->frontalMemory),
 			offset, length, buffer);
 	HEL_CHECK(writeMemory.error());
+	co_return {};
 }
 
 async::detached FileSystem::initiateInode(std::shared_ptr<Inode> inode) {
@@ -786,6 +1231,11 @@ async::detached FileSystem::initiateInode(std::shared_ptr<Inode> inode) {
 	inode->uid = disk_inode->uid;
 	inode->gid = disk_inode->gid;
 
+	// Extent trees are small compared to the data that they map; cache them up-front.
+	if(inode->usesExtents())
+		co_await loadExtents(inode.get(),
+				reinterpret_cast<const ExtentHeader *>(disk_inode->data.embedded));
+
 	// Allocate a page cache for the file.
 	auto cache_size = (inode->fileSize() + 0xFFF) & ~size_t(0xFFF);
 	HEL_CHECK(helCreateManagedMemory(cache_size, kHelManagedReadahead,
@@ -802,13 +1252,24 @@ async::detached FileSystem::initiateInode(std::shared_ptr<Inode> inode) {
 	HelHandle backingOrder1, backingOrder2;
 	HEL_CHECK(helCreateManagedMemory(3 << blockPagesShift,
 			0, &backingOrder1, &frontalOrder1));
-	HEL_CHECK(helCreateManagedMemory((blockSize / 4) << blockPagesShift,
+	HEL_CHECK(helCreateManagedMemory(2 * (blockSize / 4) << blockPagesShift,
 			0, &backingOrder2, &frontalOrder2));
 	inode->indirectOrder1 = helix::UniqueDescriptor{frontalOrder1};
 	inode->indirectOrder2 = helix::UniqueDescriptor{frontalOrder2};
 
 	manageIndirect(inode, 1, helix::UniqueDescriptor{backingOrder1});
 	manageIndirect(inode, 2, helix::UniqueDescriptor{backingOrder2});
+
+	// We never allocate triple indirect blocks, so only files that already have one need this.
+	if(inode->fileType != kTypeSymlink && !inode->usesExtents()
+			&& disk_inode->data.blocks.tripleIndirect) {
+		HelHandle frontalOrder3, backingOrder3;
+		HEL_CHECK(helCreateManagedMemory((blockSize / 4) * (blockSize / 4) << blockPagesShift,
+				0, &backingOrder3, &frontalOrder3));
+		inode->indirectOrder3 = helix::UniqueDescriptor{frontalOrder3};
+
+		manageIndirect(inode, 3, helix::UniqueDescriptor{backingOrder3});
+	}
 	manageFileData(inode);
 
 	inode->isReady = true;
@@ -824,37 +1285,46 @@ async::detached FileSystem::manageFileData(std::shared_ptr<Inode> inode) {
 		HEL_CHECK(manage.error());
 		assert(manage.offset() + manage.length() <= ((inode->fileSize() + 0xFFF) & ~size_t(0xFFF)));
 
-		if(manage.type() == kHelManageInitialize) {
-			helix::Mapping file_map{helix::BorrowedDescriptor{inode->backingMemory},
-					static_cast<ptrdiff_t>(manage.offset()), manage.length(), kHelMapProtWrite};
+		// The kernel issues readahead asynchronously; serve requests concurrently
+		// such that demand fetches do not queue up behind large readahead windows.
+		handleFileDataRequest(inode, manage.type(), manage.offset(), manage.length());
+	}
+}
 
-			assert(!(manage.offset() % inode->fs.blockSize));
-			size_t backed_size = std::min(manage.length(), inode->fileSize() - manage.offset());
-			size_t num_blocks = (backed_size + (inode->fs.blockSize - 1)) / inode->fs.blockSize;
+async::detached FileSystem::handleFileDataRequest(std::shared_ptr<Inode> inode,
+		int type, uintptr_t offset, size_t length) {
+	if(type == kHelManageInitialize) {
+		helix::Mapping file_map{helix::BorrowedDescriptor{inode->backingMemory},
+				static_cast<ptrdiff_t>(offset), length, kHelMapProtWrite};
 
-			assert(num_blocks * inode->fs.blockSize <= manage.length());
-			co_await inode->fs.readDataBlocks(inode, manage.offset() / inode->fs.blockSize,
-					num_blocks, file_map.get());
+		assert(!(offset % inode->fs.blockSize));
+		size_t backed_size = std::min(length, inode->fileSize() - offset);
+		size_t num_blocks = (backed_size + (inode->fs.blockSize - 1)) / inode->fs.blockSize;
 
-			HEL_CHECK(helUpdateMemory(inode->backingMemory, kHelManageInitialize,
-					manage.offset(), manage.length()));
-		}else{
-			assert(manage.type() == kHelManageWriteback);
+		assert(num_blocks * inode->fs.blockSize <= length);
+		co_await inode->fs.readDataBlocks(inode, offset / inode->fs.blockSize,
+				num_blocks, file_map.get());
+
+		HEL_CHECK(helUpdateMemory(inode->backingMemory, kHelManageInitialize,
+				offset, length));
+	}else{
+		assert(type == kHelManageWriteback);
 
-			helix::Mapping file_map{helix::BorrowedDescriptor{inode->backingMemory},
-					static_cast<ptrdiff_t>(manage.offset()), manage.length(), kHelMapProtRead};
+		helix::Mapping file_map{helix::BorrowedDescriptor{inode->backingMemory},
+				static_cast<ptrdiff_t>(offset), length, kHelMapProtRead};
 
-			assert(!(manage.offset() % inode->fs.blockSize));
-			size_t backed_size = std::min(manage.length(), inode->fileSize() - manage.offset());
-			size_t num_blocks = (backed_size + (inode->fs.blockSize - 1)) / inode->fs.blockSize;
+		assert(!(offset % inode->fs.blockSize));
+		size_t backed_size = std::min(length, inode->fileSize() - offset);
+		size_t num_blocks = (backed_size + (inode->fs.blockSize - 1)) / inode->fs.blockSize;
 
-			assert(num_blocks * inode->fs.blockSize <= manage.length());
-			co_await inode->fs.writeDataBlocks(inode, manage.offset() / inode->fs.blockSize,
+		assert(num_blocks * inode->fs.blockSize <= length);
+		// Pages can still be dirtied through writable mappings; never write them back.
+		if(!inode->fs.readOnly)
+			co_await inode->fs.writeDataBlocks(inode, offset / inode->fs.blockSize,
 					num_blocks, file_map.get());
 
-			HEL_CHECK(helUpdateMemory(inode->backingMemory, kHelManageWriteback,
-					manage.offset(), manage.length()));
-		}
+		HEL_CHECK(helUpdateMemory(inode->backingMemory, kHelManageWriteback,
+				offset, length));
 	}
 }
 
@@ -882,21 +1352,27 @@ async::detached FileSystem::manageIndirect(std::shared_ptr<Inode> inode,
 				abort();
 			}
 		}else{
-			assert(order == 2);
-
-			auto indirect_frame = element >> (blockShift - 2);
+			assert(order == 2 || order == 3);
+
+			// Order 2 elements are children of the double (frame 0) and triple (frame 1)
+			// indirect blocks. Order 3 elements are children of the order 2 elements
+			// that belong to the triple indirect block.
+			auto &parent = order == 2 ? inode->indirectOrder1 : inode->indirectOrder2;
+			size_t indirect_frame = (element >> (blockShift - 2))
+					+ (order == 2 ? 1 : blockSize / 4);
 			auto indirect_index = element & ((1 << (blockShift - 2)) - 1);
 
 			helix::LockMemoryView lock_indirect;
-			auto &&submit_indirect = helix::submitLockMemoryView(inode->indirectOrder1,
+			auto &&submit_indirect = helix::submitLockMemoryView(parent,
 					&lock_indirect,
-					(1 + indirect_frame) << blockPagesShift, 1 << blockPagesShift,
+					indirect_frame << blockPagesShift, 1 << blockPagesShift,
 					helix::Dispatcher::global());
 			co_await submit_indirect.async_wait();
 			HEL_CHECK(lock_indirect.error());
 
-			helix::Mapping indirect_map{inode->indirectOrder1,
-					(1 + indirect_frame) << blockPagesShift, size_t{1} << blockPagesShift,
+			helix::Mapping indirect_map{parent,
+					static_cast<ptrdiff_t>(indirect_frame << blockPagesShift),
+					size_t{1} << blockPagesShift,
 					kHelMapProtRead | kHelMapDontRequireBacking};
 			block = reinterpret_cast<uint32_t *>(indirect_map.get())[indirect_index];
 		}
@@ -927,8 +1403,17 @@ async::detached FileSystem::manageIndirect(std::shared_ptr<Inode> inode,
 	}
 }
 
-async::result<uint32_t> FileSystem::allocateBlock() {
-	for(uint32_t bg_idx = 0; bg_idx < numBlockGroups; bg_idx++) {
+// Allocates a run of up to count contiguous blocks. The search starts in the given block group
+// at the position where the previous allocation in that group ended.
+// Returns the first block and the length of the run; the length is zero if the disk is full.
+async::result<std::pair<uint32_t, size_t>> FileSystem::allocateBlocks(uint32_t group, size_t count) {
+	assert(count);
+
+	for(uint32_t i = 0; i < numBlockGroups; i++) {
+		auto bg_idx = (group + i) % numBlockGroups;
+		if(!groupDesc(bg_idx).freeBlocksCount)
+			continue;
+
 		helix::LockMemoryView lock_bitmap;
 		auto &&submit_bitmap = helix::submitLockMemoryView(blockBitmap,
 				&lock_bitmap,
@@ -940,33 +1425,83 @@ async::result<uint32_t> FileSystem::allocateBlock() {
 		helix::Mapping bitmap_map{blockBitmap,
 				bg_idx << blockPagesShift, size_t{1} << blockPagesShift,
 				kHelMapProtRead | kHelMapProtWrite | kHelMapDontRequireBacking};
-
-		auto words = reinterpret_cast<uint32_t *>(bitmap_map.get());
-		for(unsigned int i = 0; i < (blocksPerGroup + 31) / 32; i++) {
-			if(words[i] == 0xFFFFFFFF)
+		auto words = reinterpret_cast<uint64_t *>(bitmap_map.get());
+
+		// The last group can be smaller than the others.
+		size_t end = std::min(blocksPerGroup,
+				blocksCount - firstDataBlock - bg_idx * blocksPerGroup);
+		size_t hint = std::min<size_t>(blockAllocHints[bg_idx], end);
+
+		// Search from the hint to the end of the group, then wrap around.
+		auto bit = findClearBit(words, hint, end);
+		if(bit == end) {
+			bit = findClearBit(words, 0, hint);
+			if(bit == hint)
 				continue;
-			for(int j = 0; j < 32; j++) {
-				if(i * 32 + j >= blocksPerGroup)
-					break;
-				if(words[i] & (static_cast<uint32_t>(1) << j))
-					continue;
-				// TODO: Make sure we never return reserved blocks.
-				// TODO: Make sure we never return blocks higher than the max. block in the SB.
-				auto block = bg_idx * blocksPerGroup + i * 32 + j;
-				assert(block);
-				assert(block < blocksCount);
-				words[i] |= static_cast<uint32_t>(1) << j;
+		}
 
-				bgdt[bg_idx].freeBlocksCount--;
-				co_await writebackBgdt();
+		auto length = countClearBits(words, bit, std::min(end, bit + count));
+		assert(length);
+		setBits(words, bit, length, true);
 
-				co_return block;
-			}
-			assert(!"Failed to find zero-bit");
-		}
+		// TODO: Make sure we never return reserved blocks.
+		uint32_t block = firstDataBlock + bg_idx * blocksPerGroup + bit;
+		assert(block);
+		assert(block + length <= blocksCount);
+
+		blockAllocHints[bg_idx] = bit + length;
+		assert(groupDesc(bg_idx).freeBlocksCount >= length);
+		groupDesc(bg_idx).freeBlocksCount -= length;
+		bgdtDirty = true;
+
+		co_return std::pair<uint32_t, size_t>{block, length};
 	}
 
-	co_return 0;
+	co_return std::pair<uint32_t, size_t>{0, 0};
+}
+
+// Returns the next block of run, allocating a new run of up to wanted blocks if necessary.
+async::result<uint32_t> FileSystem::allocateFromRun(BlockRun &run, uint32_t group, size_t wanted) {
+	if(!run.remaining) {
+		auto [block, length] = co_await allocateBlocks(group, std::max(wanted, size_t{1}));
+		if(!length)
+			co_return 0;
+		run.next = block;
+		run.remaining = length;
+	}
+
+	run.remaining--;
+	co_return run.next++;
+}
+
+// Returns the blocks of a run that were not handed out to the bitmap.
+async::result<void> FileSystem::releaseRun(BlockRun &run) {
+	if(!run.remaining)
+		co_return;
+
+	auto bg_idx = (run.next - firstDataBlock) / blocksPerGroup;
+	auto bit = (run.next - firstDataBlock) % blocksPerGroup;
+
+	helix::LockMemoryView lock_bitmap;
+	auto &&submit_bitmap = helix::submitLockMemoryView(blockBitmap,
+			&lock_bitmap,
+			bg_idx << blockPagesShift, 1 << blockPagesShift,
+			helix::Dispatcher::global());
+	co_await submit_bitmap.async_wait();
+	HEL_CHECK(lock_bitmap.error());
+
+	helix::Mapping bitmap_map{blockBitmap,
+			bg_idx << blockPagesShift, size_t{1} << blockPagesShift,
+			kHelMapProtRead | kHelMapProtWrite | kHelMapDontRequireBacking};
+	setBits(reinterpret_cast<uint64_t *>(bitmap_map.get()), bit, run.remaining, false);
+
+	// Runs never cross block groups.
+	if(blockAllocHints[bg_idx] == bit + run.remaining)
+		blockAllocHints[bg_idx] = bit;
+	groupDesc(bg_idx).freeBlocksCount += run.remaining;
+	bgdtDirty = true;
+
+	run.remaining = 0;
 }
 
 async::result<uint32_t> FileSystem::allocateInode() {
@@ -1000,8 +1535,8 @@ async::result<uint32_t> FileSystem::allocateInode() {
 				assert(ino < inodesCount);
 				words[i] |= static_cast<uint32_t>(1) << j;
 
-				bgdt[bg_idx].freeInodesCount--;
-				co_await writebackBgdt();
+				groupDesc(bg_idx).freeInodesCount--;
+				bgdtDirty = true;
 
 				co_return ino;
 			}
@@ -1012,8 +1547,60 @@ async::result<uint32_t> FileSystem::allocateInode() {
 	co_return 0;
 }
 
-async::result<void> FileSystem::assignDataBlocks(Inode *inode,
+// Frees an inode that was never linked into a directory, including its direct blocks.
+async::result<void> FileSystem::releaseInode(Inode *inode) {
+	auto disk_inode = inode->diskInode();
+	assert(!inode->usesExtents());
+	assert(!disk_inode->data.blocks.singleIndirect);
+
+	for(auto &block : disk_inode->data.blocks.direct) {
+		if(!block)
+			continue;
+		BlockRun run{.next = block, .remaining = 1};
+		co_await releaseRun(run);
+		block = 0;
+	}
+
+	struct timespec time;
+	// TODO: Move to CLOCK_REALTIME when supported
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	disk_inode->linksCount = 0;
+	disk_inode->dtime = time.tv_sec;
+	auto syncInode = co_await helix_ng::synchronizeSpace(
+			helix::BorrowedDescriptor{kHelNullHandle},
+			inode->diskMapping.get(), inodeSize);
+	HEL_CHECK(syncInode.error());
+
+	auto bg_idx = (inode->number - 1) / inodesPerGroup;
+	auto bit = (inode->number - 1) % inodesPerGroup;
+
+	helix::LockMemoryView lock_bitmap;
+	auto &&submit_bitmap = helix::submitLockMemoryView(inodeBitmap,
+			&lock_bitmap,
+			bg_idx << blockPagesShift, 1 << blockPagesShift,
+			helix::Dispatcher::global());
+	co_await submit_bitmap.async_wait();
+	HEL_CHECK(lock_bitmap.error());
+
+	helix::Mapping bitmap_map{inodeBitmap,
+			bg_idx << blockPagesShift, size_t{1} << blockPagesShift,
+			kHelMapProtRead | kHelMapProtWrite | kHelMapDontRequireBacking};
+	auto words = reinterpret_cast<uint32_t *>(bitmap_map.get());
+	assert(words[bit / 32] & (static_cast<uint32_t>(1) << (bit % 32)));
+	words[bit / 32] &= ~(static_cast<uint32_t>(1) << (bit % 32));
+
+	groupDesc(bg_idx).freeInodesCount++;
+	if((disk_inode->mode & EXT2_S_IFMT) == EXT2_S_IFDIR)
+		groupDesc(bg_idx).usedDirsCount--;
+	bgdtDirty = true;
+	co_await flushBgdt();
+}
+
+async::result<frg::expected<protocols::fs::Error>> FileSystem::assignDataBlocks(Inode *inode,
 		uint64_t block_offset, size_t num_blocks) {
+	if(inode->usesExtents())
+		co_return co_await assignExtentBlocks(inode, block_offset, num_blocks);
+
 	size_t per_indirect = blockSize / 4;
 	size_t per_single = per_indirect;
 	size_t per_double = per_indirect * per_indirect;
@@ -1025,6 +1612,10 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 
 	auto disk_inode = inode->diskInode();
 
+	// Allocate blocks in contiguous runs, preferably in the inode's block group.
+	auto group = (inode->number - 1) / inodesPerGroup;
+	BlockRun run;
+
 	size_t prg = 0;
 	while(prg < num_blocks) {
 		if(block_offset + prg < i_range) {
@@ -1035,7 +1626,7 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 					prg++;
 					continue;
 				}
-				auto block = co_await allocateBlock();
+				auto block = co_await allocateFromRun(run, group, num_blocks - prg);
 				assert(block && "Out of disk space"); // TODO: Fix this.
 				disk_inode->blocks += (blockSize / 512);
 				disk_inode->data.blocks.direct[idx] = block;
@@ -1046,7 +1637,7 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 
 			// Allocate the single-indirect block itself.
 			if(!disk_inode->data.blocks.singleIndirect) {
-				auto block = co_await allocateBlock();
+				auto block = co_await allocateFromRun(run, group, num_blocks - prg);
 				assert(block && "Out of disk space"); // TODO: Fix this.
 				disk_inode->blocks += (blockSize / 512);
 				disk_inode->data.blocks.singleIndirect = block;
@@ -1075,7 +1666,7 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 					prg++;
 					continue;
 				}
-				auto block = co_await allocateBlock();
+				auto block = co_await allocateFromRun(run, group, num_blocks - prg);
 				assert(block && "Out of disk space"); // TODO: Fix this.
 				disk_inode->blocks += (blockSize / 512);
 				window[idx] = block;
@@ -1084,7 +1675,7 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 		}else if(block_offset + prg < d_range) {
 			bool doubleNeedsReset = false;
 			if(!disk_inode->data.blocks.doubleIndirect) {
-				auto block = co_await allocateBlock();
+				auto block = co_await allocateFromRun(run, group, num_blocks - prg);
 				assert(block && "Out of disk space"); // TODO: Fix this.
 				disk_inode->blocks += (blockSize / 512);
 				disk_inode->data.blocks.doubleIndirect = block;
@@ -1114,7 +1705,7 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 				bool needsReset = false;
 				if(!double_window[indirect_frame]) {
 					// Allocate the single indirect block.
-					auto block = co_await allocateBlock();
+					auto block = co_await allocateFromRun(run, group, num_blocks - prg);
 					assert(block && "Out of disk space"); // TODO: Fix this.
 					disk_inode->blocks += (blockSize / 512);
 					double_window[indirect_frame] = block;
@@ -1141,7 +1732,7 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 					continue;
 				}
 
-				auto block = co_await allocateBlock();
+				auto block = co_await allocateFromRun(run, group, num_blocks - prg);
 				assert(block && "Out of disk space"); // TODO: Fix this.
 				disk_inode->blocks += (blockSize / 512);
 				window[indirect_index] = block;
@@ -1152,10 +1743,181 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 		}
 	}
 
+	co_await releaseRun(run);
+	co_await flushBgdt();
+
 	auto syncInode = co_await helix_ng::synchronizeSpace(
 			helix::BorrowedDescriptor{kHelNullHandle},
 			inode->diskMapping.get(), inodeSize);
 	HEL_CHECK(syncInode.error());
+	co_return {};
+}
+
+// We only modify extent trees that consist of the root node in the inode; writes that
+// would require splitting nodes or converting unwritten extents fail with an error.
+// In that case, all blocks that were allocated remain mapped by the tree.
+async::result<frg::expected<protocols::fs::Error>> FileSystem::assignExtentBlocks(Inode *inode,
+		uint64_t block_offset, size_t num_blocks) {
+	auto disk_inode = inode->diskInode();
+	auto &extents = inode->extents;
+	auto group = (inode->number - 1) / inodesPerGroup;
+	auto root = reinterpret_cast<ExtentHeader *>(disk_inode->data.embedded);
+	assert(root->magic == EXT4_EXTENT_MAGIC);
+
+	// Check for the unsupported cases before we allocate anything.
+	for(size_t prg = 0; prg < num_blocks; ) {
+		auto [block, n] = mapExtent(inode, block_offset + prg, num_blocks - prg);
+		if(!block) {
+			auto it = std::upper_bound(extents.begin(), extents.end(), block_offset + prg,
+					[] (uint64_t index, const Inode::CachedExtent &extent) {
+				return index < extent.logical;
+			});
+			if(it != extents.begin()) {
+				auto &prev = *std::prev(it);
+				if(block_offset + prg < uint64_t{prev.logical} + prev.length) {
+					std::cout << "\e[31m" "ext2fs: Writes to unwritten extents are not supported"
+							"\e[39m" << std::endl;
+					co_return protocols::fs::Error::illegalOperationTarget;
+				}
+			}
+			if(root->depth) {
+				std::cout << "\e[31m" "ext2fs: Allocation in extent trees of depth > 0"
+						" is not supported" "\e[39m" << std::endl;
+				co_return protocols::fs::Error::illegalOperationTarget;
+			}
+		}
+		prg += n;
+	}
+
+	BlockRun run;
+	bool changed = false;
+	bool full = false;
+	for(size_t prg = 0; prg < num_blocks; prg++) {
+		uint32_t index = block_offset + prg;
+		auto it = std::upper_bound(extents.begin(), extents.end(), index,
+				[] (uint32_t index, const Inode::CachedExtent &extent) {
+			return index < extent.logical;
+		});
+
+		if(it != extents.begin()) {
+			auto &prev = *std::prev(it);
+			if(index < uint64_t{prev.logical} + prev.length)
+				continue;
+		}
+
+		auto block = co_await allocateFromRun(run, group, num_blocks - prg);
+		assert(block && "Out of disk space"); // TODO: Fix this.
+
+		// Grow the previous extent if the new block is contiguous to it.
+		if(it != extents.begin()) {
+			auto &prev = *std::prev(it);
+			if(!prev.unwritten
+					&& prev.logical + prev.length == index
+					&& prev.physical + prev.length == block
+					&& prev.length < EXT4_EXTENT_MAX_INIT_LENGTH) {
+				disk_inode->blocks += (blockSize / 512);
+				changed = true;
+				prev.length++;
+				continue;
+			}
+		}
+
+		// The root node has no room for another extent. Return the block to the run
+		// (it was the last one that the run handed out) such that releaseRun() frees it.
+		if(extents.size() >= root->max) {
+			assert(block + 1 == run.next);
+			run.next--;
+			run.remaining++;
+			full = true;
+			break;
+		}
+
+		disk_inode->blocks += (blockSize / 512);
+		changed = true;
+		extents.insert(it, Inode::CachedExtent{index, 1, block, false});
+	}
+
+	co_await releaseRun(run);
+	co_await flushBgdt();
+
+	if(changed) {
+		// Write the extents back to the inode.
+		auto leaves = reinterpret_cast<Extent *>(root + 1);
+		for(size_t i = 0; i < extents.size(); i++) {
+			auto &extent = extents[i];
+			leaves[i].block = extent.logical;
+			leaves[i].length = extent.unwritten
+					? extent.length + EXT4_EXTENT_MAX_INIT_LENGTH : extent.length;
+			leaves[i].startHi = extent.physical >> 32;
+			leaves[i].startLo = extent.physical;
+		}
+		root->entries = extents.size();
+	}
+
+	auto syncInode = co_await helix_ng::synchronizeSpace(
+			helix::BorrowedDescriptor{kHelNullHandle},
+			inode->diskMapping.get(), inodeSize);
+	HEL_CHECK(syncInode.error());
+
+	if(full) {
+		std::cout << "\e[31m" "ext2fs: Splitting extent tree nodes is not supported"
+				"\e[39m" << std::endl;
+		co_return protocols::fs::Error::noSpaceLeft;
+	}
+	co_return {};
+}
+
+async::result<void> FileSystem::loadExtents(Inode *inode, const ExtentHeader *node) {
+	assert(node->magic == EXT4_EXTENT_MAGIC);
+
+	if(!node->depth) {
+		auto leaves = reinterpret_cast<const Extent *>(node + 1);
+		for(unsigned int i = 0; i < node->entries; i++) {
+			auto &extent = leaves[i];
+			bool unwritten = extent.length > EXT4_EXTENT_MAX_INIT_LENGTH;
+			inode->extents.push_back(Inode::CachedExtent{
+				extent.block,
+				unwritten ? extent.length - EXT4_EXTENT_MAX_INIT_LENGTH : extent.length,
+				(static_cast<uint64_t>(extent.startHi) << 32) | extent.startLo,
+				unwritten
+			});
+		}
+		co_return;
+	}
+
+	// Interior nodes are only read once, so we do not bother caching them.
+	auto indices = reinterpret_cast<const ExtentIdx *>(node + 1);
+	std::vector<std::byte> buffer(blockSize);
+	for(unsigned int i = 0; i < node->entries; i++) {
+		auto block = (static_cast<uint64_t>(indices[i].leafHi) << 32) | indices[i].leafLo;
+		co_await device->readSectors(block * sectorsPerBlock, buffer.data(), sectorsPerBlock);
+		co_await loadExtents(inode, reinterpret_cast<const ExtentHeader *>(buffer.data()));
+	}
+}
+
+// Returns the physical block and the number of consecutive blocks that are mapped
+// starting at the given logical block. Holes and unwritten extents map to block zero.
+std::pair<size_t, size_t> FileSystem::mapExtent(Inode *inode, uint64_t index, size_t remaining) {
+	auto &extents = inode->extents;
+	auto it = std::upper_bound(extents.begin(), extents.end(), index,
+			[] (uint64_t index, const Inode::CachedExtent &extent) {
+		return index < extent.logical;
+	});
+
+	if(it != extents.begin()) {
+		auto &prev = *std::prev(it);
+		uint64_t end = uint64_t{prev.logical} + prev.length;
+		if(index < end) {
+			auto n = std::min(remaining, static_cast<size_t>(end - index));
+			if(prev.unwritten)
+				return {0, n};
+			return {prev.physical + (index - prev.logical), n};
+		}
+	}
+
+	if(it == extents.end())
+		return {0, remaining};
+	return {0, std::min(remaining, static_cast<size_t>(it->logical - index))};
 }
 
 async::result<void> FileSystem::readDataBlocks(std::shared_ptr<Inode> inode,
@@ -1180,6 +1942,7 @@ async::result<void> FileSystem::readDataBlocks(std::shared_ptr<Inode> inode,
 	size_t i_range = 12; // Direct blocks only.
 	size_t s_range = i_range + per_single; // Plus the first single indirect block.
 	size_t d_range = s_range + per_double; // Plus the first double indirect block.
+	size_t t_range = d_range + per_double * per_indirect; // Plus the triple indirect block.
 
 	co_await inode->readyJump.wait();
 	// TODO: Assert that we do not read past the EOF.
@@ -1197,23 +1960,27 @@ async::result<void> FileSystem::readDataBlocks(std::shared_ptr<Inode> inode,
 //		std::cout << "Reading " << index << "-th block from inode " << inode->number
 //				<< " (" << progress << "/" << num_blocks << " in request)" << std::endl;
 
-		assert(index < d_range);
-		if(index >= d_range) {
-			assert(!"Fix triple indirect blocks");
-		}else if(index >= s_range) { // Use the double indirect block.
+		if(inode->usesExtents()) {
+			issue = mapExtent(inode.get(), index, num_blocks - progress);
+		}else if(index >= s_range) { // Use the double or triple indirect block.
+			assert(index < t_range);
 			auto remaining = num_blocks - progress;
-			int64_t indirect_frame = (index - s_range) >> (blockShift - 2);
-			int64_t indirect_index = (index - s_range) & ((1 << (blockShift - 2)) - 1);
+			// The last level of both double and triple indirect blocks is cached in
+			// indirectOrder2 and indirectOrder3, respectively.
+			auto &memory = index >= d_range ? inode->indirectOrder3 : inode->indirectOrder2;
+			auto base = index >= d_range ? d_range : s_range;
+			int64_t indirect_frame = (index - base) >> (blockShift - 2);
+			int64_t indirect_index = (index - base) & ((1 << (blockShift - 2)) - 1);
 
 			if (remaining > indirectBufferSize) {
 				helix::LockMemoryView lock_indirect;
-				auto &&submit = helix::submitLockMemoryView(inode->indirectOrder2, &lock_indirect,
+				auto &&submit = helix::submitLockMemoryView(memory, &lock_indirect,
 						indirect_frame << blockPagesShift, 1 << blockPagesShift,
 						helix::Dispatcher::global());
 				co_await submit.async_wait();
 				HEL_CHECK(lock_indirect.error());
 
-				helix::Mapping indirect_map{inode->indirectOrder2,
+				helix::Mapping indirect_map{memory,
 						indirect_frame << blockPagesShift, size_t{1} << blockPagesShift,
 						kHelMapProtRead | kHelMapDontRequireBacking};
 
@@ -1222,7 +1989,7 @@ async::result<void> FileSystem::readDataBlocks(std::shared_ptr<Inode> inode,
 						per_indirect - indirect_index);
 			} else {
 				auto readMemory = co_await helix_ng::readMemory(
-						helix::BorrowedDescriptor{inode->indirectOrder2},
+						helix::BorrowedDescriptor{memory},
 						(indirect_frame << blockPagesShift) + indirect_index * 4,
 						remaining * 4, indirectBuffer.data());
 				HEL_CHECK(readMemory.error());
@@ -1301,6 +2068,7 @@ async::result<void> FileSystem::writeDataBlocks(std::shared_ptr<Inode> inode,
 	size_t i_range = 12; // Direct blocks only.
 	size_t s_range = i_range + per_single; // Plus the first single indirect block.
 	size_t d_range = s_range + per_double; // Plus the first double indirect block.
+	size_t t_range = d_range + per_double * per_indirect; // Plus the triple indirect block.
 
 	co_await inode->readyJump.wait();
 	// TODO: Assert that we do not write past the EOF.
@@ -1314,28 +2082,29 @@ async::result<void> FileSystem::writeDataBlocks(std::shared_ptr<Inode> inode,
 //		std::cout << "Write " << index << "-th block to inode " << inode->number
 //				<< " (" << progress << "/" << num_blocks << " in request)" << std::endl;
 
-		assert(index < d_range);
-		if(index >= d_range) {
-			assert(!"Fix triple indirect blocks");
-		}else if(index >= s_range) { // Use the double indirect block.
-			// TODO: Use shift/and instead of div/mod.
-			int64_t indirect_frame = (index - s_range) >> (blockShift - 2);
-			int64_t indirect_index = (index - s_range) & ((1 << (blockShift - 2)) - 1);
+		if(inode->usesExtents()) {
+			issue = mapExtent(inode.get(), index, num_blocks - progress);
+		}else if(index >= s_range) { // Use the double or triple indirect block.
+			assert(index < t_range);
+			auto &memory = index >= d_range ? inode->indirectOrder3 : inode->indirectOrder2;
+			auto base = index >= d_range ? d_range : s_range;
+			int64_t indirect_frame = (index - base) >> (blockShift - 2);
+			int64_t indirect_index = (index - base) & ((1 << (blockShift - 2)) - 1);
 
 			helix::LockMemoryView lock_indirect;
-			auto &&submit = helix::submitLockMemoryView(inode->indirectOrder2, &lock_indirect,
+			auto &&submit = helix::submitLockMemoryView(memory, &lock_indirect,
 					indirect_frame << blockPagesShift, 1 << blockPagesShift,
 					helix::Dispatcher::global());
 			co_await submit.async_wait();
 			HEL_CHECK(lock_indirect.error());
 
-			helix::Mapping indirect_map{inode->indirectOrder2,
+			helix::Mapping indirect_map{memory,
 					indirect_frame << blockPagesShift, size_t{1} << blockPagesShift,
 					kHelMapProtRead | kHelMapDontRequireBacking};
 
 			issue = fuse(indirect_index, num_blocks - progress,
 					reinterpret_cast<uint32_t *>(indirect_map.get()), per_indirect);
-		}else if(index >= i_range) { // Use the triple indirect block.
+		}else if(index >= i_range) { // Use the single indirect block.
 			helix::LockMemoryView lock_indirect;
 			auto &&submit = helix::submitLockMemoryView(inode->indirectOrder1,
 					&lock_indirect, 0, 1 << blockPagesShift,
@@ -1358,7 +2127,19 @@ async::result<void> FileSystem::writeDataBlocks(std::shared_ptr<Inode> inode,
 //		std::cout << "Issuing write of " << issue.second
 //				<< " blocks, starting at " << issue.first << std::endl;
 
-		assert(issue.first);
+		// Pages can be dirtied through mappings of holes or unwritten extents.
+		// Allocate blocks for them now; afterwards, we map the same range again.
+		if(!issue.first) {
+			if(co_await assignDataBlocks(inode.get(), index, issue.second))
+				continue;
+
+			// The file system is full or the extent tree cannot be modified.
+			std::cout << "\e[31m" "ext2fs: Failed to allocate blocks for writeback of "
+					<< issue.second << " blocks of inode " << inode->number
+					<< ", data is lost" "\e[39m" << std::endl;
+			progress += issue.second;
+			continue;
+		}
 		co_await device->writeSectors(issue.first * sectorsPerBlock,
 				(const uint8_t *)buffer + progress * blockSize,
 				issue.second * sectorsPerBlock);
@@ -1368,14 +2149,163 @@ async::result<void> FileSystem::writeDataBlocks(std::shared_ptr<Inode> inode,
 
 
 async::result<void> FileSystem::truncate(Inode *inode, size_t size) {
-	HEL_CHECK(helResizeMemory(inode->backingMemory,
-			(size + 0xFFF) & ~size_t(0xFFF)));
-	inode->setFileSize(size);
+	// Do not keep pages beyond the new end of the file locked.
+	if(inode->readWindow.get())
+		evictReadWindow(inode);
+
+	// Clients that read the page cache directly must observe a smaller size
+	// before the memory shrinks but a larger size only after it grows.
+	if(size < inode->fileSize()) {
+		inode->setFileSize(size);
+		co_await inode->waitForCacheReaders();
+		// The file may have grown again while we waited.
+		HEL_CHECK(helResizeMemory(inode->backingMemory,
+				(inode->fileSize() + 0xFFF) & ~size_t(0xFFF)));
+	}else{
+		HEL_CHECK(helResizeMemory(inode->backingMemory,
+				(size + 0xFFF) & ~size_t(0xFFF)));
+		inode->setFileSize(size);
+	}
 	auto syncInode = co_await helix_ng::synchronizeSpace(
 			helix::BorrowedDescriptor{kHelNullHandle},
 			inode->diskMapping.get(), inodeSize);
 	HEL_CHECK(syncInode.error());
-	co_return;
+	co_await noteFileSize(inode->fileSize());
+}
+
+async::result<size_t> FileSystem::readCached(Inode *inode, uint64_t offset,
+		void *buffer, size_t length) {
+	assert(length);
+
+	auto firstChunk = offset >> readChunkShift;
+	size_t lastChunk;
+
+	// Every suspension point below restarts the loop: the file may have been truncated
+	// (and the window unmapped) or chunks may have been evicted in the meantime.
+	while(true) {
+		auto fileSize = inode->fileSize();
+		if(offset >= fileSize)
+			co_return 0;
+		length = std::min(length, static_cast<size_t>(fileSize - offset));
+		lastChunk = (offset + length - 1) >> readChunkShift;
+
+		// (Re-)map the window if the file grew; chunks that are already locked stay locked.
+		auto viewSize = (fileSize + 0xFFF) & ~size_t(0xFFF);
+		if(inode->readWindow.size() < viewSize) {
+			inode->readWindow = helix::Mapping{helix::BorrowedDescriptor{inode->frontalMemory},
+					0, viewSize,
+					kHelMapProtRead | kHelMapDontRequireBacking};
+			inode->readChunks.resize((viewSize + readChunkSize - 1) >> readChunkShift);
+		}
+
+		// Only pages that are not locked yet require a kernel call.
+		std::optional<size_t> missing;
+		for(auto i = firstChunk; i <= lastChunk; i++) {
+			auto chunkOffset = i << readChunkShift;
+			if(inode->readChunks[i].size < std::min(readChunkSize, viewSize - chunkOffset)) {
+				missing = i;
+				break;
+			}
+		}
+		if(!missing)
+			break;
+
+		auto seq = inode->readWindowSeq;
+		auto chunkOffset = *missing << readChunkShift;
+		auto chunkSize = std::min(readChunkSize, viewSize - chunkOffset);
+
+		helix::LockMemoryView lockMemory;
+		auto &&submit = helix::submitLockMemoryView(
+				helix::BorrowedDescriptor{inode->frontalMemory},
+				&lockMemory, chunkOffset, chunkSize, helix::Dispatcher::global());
+		co_await submit.async_wait();
+
+		// If the file was truncated, the lock may fail or the chunk may not exist anymore.
+		if(inode->readWindowSeq != seq || inode->fileSize() < fileSize)
+			continue;
+		HEL_CHECK(lockMemory.error());
+
+		auto &chunk = inode->readChunks[*missing];
+		if(chunk.size < chunkSize) {
+			readWindowLockedBytes += chunkSize - chunk.size;
+			chunk.lock = lockMemory.descriptor();
+			chunk.size = chunkSize;
+		}
+	}
+
+	// There is no suspension point below, hence no chunk can be evicted under our feet.
+	for(auto i = firstChunk; i <= lastChunk; i++) {
+		auto &chunk = inode->readChunks[i];
+		if(chunk.lru)
+			readChunkLru.erase(*chunk.lru);
+		readChunkLru.push_front({inode, i});
+		chunk.lru = readChunkLru.begin();
+	}
+
+	// Evict the least recently used chunks (of all inodes) to bound the amount of
+	// locked memory. Chunks of the current request are the most recently used ones.
+	while(readWindowLockedBytes > readWindowBudget) {
+		auto [victim, index] = readChunkLru.back();
+		if(victim == inode && index >= firstChunk && index <= lastChunk)
+			break;
+		evictReadChunk(victim, index);
+	}
+
+	memcpy(buffer, reinterpret_cast<char *>(inode->readWindow.get()) + offset, length);
+	co_return length;
+}
+
+void FileSystem::evictReadWindow(Inode *inode) {
+	for(size_t i = 0; i < inode->readChunks.size(); i++)
+		evictReadChunk(inode, i);
+	inode->readChunks.clear();
+	inode->readWindow = helix::Mapping{};
+	inode->readWindowSeq++;
+}
+
+void FileSystem::evictReadChunk(Inode *inode, size_t index) {
+	auto &chunk = inode->readChunks[index];
+	if(chunk.lru) {
+		readChunkLru.erase(*chunk.lru);
+		chunk.lru = std::nullopt;
+	}
+	readWindowLockedBytes -= chunk.size;
+	chunk.lock = helix::UniqueDescriptor{};
+	chunk.size = 0;
+}
+
+async::result<frg::expected<protocols::fs::Error>> FileSystem::setupCacheHeader(OpenFile *file) {
+	auto inode = file->inode.get();
+	co_await inode->readyJump.wait();
+
+	if(inode->fileType != kTypeRegular)
+		co_return protocols::fs::Error::illegalOperationTarget;
+	if(file->cacheHeader)
+		co_return {};
+
+	HelHandle handle;
+	HEL_CHECK(helAllocateMemory(pageSize, 0, nullptr, &handle));
+	auto &page = inode->cacheHeaders.emplace_back();
+	page.memory = helix::UniqueDescriptor{handle};
+	page.mapping = helix::Mapping{page.memory,
+			0, pageSize,
+			kHelMapProtRead | kHelMapProtWrite};
+
+	auto header = new (page.mapping.get()) protocols::fs::CacheHeader{};
+	header->fileSize.store(inode->fileSize(), std::memory_order_relaxed);
+	header->seq.store(0, std::memory_order_release);
+	file->cacheHeader = std::prev(inode->cacheHeaders.end());
+	co_return {};
+}
+
+async::result<void> FileSystem::noteFileSize(uint64_t size) {
+	// Files of 2 GiB or more need the upper half of the size field.
+	if(size < (uint64_t{1} << 31))
+		co_return;
+	if(superblock.featureRoCompat & EXT2_FEATURE_RO_COMPAT_LARGE_FILE)
+		co_return;
+	superblock.featureRoCompat |= EXT2_FEATURE_RO_COMPAT_LARGE_FILE;
+	co_await device->writeSectors(2, &superblock, 2);
 }
 
 async::result<void> FileSystem::writebackBgdt() {
@@ -1384,6 +2314,13 @@ async::result<void> FileSystem::writebackBgdt() {
 			blockGroupDescriptorBuffer.data(), blockGroupDescriptorBuffer.size() / 512);
 }
 
+async::result<void> FileSystem::flushBgdt() {
+	if(!bgdtDirty)
+		co_return;
+	bgdtDirty = false;
+	co_await writebackBgdt();
+}
+
 // --------------------------------------------------------
 // OpenFile
 // --------------------------------------------------------
@@ -1391,6 +2328,11 @@ async::result<void> FileSystem::writebackBgdt() {
 OpenFile::OpenFile(std::shared_ptr<Inode> inode)
 : inode(inode), offset(0) { }
 
+OpenFile::~OpenFile() {
+	if(cacheHeader)
+		inode->cacheHeaders.erase(*cacheHeader);
+}
+
 async::result<std::optional<std::string>>
 OpenFile::readEntries() {
 	co_await inode->readyJump.wait();
@@ -1435,5 +2377,64 @@ OpenFile::readEntries() {
 	co_return std::nullopt;
 }
 
+async::result<protocols::fs::ReadResult>
+OpenFile::readEntriesBatch(void *buffer, size_t length) {
+	co_await inode->readyJump.wait();
+
+	if (inode->fileType != kTypeDirectory)
+		co_return protocols::fs::Error::notDirectory;
+
+	assert(offset <= inode->fileSize());
+	if(offset == inode->fileSize())
+		co_return size_t{0};
+
+	auto map_size = (inode->fileSize() + 0xFFF) & ~size_t(0xFFF);
+
+	helix::LockMemoryView lock_memory;
+	auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(inode->frontalMemory),
+			&lock_memory, 0, map_size, helix::Dispatcher::global());
+	co_await submit.async_wait();
+	HEL_CHECK(lock_memory.error());
+
+	// Map the page cache once and return as many entries as fit into the buffer.
+	helix::Mapping file_map{helix::BorrowedDescriptor{inode->frontalMemory},
+			0, map_size,
+			kHelMapProtRead | kHelMapDontRequireBacking};
+
+	protocols::fs::DirentWriter writer{buffer, length};
+	while(offset < inode->fileSize()) {
+		assert(!(offset & 3));
+		assert(offset + sizeof(DiskDirEntry) <= inode->fileSize());
+		auto disk_entry = reinterpret_cast<DiskDirEntry *>(
+				reinterpret_cast<char *>(file_map.get()) + offset);
+		assert(offset + disk_entry->recordLength <= inode->fileSize());
+
+		if(disk_entry->inode) {
+			uint8_t type;
+			switch(disk_entry->fileType) {
+			case EXT2_FT_REG_FILE: type = DT_REG; break;
+			case EXT2_FT_DIR: type = DT_DIR; break;
+			case EXT2_FT_SYMLINK: type = DT_LNK; break;
+			case EXT2_FT_CHRDEV: type = DT_CHR; break;
+			case EXT2_FT_BLKDEV: type = DT_BLK; break;
+			case EXT2_FT_FIFO: type = DT_FIFO; break;
+			case EXT2_FT_SOCK: type = DT_SOCK; break;
+			default: type = DT_UNKNOWN;
+			}
+
+			// Leave the entry for the next request if it does not fit.
+			if(!writer.append(disk_entry->inode, type,
+					{disk_entry->name, disk_entry->nameLength}))
+				break;
+		}
+
+		offset += disk_entry->recordLength;
+	}
+
+	if(!writer.size() && offset < inode->fileSize())
+		co_return protocols::fs::Error::illegalArguments;
+	co_return writer.size();
+}
+
 } } // namespace blockfs::ext2fs
 
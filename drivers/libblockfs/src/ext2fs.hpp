@@ -1,12 +1,14 @@
 
 #include <string.h>
 #include <time.h>
+#include <list>
 #include <optional>
 #include <memory>
 #include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include <protocols/fs/common.hpp>
 #include <protocols/fs/file-locks.hpp>
 
 #include <async/oneshot-event.hpp>
@@ -89,11 +91,20 @@ struct DiskSuperblock {
 	//-- Directory Indexing Support --
 	uint32_t hashSeed[4];
 	uint8_t defHashVersion;
-	uint8_t padding[3];
+	uint8_t jnlBackupType;
+	uint16_t descSize;
 	//-- Other options --
 	uint32_t defaultMountOptions;
 	uint32_t firstMetaBg;
-	uint8_t unused[760];
+	uint32_t mkfsTime;
+	uint32_t jnlBlocks[17];
+	uint32_t blocksCountHi;
+	uint32_t rBlocksCountHi;
+	uint32_t freeBlocksCountHi;
+	uint16_t minExtraIsize;
+	uint16_t wantExtraIsize;
+	uint32_t flags;
+	uint8_t unused[668];
 };
 static_assert(sizeof(DiskSuperblock) == 1024, "Bad DiskSuperblock struct size");
 
@@ -109,6 +120,23 @@ struct DiskGroupDesc {
 };
 static_assert(sizeof(DiskGroupDesc) == 32, "Bad DiskGroupDesc struct size");
 
+// Upper halves of the group descriptor fields.
+// They follow DiskGroupDesc if the file system has 64-bit group descriptors.
+struct DiskGroupDescHi {
+	uint32_t blockBitmapHi;
+	uint32_t inodeBitmapHi;
+	uint32_t inodeTableHi;
+	uint16_t freeBlocksCountHi;
+	uint16_t freeInodesCountHi;
+	uint16_t usedDirsCountHi;
+	uint16_t itableUnusedHi;
+	uint32_t excludeBitmapHi;
+	uint16_t blockBitmapCsumHi;
+	uint16_t inodeBitmapCsumHi;
+	uint32_t reserved;
+};
+static_assert(sizeof(DiskGroupDescHi) == 32, "Bad DiskGroupDescHi struct size");
+
 struct DiskInode {
 	uint16_t mode;
 	uint16_t uid;
@@ -125,7 +153,7 @@ struct DiskInode {
 	FileData data;
 	uint32_t generation;
 	uint32_t fileAcl;
-	uint32_t dirAcl;
+	uint32_t sizeHigh; // dirAcl in revision 0.
 	uint32_t faddr;
 	uint8_t osd2[12];
 };
@@ -135,6 +163,71 @@ enum {
 	EXT2_ROOT_INO = 2
 };
 
+enum {
+	EXT2_FEATURE_COMPAT_DIR_INDEX = 0x0020
+};
+
+enum {
+	EXT2_FLAGS_UNSIGNED_HASH = 0x0002
+};
+
+enum {
+	EXT2_FEATURE_INCOMPAT_FILETYPE = 0x0002,
+	EXT2_FEATURE_INCOMPAT_EXTENTS = 0x0040,
+	EXT2_FEATURE_INCOMPAT_64BIT = 0x0080,
+	EXT2_FEATURE_INCOMPAT_FLEX_BG = 0x0200,
+	// Features that we can write. Extent trees can only be modified as long as they
+	// fit into the inode (see FileSystem::assignExtentBlocks()).
+	EXT2_FEATURE_INCOMPAT_WRITABLE = EXT2_FEATURE_INCOMPAT_FILETYPE
+			| EXT2_FEATURE_INCOMPAT_EXTENTS | EXT2_FEATURE_INCOMPAT_FLEX_BG
+};
+
+enum {
+	EXT2_FEATURE_RO_COMPAT_SPARSE_SUPER = 0x0001,
+	EXT2_FEATURE_RO_COMPAT_LARGE_FILE = 0x0002,
+	EXT2_FEATURE_RO_COMPAT_WRITABLE = EXT2_FEATURE_RO_COMPAT_SPARSE_SUPER
+			| EXT2_FEATURE_RO_COMPAT_LARGE_FILE
+};
+
+enum {
+	EXT2_INDEX_FL = 0x00001000,
+	EXT4_EXTENTS_FL = 0x00080000
+};
+
+// ext4 extent trees. The root node is stored in DiskInode::data; interior and leaf nodes
+// occupy full blocks. Each node starts with an ExtentHeader, followed by either ExtentIdx
+// (interior nodes) or Extent (leaf nodes) entries.
+struct ExtentHeader {
+	uint16_t magic;
+	uint16_t entries;
+	uint16_t max;
+	uint16_t depth;
+	uint32_t generation;
+};
+static_assert(sizeof(ExtentHeader) == 12, "Bad ExtentHeader struct size");
+
+struct ExtentIdx {
+	uint32_t block;
+	uint32_t leafLo;
+	uint16_t leafHi;
+	uint16_t unused;
+};
+static_assert(sizeof(ExtentIdx) == 12, "Bad ExtentIdx struct size");
+
+struct Extent {
+	uint32_t block;
+	uint16_t length;
+	uint16_t startHi;
+	uint32_t startLo;
+};
+static_assert(sizeof(Extent) == 12, "Bad Extent struct size");
+
+enum {
+	EXT4_EXTENT_MAGIC = 0xF30A,
+	// Extents longer than this are unwritten (i.e., preallocated but read as zeros).
+	EXT4_EXTENT_MAX_INIT_LENGTH = 32768
+};
+
 enum {
 	EXT2_S_IFMT = 0xF000,
 	EXT2_S_IFLNK = 0xA000,
@@ -153,9 +246,47 @@ struct DiskDirEntry {
 enum {
 	EXT2_FT_REG_FILE = 1,
 	EXT2_FT_DIR = 2,
+	EXT2_FT_CHRDEV = 3,
+	EXT2_FT_BLKDEV = 4,
+	EXT2_FT_FIFO = 5,
+	EXT2_FT_SOCK = 6,
 	EXT2_FT_SYMLINK = 7
 };
 
+// Hashed directory index (htree). The root block starts with "." and ".." entries,
+// followed by a DxRootInfo and an array of DxEntry. The first DxEntry stores
+// a DxCountLimit instead of a hash.
+struct DxRootInfo {
+	uint32_t reservedZero;
+	uint8_t hashVersion;
+	uint8_t infoLength;
+	uint8_t indirectLevels;
+	uint8_t unusedFlags;
+};
+static_assert(sizeof(DxRootInfo) == 8, "Bad DxRootInfo struct size");
+
+struct DxCountLimit {
+	uint16_t limit;
+	uint16_t count;
+};
+static_assert(sizeof(DxCountLimit) == 4, "Bad DxCountLimit struct size");
+
+struct DxEntry {
+	uint32_t hash;
+	uint32_t block;
+};
+static_assert(sizeof(DxEntry) == 8, "Bad DxEntry struct size");
+
+enum {
+	EXT2_DX_HASH_LEGACY = 0,
+	EXT2_DX_HASH_HALF_MD4 = 1,
+	EXT2_DX_HASH_TEA = 2,
+	// Unsigned variants; never stored on disk.
+	EXT2_DX_HASH_LEGACY_UNSIGNED = 3,
+	EXT2_DX_HASH_HALF_MD4_UNSIGNED = 4,
+	EXT2_DX_HASH_TEA_UNSIGNED = 5
+};
+
 // --------------------------------------------------------
 // DirEntry
 // --------------------------------------------------------
@@ -170,20 +301,45 @@ struct DirEntry {
 // --------------------------------------------------------
 
 struct FileSystem;
+struct OpenFile;
+
+// Page with a protocols::fs::CacheHeader for a client that reads the page cache directly
+// (see PT_ACCESS_CACHE). The kernel cannot hand out read-only views of memory objects,
+// hence each open file gets its own copy; a client can only corrupt its own header.
+struct CacheHeaderPage {
+	helix::UniqueDescriptor memory;
+	helix::Mapping mapping;
+
+	protocols::fs::CacheHeader *header() {
+		return reinterpret_cast<protocols::fs::CacheHeader *>(mapping.get());
+	}
+};
 
 struct Inode : std::enable_shared_from_this<Inode> {
 	Inode(FileSystem &fs, uint32_t number);
 
+	~Inode();
+
 	DiskInode *diskInode() {
 		return reinterpret_cast<DiskInode *>(diskMapping.get());
 	}
 
 	// Returns the size of the file in bytes.
 	uint64_t fileSize() {
-		return diskInode()->size;
+		uint64_t size = diskInode()->size;
+		if((diskInode()->mode & EXT2_S_IFMT) == EXT2_S_IFREG)
+			size |= static_cast<uint64_t>(diskInode()->sizeHigh) << 32;
+		return size;
+	}
+
+	bool usesExtents() {
+		return diskInode()->flags & EXT4_EXTENTS_FL;
 	}
 
 	void setFileSize(uint64_t size);
+	// Waits until no client reads the page cache directly via the CacheHeader.
+	// Must be called after a shrinking setFileSize() and before the page cache shrinks.
+	async::result<void> waitForCacheReaders();
 
 	async::result<frg::expected<protocols::fs::Error, std::optional<DirEntry>>>
 	findEntry(std::string name);
@@ -214,6 +370,23 @@ struct Inode : std::enable_shared_from_this<Inode> {
 	HelHandle frontalMemory;
 	helix::Mapping fileMapping;
 
+	// Long-lived mapping of the page cache that serves reads of regular files.
+	// Chunks are locked on first access and stay locked until they are evicted,
+	// see FileSystem::readCached().
+	struct ReadChunk {
+		helix::UniqueDescriptor lock;
+		size_t size = 0;
+		std::optional<std::list<std::pair<Inode *, size_t>>::iterator> lru;
+	};
+	helix::Mapping readWindow;
+	std::vector<ReadChunk> readChunks;
+	// Incremented when the window is unmapped such that concurrent readers can detect it.
+	uint64_t readWindowSeq = 0;
+
+	// Headers of all open files that read the page cache directly.
+	// setFileSize() updates all of them.
+	std::list<CacheHeaderPage> cacheHeaders;
+
 	// Caches indirection blocks reachable from the inode.
 	// - Indirection level 1/1 for single indirect blocks.
 	// - Indirection level 1/2 for double indirect blocks.
@@ -225,8 +398,18 @@ struct Inode : std::enable_shared_from_this<Inode> {
 	helix::UniqueDescriptor indirectOrder2;
 	// Caches indirection blocks reachable from order 2 blocks.
 	// - Indirection level 3/3 for triple indirect blocks.
+	// Only allocated if the inode has a triple indirect block.
 	helix::UniqueDescriptor indirectOrder3;
 
+	// Flattened extent tree of extent-mapped files, sorted by logical block.
+	struct CachedExtent {
+		uint32_t logical;
+		uint32_t length;
+		uint64_t physical;
+		bool unwritten;
+	};
+	std::vector<CachedExtent> extents;
+
 	// NOTE: The following fields are only meaningful if the isReady is true
 
 	FileType fileType;
@@ -235,6 +418,16 @@ struct Inode : std::enable_shared_from_this<Inode> {
 	FlockManager flockManager;
 
 	std::unordered_set<std::string> obstructedLinks;
+
+	// Maps names to entries of large directories that do not have an htree index.
+	// Built lazily by findEntry() and kept up-to-date by link() and unlink().
+	std::unordered_map<std::string, DirEntry> nameIndex;
+	bool nameIndexValid = false;
+
+private:
+	bool isIndexedDirectory();
+	bool lookupIndexed(const std::string &name, std::optional<DirEntry> &entry);
+	void buildNameIndex();
 };
 
 // --------------------------------------------------------
@@ -256,20 +449,36 @@ struct FileSystem {
 	async::result<std::shared_ptr<Inode>> createDirectory();
 	async::result<std::shared_ptr<Inode>> createSymlink();
 
-	async::result<void> write(Inode *inode, uint64_t offset,
+	async::result<frg::expected<protocols::fs::Error>> write(Inode *inode, uint64_t offset,
 			const void *buffer, size_t length);
 
 	async::detached initiateInode(std::shared_ptr<Inode> inode);
 	async::detached manageFileData(std::shared_ptr<Inode> inode);
+	async::detached handleFileDataRequest(std::shared_ptr<Inode> inode,
+			int type, uintptr_t offset, size_t length);
 	async::detached manageIndirect(std::shared_ptr<Inode> inode, int order,
 			helix::UniqueDescriptor memory);
 
-	async::result<uint32_t> allocateBlock();
+	// A contiguous run of blocks that was allocated but not handed out yet.
+	struct BlockRun {
+		uint32_t next = 0;
+		size_t remaining = 0;
+	};
+
+	async::result<std::pair<uint32_t, size_t>> allocateBlocks(uint32_t group, size_t count);
+	async::result<uint32_t> allocateFromRun(BlockRun &run, uint32_t group, size_t wanted);
+	async::result<void> releaseRun(BlockRun &run);
 	async::result<uint32_t> allocateInode();
+	async::result<void> releaseInode(Inode *inode);
 
-	async::result<void> assignDataBlocks(Inode *inode,
+	async::result<frg::expected<protocols::fs::Error>> assignDataBlocks(Inode *inode,
+			uint64_t block_offset, size_t num_blocks);
+	async::result<frg::expected<protocols::fs::Error>> assignExtentBlocks(Inode *inode,
 			uint64_t block_offset, size_t num_blocks);
 
+	async::result<void> loadExtents(Inode *inode, const ExtentHeader *node);
+	std::pair<size_t, size_t> mapExtent(Inode *inode, uint64_t index, size_t remaining);
+
 	async::result<void> readDataBlocks(std::shared_ptr<Inode> inode, uint64_t block_offset,
 			size_t num_blocks, void *buffer);
 	async::result<void> writeDataBlocks(std::shared_ptr<Inode> inode, uint64_t block_offset,
@@ -277,9 +486,55 @@ struct FileSystem {
 
 	async::result<void> truncate(Inode *inode, size_t size);
 
+	// Copies file data from the page cache through the inode's read window.
+	// Returns the number of bytes that were copied; this is less than length
+	// if the file is truncated concurrently.
+	async::result<size_t> readCached(Inode *inode, uint64_t offset,
+			void *buffer, size_t length);
+	void evictReadWindow(Inode *inode);
+	void evictReadChunk(Inode *inode, size_t index);
+
+	// Allocates the CacheHeader that is handed out to the client along with the page cache.
+	async::result<frg::expected<protocols::fs::Error>> setupCacheHeader(OpenFile *file);
+
+	// Sets RO_COMPAT_LARGE_FILE in the superblock once a file reaches 2 GiB.
+	async::result<void> noteFileSize(uint64_t size);
+
 	async::result<void> writebackBgdt();
+	async::result<void> flushBgdt();
+
+	DiskGroupDesc &groupDesc(uint32_t bg_idx) {
+		return *reinterpret_cast<DiskGroupDesc *>(blockGroupDescriptorBuffer.data()
+				+ bg_idx * descSize);
+	}
+
+	// Returns nullptr unless the file system has 64-bit group descriptors.
+	// Such file systems are read-only, hence only block locations use the upper halves.
+	DiskGroupDescHi *groupDescHi(uint32_t bg_idx) {
+		if(descSize < sizeof(DiskGroupDesc) + sizeof(DiskGroupDescHi))
+			return nullptr;
+		return reinterpret_cast<DiskGroupDescHi *>(blockGroupDescriptorBuffer.data()
+				+ bg_idx * descSize + sizeof(DiskGroupDesc));
+	}
+
+	uint64_t blockBitmapOf(uint32_t bg_idx) {
+		auto hi = groupDescHi(bg_idx);
+		return groupDesc(bg_idx).blockBitmap | (hi ? uint64_t{hi->blockBitmapHi} << 32 : 0);
+	}
+
+	uint64_t inodeBitmapOf(uint32_t bg_idx) {
+		auto hi = groupDescHi(bg_idx);
+		return groupDesc(bg_idx).inodeBitmap | (hi ? uint64_t{hi->inodeBitmapHi} << 32 : 0);
+	}
+
+	uint64_t inodeTableOf(uint32_t bg_idx) {
+		auto hi = groupDescHi(bg_idx);
+		return groupDesc(bg_idx).inodeTable | (hi ? uint64_t{hi->inodeTableHi} << 32 : 0);
+	}
 
 	BlockDevice *device;
+	// In-memory copy of the primary superblock.
+	DiskSuperblock superblock;
 	uint16_t inodeSize;
 	uint32_t blockShift;
 	uint32_t blockSize;
@@ -290,14 +545,31 @@ struct FileSystem {
 	uint32_t inodesPerGroup;
 	uint32_t blocksCount;
 	uint32_t inodesCount;
+	uint32_t firstDataBlock;
+	bool dirIndex;
+	bool unsignedHash;
+	// Set if the file system uses features that we cannot write.
+	bool readOnly = false;
+	uint32_t hashSeed[4];
 	std::vector<std::byte> blockGroupDescriptorBuffer;
-	DiskGroupDesc *bgdt;
+	// Size of each entry of the BGDT (32 or, for 64-bit file systems, at least 64 bytes).
+	size_t descSize;
+	// Set if the BGDT was modified since the last writeback. Allocations only mark the BGDT dirty;
+	// operations call flushBgdt() once they are done.
+	bool bgdtDirty = false;
+	// Per block group bit index at which the next block allocation starts searching.
+	std::vector<uint32_t> blockAllocHints;
 
 	helix::UniqueDescriptor blockBitmap;
 	helix::UniqueDescriptor inodeBitmap;
 	helix::UniqueDescriptor inodeTable;
 
 	std::unordered_map<uint32_t, std::weak_ptr<Inode>> activeInodes;
+
+	// Locked read window chunks (inode, chunk index) in least-recently-used order
+	// (front = most recently used).
+	std::list<std::pair<Inode *, size_t>> readChunkLru;
+	size_t readWindowLockedBytes = 0;
 };
 
 // --------------------------------------------------------
@@ -307,12 +579,17 @@ struct FileSystem {
 struct OpenFile {
 	OpenFile(std::shared_ptr<Inode> inode);
 
+	~OpenFile();
+
 	async::result<std::optional<std::string>> readEntries();
+	async::result<protocols::fs::ReadResult> readEntriesBatch(void *buffer, size_t length);
 
 	std::shared_ptr<Inode> inode;
 	uint64_t offset;
 	Flock flock;
 	bool append;
+	// Set once the client reads the page cache directly, see FileSystem::setupCacheHeader().
+	std::optional<std::list<CacheHeaderPage>::iterator> cacheHeader;
 };
 
 } } // namespace blockfs::ext2fs
@@ -86,31 +86,11 @@ async::result<protocols::fs::ReadResult> read(void *object, const char *,
 	auto chunk_offset = self->offset;
 	self->offset += chunkSize;
 
-	// TODO: If we *know* that the pages are already available,
-	//       we can also fall back to the following "old" mapping code.
-/*
-	auto mapOffset = chunk_offset & ~size_t(0xFFF);
-	auto mapSize = (((chunk_offset & size_t(0xFFF)) + chunkSize + 0xFFF) & ~size_t(0xFFF));
-
-	helix::LockMemoryView lockMemory;
-	auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(self->inode->frontalMemory),
-			&lockMemory, mapOffset, mapSize, helix::Dispatcher::global());
-	co_await submit.wait();
-	HEL_CHECK(lockMemory.error());
-
-	// Map the page cache into the address space.
-	helix::Mapping fileMap{helix::BorrowedDescriptor{self->inode->frontalMemory},
-			static_cast<ptrdiff_t>(mapOffset), mapSize,
-			kHelMapProtRead | kHelMapDontRequireBacking};
-
-	memcpy(buffer, reinterpret_cast<char *>(fileMap.get()) + (chunk_offset - mapOffset),
-			chunkSize);
-*/
-
-	auto readMemory = co_await helix_ng::readMemory(
-			helix::BorrowedDescriptor(self->inode->frontalMemory),
-			chunk_offset, chunkSize, buffer);
-	HEL_CHECK(readMemory.error());
+	auto actualSize = co_await self->inode->fs.readCached(self->inode.get(), chunk_offset,
+			buffer, chunkSize);
+	// The file was truncated concurrently; do not skip over data that is appended later.
+	if(actualSize < chunkSize && self->offset == chunk_offset + chunkSize)
+		self->offset = chunk_offset + actualSize;
 
 	uint64_t end;
 	HEL_CHECK(helGetClock(&end));
@@ -120,7 +100,7 @@ async::result<protocols::fs::ReadResult> read(void *object, const char *,
 	oste.withCounter(ostTimeCounter, static_cast<int64_t>(end - start));
 	co_await oste.emit();
 
-	co_return chunkSize;
+	co_return actualSize;
 }
 
 async::result<protocols::fs::ReadResult> pread(void *object, int64_t offset, const char *,
@@ -130,7 +110,7 @@ async::result<protocols::fs::ReadResult> pread(void *object, int64_t offset, con
 	auto self = static_cast<ext2fs::OpenFile *>(object);
 	co_await self->inode->readyJump.wait();
 
-	if(self->offset >= self->inode->fileSize())
+	if(static_cast<uint64_t>(offset) >= self->inode->fileSize())
 		co_return size_t{0};
 
 	auto remaining = self->inode->fileSize() - offset;
@@ -138,24 +118,8 @@ async::result<protocols::fs::ReadResult> pread(void *object, int64_t offset, con
 	if(!chunk_size)
 		co_return size_t{0}; // TODO: Return an explicit end-of-file error?
 
-	auto chunk_offset = offset;
-	auto map_offset = chunk_offset & ~size_t(0xFFF);
-	auto map_size = (((chunk_offset & size_t(0xFFF)) + chunk_size + 0xFFF) & ~size_t(0xFFF));
-
-	helix::LockMemoryView lock_memory;
-	auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(self->inode->frontalMemory),
-			&lock_memory, map_offset, map_size, helix::Dispatcher::global());
-	co_await submit.async_wait();
-	HEL_CHECK(lock_memory.error());
-
-	// Map the page cache into the address space.
-	helix::Mapping file_map{helix::BorrowedDescriptor{self->inode->frontalMemory},
-			static_cast<ptrdiff_t>(map_offset), map_size,
-			kHelMapProtRead | kHelMapDontRequireBacking};
-
-	memcpy(buffer, reinterpret_cast<char *>(file_map.get()) + (chunk_offset - map_offset),
-			chunk_size);
-	co_return chunk_size;
+	co_return co_await self->inode->fs.readCached(self->inode.get(), offset,
+			buffer, chunk_size);
 }
 
 async::result<frg::expected<protocols::fs::Error, size_t>> write(void *object, const char *,
@@ -165,10 +129,12 @@ async::result<frg::expected<protocols::fs::Error, size_t>> write(void *object, c
 	}
 
 	auto self = static_cast<ext2fs::OpenFile *>(object);
+	if(self->inode->fs.readOnly)
+		co_return protocols::fs::Error::accessDenied;
 	if(self->append) {
 		self->offset = self->inode->fileSize();
 	}
-	co_await self->inode->fs.write(self->inode.get(), self->offset, buffer, length);
+	FRG_CO_TRY(co_await self->inode->fs.write(self->inode.get(), self->offset, buffer, length));
 	self->offset += length;
 	co_return length;
 }
@@ -180,7 +146,9 @@ async::result<frg::expected<protocols::fs::Error, size_t>> pwrite(void *object,
 	}
 
 	auto self = static_cast<ext2fs::OpenFile *>(object);
-	co_await self->inode->fs.write(self->inode.get(), offset, buffer, length);
+	if(self->inode->fs.readOnly)
+		co_return protocols::fs::Error::accessDenied;
+	FRG_CO_TRY(co_await self->inode->fs.write(self->inode.get(), offset, buffer, length));
 	co_return length;
 }
 
@@ -191,6 +159,16 @@ accessMemory(void *object) {
 	co_return self->inode->frontalMemory;
 }
 
+async::result<frg::expected<protocols::fs::Error, protocols::fs::CacheAccess>>
+accessCache(void *object) {
+	auto self = static_cast<ext2fs::OpenFile *>(object);
+	FRG_CO_TRY(co_await self->inode->fs.setupCacheHeader(self));
+	co_return protocols::fs::CacheAccess{
+		.memory = helix::BorrowedDescriptor{self->inode->frontalMemory},
+		.header = (*self->cacheHeader)->memory
+	};
+}
+
 async::result<protocols::fs::ReadEntriesResult>
 readEntries(void *object) {
 	auto self = static_cast<ext2fs::OpenFile *>(object);
@@ -201,9 +179,21 @@ readEntries(void *object) {
 	co_return co_await self->readEntries();
 }
 
+async::result<protocols::fs::ReadResult>
+readEntriesBatch(void *object, void *buffer, size_t length) {
+	auto self = static_cast<ext2fs::OpenFile *>(object);
+
+	protocols::ostrace::Event oste{&ostContext, ostReaddirEvent};
+	co_await oste.emit();
+
+	co_return co_await self->readEntriesBatch(buffer, length);
+}
+
 async::result<frg::expected<protocols::fs::Error>>
 truncate(void *object, size_t size) {
 	auto self = static_cast<ext2fs::OpenFile *>(object);
+	if(self->inode->fs.readOnly)
+		co_return protocols::fs::Error::accessDenied;
 	co_await self->inode->fs.truncate(self->inode.get(), size);
 	co_return {};
 }
@@ -227,7 +217,9 @@ constexpr protocols::fs::FileOperations fileOperations {
 	.write        = &write,
 	.pwrite       = &pwrite,
 	.readEntries  = &readEntries,
+	.readEntriesBatch = &readEntriesBatch,
 	.accessMemory = &accessMemory,
+	.accessCache  = &accessCache,
 	.truncate     = &truncate,
 	.flock        = &flock,
 	.getFileFlags = &getFileFlags,
@@ -267,6 +259,9 @@ getLink(std::shared_ptr<void> object,
 async::result<protocols::fs::GetLinkResult> link(std::shared_ptr<void> object,
 		std::string name, int64_t ino) {
 	auto self = std::static_pointer_cast<ext2fs::Inode>(object);
+	if(self->fs.readOnly)
+		co_return protocols::fs::GetLinkResult{nullptr, -1,
+				protocols::fs::FileType::unknown};
 	auto entry = co_await self->link(std::move(name), ino, kTypeRegular);
 	if(!entry)
 		co_return protocols::fs::GetLinkResult{nullptr, -1,
@@ -293,6 +288,8 @@ async::result<protocols::fs::GetLinkResult> link(std::shared_ptr<void> object,
 
 async::result<frg::expected<protocols::fs::Error>> unlink(std::shared_ptr<void> object, std::string name) {
 	auto self = std::static_pointer_cast<ext2fs::Inode>(object);
+	if(self->fs.readOnly)
+		co_return protocols::fs::Error::accessDenied;
 	auto result = co_await self->unlink(std::move(name));
 	if(!result) {
 		assert(result.error() == protocols::fs::Error::fileNotFound);
@@ -379,6 +376,8 @@ async::result<std::string> readSymlink(std::shared_ptr<void> object) {
 async::result<protocols::fs::MkdirResult>
 mkdir(std::shared_ptr<void> object, std::string name) {
 	auto self = std::static_pointer_cast<ext2fs::Inode>(object);
+	if(self->fs.readOnly)
+		co_return protocols::fs::MkdirResult{nullptr, -1};
 	auto entry = co_await self->mkdir(std::move(name));
 
 	if(!entry)
@@ -391,6 +390,8 @@ mkdir(std::shared_ptr<void> object, std::string name) {
 async::result<protocols::fs::SymlinkResult>
 symlink(std::shared_ptr<void> object, std::string name, std::string target) {
 	auto self = std::static_pointer_cast<ext2fs::Inode>(object);
+	if(self->fs.readOnly)
+		co_return protocols::fs::SymlinkResult{nullptr, -1};
 	auto entry = co_await self->symlink(std::move(name), std::move(target));
 
 	if(!entry)
@@ -402,6 +403,8 @@ symlink(std::shared_ptr<void> object, std::string name, std::string target) {
 
 async::result<protocols::fs::Error> chmod(std::shared_ptr<void> object, int mode) {
 	auto self = std::static_pointer_cast<ext2fs::Inode>(object);
+	if(self->fs.readOnly)
+		co_return protocols::fs::Error::accessDenied;
 	auto result = co_await self->chmod(mode);
 
 	co_return result;
@@ -409,6 +412,8 @@ async::result<protocols::fs::Error> chmod(std::shared_ptr<void> object, int mode
 
 async::result<protocols::fs::Error> utimensat(std::shared_ptr<void> object, uint64_t atime_sec, uint64_t atime_nsec, uint64_t mtime_sec, uint64_t mtime_nsec) {
 	auto self = std::static_pointer_cast<ext2fs::Inode>(object);
+	if(self->fs.readOnly)
+		co_return protocols::fs::Error::accessDenied;
 	auto result = co_await self->utimensat(atime_sec, atime_nsec, mtime_sec, mtime_nsec);
 
 	co_return result;
@@ -647,6 +652,17 @@ async::detached servePartition(helix::UniqueLane lane) {
 			HEL_CHECK(send_resp.error());
 			HEL_CHECK(push_node.error());
 		}else if(req.req_type() == managarm::fs::CntReqType::SB_CREATE_REGULAR) {
+			if(fs->readOnly) {
+				managarm::fs::SvrResponse resp;
+				resp.set_error(managarm::fs::Errors::ACCESS_DENIED);
+
+				auto ser = resp.SerializeAsString();
+				auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
+					helix_ng::sendBuffer(ser.data(), ser.size()));
+				HEL_CHECK(send_resp.error());
+				continue;
+			}
+
 			auto inode = co_await fs->createRegular();
 
 			helix::UniqueLane local_lane, remote_lane;
@@ -682,6 +698,17 @@ async::detached servePartition(helix::UniqueLane lane) {
 				break;
 			}
 
+			if(fs->readOnly) {
+				managarm::fs::SvrResponse resp;
+				resp.set_error(managarm::fs::Errors::ACCESS_DENIED);
+
+				auto ser = resp.SerializeAsString();
+				auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
+					helix_ng::sendBuffer(ser.data(), ser.size()));
+				HEL_CHECK(send_resp.error());
+				continue;
+			}
+
 			auto oldInode = fs->accessInode(req->inode_source());
 			auto newInode = fs->accessInode(req->inode_target());
 
@@ -1,6 +1,7 @@
 #include <nic/virtio/virtio.hpp>
 
 #include <arch/dma_pool.hpp>
+#include <cassert>
 #include <core/virtio/core.hpp>
 
 namespace {
@@ -11,12 +12,16 @@ namespace {
 // Device feature bits.
 constexpr size_t legacyHeaderSize = 10;
 enum {
-	VIRTIO_NET_F_MAC = 5
+	VIRTIO_NET_F_CSUM = 0,
+	VIRTIO_NET_F_GUEST_CSUM = 1,
+	VIRTIO_NET_F_MAC = 5,
+	VIRTIO_NET_F_HOST_TSO4 = 11
 };
 
 // Bits for VirtHeader::flags.
 enum {
-	VIRTIO_NET_HDR_F_NEEDS_CSUM = 1
+	VIRTIO_NET_HDR_F_NEEDS_CSUM = 1,
+	VIRTIO_NET_HDR_F_DATA_VALID = 2
 };
 
 // Values for VirtHeader::gsoType.
@@ -41,8 +46,10 @@ struct VirtHeader {
 struct VirtioNic : nic::Link {
 	VirtioNic(std::unique_ptr<virtio_core::Transport> transport);
 
-	virtual async::result<void> receive(arch::dma_buffer_view) override;
+	virtual async::result<nic::RxInfo> receive(arch::dma_buffer_view) override;
 	virtual async::result<void> send(const arch::dma_buffer_view) override;
+	virtual async::result<void> send(const arch::dma_buffer_view,
+			nic::TxOffload offload) override;
 
 	virtual ~VirtioNic() override = default;
 private:
@@ -68,6 +75,21 @@ VirtioNic::VirtioNic(std::unique_ptr<virtio_core::Transport> transport)
 		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_MAC);
 	}
 
+	if(transport_->checkDeviceFeature(VIRTIO_NET_F_CSUM)) {
+		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_CSUM);
+		offloads_ |= nic::OFFLOAD_TX_CHECKSUM;
+
+		// TSO requires checksum offloading.
+		if(transport_->checkDeviceFeature(VIRTIO_NET_F_HOST_TSO4)) {
+			transport_->acknowledgeDriverFeature(VIRTIO_NET_F_HOST_TSO4);
+			offloads_ |= nic::OFFLOAD_TSO4;
+		}
+	}
+	if(transport_->checkDeviceFeature(VIRTIO_NET_F_GUEST_CSUM)) {
+		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_GUEST_CSUM);
+		offloads_ |= nic::OFFLOAD_RX_CHECKSUM;
+	}
+
 	transport_->finalizeFeatures();
 	transport_->claimQueues(2);
 	receiveVq_ = transport_->setupQueue(0);
@@ -76,7 +98,7 @@ VirtioNic::VirtioNic(std::unique_ptr<virtio_core::Transport> transport)
 	transport_->runDevice();
 }
 
-async::result<void> VirtioNic::receive(arch::dma_buffer_view frame) {
+async::result<nic::RxInfo> VirtioNic::receive(arch::dma_buffer_view frame) {
 	arch::dma_object<VirtHeader> header { &dmaPool_ };
 
 	virtio_core::Chain chain;
@@ -88,17 +110,42 @@ async::result<void> VirtioNic::receive(arch::dma_buffer_view frame) {
 
 	co_await receiveVq_->submitDescriptor(chain.front());
 
-	co_return;
+	// With VIRTIO_NET_F_GUEST_CSUM, the device either validated the checksum or
+	// the packet originates from the host and carries only a partial checksum.
+	nic::RxInfo info;
+	if(offloads_ & nic::OFFLOAD_RX_CHECKSUM)
+		info.checksumValid = header->flags
+				& (VIRTIO_NET_HDR_F_DATA_VALID | VIRTIO_NET_HDR_F_NEEDS_CSUM);
+	co_return info;
 }
 
 async::result<void> VirtioNic::send(const arch::dma_buffer_view payload) {
-	if (payload.size() > 1514) {
+	co_await send(payload, nic::TxOffload{});
+}
+
+async::result<void> VirtioNic::send(const arch::dma_buffer_view payload,
+		nic::TxOffload offload) {
+	if (!offload.segmentSize && payload.size() > 1514) {
 		throw std::runtime_error("data exceeds mtu");
 	}
 
 	arch::dma_object<VirtHeader> header { &dmaPool_ };
 	memset(header.data(), 0, sizeof(VirtHeader));
 
+	if(offload.needsChecksum) {
+		assert(offloads_ & nic::OFFLOAD_TX_CHECKSUM);
+		header->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		header->csumStart = offload.checksumStart;
+		header->csumOffset = offload.checksumOffset;
+	}
+	if(offload.segmentSize) {
+		assert(offloads_ & nic::OFFLOAD_TSO4);
+		assert(offload.needsChecksum);
+		header->gsoType = VIRTIO_NET_HDR_GSO_TCPV4;
+		header->gsoSize = offload.segmentSize;
+		header->hdrLen = offload.headerLength;
+	}
+
 	virtio_core::Chain chain;
 	chain.append(co_await transmitVq_->obtainDescriptor());
 	chain.setupBuffer(virtio_core::hostToDevice,
@@ -13,9 +13,15 @@ namespace thor {
 
 enum {
 	kPageSize = 0x1000,
-	kPageShift = 12
+	kPageShift = 12,
+	kHugePageSize = 0x200000,
+	kHugePageShift = 21
 };
 
+// Whether the page table cursors can install kHugePageSize leaves.
+// TODO: Support 2 MiB block descriptors.
+constexpr bool kHugePagesSupported = false;
+
 constexpr Word kPfAccess = 1;
 constexpr Word kPfWrite = 2;
 constexpr Word kPfUser = 4;
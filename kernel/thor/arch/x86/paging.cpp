@@ -718,7 +718,8 @@ ClientPageSpace::~ClientPageSpace() {
 		PageAccessor accessor{ps};
 		auto tbl = reinterpret_cast<uint64_t *>(accessor.get());
 		for(int i = 0; i < 512; i++) {
-			if(tbl[i] & kPagePresent)
+			// 2 MiB pages are owned by their MemoryView, not by the page space.
+			if((tbl[i] & kPagePresent) && !(tbl[i] & pdeHuge))
 				physicalAllocator->free(tbl[i] & kPageAddress, kPageSize);
 		}
 	};
@@ -811,6 +812,7 @@ void ClientPageSpace::mapSingle4k(VirtualAddr pointer, PhysicalAddr physical,
 
 	// Make sure there is a PT.
 	tbl2 = reinterpret_cast<arch::scalar_variable<uint64_t> *>(accessor2.get());
+	assert(!(tbl2[index2].load() & pdeHuge) && "2 MiB pages are only supported by Cursor");
 	if(tbl2[index2].load() & kPagePresent) {
 		accessor1 = PageAccessor{tbl2[index2].load() & 0x000FFFFFFFFFF000};
 	}else{
@@ -887,6 +889,7 @@ PageStatus ClientPageSpace::unmapSingle4k(VirtualAddr pointer) {
 	if(!(tbl2[index2].load() & kPagePresent))
 		return 0;
 	assert(tbl2[index2].load() & kPagePresent);
+	assert(!(tbl2[index2].load() & pdeHuge) && "2 MiB pages are only supported by Cursor");
 	accessor1 = PageAccessor{tbl2[index2].load() & 0x000FFFFFFFFFF000};
 	auto tbl1 = reinterpret_cast<arch::scalar_variable<uint64_t> *>(accessor1.get());
 
@@ -939,6 +942,7 @@ PageStatus ClientPageSpace::cleanSingle4k(VirtualAddr pointer) {
 	if(!(tbl2[index2].load() & kPagePresent))
 		return 0;
 	assert(tbl2[index2].load() & kPagePresent);
+	assert(!(tbl2[index2].load() & pdeHuge) && "2 MiB pages are only supported by Cursor");
 	accessor1 = PageAccessor{tbl2[index2].load() & 0x000FFFFFFFFFF000};
 	auto tbl1 = reinterpret_cast<arch::scalar_variable<uint64_t> *>(accessor1.get());
 
@@ -993,6 +997,8 @@ bool ClientPageSpace::isMapped(VirtualAddr pointer) {
 	// Find the PT.
 	if(!(tbl2[index2].load() & kPagePresent))
 		return false;
+	if(tbl2[index2].load() & pdeHuge)
+		return true;
 	accessor1 = PageAccessor{tbl2[index2].load() & 0x000FFFFFFFFFF000};
 	tbl1 = reinterpret_cast<arch::scalar_variable<uint64_t> *>(accessor1.get());
 
@@ -1074,16 +1080,18 @@ void ClientPageSpace::Walk::_update() {
 	auto tbl2 = reinterpret_cast<arch::scalar_variable<uint64_t> *>(_accessor2.get());
 	if(!(tbl2[index2].load() & kPagePresent))
 		return;
+	assert(!(tbl2[index2].load() & pdeHuge) && "2 MiB pages are only supported by Cursor");
 	_accessor1 = PageAccessor{tbl2[index2].load() & 0x000FFFFFFFFFF000};
 }
 
-void ClientPageSpace::Cursor::realizePts() {
-	auto doRealize = [&] <int S> (PageAccessor &subPt, PageAccessor &pt,
-			std::integral_constant<int, S>) {
-		auto ptPtr = reinterpret_cast<uint64_t *>(pt.get())
-				+ ((va_ >> S) & 0x1FF);
+namespace {
+	constexpr uint64_t pdeHugeAddress = 0x000F'FFFF'FFE0'0000;
+
+	// Makes sure that the entry at ptPtr points to a table and sets up an accessor for it.
+	void realizeTable(PageAccessor &subPt, uint64_t *ptPtr) {
 		auto ptEnt = __atomic_load_n(ptPtr, __ATOMIC_RELAXED);
 		if(ptEnt & ptePresent) {
+			assert(!(ptEnt & pdeHuge));
 			subPt = PageAccessor{ptEnt & pteAddress};
 			return;
 		}
@@ -1099,28 +1107,94 @@ void ClientPageSpace::Cursor::realizePts() {
 
 		ptEnt = subPtPage | ptePresent | pteWrite | pteUser;
 		__atomic_store_n(ptPtr, ptEnt, __ATOMIC_RELEASE);
-	};
+	}
 
-	auto realize3 = [&] {
-		if(_accessor3) /* [[likely]] */
-			return;
-		doRealize(_accessor3, _accessor4, std::integral_constant<int, 39>{});
-	};
-	auto realize2 = [&] {
-		if(_accessor2) /* [[likely]] */
-			return;
-		realize3();
-		doRealize(_accessor2, _accessor3, std::integral_constant<int, 30>{});
-	};
+	// Replaces the 2 MiB page at pdPtr by a PT that maps the same memory.
+	// Since the translation does not change, no shootdown is necessary; operations that
+	// subsequently change the PT perform a shootdown that also covers the 2 MiB TLB entry.
+	void splitHugePage(PageAccessor &subPt, uint64_t *pdPtr) {
+		PhysicalAddr subPtPage = physicalAllocator->allocate(kPageSize);
+		assert(subPtPage != static_cast<PhysicalAddr>(-1) && "OOM");
+		subPt = PageAccessor{subPtPage};
+		auto subPtPtr = reinterpret_cast<uint64_t *>(subPt.get());
+
+		// The CPU can concurrently set the dirty bit of the 2 MiB page; retry in that case.
+		auto pdEnt = __atomic_load_n(pdPtr, __ATOMIC_RELAXED);
+		while(true) {
+			assert((pdEnt & ptePresent) && (pdEnt & pdeHuge));
+
+			// map2m() only maps write-back memory, hence we do not need to translate PAT bits.
+			auto physical = pdEnt & pdeHugeAddress;
+			auto bits = pdEnt & (ptePresent | pteWrite | pteUser | pteDirty | pteXd);
+			for(int i = 0; i < 512; i++)
+				subPtPtr[i] = (physical + (uint64_t(i) << kPageShift)) | bits;
+
+			auto newEnt = subPtPage | ptePresent | pteWrite | pteUser;
+			if(__atomic_compare_exchange_n(pdPtr, &pdEnt, newEnt, false,
+					__ATOMIC_RELEASE, __ATOMIC_RELAXED))
+				return;
+		}
+	}
+}
+
+bool ClientPageSpace::Cursor::map2m(PhysicalAddr pa, PageFlags flags, CachingMode cachingMode) {
+	assert(!(va_ & (kHugePageSize - 1)));
+	assert(!(pa & (kHugePageSize - 1)));
+
+	// For now, we only use 2 MiB pages for normal (i.e., write-back) memory.
+	if(cachingMode != CachingMode::null && cachingMode != CachingMode::writeBack)
+		return false;
+	if(_accessor1)
+		return false;
+
+	if(!_accessor2)
+		realizePds();
 
+	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&space_->_mutex);
+
+	auto pdPtr = accessPde();
+	auto pdEnt = __atomic_load_n(pdPtr, __ATOMIC_RELAXED);
+	if(pdEnt & ptePresent)
+		return false;
+
+	pdEnt = pa | ptePresent | pteUser | pdeHuge;
+	if(flags & page_access::write)
+		pdEnt |= pteWrite;
+	if(!(flags & page_access::execute))
+		pdEnt |= pteXd;
+	__atomic_store_n(pdPtr, pdEnt, __ATOMIC_RELAXED);
+	return true;
+}
+
+void ClientPageSpace::Cursor::realizePds() {
+	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&space_->_mutex);
+
+	if(!_accessor3)
+		realizeTable(_accessor3, reinterpret_cast<uint64_t *>(_accessor4.get())
+				+ ((va_ >> 39) & 0x1FF));
+	if(!_accessor2)
+		realizeTable(_accessor2, reinterpret_cast<uint64_t *>(_accessor3.get())
+				+ ((va_ >> 30) & 0x1FF));
+}
+
+void ClientPageSpace::Cursor::realizePts() {
 	// This function is called after cachePts() if not all PTs are present.
 	assert(!_accessor1);
 
+	if(!_accessor2)
+		realizePds();
+
 	auto irqLock = frg::guard(&irqMutex());
 	auto lock = frg::guard(&space_->_mutex);
-	{
-		realize2();
-		doRealize(_accessor1, _accessor2, std::integral_constant<int, 21>{});
+
+	auto pdPtr = accessPde();
+	auto pdEnt = __atomic_load_n(pdPtr, __ATOMIC_RELAXED);
+	if((pdEnt & ptePresent) && (pdEnt & pdeHuge)) {
+		splitHugePage(_accessor1, pdPtr);
+	}else{
+		realizeTable(_accessor1, pdPtr);
 	}
 }
 
@@ -115,19 +115,16 @@ GlobalApicContext *globalApicContext() {
 	return &globalApicContextInstance.get();
 }
 
-void GlobalApicContext::GlobalAlarmSlot::arm(uint64_t nanos) {
+void GlobalApicContext::LocalAlarmSlot::arm(uint64_t nanos) {
 	assert(localApicContext()->timersAreCalibrated);
+	assert(!intsAreEnabled());
 
-	{
-		auto irq_lock = frg::guard(&irqMutex());
-		auto lock = frg::guard(&globalApicContext()->_mutex);
-		globalApicContext()->_globalDeadline = nanos;
-	}
+	localApicContext()->_alarmDeadline = nanos;
 	LocalApicContext::_updateLocalTimer();
 }
 
 LocalApicContext::LocalApicContext()
-: _preemptionDeadline{0}, _globalDeadline{0} { }
+: _preemptionDeadline{0}, _alarmDeadline{0} { }
 
 void LocalApicContext::setPreemption(uint64_t nanos) {
 	assert(localApicContext()->timersAreCalibrated);
@@ -152,22 +149,19 @@ void LocalApicContext::handleTimerIrq() {
 	if(self->_preemptionDeadline && now > self->_preemptionDeadline)
 		self->_preemptionDeadline = 0;
 
-	if(self->_globalDeadline && now > self->_globalDeadline) {
-		self->_globalDeadline = 0;
-		globalApicContext()->_globalAlarmInstance.fireAlarm();
-
-		// Update the global deadline to avoid calling fireAlarm() on the next IRQ.
-		{
-			auto irq_lock = frg::guard(&irqMutex());
-			auto lock = frg::guard(&globalApicContext()->_mutex);
-			localApicContext()->_globalDeadline = globalApicContext()->_globalDeadline;
-		}
+	// fireAlarm() re-arms the alarm if there are more timers.
+	if(self->_alarmDeadline && now > self->_alarmDeadline) {
+		self->_alarmDeadline = 0;
+		globalApicContext()->_localAlarmInstance.fireAlarm();
 	}
 
 	localApicContext()->_updateLocalTimer();
 }
 
 void LocalApicContext::_updateLocalTimer() {
+	// Do not let the timer IRQ interleave with the computation of the deadline.
+	auto irq_lock = frg::guard(&irqMutex());
+
 	uint64_t deadline = 0;
 	auto consider = [&] (uint64_t dc) {
 		if(!dc)
@@ -176,15 +170,8 @@ void LocalApicContext::_updateLocalTimer() {
 			deadline = dc;
 	};
 
-	// Copy the global deadline so we can access it without locking.
-	{
-		auto irq_lock = frg::guard(&irqMutex());
-		auto lock = frg::guard(&globalApicContext()->_mutex);
-		localApicContext()->_globalDeadline = globalApicContext()->_globalDeadline;
-	}
-
 	consider(localApicContext()->_preemptionDeadline);
-	consider(localApicContext()->_globalDeadline);
+	consider(localApicContext()->_alarmDeadline);
 
 	if(localApicContext()->useTscMode) {
 		if(!deadline) {
@@ -398,7 +385,7 @@ static initgraph::Task assessTimersTask{&globalInitEngine, "x86.assess-timers",
 		}
 
 		globalTimerEngine = frg::construct<PrecisionTimerEngine>(*kernelAlloc,
-				globalClockSource, globalApicContext()->globalAlarm());
+				globalClockSource, globalApicContext()->localAlarm());
 	//			globalClockSource, hpetAlarmTracker);
 	}
 };
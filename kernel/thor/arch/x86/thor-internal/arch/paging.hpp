@@ -13,9 +13,14 @@ namespace thor {
 
 enum {
 	kPageSize = 0x1000,
-	kPageShift = 12
+	kPageShift = 12,
+	kHugePageSize = 0x200000,
+	kHugePageShift = 21
 };
 
+// Whether the page table cursors can install kHugePageSize leaves (i.e., 2 MiB PDEs).
+constexpr bool kHugePagesSupported = true;
+
 constexpr Word kPfAccess = 1;
 constexpr Word kPfWrite = 2;
 constexpr Word kPfUser = 4;
@@ -321,6 +326,7 @@ constexpr uint64_t ptePat = 0x80;
 constexpr uint64_t pteGlobal = 0x100;
 constexpr uint64_t pteXd = 0x8000000000000000;
 constexpr uint64_t pteAddress = 0x000FFFFFFFFFF00;
+constexpr uint64_t pdeHuge = 0x80;
 
 struct ClientPageSpace : PageSpace {
 public:
@@ -382,9 +388,29 @@ public:
 			moveTo(va_ + kPageSize);
 		}
 
+		// Returns true if va_ is covered by a 2 MiB page.
+		bool isHuge() {
+			auto pdPtr = accessPde();
+			if(!pdPtr)
+				return false;
+			auto pdEnt = __atomic_load_n(pdPtr, __ATOMIC_RELAXED);
+			return (pdEnt & ptePresent) && (pdEnt & pdeHuge);
+		}
+
+		bool isPresent() {
+			if(!_accessor1)
+				return isHuge();
+			auto ptPtr = reinterpret_cast<uint64_t *>(_accessor1.get())
+					+ ((va_ >> 12) & 0x1FF);
+			auto ptEnt = __atomic_load_n(ptPtr, __ATOMIC_RELAXED);
+			return ptEnt & ptePresent;
+		}
+
 		bool findPresent(uintptr_t limit) {
 			while(va_ < limit) {
 				if(!_accessor1) {
+					if(isHuge())
+						return true;
 					advance4k();
 					continue;
 				}
@@ -401,6 +427,8 @@ public:
 		bool findDirty(uintptr_t limit) {
 			while(va_ < limit) {
 				if(!_accessor1) {
+					if(isHuge() && (__atomic_load_n(accessPde(), __ATOMIC_RELAXED) & pteDirty))
+						return true;
 					advance4k();
 					continue;
 				}
@@ -470,8 +498,11 @@ public:
 		}
 
 		PageStatus clean4k() {
-			if(!_accessor1)
-				return 0;
+			if(!_accessor1) {
+				if(!isHuge())
+					return 0;
+				realizePts();
+			}
 
 			auto ptPtr = reinterpret_cast<uint64_t *>(_accessor1.get())
 					+ ((va_ >> 12) & 0x1FF);
@@ -485,8 +516,11 @@ public:
 		}
 
 		PageStatus unmap4k() {
-			if(!_accessor1)
-				return 0;
+			if(!_accessor1) {
+				if(!isHuge())
+					return 0;
+				realizePts();
+			}
 
 			auto ptPtr = reinterpret_cast<uint64_t *>(_accessor1.get())
 					+ ((va_ >> 12) & 0x1FF);
@@ -499,7 +533,29 @@ public:
 			return status;
 		}
 
+		// Maps a 2 MiB page at va_ (which needs to be 2 MiB aligned).
+		// Fails if the range is already covered by a page table; callers fall back to map4k().
+		bool map2m(PhysicalAddr pa, PageFlags flags, CachingMode cachingMode);
+
+		PageStatus unmap2m() {
+			assert(!(va_ & (kHugePageSize - 1)));
+			assert(isHuge());
+
+			auto pdEnt = __atomic_exchange_n(accessPde(), 0, __ATOMIC_RELAXED);
+			PageStatus status = page_status::present;
+			if(pdEnt & pteDirty)
+				status |= page_status::dirty;
+			return status;
+		}
+
 	private:
+		uint64_t *accessPde() {
+			if(!_accessor2)
+				return nullptr;
+			return reinterpret_cast<uint64_t *>(_accessor2.get())
+					+ ((va_ >> 21) & 0x1FF);
+		}
+
 		void accessPts() {
 			auto doReload = [&] <int S> (PageAccessor &subPt, PageAccessor &pt,
 					std::integral_constant<int, S>) -> bool {
@@ -508,6 +564,9 @@ public:
 				auto ptEnt = __atomic_load_n(ptPtr, __ATOMIC_ACQUIRE);
 				if(!(ptEnt & ptePresent))
 					return false;
+				// 2 MiB pages do not have a PT.
+				if(S == 21 && (ptEnt & pdeHuge))
+					return false;
 				subPt = PageAccessor{ptEnt & pteAddress};
 				return true;
 			};
@@ -532,6 +591,9 @@ public:
 			doReload(_accessor1, _accessor2, std::integral_constant<int, 21>{});
 		}
 
+		// Allocates missing PDPTs and PDs.
+		void realizePds();
+		// Allocates missing PDPTs, PDs and PTs; splits 2 MiB pages into PTs.
 		void realizePts();
 
 		ClientPageSpace *space_;
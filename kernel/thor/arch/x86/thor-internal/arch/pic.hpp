@@ -57,23 +57,19 @@ private:
 struct GlobalApicContext {
 	friend struct LocalApicContext;
 
-	struct GlobalAlarmSlot final : AlarmTracker {
+	// Programs the local APIC timer of the calling CPU.
+	struct LocalAlarmSlot final : AlarmTracker {
 		using AlarmTracker::fireAlarm;
 
 		void arm(uint64_t nanos) override;
 	};
 
-	AlarmTracker *globalAlarm() {
-		return &_globalAlarmInstance;
+	AlarmTracker *localAlarm() {
+		return &_localAlarmInstance;
 	}
 
 private:
-	GlobalAlarmSlot _globalAlarmInstance;
-
-private:
-	frg::ticket_spinlock _mutex;
-
-	uint64_t _globalDeadline;
+	LocalAlarmSlot _localAlarmInstance;
 };
 
 struct LocalApicContext {
@@ -96,7 +92,7 @@ private:
 
 private:
 	uint64_t _preemptionDeadline;
-	uint64_t _globalDeadline;
+	uint64_t _alarmDeadline;
 };
 
 GlobalApicContext *globalApicContext();
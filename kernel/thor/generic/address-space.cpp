@@ -15,6 +15,11 @@ namespace {
 	constexpr bool logCleanup = false;
 	constexpr bool logUsage = false;
 
+	// Number of pages around a faulting page that are mapped if they are already resident.
+	// Must be a power of two; zero disables fault-around.
+	// Mappings with kHelMapNoFaultAround opt out individually.
+	constexpr size_t faultAroundPages = 16;
+
 	[[maybe_unused]]
 	void logRss(VirtualSpace *space) {
 		if(!logUsage)
@@ -107,6 +112,36 @@ frg::expected<Error> VirtualOperations::faultPage(VirtualAddr va, MemoryView *vi
 	return {};
 }
 
+frg::expected<Error> VirtualOperations::faultHugePage(VirtualAddr, MemoryView *,
+		uintptr_t, PageFlags) {
+	// The generic implementation only supports 4 KiB pages.
+	return Error::fault;
+}
+
+frg::expected<Error> VirtualOperations::mapResidentPages(VirtualAddr va, MemoryView *view,
+		uintptr_t offset, size_t size, PageFlags flags) {
+	assert(!(va & (kPageSize - 1)));
+	assert(!(offset & (kPageSize - 1)));
+	assert(!(size & (kPageSize - 1)));
+
+	if (!flags)
+		return {};
+
+	for(size_t progress = 0; progress < size; progress += kPageSize) {
+		if(isMapped(va + progress))
+			continue;
+
+		auto physicalRange = view->peekRange(offset + progress);
+		if(physicalRange.get<0>() == PhysicalAddr(-1))
+			continue;
+		assert(!(physicalRange.get<0>() & (kPageSize - 1)));
+
+		mapSingle4k(va + progress, physicalRange.get<0>(),
+				flags, physicalRange.get<1>());
+	}
+	return {};
+}
+
 frg::expected<Error> VirtualOperations::cleanPages(VirtualAddr va, MemoryView *view,
 		uintptr_t offset, size_t size) {
 	assert(!(va & (kPageSize - 1)));
@@ -479,6 +514,8 @@ VirtualSpace::map(smarter::borrowed_ptr<MemorySlice> slice,
 
 		if(flags & kMapDontRequireBacking)
 			mappingFlags |= MappingFlags::dontRequireBacking;
+		if(flags & kMapNoFaultAround)
+			mappingFlags |= MappingFlags::noFaultAround;
 
 		mapping = smarter::allocate_shared<Mapping>(Allocator{},
 				length, static_cast<MappingFlags>(mappingFlags),
@@ -671,6 +708,20 @@ VirtualSpace::handleFault(VirtualAddr address, uint32_t faultFlags,
 		co_await mapping->evictionMutex.async_lock();
 		frg::unique_lock evictionLock{frg::adopt_lock, mapping->evictionMutex};
 
+		// Try to map the surrounding huge page if the mapping covers it entirely.
+		auto hugeAddress = (mapping->address + offset) & ~(kHugePageSize - 1);
+		if(kHugePagesSupported
+				&& hugeAddress >= mapping->address
+				&& hugeAddress - mapping->address + kHugePageSize <= mapping->length
+				&& !((mapping->viewOffset + (hugeAddress - mapping->address))
+					& (kHugePageSize - 1))) {
+			auto hugeOffset = hugeAddress - mapping->address;
+			auto hugeOutcome = _ops->faultHugePage(hugeAddress, mapping->view.get(),
+					mapping->viewOffset + hugeOffset, mapping->compilePageFlags());
+			if(hugeOutcome)
+				co_return {};
+		}
+
 		auto remapOutcome = _ops->faultPage(address & ~(kPageSize - 1),
 				mapping->view.get(), mapping->viewOffset + offset,
 				mapping->compilePageFlags());
@@ -687,6 +738,26 @@ VirtualSpace::handleFault(VirtualAddr address, uint32_t faultFlags,
 			}
 		}
 
+		// Map resident neighbours within the same mapping to avoid further faults.
+		if(faultAroundPages > 1 && !(mapping->flags & MappingFlags::noFaultAround)) {
+			auto windowSize = faultAroundPages << kPageShift;
+			auto windowStart = offset & ~(windowSize - 1);
+			auto windowEnd = frg::min(windowStart + windowSize, mapping->length);
+
+			if(windowStart < offset) {
+				auto aroundOutcome = _ops->mapResidentPages(mapping->address + windowStart,
+						mapping->view.get(), mapping->viewOffset + windowStart,
+						offset - windowStart, mapping->compilePageFlags());
+				assert(aroundOutcome);
+			}
+			if(offset + kPageSize < windowEnd) {
+				auto aroundOutcome = _ops->mapResidentPages(mapping->address + offset + kPageSize,
+						mapping->view.get(), mapping->viewOffset + offset + kPageSize,
+						windowEnd - (offset + kPageSize), mapping->compilePageFlags());
+				assert(aroundOutcome);
+			}
+		}
+
 		co_return {};
 	}
 }
@@ -1238,6 +1309,63 @@ coroutine<size_t> VirtualSpace::writePartialSpace(uintptr_t address,
 	co_return progress;
 }
 
+PhysicalAddr VirtualSpace::PinnedRange::physicalAt(uintptr_t pointer) {
+	assert(pointer >= address && pointer < address + size);
+	auto offsetInMapping = pointer - mapping->address;
+	auto [physical, cacheMode] = mapping->resolveRange(offsetInMapping & ~(kPageSize - 1));
+	// Since we have locked the MemoryView, the physical address remains valid here.
+	assert(physical != PhysicalAddr(-1));
+	return physical;
+}
+
+coroutine<frg::expected<Error, VirtualSpace::PinnedRange>>
+VirtualSpace::pinRange(uintptr_t address, size_t size, smarter::shared_ptr<WorkQueue> wq) {
+	// We do not take _consistencyMutex here since we are only interested in a snapshot.
+	assert(size);
+
+	smarter::shared_ptr<Mapping> mapping;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		auto spaceGuard = frg::guard(&_snapshotMutex);
+
+		mapping = _findMapping(address);
+	}
+	if(!mapping)
+		co_return Error::fault;
+
+	auto startInMapping = address - mapping->address;
+	auto limitInMapping = frg::min(size, mapping->length - startInMapping);
+	// Otherwise, _findMapping() would have returned garbage.
+	assert(limitInMapping);
+
+	auto lockOutcome = co_await mapping->lockVirtualRange(startInMapping, limitInMapping, wq);
+	if(!lockOutcome)
+		co_return lockOutcome.error();
+
+	FetchFlags fetchFlags = 0;
+	if(mapping->flags & MappingFlags::dontRequireBacking)
+		fetchFlags |= fetchDisallowBacking;
+
+	// Ensure that all pages are available such that physicalAt() can resolve them.
+	auto misalign = startInMapping & (kPageSize - 1);
+	for(size_t progress = 0; progress < misalign + limitInMapping; progress += kPageSize) {
+		auto touchOutcome = co_await mapping->view->fetchRange(
+				mapping->viewOffset + startInMapping - misalign + progress, fetchFlags, wq);
+		if(!touchOutcome) {
+			mapping->unlockVirtualRange(startInMapping, limitInMapping);
+			co_return touchOutcome.error();
+		}
+	}
+
+	co_return PinnedRange{std::move(mapping), address, limitInMapping};
+}
+
+void VirtualSpace::unpinRange(PinnedRange &range) {
+	assert(range.mapping);
+	range.mapping->unlockVirtualRange(range.address - range.mapping->address, range.size);
+	range = PinnedRange{};
+}
+
 // --------------------------------------------------------
 // AddressSpace
 // --------------------------------------------------------
@@ -38,6 +38,37 @@ namespace {
 		assert(handle == kHelZeroMemory);
 		return getZeroMemory();
 	}
+
+	// Flows of at least this size are sent directly from the sender's pinned pages
+	// instead of being copied through kernel buffers first.
+	constexpr size_t zeroCopyFlowThreshold = 64 * 1024;
+	// Number of pages that such flows pin (and keep in-flight) at a time.
+	constexpr size_t zeroCopyFlowWindow = 16;
+
+	// Translates HelMapFlags to AddressSpace flags.
+	uint32_t translateMapFlags(uint32_t flags) {
+		uint32_t map_flags = 0;
+		if(flags & kHelMapFixed) {
+			map_flags |= AddressSpace::kMapFixed;
+		}else if(flags & kHelMapFixedNoReplace) {
+			map_flags |= AddressSpace::kMapFixedNoReplace;
+		}else{
+			map_flags |= AddressSpace::kMapPreferTop;
+		}
+
+		if(flags & kHelMapProtRead)
+			map_flags |= AddressSpace::kMapProtRead;
+		if(flags & kHelMapProtWrite)
+			map_flags |= AddressSpace::kMapProtWrite;
+		if(flags & kHelMapProtExecute)
+			map_flags |= AddressSpace::kMapProtExecute;
+
+		if(flags & kHelMapDontRequireBacking)
+			map_flags |= AddressSpace::kMapDontRequireBacking;
+		if(flags & kHelMapNoFaultAround)
+			map_flags |= AddressSpace::kMapNoFaultAround;
+		return map_flags;
+	}
 }
 
 extern "C" int doCopyFromUser(void *dest, const void *src, size_t size);
@@ -78,6 +109,22 @@ bool writeUserObject(T *pointer, T object) {
 	return writeUserMemory(pointer, &object, sizeof(T));
 }
 
+// Copies a scatter-gather list of exactly size bytes from user memory.
+bool gatherUserMemory(void *kernelPtr, const HelSgItem *sglist, size_t count, size_t size) {
+	size_t offset = 0;
+	for(size_t i = 0; i < count; i++) {
+		HelSgItem item;
+		if(!readUserObject(sglist + i, item))
+			return false;
+		if(item.length > size - offset)
+			return false;
+		if(!readUserMemory(reinterpret_cast<char *>(kernelPtr) + offset, item.buffer, item.length))
+			return false;
+		offset += item.length;
+	}
+	return offset == size;
+}
+
 template<typename T>
 bool readUserArray(const T *pointer, T *array, size_t count) {
 	size_t size;
@@ -147,7 +194,7 @@ HelError helSubmitAsyncNop(HelHandle queueHandle, uintptr_t context) {
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irqLock = frg::guard(&irqMutex());
-		Universe::Guard universeGuard(thisUniverse->lock);
+		Universe::ReadGuard universeGuard;
 
 		auto queueWrapper = thisUniverse->getDescriptor(universeGuard, queueHandle);
 		if(!queueWrapper)
@@ -228,7 +275,7 @@ HelError helDescriptorInfo(HelHandle handle, HelDescriptorInfo *) {
 	auto this_universe = this_thread->getUniverse();
 
 	auto irq_lock = frg::guard(&irqMutex());
-	Universe::Guard universe_guard(this_universe->lock);
+	Universe::ReadGuard universe_guard;
 
 	auto wrapper = this_universe->getDescriptor(universe_guard, handle);
 	if(!wrapper)
@@ -249,7 +296,7 @@ HelError helGetCredentials(HelHandle handle, uint32_t flags, char *credentials)
 	smarter::shared_ptr<Credentials> creds;
 	{
 		auto irqLock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(thisUniverse->lock);
+		Universe::ReadGuard universe_guard;
 
 		if(handle == kHelThisThread) {
 			creds = thisThread.lock();
@@ -281,7 +328,7 @@ HelError helCloseDescriptor(HelHandle universeHandle, HelHandle handle) {
 		universe = thisUniverse.lock();
 	}else{
 		auto irqLock = frg::guard(&irqMutex());
-		Universe::Guard universeLock(thisUniverse->lock);
+		Universe::ReadGuard universeLock;
 
 		auto universeIt = thisUniverse->getDescriptor(universeLock, universeHandle);
 		if(!universeIt)
@@ -338,7 +385,7 @@ HelError helCancelAsync(HelHandle handle, uint64_t async_id) {
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto queue_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!queue_wrapper)
@@ -353,6 +400,69 @@ HelError helCancelAsync(HelHandle handle, uint64_t async_id) {
 	return kHelErrNone;
 }
 
+HelError helAddQueueChunks(HelHandle handle, unsigned int numChunks, HelHandle *memoryHandle) {
+	auto thisThread = getCurrentThread();
+	auto thisUniverse = thisThread->getUniverse();
+
+	smarter::shared_ptr<IpcQueue> queue;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		Universe::ReadGuard universeGuard;
+
+		auto queueWrapper = thisUniverse->getDescriptor(universeGuard, handle);
+		if(!queueWrapper)
+			return kHelErrNoDescriptor;
+		if(!queueWrapper->is<QueueDescriptor>())
+			return kHelErrBadDescriptor;
+		queue = queueWrapper->get<QueueDescriptor>().queue;
+	}
+
+	auto memory = queue->addChunks(numChunks);
+	if(!memory)
+		return translateError(memory.error());
+
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		Universe::Guard universeGuard(thisUniverse->lock);
+
+		*memoryHandle = thisUniverse->attachDescriptor(universeGuard,
+				MemoryViewDescriptor(std::move(memory.value())));
+	}
+
+	return kHelErrNone;
+}
+
+HelError helQueryQueueStats(HelHandle handle, HelQueueStats *stats) {
+	auto thisThread = getCurrentThread();
+	auto thisUniverse = thisThread->getUniverse();
+
+	smarter::shared_ptr<IpcQueue> queue;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		Universe::ReadGuard universeGuard;
+
+		auto queueWrapper = thisUniverse->getDescriptor(universeGuard, handle);
+		if(!queueWrapper)
+			return kHelErrNoDescriptor;
+		if(!queueWrapper->is<QueueDescriptor>())
+			return kHelErrBadDescriptor;
+		queue = queueWrapper->get<QueueDescriptor>().queue;
+	}
+
+	auto queueStats = queue->getStats();
+	HelQueueStats helStats{
+		.numElements = queueStats.numElements,
+		.numBatches = queueStats.numBatches,
+		.numWakes = queueStats.numWakes,
+		.numStalls = queueStats.numStalls,
+		.numChunks = queueStats.numChunks
+	};
+	if(!writeUserObject(stats, helStats))
+		return kHelErrFault;
+
+	return kHelErrNone;
+}
+
 HelError helAllocateMemory(size_t size, uint32_t flags,
 		HelAllocRestrictions *restrictions, HelHandle *handle) {
 	if(!size)
@@ -404,7 +514,7 @@ HelError helResizeMemory(HelHandle handle, size_t newSize) {
 	smarter::shared_ptr<MemoryView> memory;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!wrapper)
@@ -467,7 +577,7 @@ HelError helCopyOnWrite(HelHandle memoryHandle,
 
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		if(memoryHandle >= 0) {
 			auto wrapper = this_universe->getDescriptor(universe_guard, memoryHandle);
@@ -538,7 +648,7 @@ HelError helAlterMemoryIndirection(HelHandle indirectHandle, size_t slot,
 	smarter::shared_ptr<MemoryView> memoryView;
 	{
 		auto irqLock = frg::guard(&irqMutex());
-		Universe::Guard universeLock(thisUniverse->lock);
+		Universe::ReadGuard universeLock;
 
 		auto indirectWrapper = thisUniverse->getDescriptor(universeLock, indirectHandle);
 		if(!indirectWrapper)
@@ -583,7 +693,7 @@ HelError helCreateSliceView(HelHandle memoryHandle,
 	smarter::shared_ptr<MemoryView> view;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto wrapper = this_universe->getDescriptor(universe_guard, memoryHandle);
 		if(!wrapper)
@@ -613,7 +723,7 @@ HelError helForkMemory(HelHandle handle, HelHandle *forkedHandle) {
 	smarter::shared_ptr<MemoryView> view;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto viewWrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!viewWrapper)
@@ -770,24 +880,7 @@ HelError helMapMemory(HelHandle memory_handle, HelHandle space_handle,
 	auto this_thread = getCurrentThread();
 	auto this_universe = this_thread->getUniverse();
 
-	uint32_t map_flags = 0;
-	if(flags & kHelMapFixed) {
-		map_flags |= AddressSpace::kMapFixed;
-	}else if(flags & kHelMapFixedNoReplace) {
-		map_flags |= AddressSpace::kMapFixedNoReplace;
-	}else{
-		map_flags |= AddressSpace::kMapPreferTop;
-	}
-
-	if(flags & kHelMapProtRead)
-		map_flags |= AddressSpace::kMapProtRead;
-	if(flags & kHelMapProtWrite)
-		map_flags |= AddressSpace::kMapProtWrite;
-	if(flags & kHelMapProtExecute)
-		map_flags |= AddressSpace::kMapProtExecute;
-
-	if(flags & kHelMapDontRequireBacking)
-		map_flags |= AddressSpace::kMapDontRequireBacking;
+	uint32_t map_flags = translateMapFlags(flags);
 
 	smarter::shared_ptr<MemorySlice> slice;
 	smarter::shared_ptr<AddressSpace, BindableHandle> space;
@@ -795,7 +888,7 @@ HelError helMapMemory(HelHandle memory_handle, HelHandle space_handle,
 	bool isVspace = false;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto memory_wrapper = this_universe->getDescriptor(universe_guard, memory_handle);
 		if(!memory_wrapper)
@@ -862,6 +955,122 @@ HelError helMapMemory(HelHandle memory_handle, HelHandle space_handle,
 	return kHelErrNone;
 }
 
+HelError helForkSpace(HelForkArea *areas, size_t numAreas, HelHandle *spaceHandle) {
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	if(numAreas > kHelMaxForkAreas)
+		return kHelErrIllegalArgs;
+
+	frg::vector<HelForkArea, KernelAlloc> forkAreas{*kernelAlloc};
+	forkAreas.resize(numAreas);
+	if(!readUserArray(areas, forkAreas.data(), numAreas))
+		return kHelErrFault;
+
+	for(const auto &area : forkAreas) {
+		if(!area.pointer || !area.size)
+			return kHelErrIllegalArgs;
+		if((uintptr_t)area.pointer % kPageSize != 0)
+			return kHelErrIllegalArgs;
+		if(area.offset % kPageSize != 0)
+			return kHelErrIllegalArgs;
+		if(area.size % kPageSize != 0)
+			return kHelErrIllegalArgs;
+	}
+
+	// Look up all memory objects while taking the universe lock only once.
+	smarter::shared_ptr<AddressSpace, BindableHandle> space;
+	frg::vector<smarter::shared_ptr<MemoryView>, KernelAlloc> views{*kernelAlloc};
+	frg::vector<smarter::shared_ptr<MemorySlice>, KernelAlloc> slices{*kernelAlloc};
+	views.resize(numAreas);
+	slices.resize(numAreas);
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::ReadGuard universe_guard;
+
+		if(*spaceHandle != kHelNullHandle) {
+			auto space_wrapper = this_universe->getDescriptor(universe_guard, *spaceHandle);
+			if(!space_wrapper)
+				return kHelErrNoDescriptor;
+			if(!space_wrapper->is<AddressSpaceDescriptor>())
+				return kHelErrBadDescriptor;
+			space = space_wrapper->get<AddressSpaceDescriptor>().space;
+		}
+
+		for(size_t i = 0; i < numAreas; i++) {
+			auto memory_wrapper = this_universe->getDescriptor(universe_guard,
+					forkAreas[i].memory);
+			if(!memory_wrapper)
+				return kHelErrNoDescriptor;
+			if(memory_wrapper->is<MemoryViewDescriptor>()) {
+				views[i] = memory_wrapper->get<MemoryViewDescriptor>().memory;
+			}else if(memory_wrapper->is<MemorySliceDescriptor>()
+					&& !(forkAreas[i].flags & kHelForkAreaCopyOnWrite)) {
+				slices[i] = memory_wrapper->get<MemorySliceDescriptor>().slice;
+			}else{
+				return kHelErrBadDescriptor;
+			}
+		}
+	}
+
+	// Fork all copy-on-write memory objects.
+	for(size_t i = 0; i < numAreas; i++) {
+		if(!(forkAreas[i].flags & kHelForkAreaCopyOnWrite))
+			continue;
+		auto [error, forkedView] = Thread::asyncBlockCurrent(views[i]->fork());
+		if(error == Error::illegalObject)
+			return kHelErrUnsupportedOperation;
+		assert(error == Error::success);
+		views[i] = std::move(forkedView);
+	}
+
+	bool newSpace = !space;
+	if(newSpace)
+		space = AddressSpace::create();
+	for(size_t i = 0; i < numAreas; i++) {
+		if(!slices[i]) {
+			auto sliceLength = views[i]->getLength();
+			slices[i] = smarter::allocate_shared<MemorySlice>(*kernelAlloc,
+					views[i], 0, sliceLength);
+		}
+
+		auto mapResult = Thread::asyncBlockCurrent(space->map(slices[i],
+				(VirtualAddr)forkAreas[i].pointer, forkAreas[i].offset, forkAreas[i].size,
+				translateMapFlags((forkAreas[i].mapFlags & ~kHelMapFixedNoReplace) | kHelMapFixed)));
+		if(!mapResult) {
+			assert(mapResult.error() == Error::bufferTooSmall
+					|| mapResult.error() == Error::noMemory);
+			if(mapResult.error() == Error::bufferTooSmall)
+				return kHelErrBufferTooSmall;
+			return kHelErrNoMemory;
+		}
+	}
+
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		for(size_t i = 0; i < numAreas; i++) {
+			if(!(forkAreas[i].flags & kHelForkAreaCopyOnWrite)) {
+				forkAreas[i].forkedMemory = kHelNullHandle;
+				continue;
+			}
+			forkAreas[i].forkedMemory = this_universe->attachDescriptor(universe_guard,
+					MemoryViewDescriptor(views[i]));
+		}
+
+		if(newSpace)
+			*spaceHandle = this_universe->attachDescriptor(universe_guard,
+					AddressSpaceDescriptor(std::move(space)));
+	}
+
+	// Report the handles of the forked memory objects back to user space.
+	if(!writeUserArray(areas, forkAreas.data(), numAreas))
+		return kHelErrFault;
+
+	return kHelErrNone;
+}
+
 HelError helSubmitProtectMemory(HelHandle space_handle,
 		void *pointer, size_t length, uint32_t flags,
 		HelHandle queue_handle, uintptr_t context) {
@@ -880,7 +1089,7 @@ HelError helSubmitProtectMemory(HelHandle space_handle,
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		if(space_handle == kHelNullHandle) {
 			space = this_thread->getAddressSpace().lock();
@@ -929,7 +1138,7 @@ HelError helUnmapMemory(HelHandle space_handle, void *pointer, size_t length) {
 	smarter::shared_ptr<AddressSpace, BindableHandle> space;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		if(space_handle == kHelNullHandle) {
 			space = this_thread->getAddressSpace().lock();
@@ -961,7 +1170,7 @@ HelError helSubmitSynchronizeSpace(HelHandle spaceHandle, void *pointer, size_t
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irqLock = frg::guard(&irqMutex());
-		Universe::Guard universeGuard(thisUniverse->lock);
+		Universe::ReadGuard universeGuard;
 
 		if(spaceHandle == kHelNullHandle) {
 			space = thisThread->getAddressSpace().lock();
@@ -1027,7 +1236,7 @@ HelError helSubmitReadMemory(HelHandle handle, uintptr_t address,
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universeGuard(thisUniverse->lock);
+		Universe::ReadGuard universeGuard;
 
 		auto wrapper = thisUniverse->getDescriptor(universeGuard, handle);
 		if(!wrapper)
@@ -1184,7 +1393,7 @@ HelError helSubmitWriteMemory(HelHandle handle, uintptr_t address,
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irqLock = frg::guard(&irqMutex());
-		Universe::Guard universeGuard(thisUniverse->lock);
+		Universe::ReadGuard universeGuard;
 
 		auto wrapper = thisUniverse->getDescriptor(universeGuard, handle);
 		if(!wrapper)
@@ -1339,7 +1548,7 @@ HelError helMemoryInfo(HelHandle handle, size_t *size) {
 	smarter::shared_ptr<MemoryView> memory;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!wrapper)
@@ -1361,7 +1570,7 @@ HelError helSubmitManageMemory(HelHandle handle, HelHandle queue_handle, uintptr
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto memory_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!memory_wrapper)
@@ -1415,7 +1624,7 @@ HelError helUpdateMemory(HelHandle handle, int type,
 	smarter::shared_ptr<MemoryView> memory;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto memory_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!memory_wrapper)
@@ -1455,7 +1664,7 @@ HelError helSubmitLockMemoryView(HelHandle handle, uintptr_t offset, size_t size
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto memory_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!memory_wrapper)
@@ -1531,7 +1740,7 @@ HelError helLoadahead(HelHandle handle, uintptr_t offset, size_t length) {
 	smarter::shared_ptr<MemoryView> memory;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto memory_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!memory_wrapper)
@@ -1566,7 +1775,7 @@ HelError helCreateThread(HelHandle universe_handle, HelHandle space_handle,
 	smarter::shared_ptr<AddressSpace, BindableHandle> space;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		if(universe_handle == kHelNullHandle) {
 			universe = this_thread->getUniverse().lock();
@@ -1626,7 +1835,7 @@ HelError helQueryThreadStats(HelHandle handle, HelThreadStats *user_stats) {
 		thread = this_thread.lock();
 	}else{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!thread_wrapper)
@@ -1655,7 +1864,7 @@ HelError helSetPriority(HelHandle handle, int priority) {
 		thread = this_thread.lock();
 	}else{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!thread_wrapper)
@@ -1685,7 +1894,7 @@ HelError helSubmitObserve(HelHandle handle, uint64_t inSeq,
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irqLock = frg::guard(&irqMutex());
-		Universe::Guard universeGuard(thisUniverse->lock);
+		Universe::ReadGuard universeGuard;
 
 		auto threadWrapper = thisUniverse->getDescriptor(universeGuard, handle);
 		if(!threadWrapper)
@@ -1746,7 +1955,7 @@ HelError helKillThread(HelHandle handle) {
 	smarter::shared_ptr<Thread> thread;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!thread_wrapper)
@@ -1768,7 +1977,7 @@ HelError helInterruptThread(HelHandle handle) {
 	smarter::shared_ptr<Thread> thread;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!thread_wrapper)
@@ -1790,7 +1999,7 @@ HelError helResume(HelHandle handle) {
 	smarter::shared_ptr<Thread> thread;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!thread_wrapper)
@@ -1818,7 +2027,7 @@ HelError helLoadRegisters(HelHandle handle, int set, void *image) {
 	VirtualizedCpuDescriptor vcpu;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!thread_wrapper)
@@ -1972,7 +2181,7 @@ HelError helStoreRegisters(HelHandle handle, int set, const void *image) {
 		thread = this_thread.lock();
 	}else{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!thread_wrapper)
@@ -2175,11 +2384,17 @@ HelError helGetClock(uint64_t *counter) {
 
 HelError helSubmitAwaitClock(uint64_t counter, HelHandle queue_handle, uintptr_t context,
 		uint64_t *async_id) {
+	return helSubmitAwaitClockWithSlack(counter, 0, queue_handle, context, async_id);
+}
+
+HelError helSubmitAwaitClockWithSlack(uint64_t counter, uint64_t slack,
+		HelHandle queue_handle, uintptr_t context, uint64_t *async_id) {
 	struct Closure final : CancelNode, PrecisionTimerNode, IpcNode {
-		static void issue(uint64_t nanos, smarter::shared_ptr<IpcQueue> queue,
+		static void issue(uint64_t nanos, uint64_t slack, smarter::shared_ptr<IpcQueue> queue,
 				uintptr_t context, uint64_t *async_id) {
 			auto closure = frg::construct<Closure>(*kernelAlloc, nanos,
 					std::move(queue), context);
+			closure->setSlack(slack);
 			closure->queue->registerNode(closure);
 			*async_id = closure->asyncId();
 			generalTimerEngine()->installTimer(closure);
@@ -2226,7 +2441,7 @@ HelError helSubmitAwaitClock(uint64_t counter, HelHandle queue_handle, uintptr_t
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto queue_wrapper = this_universe->getDescriptor(universe_guard, queue_handle);
 		if(!queue_wrapper)
@@ -2239,7 +2454,7 @@ HelError helSubmitAwaitClock(uint64_t counter, HelHandle queue_handle, uintptr_t
 	if(!queue->validSize(ipcSourceSize(sizeof(HelSimpleResult))))
 		return kHelErrQueueTooSmall;
 
-	Closure::issue(counter, std::move(queue), context, async_id);
+	Closure::issue(counter, slack, std::move(queue), context, async_id);
 
 	return kHelErrNone;
 }
@@ -2276,7 +2491,7 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(thisUniverse->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto wrapper = thisUniverse->getDescriptor(universe_guard, handle);
 		if(!wrapper)
@@ -2348,7 +2563,7 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 					creds = thisThread.lock();
 				} else {
 					auto irq_lock = frg::guard(&irqMutex());
-					Universe::Guard universe_guard(thisUniverse->lock);
+					Universe::ReadGuard universe_guard;
 
 					auto wrapper = thisUniverse->getDescriptor(universe_guard, recipe->handle);
 					if(!wrapper) {
@@ -2396,6 +2611,15 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 					length += item.length;
 				}
 
+				// Large payloads are gathered page by page by the flow protocol.
+				if(length > kPageSize) {
+					node->_tag = kTagSendFlow;
+					node->_maxLength = length;
+					++numFlows;
+					ipcSize += ipcSourceSize(sizeof(HelSimpleResult));
+					break;
+				}
+
 				frg::unique_memory<KernelAlloc> buffer(*kernelAlloc, length);
 				size_t offset = 0;
 				for(size_t j = 0; j < recipe->length; j++) {
@@ -2429,7 +2653,7 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 				AnyDescriptor operand;
 				{
 					auto irq_lock = frg::guard(&irqMutex());
-					Universe::Guard universe_guard(thisUniverse->lock);
+					Universe::ReadGuard universe_guard;
 
 					auto wrapper = thisUniverse->getDescriptor(universe_guard, recipe->handle);
 					if(!wrapper)
@@ -2656,13 +2880,18 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 				continue;
 			}
 
-			if(recipe->type == kHelActionSendFromBuffer
-					&& node->tag() == kTagSendFlow
-					&& peer->tag() == kTagRecvKernelBuffer) {
-				frg::unique_memory<KernelAlloc> buffer(*kernelAlloc, recipe->length);
+			if(node->tag() == kTagSendFlow && peer->tag() == kTagRecvKernelBuffer) {
+				frg::unique_memory<KernelAlloc> buffer(*kernelAlloc, node->_maxLength);
 
 				co_await thread->mainWorkQueue()->enter();
-				auto outcome = readUserMemory(buffer.data(), recipe->buffer, recipe->length);
+				bool outcome;
+				if(recipe->type == kHelActionSendFromBufferSg) {
+					outcome = gatherUserMemory(buffer.data(),
+							reinterpret_cast<HelSgItem *>(recipe->buffer), recipe->length,
+							node->_maxLength);
+				}else{
+					outcome = readUserMemory(buffer.data(), recipe->buffer, recipe->length);
+				}
 				if(!outcome) {
 					// We complete with fault; the remote with success.
 					// TODO: it probably makes sense to introduce a "remote fault" error.
@@ -2677,11 +2906,32 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 				peer->_transmitBuffer = std::move(buffer);
 				peer->complete();
 				node->complete();
-			}else if(recipe->type == kHelActionSendFromBuffer
-					&& node->tag() == kTagSendFlow
-					&& peer->tag() == kTagRecvFlow) {
+			}else if(node->tag() == kTagSendFlow && peer->tag() == kTagRecvFlow) {
 				// Empty packets are handled by the generic stream code.
-				assert(recipe->length);
+				assert(node->_maxLength);
+
+				// Large transfers do not go through xferBuffers. Instead, we pin our own
+				// pages and let the receiver copy from them directly; pages stay pinned
+				// until all packets that refer to them are acked.
+				bool zeroCopy = node->_maxLength >= zeroCopyFlowThreshold;
+				size_t window = zeroCopy ? zeroCopyFlowWindow : xferBuffers.size();
+				smarter::shared_ptr<AddressSpace, BindableHandle> space;
+				if(zeroCopy)
+					space = thread->getAddressSpace().lock();
+				VirtualSpace::PinnedRange pinned;
+				size_t pinnedProgress = 0;
+				// The receiver accesses the pages only when it processes a packet, hence each
+				// in-flight packet owns an accessor until it is acked.
+				frg::array<PageAccessor, zeroCopyFlowWindow> inflightAccessors;
+
+				// The current scatter-gather item (for plain sends: the entire buffer).
+				bool isSg = recipe->type == kHelActionSendFromBufferSg;
+				auto sglist = reinterpret_cast<HelSgItem *>(recipe->buffer);
+				size_t sgIndex = 0;
+				HelSgItem segment{};
+				if(!isSg)
+					segment = {recipe->buffer, recipe->length};
+				size_t segmentProgress = 0;
 
 				size_t progress = 0;
 				size_t numSent = 0;
@@ -2689,11 +2939,14 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 				bool lastTransferSent = false;
 				// Each iteration of this loop sends one transfer packet (or terminates).
 				while(true) {
+					// Pinned pages can only be released once all packets are acked.
+					bool drain = lastTransferSent
+							|| (pinned.mapping && pinnedProgress == pinned.size);
 					bool anyRemoteFault = false;
 					while(numSent != numAcked) {
 						// If there is anything more to send, we only need to wait until
 						// at least one buffer is not in-flight (otherwise, we wait for all).
-						if(!lastTransferSent && numSent - numAcked < xferBuffers.size())
+						if(!drain && numSent - numAcked < window)
 							break;
 						auto ackPacket = co_await node->flowQueue.async_get();
 						assert(ackPacket);
@@ -2702,6 +2955,11 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 						++numAcked;
 					}
 
+					if(pinned.mapping && pinnedProgress == pinned.size) {
+						assert(numSent == numAcked);
+						space->unpinRange(pinned);
+					}
+
 					if(lastTransferSent) {
 						if(anyRemoteFault) {
 							node->_error = Error::remoteFault;
@@ -2729,18 +2987,60 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 						break;
 					}
 
-					// Prepare a buffer an send it.
-					assert(numSent - numAcked < xferBuffers.size());
-					auto &xb = xferBuffers[numSent & (xferBuffers.size() - 1)];
-					if(!xb.size())
-						xb = frg::unique_memory<KernelAlloc>{*kernelAlloc, 4096};
+					co_await thread->mainWorkQueue()->enter();
+
+					// Advance to the next scatter-gather item.
+					// If the items changed since submission, we treat this as a fault.
+					bool outcome = true;
+					while(segmentProgress == segment.length) {
+						if(!isSg || sgIndex == recipe->length
+								|| !readUserObject(sglist + sgIndex, segment)) {
+							outcome = false;
+							break;
+						}
+						++sgIndex;
+						segmentProgress = 0;
+					}
+
+					auto address = reinterpret_cast<uintptr_t>(segment.buffer) + segmentProgress;
+					auto chunkSize = frg::min(node->_maxLength - progress,
+							segment.length - segmentProgress);
+					void *data = nullptr;
+					if(outcome && zeroCopy) {
+						auto misalign = address & (kPageSize - 1);
+						if(!pinned.mapping) {
+							auto pinOutcome = co_await space->pinRange(address,
+									frg::min(chunkSize, zeroCopyFlowWindow * kPageSize - misalign),
+									thread->mainWorkQueue()->take());
+							if(pinOutcome) {
+								pinned = std::move(pinOutcome.value());
+								pinnedProgress = 0;
+							}else{
+								outcome = false;
+							}
+						}
 
-					auto chunkSize = frg::min(recipe->length - progress, xb.size());
-					assert(chunkSize);
+						if(outcome) {
+							chunkSize = frg::min(chunkSize, pinned.size - pinnedProgress);
+							chunkSize = frg::min(chunkSize, kPageSize - misalign);
+							auto &accessor = inflightAccessors[numSent % zeroCopyFlowWindow];
+							accessor = PageAccessor{pinned.physicalAt(address)};
+							data = reinterpret_cast<std::byte *>(accessor.get()) + misalign;
+							pinnedProgress += chunkSize;
+						}
+					}else if(outcome) {
+						// Prepare a buffer an send it.
+						assert(numSent - numAcked < xferBuffers.size());
+						auto &xb = xferBuffers[numSent & (xferBuffers.size() - 1)];
+						if(!xb.size())
+							xb = frg::unique_memory<KernelAlloc>{*kernelAlloc, 4096};
+
+						chunkSize = frg::min(chunkSize, xb.size());
+						outcome = readUserMemory(xb.data(),
+								reinterpret_cast<void *>(address), chunkSize);
+						data = xb.data();
+					}
 
-					co_await thread->mainWorkQueue()->enter();
-					auto outcome = readUserMemory(xb.data(),
-							reinterpret_cast<std::byte *>(recipe->buffer) + progress, chunkSize);
 					if(!outcome) {
 						// Send the packet (may deallocate the peer!).
 						peer->flowQueue.put({ .terminate = true, .fault = true });
@@ -2757,18 +3057,23 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 						node->_error = Error::fault;
 						break;
 					}
+					assert(chunkSize);
 
-					lastTransferSent = (progress + chunkSize == recipe->length);
+					lastTransferSent = (progress + chunkSize == node->_maxLength);
 					// Send the packet (may deallocate the peer!).
 					peer->flowQueue.put({
-						.data = xb.data(),
+						.data = data,
 						.size = chunkSize,
 						.terminate = lastTransferSent
 					});
 					++numSent;
 					progress += chunkSize;
+					segmentProgress += chunkSize;
 				}
 
+				if(pinned.mapping)
+					space->unpinRange(pinned);
+
 				node->complete();
 			}else if(recipe->type == kHelActionRecvToBuffer
 					&& peer->tag() == kTagSendKernelBuffer) {
@@ -2866,7 +3171,7 @@ HelError helShutdownLane(HelHandle handle) {
 	LaneHandle lane;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!wrapper)
@@ -2969,7 +3274,7 @@ HelError helRaiseEvent(HelHandle handle) {
 	AnyDescriptor descriptor;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!wrapper)
@@ -3024,7 +3329,7 @@ HelError helAcknowledgeIrq(HelHandle handle, uint32_t flags, uint64_t sequence)
 	smarter::shared_ptr<IrqObject> irq;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto irq_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!irq_wrapper)
@@ -3146,7 +3451,7 @@ HelError helSubmitAwaitEvent(HelHandle handle, uint64_t sequence,
 	smarter::shared_ptr<IpcQueue> queue;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!wrapper)
@@ -3193,7 +3498,7 @@ HelError helAutomateIrq(HelHandle handle, uint32_t flags, HelHandle kernlet_hand
 	smarter::shared_ptr<BoundKernlet> kernlet;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto irq_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!irq_wrapper)
@@ -3247,7 +3552,7 @@ HelError helEnableIo(HelHandle handle) {
 	smarter::shared_ptr<IoSpace> io_space;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!wrapper)
@@ -3286,7 +3591,7 @@ HelError helBindKernlet(HelHandle handle, const HelKernletData *data, size_t num
 	smarter::shared_ptr<KernletObject> kernlet;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto kernlet_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!kernlet_wrapper)
@@ -3314,7 +3619,7 @@ HelError helBindKernlet(HelHandle handle, const HelKernletData *data, size_t num
 			smarter::shared_ptr<MemoryView> memory;
 			{
 				auto irq_lock = frg::guard(&irqMutex());
-				Universe::Guard universe_guard(this_universe->lock);
+				Universe::ReadGuard universe_guard;
 
 				auto wrapper = this_universe->getDescriptor(universe_guard, d.handle);
 				if(!wrapper)
@@ -3341,7 +3646,7 @@ HelError helBindKernlet(HelHandle handle, const HelKernletData *data, size_t num
 			smarter::shared_ptr<BitsetEvent> event;
 			{
 				auto irq_lock = frg::guard(&irqMutex());
-				Universe::Guard universe_guard(this_universe->lock);
+				Universe::ReadGuard universe_guard;
 
 				auto wrapper = this_universe->getDescriptor(universe_guard, d.handle);
 				if(!wrapper)
@@ -3373,7 +3678,7 @@ HelError helGetAffinity(HelHandle handle, uint8_t *mask, size_t size, size_t *ac
 	smarter::borrowed_ptr<Thread> thread;
 	{
 		auto irq_lock = frg::guard(&irqMutex());
-		Universe::Guard universe_guard(this_universe->lock);
+		Universe::ReadGuard universe_guard;
 
 		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 		if(!thread_wrapper)
@@ -3426,7 +3731,7 @@ HelError helSetAffinity(HelHandle handle, uint8_t *mask, size_t size) {
 		smarter::borrowed_ptr<Thread> thread;
 		{
 			auto irq_lock = frg::guard(&irqMutex());
-			Universe::Guard universe_guard(this_universe->lock);
+			Universe::ReadGuard universe_guard;
 
 			auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
 			if(!thread_wrapper)
@@ -11,19 +11,28 @@ namespace thor {
 // IpcQueue
 // ----------------------------------------------------------------------------
 
+namespace {
+	// Upper bound on the number of chunks (including chunks that are added later).
+	constexpr size_t maxChunks = 4096;
+	// Upper bound on the number of elements that are published at once.
+	constexpr size_t maxBatchSize = 64;
+
+	size_t reservedPerChunk(size_t chunkSize) {
+		return (sizeof(ChunkStruct) + chunkSize + 63) & ~size_t(63);
+	}
+}
+
 IpcQueue::IpcQueue(unsigned int ringShift, unsigned int numChunks, size_t chunkSize)
-: _ringShift{ringShift}, _chunkSize{chunkSize}, _chunkOffsets{*kernelAlloc},
+: _ringShift{ringShift}, _chunkSize{chunkSize}, _chunks{*kernelAlloc},
 		_currentIndex{0}, _currentProgress{0}, _anyNodes{false} {
 	auto chunksOffset = (sizeof(QueueStruct) + (sizeof(int) << ringShift) + 63) & ~size_t(63);
-	auto reservedPerChunk = (sizeof(ChunkStruct) + chunkSize + 63) & ~size_t(63);
-	auto overallSize = chunksOffset + numChunks * reservedPerChunk;
+	auto overallSize = chunksOffset + numChunks * reservedPerChunk(chunkSize);
 
 	// Setup internal state.
 	_memory = smarter::allocate_shared<ImmediateMemory>(*kernelAlloc, overallSize);
 	_memory->selfPtr = _memory;
-	_chunkOffsets.resize(numChunks);
 	for(unsigned int i = 0; i < numChunks; ++i)
-		_chunkOffsets[i] = chunksOffset + i * reservedPerChunk;
+		_chunks.push(Chunk{_memory, chunksOffset + i * reservedPerChunk(chunkSize)});
 
 	async::detach_with_allocator(*kernelAlloc, _runQueue());
 }
@@ -32,6 +41,43 @@ bool IpcQueue::validSize(size_t size) {
 	return sizeof(ElementStruct) + size <= _chunkSize;
 }
 
+frg::expected<Error, smarter::shared_ptr<ImmediateMemory>>
+IpcQueue::addChunks(unsigned int numChunks) {
+	if(!numChunks || numChunks > maxChunks)
+		return Error::illegalArgs;
+
+	auto memory = smarter::allocate_shared<ImmediateMemory>(*kernelAlloc,
+			numChunks * reservedPerChunk(_chunkSize));
+	memory->selfPtr = memory;
+
+	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	if(_chunks.size() + numChunks > maxChunks)
+		return Error::illegalArgs;
+	for(unsigned int i = 0; i < numChunks; ++i)
+		_chunks.push(Chunk{memory, i * reservedPerChunk(_chunkSize)});
+	return memory;
+}
+
+IpcQueue::Stats IpcQueue::getStats() {
+	size_t numChunks;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&_mutex);
+
+		numChunks = _chunks.size();
+	}
+
+	return {
+		.numElements = _numElements.load(std::memory_order_relaxed),
+		.numBatches = _numBatches.load(std::memory_order_relaxed),
+		.numWakes = _numWakes.load(std::memory_order_relaxed),
+		.numStalls = _numStalls.load(std::memory_order_relaxed),
+		.numChunks = numChunks
+	};
+}
+
 void IpcQueue::submit(IpcNode *node) {
 	{
 		auto irqLock = frg::guard(&irqMutex());
@@ -75,24 +121,27 @@ coroutine<void> IpcQueue::_runQueue() {
 			if(pastCurrentChunk)
 				break;
 
+			// Elements are pending but user-space did not supply a chunk.
+			_numStalls.fetch_add(1, std::memory_order_relaxed);
+
 			auto hfOffset = offsetof(QueueStruct, headFutex);
 			co_await getGlobalFutexRealm()->wait(_memory->getImmediateFutex(hfOffset),
 					_currentIndex | kHeadWaiters);
 		}
 
 		// Lock the chunk.
-		size_t chunkOffset;
+		Chunk chunk;
 		{
 			auto irqLock = frg::guard(&irqMutex());
 			auto lock = frg::guard(&_mutex);
 
 			size_t iq = + _currentIndex & ((size_t{1} << _ringShift) - 1);
 			size_t cn = *_memory->accessImmediate<int>(offsetof(QueueStruct, indexQueue) + iq * sizeof(int));
-			assert(cn < _chunkOffsets.size());
-			chunkOffset = _chunkOffsets[cn];
+			assert(cn < _chunks.size());
+			chunk = _chunks[cn];
 		}
 
-		auto chunkHead = _memory->accessImmediate<ChunkStruct>(chunkOffset);
+		auto chunkHead = chunk.memory->accessImmediate<ChunkStruct>(chunk.offset);
 
 		// This inner loop runs until the chunk is exhausted.
 		while(true) {
@@ -102,27 +151,34 @@ coroutine<void> IpcQueue::_runQueue() {
 			if(!_anyNodes.load(std::memory_order_relaxed))
 				continue;
 
-			// Check if there is enough space in the current chunk.
-			IpcNode *node;
-			uintptr_t progress;
-			{
-				auto irqLock = frg::guard(&irqMutex());
-				auto lock = frg::guard(&_mutex);
+			// Emit all elements that are pending (and fit into the chunk) but only publish
+			// them once. This way, user-space is woken up once per batch.
+			NodeList batch;
+			size_t batchSize = 0;
+			bool retireChunk = false;
+			while(batchSize < maxBatchSize) {
+				IpcNode *node;
+				{
+					auto irqLock = frg::guard(&irqMutex());
+					auto lock = frg::guard(&_mutex);
+
+					if(_nodeQueue.empty())
+						break;
+					node = _nodeQueue.front();
+				}
 
-				assert(!_nodeQueue.empty());
-				node = _nodeQueue.front();
-				progress = _currentProgress;
-			}
+				// Compute the overall length of the element.
+				size_t length = 0;
+				for(auto sgSource = node->_source; sgSource; sgSource = sgSource->link)
+					length += (sgSource->size + 7) & ~size_t(7);
+				assert(length <= _chunkSize);
 
-			// Compute the overall length of the element.
-			size_t length = 0;
-			for(auto sgSource = _nodeQueue.front()->_source; sgSource; sgSource = sgSource->link)
-				length += (sgSource->size + 7) & ~size_t(7);
-			assert(length <= _chunkSize);
+				// Check if we need to retire the current chunk.
+				if(_currentProgress + length > _chunkSize) {
+					retireChunk = true;
+					break;
+				}
 
-			// Check if we need to retire the current chunk.
-			bool emitElement = true;
-			if(progress + length <= _chunkSize) {
 				// Emit the next element to the current chunk.
 				auto elementOffset = offsetof(ChunkStruct, buffer) + _currentProgress;
 				assert(!(elementOffset & 0x7));
@@ -131,60 +187,64 @@ coroutine<void> IpcQueue::_runQueue() {
 				memset(&element, 0, sizeof(element));
 				element.length = length;
 				element.context = reinterpret_cast<void *>(node->_context);
-				_memory->writeImmediate(chunkOffset + elementOffset,
+				chunk.memory->writeImmediate(chunk.offset + elementOffset,
 						&element, sizeof(ElementStruct));
 
 				size_t sgOffset = sizeof(ElementStruct);
 				for(auto sgSource = node->_source; sgSource; sgSource = sgSource->link) {
-					_memory->writeImmediate(chunkOffset + elementOffset + sgOffset,
+					chunk.memory->writeImmediate(chunk.offset + elementOffset + sgOffset,
 							sgSource->pointer, sgSource->size);
 					sgOffset += (sgSource->size + 7) & ~size_t(7);
 				}
-			}else{
-				emitElement = false;
+
+				// Update our internal state and retire the node.
+				{
+					auto irqLock = frg::guard(&irqMutex());
+					auto lock = frg::guard(&_mutex);
+
+					_currentProgress += sizeof(ElementStruct) + length;
+					_nodeQueue.pop_front();
+
+					assert(_anyNodes.load(std::memory_order_relaxed));
+					if(_nodeQueue.empty())
+						_anyNodes.store(false, std::memory_order_relaxed);
+				}
+
+				batch.push_back(node);
+				++batchSize;
 			}
 
 			// Update the progress futex.
-			unsigned int newProgressWord;
-			if(emitElement) {
-				newProgressWord = progress + sizeof(ElementStruct) + length;
-			}else{
-				newProgressWord = progress | kProgressDone;
-			}
+			unsigned int newProgressWord = _currentProgress;
+			if(retireChunk)
+				newProgressWord |= kProgressDone;
 
 			auto progressFutexWord = __atomic_exchange_n(&chunkHead->progressFutex,
 					newProgressWord, __ATOMIC_RELEASE);
 			// If user-space modifies any non-flags field, that's a contract violation.
 			// TODO: Shut down the queue in this case.
 			if(progressFutexWord & kProgressWaiters) {
-				auto pfOffset = chunkOffset + offsetof(ChunkStruct, progressFutex);
-				getGlobalFutexRealm()->wake(_memory->resolveImmediateFutex(pfOffset));
+				auto pfOffset = chunk.offset + offsetof(ChunkStruct, progressFutex);
+				getGlobalFutexRealm()->wake(chunk.memory->resolveImmediateFutex(pfOffset));
+				_numWakes.fetch_add(1, std::memory_order_relaxed);
 			}
+			_numElements.fetch_add(batchSize, std::memory_order_relaxed);
+			_numBatches.fetch_add(1, std::memory_order_relaxed);
 
 			// Update our internal state and retire the chunk.
-			if(!emitElement) {
+			if(retireChunk) {
 				auto irqLock = frg::guard(&irqMutex());
 				auto lock = frg::guard(&_mutex);
 
 				_currentIndex = ((_currentIndex + 1) & kHeadMask);
 				_currentProgress = 0;
-				break;
 			}
 
-			// Update our internal state and retire the node.
-			{
-				auto irqLock = frg::guard(&irqMutex());
-				auto lock = frg::guard(&_mutex);
+			while(!batch.empty())
+				batch.pop_front()->complete();
 
-				_currentProgress += sizeof(ElementStruct) + length;
-				_nodeQueue.pop_front();
-
-				assert(_anyNodes.load(std::memory_order_relaxed));
-				if(_nodeQueue.empty())
-					_anyNodes.store(false, std::memory_order_relaxed);
-			}
-
-			node->complete();
+			if(retireChunk)
+				break;
 		}
 	}
 }
@@ -9,6 +9,7 @@
 #include <thor-internal/stream.hpp>
 #include <thor-internal/timer.hpp>
 #include <thor-internal/mbus.hpp>
+#include <thor-internal/physical.hpp>
 
 #include <bragi/helpers-frigg.hpp>
 #include <bragi/helpers-all.hpp>
@@ -71,6 +72,48 @@ private:
 			auto cmdlineError = co_await SendBufferSender{lane, std::move(cmdlineBuffer)};
 			if(cmdlineError != Error::success)
 				co_return cmdlineError;
+		}else if(preamble.id() == bragi::message_id<managarm::kerncfg::GetMemoryStatsRequest>) {
+			auto req = bragi::parse_head_only<managarm::kerncfg::GetMemoryStatsRequest>(reqBuffer, *kernelAlloc);
+
+			if (!req)
+				co_return Error::protocolViolation;
+
+			auto stats = physicalAllocator->collectCacheStats();
+
+			managarm::kerncfg::MemoryStatsResponse<KernelAlloc> resp(*kernelAlloc);
+			resp.set_error(managarm::kerncfg::Error::SUCCESS);
+			resp.set_total_pages(physicalAllocator->numTotalPages());
+			resp.set_used_pages(physicalAllocator->numUsedPages());
+			resp.set_free_pages(physicalAllocator->numFreePages());
+			resp.set_cached_pages(stats.cachedPages);
+			resp.set_cache_hits(stats.hits);
+			resp.set_cache_misses(stats.misses);
+			resp.set_cache_refills(stats.refills);
+			resp.set_cache_drains(stats.drains);
+
+			frg::unique_memory<KernelAlloc> respBuffer{*kernelAlloc, resp.size_of_head()};
+			bragi::write_head_only(resp, respBuffer);
+			auto respError = co_await SendBufferSender{lane, std::move(respBuffer)};
+			if(respError != Error::success)
+				co_return respError;
+		}else if(preamble.id() == bragi::message_id<managarm::kerncfg::GetTimerStatsRequest>) {
+			auto req = bragi::parse_head_only<managarm::kerncfg::GetTimerStatsRequest>(reqBuffer, *kernelAlloc);
+
+			if (!req)
+				co_return Error::protocolViolation;
+
+			auto stats = generalTimerEngine()->getStats();
+
+			managarm::kerncfg::TimerStatsResponse<KernelAlloc> resp(*kernelAlloc);
+			resp.set_error(managarm::kerncfg::Error::SUCCESS);
+			resp.set_alarms_fired(stats.alarmsFired);
+			resp.set_timers_expired(stats.timersExpired);
+
+			frg::unique_memory<KernelAlloc> respBuffer{*kernelAlloc, resp.size_of_head()};
+			bragi::write_head_only(resp, respBuffer);
+			auto respError = co_await SendBufferSender{lane, std::move(respBuffer)};
+			if(respError != Error::success)
+				co_return respError;
 		}else{
 			managarm::kerncfg::SvrResponse<KernelAlloc> resp(*kernelAlloc);
 			resp.set_error(managarm::kerncfg::Error::ILLEGAL_REQUEST);
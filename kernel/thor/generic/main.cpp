@@ -615,6 +615,14 @@ void handleSyscall(SyscallImageAccessor image) {
 	case kHelCallCancelAsync: {
 		*image.error() = helCancelAsync((HelHandle)arg0, (uint64_t)arg1);
 	} break;
+	case kHelCallAddQueueChunks: {
+		HelHandle handle;
+		*image.error() = helAddQueueChunks((HelHandle)arg0, (unsigned int)arg1, &handle);
+		*image.out0() = handle;
+	} break;
+	case kHelCallQueryQueueStats: {
+		*image.error() = helQueryQueueStats((HelHandle)arg0, (HelQueueStats *)arg1);
+	} break;
 
 	case kHelCallAllocateMemory: {
 		HelHandle handle;
@@ -667,6 +675,11 @@ void handleSyscall(SyscallImageAccessor image) {
 		*image.error() = helCreateSpace(&handle);
 		*image.out0() = handle;
 	} break;
+	case kHelCallForkSpace: {
+		auto handle = (HelHandle)arg2;
+		*image.error() = helForkSpace((HelForkArea *)arg0, (size_t)arg1, &handle);
+		*image.out0() = handle;
+	} break;
 	case kHelCallMapMemory: {
 		void *actual_pointer;
 		*image.error() = helMapMemory((HelHandle)arg0, (HelHandle)arg1,
@@ -800,6 +813,12 @@ void handleSyscall(SyscallImageAccessor image) {
 				(HelHandle)arg1, (uintptr_t)arg2, &async_id);
 		*image.out0() = async_id;
 	} break;
+	case kHelCallSubmitAwaitClockWithSlack: {
+		uint64_t async_id;
+		*image.error() = helSubmitAwaitClockWithSlack((uint64_t)arg0, (uint64_t)arg1,
+				(HelHandle)arg2, (uintptr_t)arg3, &async_id);
+		*image.out0() = async_id;
+	} break;
 
 	case kHelCallCreateStream: {
 		HelHandle lane1;
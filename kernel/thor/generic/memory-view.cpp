@@ -11,6 +11,9 @@ namespace {
 	constexpr bool logUsage = false;
 	constexpr bool logUncaching = false;
 
+	// Back suitably sized AllocatedMemory by kHugePageSize chunks if possible.
+	constexpr bool enableHugePages = true;
+
 	// The following flags are debugging options to debug the correctness of various components.
 	constexpr bool tortureUncaching = false;
 	constexpr bool disableUncaching = false;
@@ -330,6 +333,10 @@ bool MemoryView::asyncLockRange(uintptr_t offset, size_t size,
 	return true;
 }
 
+frg::tuple<PhysicalAddr, CachingMode> MemoryView::peekHugeRange(uintptr_t) {
+	return frg::tuple<PhysicalAddr, CachingMode>{PhysicalAddr(-1), CachingMode::null};
+}
+
 coroutine<frg::expected<Error>>
 MemoryView::touchRange(uintptr_t offset, size_t size,
 		FetchFlags flags, smarter::shared_ptr<WorkQueue> wq) {
@@ -596,7 +603,7 @@ size_t HardwareMemory::getLength() {
 
 AllocatedMemory::AllocatedMemory(size_t desiredLngth,
 		int addressBits, size_t desiredChunkSize, size_t chunkAlign)
-: _physicalChunks{*kernelAlloc},
+: _physicalChunks{*kernelAlloc}, _groupStates{*kernelAlloc},
 		_addressBits{addressBits}, _chunkAlign{chunkAlign} {
 	static_assert(sizeof(unsigned long) == sizeof(uint64_t), "Fix use of __builtin_clzl");
 	_chunkSize = size_t(1) << (64 - __builtin_clzl(desiredChunkSize - 1));
@@ -614,6 +621,12 @@ AllocatedMemory::AllocatedMemory(size_t desiredLngth,
 	assert(_chunkAlign % kPageSize == 0);
 	assert(_chunkSize % _chunkAlign == 0);
 	_physicalChunks.resize(length / _chunkSize, PhysicalAddr(-1));
+
+	// Memory with address restrictions is usually used for DMA; do not waste it.
+	_allowHuge = enableHugePages && kHugePagesSupported
+			&& _addressBits >= 64 && _chunkSize < kHugePageSize;
+	if(_allowHuge)
+		_groupStates.resize(length / kHugePageSize, GroupState::unknown);
 }
 
 AllocatedMemory::~AllocatedMemory() {
@@ -622,7 +635,14 @@ AllocatedMemory::~AllocatedMemory() {
 	if(logUsage)
 		infoLogger() << "thor: Releasing AllocatedMemory ("
 				<< (physicalAllocator->numUsedPages() * 4) << " KiB in use)" << frg::endlog;
+	size_t chunksPerGroup = kHugePageSize / _chunkSize;
 	for(size_t i = 0; i < _physicalChunks.size(); ++i) {
+		if(_allowHuge && i / chunksPerGroup < _groupStates.size()
+				&& _groupStates[i / chunksPerGroup] == GroupState::huge) {
+			if(!(i % chunksPerGroup))
+				physicalAllocator->free(_physicalChunks[i], kHugePageSize);
+			continue;
+		}
 		if(_physicalChunks[i] != PhysicalAddr(-1))
 			physicalAllocator->free(_physicalChunks[i], _chunkSize);
 	}
@@ -640,6 +660,8 @@ void AllocatedMemory::resize(size_t newSize, async::any_receiver<void> receiver)
 		size_t num_chunks = newSize / _chunkSize;
 		assert(num_chunks >= _physicalChunks.size());
 		_physicalChunks.resize(num_chunks, PhysicalAddr(-1));
+		if(_allowHuge)
+			_groupStates.resize(newSize / kHugePageSize, GroupState::unknown);
 	}
 	receiver.set_value();
 }
@@ -675,6 +697,60 @@ frg::tuple<PhysicalAddr, CachingMode> AllocatedMemory::peekRange(uintptr_t offse
 			CachingMode::null};
 }
 
+frg::tuple<PhysicalAddr, CachingMode> AllocatedMemory::peekHugeRange(uintptr_t offset) {
+	assert(!(offset & (kHugePageSize - 1)));
+
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	if(_chunkSize >= kHugePageSize) {
+		auto index = offset / _chunkSize;
+		auto disp = offset & (_chunkSize - 1);
+		assert(index < _physicalChunks.size());
+
+		// Chunks are naturally aligned since they are allocated from the buddy allocator.
+		if(_physicalChunks[index] == PhysicalAddr(-1))
+			return frg::tuple<PhysicalAddr, CachingMode>{PhysicalAddr(-1), CachingMode::null};
+		return frg::tuple<PhysicalAddr, CachingMode>{_physicalChunks[index] + disp,
+				CachingMode::null};
+	}
+
+	auto group = offset / kHugePageSize;
+	if(!_allowHuge || group >= _groupStates.size() || _groupStates[group] != GroupState::huge)
+		return frg::tuple<PhysicalAddr, CachingMode>{PhysicalAddr(-1), CachingMode::null};
+	return frg::tuple<PhysicalAddr, CachingMode>{_physicalChunks[offset / _chunkSize],
+			CachingMode::null};
+}
+
+bool AllocatedMemory::_hugeGroupEligible(size_t group) {
+	if(!_allowHuge || group >= _groupStates.size())
+		return false;
+	if(_groupStates[group] != GroupState::unknown)
+		return false;
+
+	// Chunks can already be present if the group only became complete due to resize().
+	size_t chunksPerGroup = kHugePageSize / _chunkSize;
+	for(size_t i = 0; i < chunksPerGroup; i++) {
+		if(_physicalChunks[group * chunksPerGroup + i] != PhysicalAddr(-1)) {
+			_groupStates[group] = GroupState::small;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool AllocatedMemory::_installHugeGroup(size_t group, PhysicalAddr physical) {
+	if(!_hugeGroupEligible(group))
+		return false;
+
+	size_t chunksPerGroup = kHugePageSize / _chunkSize;
+	for(size_t i = 0; i < chunksPerGroup; i++) {
+		_physicalChunks[group * chunksPerGroup + i] = physical + i * _chunkSize;
+	}
+	_groupStates[group] = GroupState::huge;
+	return true;
+}
+
 coroutine<frg::expected<Error, PhysicalRange>>
 AllocatedMemory::fetchRange(uintptr_t offset, FetchFlags, smarter::shared_ptr<WorkQueue>) {
 	auto irq_lock = frg::guard(&irqMutex());
@@ -682,9 +758,35 @@ AllocatedMemory::fetchRange(uintptr_t offset, FetchFlags, smarter::shared_ptr<Wo
 
 	auto index = offset / _chunkSize;
 	auto disp = offset & (_chunkSize - 1);
+	auto group = offset / kHugePageSize;
 	assert(index < _physicalChunks.size());
 
+	if(_physicalChunks[index] == PhysicalAddr(-1) && _hugeGroupEligible(group)) {
+		// Clearing a huge page takes long; do not block other faults on this object meanwhile.
+		lock.unlock();
+		irq_lock.unlock();
+
+		auto physical = physicalAllocator->allocate(kHugePageSize, _addressBits);
+		if(physical != PhysicalAddr(-1)) {
+			assert(!(physical & (kHugePageSize - 1)));
+			for(size_t pg_progress = 0; pg_progress < kHugePageSize; pg_progress += kPageSize) {
+				PageAccessor accessor{physical + pg_progress};
+				memset(accessor.get(), 0, kPageSize);
+			}
+		}
+
+		irq_lock.lock();
+		lock.lock();
+
+		// Another fault might have populated the group in the meantime.
+		if(physical != PhysicalAddr(-1) && !_installHugeGroup(group, physical))
+			physicalAllocator->free(physical, kHugePageSize);
+	}
+
 	if(_physicalChunks[index] == PhysicalAddr(-1)) {
+		if(_allowHuge && group < _groupStates.size())
+			_groupStates[group] = GroupState::small;
+
 		auto physical = physicalAllocator->allocate(_chunkSize, _addressBits);
 		assert(physical != PhysicalAddr(-1) && "OOM");
 		assert(!(physical & (_chunkAlign - 1)));
@@ -925,6 +1027,54 @@ void ManagedSpace::_progressManagement(ManageList &pending) {
 	}
 }
 
+// This implements an on-demand readahead scheme similar to Linux':
+// the first miss of a stream reads a small window. Once the consumer reaches
+// the marker (i.e., the start of the most recent window), we asynchronously
+// read the next window and double its size, up to maxReadaheadPages.
+// Misses that are not sequential restart the stream. Pages that are already
+// being read (e.g., pages of the in-flight window) do not count as misses.
+void ManagedSpace::_updateReadahead(size_t index, bool missing) {
+	if(!readahead)
+		return;
+
+	size_t start, size, marker;
+	if(index == _readaheadMarker) {
+		start = _readaheadStart + _readaheadSize;
+		size = frg::min(2 * _readaheadSize, maxReadaheadPages);
+		marker = start;
+	}else if(missing) {
+		start = index;
+		if(_readaheadSize && index == _readaheadStart + _readaheadSize) {
+			// The consumer outran the readahead.
+			size = frg::min(2 * _readaheadSize, maxReadaheadPages);
+		}else{
+			size = initialReadaheadPages;
+		}
+		marker = index + 1;
+	}else{
+		return;
+	}
+
+	if(start >= numPages) {
+		_readaheadMarker = ~size_t{0};
+		return;
+	}
+	size = frg::min(size, numPages - start);
+
+	for(size_t i = 0; i < size; ++i) {
+		auto [pit, wasInserted] = pages.find_or_insert(start + i, this, start + i);
+		assert(pit);
+		if(pit->loadState == kStateMissing) {
+			pit->loadState = kStateWantInitialization;
+			_initializationList.push_back(&pit->cachePage);
+		}
+	}
+
+	_readaheadStart = start;
+	_readaheadSize = size;
+	_readaheadMarker = (marker < start + size) ? marker : ~size_t{0};
+}
+
 void ManagedSpace::_progressMonitors(MonitorList &pending) {
 	// TODO: Accelerate this by storing the monitors in a RB tree ordered by their progress.
 	auto progressNode = [&] (MonitorNode *node) -> bool {
@@ -1210,6 +1360,20 @@ FrontalMemory::fetchRange(uintptr_t offset, FetchFlags flags, smarter::shared_pt
 				globalReclaimer->addPage(&pit->cachePage);
 			}
 
+			if(index != _managed->_readaheadMarker)
+				co_return PhysicalRange{physical + misalign, kPageSize - misalign,
+						CachingMode::null};
+
+			// Issue the next readahead window but do not wait for it.
+			_managed->_updateReadahead(index, false);
+			_managed->_progressManagement(pendingManagement);
+			lock.unlock();
+			irq_lock.unlock();
+
+			while(!pendingManagement.empty()) {
+				auto node = pendingManagement.pop_front();
+				node->complete();
+			}
 			co_return PhysicalRange{physical + misalign, kPageSize - misalign, CachingMode::null};
 		}else{
 			assert(pit->loadState == ManagedSpace::kStateMissing
@@ -1224,24 +1388,13 @@ FrontalMemory::fetchRange(uintptr_t offset, FetchFlags flags, smarter::shared_pt
 		}
 
 		// We have to take the slow-path, i.e., perform the fetch asynchronously.
-		if(pit->loadState == ManagedSpace::kStateMissing) {
+		bool missing = pit->loadState == ManagedSpace::kStateMissing;
+		if(missing) {
 			pit->loadState = ManagedSpace::kStateWantInitialization;
 			_managed->_initializationList.push_back(&pit->cachePage);
 		}
 
-		// Perform readahead.
-		if(_managed->readahead)
-			for(size_t i = 1; i < 4; ++i) {
-				if(!(index + i < _managed->numPages))
-					break;
-				auto [pit, wasInserted] = _managed->pages.find_or_insert(
-						index + i, _managed.get(), index + i);
-				assert(pit);
-				if(pit->loadState == ManagedSpace::kStateMissing) {
-					pit->loadState = ManagedSpace::kStateWantInitialization;
-					_managed->_initializationList.push_back(&pit->cachePage);
-				}
-			}
+		_managed->_updateReadahead(index, missing);
 
 		_managed->_progressManagement(pendingManagement);
 
@@ -5,6 +5,7 @@
 #include <thor-internal/fiber.hpp>
 #include <thor-internal/kernel-io.hpp>
 #include <thor-internal/main.hpp>
+#include <thor-internal/memory-view.hpp>
 #include <thor-internal/ostrace.hpp>
 #include <thor-internal/stream.hpp>
 #include <thor-internal/timer.hpp>
@@ -61,6 +62,142 @@ void commitOsTrace(R record) {
 	globalOsTraceRing->enqueue(ser.data(), ser.size(), !intsAreEnabled());
 }
 
+// --------------------------------------------------------------------------------------
+// Per-process rings.
+// --------------------------------------------------------------------------------------
+
+// Processes write EventRecords into a ring that is shared with the kernel instead of
+// sending one request per event. The kernel drains the rings into the global ring.
+// The layout must match the definition in protocols/ostrace.
+//
+// The first page contains the RingHeader, the ring itself starts at kPageSize.
+// Each record starts with a RecordHeader and occupies a multiple of 16 bytes.
+// Producers reserve space by advancing head and commit a record by storing its
+// position into the RecordHeader. If a record does not fit into the remainder
+// of the ring, producers fill the remainder by a padding record (length zero).
+
+constexpr size_t ringSize = 64 * 1024;
+constexpr uint64_t ringDrainInterval = 10'000'000;
+
+struct RingHeader {
+	alignas(64) std::atomic<uint64_t> head;
+	alignas(64) std::atomic<uint64_t> tail;
+	alignas(64) std::atomic<uint64_t> dropped;
+	uint64_t size;
+};
+
+struct RecordHeader {
+	std::atomic<uint64_t> position;
+	uint32_t extent;
+	uint32_t length;
+};
+
+static_assert(sizeof(RecordHeader) == 16);
+
+std::atomic<uint64_t> nextSource{1};
+
+struct OsTraceRing {
+	OsTraceRing(uint64_t source)
+	: source{source} {
+		memory = smarter::allocate_shared<ImmediateMemory>(*kernelAlloc, kPageSize + ringSize);
+		memory->selfPtr = memory;
+		memory->accessImmediate<RingHeader>(0)->size = ringSize;
+	}
+
+	void drain() {
+		if(broken)
+			return;
+
+		auto ringHeader = memory->accessImmediate<RingHeader>(0);
+		while(true) {
+			auto offset = tail & (ringSize - 1);
+			auto recordHeader = memory->accessImmediate<RecordHeader>(kPageSize + offset);
+			if(recordHeader->position.load(std::memory_order_acquire) != tail)
+				break;
+
+			// The memory is writable by user space, hence validate everything that we read.
+			auto extent = __atomic_load_n(&recordHeader->extent, __ATOMIC_RELAXED);
+			auto length = __atomic_load_n(&recordHeader->length, __ATOMIC_RELAXED);
+			if(extent < sizeof(RecordHeader) || (extent & 15) || extent > ringSize - offset
+					|| length > extent - sizeof(RecordHeader)) {
+				infoLogger() << "thor: Invalid record in ostrace ring " << source
+						<< frg::endlog;
+				broken = true;
+				return;
+			}
+
+			if(length && !commitRecord(kPageSize + offset + sizeof(RecordHeader), length)) {
+				infoLogger() << "thor: Malformed EventRecord in ostrace ring " << source
+						<< frg::endlog;
+				broken = true;
+				return;
+			}
+
+			tail += extent;
+			ringHeader->tail.store(tail, std::memory_order_release);
+		}
+	}
+
+	uint64_t dropped() {
+		return memory->accessImmediate<RingHeader>(0)->dropped.load(std::memory_order_relaxed);
+	}
+
+	smarter::shared_ptr<ImmediateMemory> memory;
+	uint64_t source;
+	std::atomic<bool> closed{false};
+
+private:
+	bool commitRecord(uintptr_t offset, size_t length) {
+		frg::small_vector<char, 64, KernelAlloc> buffer(*kernelAlloc);
+		buffer.resize(length);
+		memory->readImmediate(offset, buffer.data(), length);
+		frg::span<const char> span{buffer.data(), length};
+
+		auto preamble = bragi::read_preamble(span);
+		if(preamble.error()
+				|| preamble.id() != bragi::message_id<managarm::ostrace::EventRecord>
+				|| 8 + preamble.tail_size() != length)
+			return false;
+
+		auto maybeRecord = bragi::parse_head_tail<managarm::ostrace::EventRecord>(
+				span.subspan(0, 8), span.subspan(8, preamble.tail_size()), *kernelAlloc);
+		if(!maybeRecord)
+			return false;
+		auto &record = maybeRecord.value();
+
+		// Keep the timestamp that the process took when it emitted the event.
+		record.set_source(source);
+		commitOsTrace(std::move(record));
+		return true;
+	}
+
+	uint64_t tail = 0;
+	bool broken = false;
+};
+
+coroutine<void> watchOsTraceRing(OsTraceRing *ring, LaneHandle lane) {
+	// The process never sends anything over this lane; it closes it once it stops tracing.
+	co_await RecvBufferSender{lane};
+	ring->closed.store(true, std::memory_order_release);
+}
+
+coroutine<void> runOsTraceRing(OsTraceRing *ring) {
+	while(true) {
+		co_await generalTimerEngine()->sleepWithSlack(ringDrainInterval, ringDrainInterval / 2);
+
+		// Drain once more after the lane was closed to pick up the final records.
+		auto last = ring->closed.load(std::memory_order_acquire);
+		ring->drain();
+		if(last)
+			break;
+	}
+
+	if(auto dropped = ring->dropped(); dropped)
+		infoLogger() << "thor: ostrace ring " << ring->source << " dropped "
+				<< dropped << " records" << frg::endlog;
+	frg::destruct(*kernelAlloc, ring);
+}
+
 } // anonymous namespace
 
 OsTraceEventId announceOsTraceEvent(frg::string_view name) {
@@ -175,6 +312,50 @@ private:
 				co_return Error::protocolViolation;
 			}
 		} break;
+		case bragi::message_id<managarm::ostrace::OpenRingReq>: {
+			auto maybeReq = bragi::parse_head_tail<managarm::ostrace::OpenRingReq>(
+					headSpan, tailSpan, *kernelAlloc);
+			if(!maybeReq)
+				co_return Error::protocolViolation;
+
+			managarm::ostrace::Response<KernelAlloc> resp(*kernelAlloc);
+			OsTraceRing *ring = nullptr;
+			if(osTraceInUse.load(std::memory_order_relaxed)) {
+				auto source = nextSource.fetch_add(1, std::memory_order_relaxed);
+				ring = frg::construct<OsTraceRing>(*kernelAlloc, source);
+				resp.set_error(managarm::ostrace::Error::SUCCESS);
+				resp.set_id(source);
+			}else{
+				resp.set_error(managarm::ostrace::Error::OSTRACE_GLOBALLY_DISABLED);
+			}
+
+			frg::string<KernelAlloc> ser(*kernelAlloc);
+			resp.SerializeToString(&ser);
+			frg::unique_memory<KernelAlloc> respBuffer{*kernelAlloc, ser.size()};
+			memcpy(respBuffer.data(), ser.data(), ser.size());
+			auto respError = co_await SendBufferSender{lane, std::move(respBuffer)};
+			if(respError != Error::success) {
+				if(ring)
+					frg::destruct(*kernelAlloc, ring);
+				assert(isRemoteIpcError(respError));
+				co_return Error::protocolViolation;
+			}
+
+			if(!ring)
+				break;
+
+			auto memoryError = co_await PushDescriptorSender{lane,
+					MemoryViewDescriptor{ring->memory}};
+			if(memoryError != Error::success) {
+				frg::destruct(*kernelAlloc, ring);
+				assert(isRemoteIpcError(memoryError));
+				co_return Error::protocolViolation;
+			}
+
+			// The ring stays alive until the process closes the conversation lane.
+			async::detach_with_allocator(*kernelAlloc, watchOsTraceRing(ring, lane));
+			async::detach_with_allocator(*kernelAlloc, runOsTraceRing(ring));
+		} break;
 		case bragi::message_id<managarm::ostrace::AnnounceEventReq>: {
 			auto maybeReq = bragi::parse_head_tail<managarm::ostrace::AnnounceEventReq>(
 					headSpan, tailSpan, *kernelAlloc);
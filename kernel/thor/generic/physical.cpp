@@ -1,4 +1,6 @@
 #include <assert.h>
+#include <string.h>
+#include <frg/utility.hpp>
 #include <thor-internal/arch/paging.hpp>
 #include <thor-internal/cpu-data.hpp>
 #include <thor-internal/debug.hpp>
@@ -36,8 +38,8 @@ PhysicalChunkAllocator::PhysicalChunkAllocator() {
 
 void PhysicalChunkAllocator::bootstrapRegion(PhysicalAddr address,
 		int order, size_t numRoots, int8_t *buddyTree) {
-	if(_numRegions >= 8) {
-		infoLogger() << "thor: Ignoring memory region (can only handle 8 regions)"
+	if(_numRegions == _regionCapacity && !_growRegionTable()) {
+		infoLogger() << "thor: Ignoring memory region (failed to grow region table)"
 				<< frg::endlog;
 		return;
 	}
@@ -47,23 +49,69 @@ void PhysicalChunkAllocator::bootstrapRegion(PhysicalAddr address,
 	_allRegions[n].regionSize = numRoots << (order + kPageShift);
 	_allRegions[n].buddyAccessor = BuddyAccessor{address, kPageShift,
 			buddyTree, numRoots, order};
+	_allRegions[n].node = 0;
+	_allRegions[n].nodeOverlap = 0;
 
-	auto currentTotal = _totalPages.load(std::memory_order_relaxed);
-	auto currentFree = _freePages.load(std::memory_order_relaxed);
-	_totalPages.store(currentTotal + (numRoots << order), std::memory_order_relaxed);
-	_freePages.store(currentFree + (numRoots << order), std::memory_order_relaxed);
+	_totalPages.fetch_add(numRoots << order, std::memory_order_relaxed);
+	_freePages.fetch_add(numRoots << order, std::memory_order_relaxed);
 }
 
-PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits) {
-	auto irq_lock = frg::guard(&irqMutex());
-	auto lock = frg::guard(&_mutex);
+void PhysicalChunkAllocator::setNodeOfRange(PhysicalAddr base, size_t length, int node) {
+	for(int i = 0; i < _numRegions; i++) {
+		auto region = &_allRegions[i];
+		auto start = frg::max(region->physicalBase, base);
+		auto end = frg::min(region->physicalBase + region->regionSize, base + length);
+		if(start >= end)
+			continue;
+		if(end - start <= region->nodeOverlap)
+			continue;
+		region->node = node;
+		region->nodeOverlap = end - start;
+	}
+}
+
+bool PhysicalChunkAllocator::_growRegionTable() {
+	int newCapacity = 2 * _regionCapacity;
+	int newOrder = 0;
+	while(newCapacity * sizeof(Region) > (size_t(kPageSize) << newOrder))
+		newOrder++;
 
-	auto currentFree = _freePages.load(std::memory_order_relaxed);
-	auto currentUsed = _usedPages.load(std::memory_order_relaxed);
-	assert(currentFree > size / kPageSize);
-	_freePages.store(currentFree - size / kPageSize, std::memory_order_relaxed);
-	_usedPages.store(currentUsed + size / kPageSize, std::memory_order_relaxed);
+	PhysicalAddr newPhysical;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&_mutex);
+		newPhysical = _allocateFromBuddy(newOrder, 64);
+	}
+	if(newPhysical == static_cast<PhysicalAddr>(-1))
+		return false;
+	_freePages.fetch_sub(size_t{1} << newOrder, std::memory_order_relaxed);
+	_usedPages.fetch_add(size_t{1} << newOrder, std::memory_order_relaxed);
+
+	auto newRegions = reinterpret_cast<Region *>(SkeletalRegion::global().access(newPhysical));
+	for(int i = 0; i < _numRegions; i++)
+		new (&newRegions[i]) Region{_allRegions[i]};
+
+	auto oldPhysical = _regionTablePhysical;
+	auto oldOrder = _regionTableOrder;
+	_allRegions = newRegions;
+	_regionCapacity = newCapacity;
+	_regionTablePhysical = newPhysical;
+	_regionTableOrder = newOrder;
+
+	if(oldPhysical != static_cast<PhysicalAddr>(-1)) {
+		{
+			auto irqLock = frg::guard(&irqMutex());
+			auto lock = frg::guard(&_mutex);
+			_freeToBuddy(oldPhysical, oldOrder);
+		}
+		_usedPages.fetch_sub(size_t{1} << oldOrder, std::memory_order_relaxed);
+		_freePages.fetch_add(size_t{1} << oldOrder, std::memory_order_relaxed);
+	}
+
+	return true;
+}
 
+PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits) {
 	// TODO: This could be solved better.
 	int target = 0;
 	while(size > (size_t(kPageSize) << target))
@@ -73,45 +121,164 @@ PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits) {
 	if(logPhysicalAllocs)
 		infoLogger() << "thor: Allocating physical memory of order "
 					<< (target + kPageShift) << frg::endlog;
-	for(int i = 0; i < _numRegions; i++) {
-		if(target > _allRegions[i].buddyAccessor.tableOrder())
-			continue;
 
-		auto physical = _allRegions[i].buddyAccessor.allocate(target, addressBits);
-		if(physical == BuddyAccessor::illegalAddress)
-			continue;
-	//	infoLogger() << "Allocate " << (void *)physical << frg::endlog;
-		assert(!(physical % (size_t(kPageSize) << target)));
-		return physical;
+	auto irqLock = frg::guard(&irqMutex());
+
+	PhysicalAddr physical;
+	if(target < PhysicalCpuCache::numOrders && addressBits >= 64) {
+		auto cache = &getCpuData()->physicalCache;
+		auto magazine = &cache->magazines[target];
+		if(magazine->count) {
+			cache->numHits.fetch_add(1, std::memory_order_relaxed);
+		}else{
+			cache->numMisses.fetch_add(1, std::memory_order_relaxed);
+			_refillCache(cache, target);
+		}
+
+		if(!magazine->count)
+			return static_cast<PhysicalAddr>(-1);
+		physical = magazine->chunks[--magazine->count];
+		cache->numCachedPages.fetch_sub(size / kPageSize, std::memory_order_relaxed);
+	}else{
+		auto lock = frg::guard(&_mutex);
+
+		physical = _allocateFromBuddy(target, addressBits);
+		if(physical == static_cast<PhysicalAddr>(-1))
+			return physical;
 	}
 
-	return static_cast<PhysicalAddr>(-1);
+	assert(!(physical % (size_t(kPageSize) << target)));
+	auto previousFree = _freePages.fetch_sub(size / kPageSize, std::memory_order_relaxed);
+	assert(previousFree >= size / kPageSize);
+	(void)previousFree;
+	_usedPages.fetch_add(size / kPageSize, std::memory_order_relaxed);
+	return physical;
 }
 
 void PhysicalChunkAllocator::free(PhysicalAddr address, size_t size) {
-	auto irq_lock = frg::guard(&irqMutex());
-	auto lock = frg::guard(&_mutex);
-	
 	int target = 0;
 	while(size > (size_t(kPageSize) << target))
 		target++;
 
+	auto irqLock = frg::guard(&irqMutex());
+
+	auto previousUsed = _usedPages.fetch_sub(size / kPageSize, std::memory_order_relaxed);
+	assert(previousUsed >= size / kPageSize);
+	(void)previousUsed;
+	_freePages.fetch_add(size / kPageSize, std::memory_order_relaxed);
+
+	if(target < PhysicalCpuCache::numOrders) {
+		auto cache = &getCpuData()->physicalCache;
+		auto magazine = &cache->magazines[target];
+		if(magazine->count == PhysicalCpuCache::capacity(target))
+			_drainCache(cache, target, PhysicalCpuCache::batchSize(target));
+
+		magazine->chunks[magazine->count++] = address;
+		cache->numCachedPages.fetch_add(size_t{1} << target, std::memory_order_relaxed);
+		return;
+	}
+
+	auto lock = frg::guard(&_mutex);
+	_freeToBuddy(address, target);
+}
+
+PhysicalCacheStats PhysicalChunkAllocator::collectCacheStats() {
+	PhysicalCacheStats stats;
+	for(int i = 0; i < getCpuCount(); i++) {
+		auto cache = &getCpuData(i)->physicalCache;
+		stats.hits += cache->numHits.load(std::memory_order_relaxed);
+		stats.misses += cache->numMisses.load(std::memory_order_relaxed);
+		stats.refills += cache->numRefills.load(std::memory_order_relaxed);
+		stats.drains += cache->numDrains.load(std::memory_order_relaxed);
+		stats.cachedPages += cache->numCachedPages.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+PhysicalAddr PhysicalChunkAllocator::_allocateFromBuddy(int order, int addressBits) {
+	// Regions that lie entirely below this limit are reserved for
+	// allocations with addressBits < 64 (i.e., DMA) as long as possible.
+	constexpr PhysicalAddr dma32Limit = PhysicalAddr{1} << 32;
+
+	auto localNode = getCpuData()->numaNode;
+
+	// Pass 0: local node, avoiding low memory for unrestricted allocations.
+	// Pass 1: local node.
+	// Pass 2: any node.
+	for(int pass = 0; pass < 3; pass++) {
+		if(pass == 0 && addressBits < 64)
+			continue;
+		for(int i = 0; i < _numRegions; i++) {
+			auto region = &_allRegions[i];
+			if(order > region->buddyAccessor.tableOrder())
+				continue;
+			if(pass < 2 && region->node != localNode)
+				continue;
+			if(pass == 0 && addressBits >= 64
+					&& region->physicalBase + region->regionSize <= dma32Limit)
+				continue;
+			if(pass == 2 && region->node == localNode)
+				continue; // Already tried in pass 1.
+
+			auto physical = region->buddyAccessor.allocate(order, addressBits);
+			if(physical == BuddyAccessor::illegalAddress)
+				continue;
+			return physical;
+		}
+	}
+
+	return static_cast<PhysicalAddr>(-1);
+}
+
+void PhysicalChunkAllocator::_freeToBuddy(PhysicalAddr address, int order) {
+	auto size = size_t(kPageSize) << order;
 	for(int i = 0; i < _numRegions; i++) {
 		if(address < _allRegions[i].physicalBase)
 			continue;
 		if(address + size - _allRegions[i].physicalBase > _allRegions[i].regionSize)
 			continue;
 
-		_allRegions[i].buddyAccessor.free(address, target);
-		auto currentFree = _freePages.load(std::memory_order_relaxed);
-		auto currentUsed = _usedPages.load(std::memory_order_relaxed);
-		assert(currentUsed > size / kPageSize);
-		_freePages.store(currentFree + size / kPageSize, std::memory_order_relaxed);
-		_usedPages.store(currentUsed - size / kPageSize, std::memory_order_relaxed);
+		_allRegions[i].buddyAccessor.free(address, order);
 		return;
 	}
 
 	assert(!"Physical page is not part of any region");
 }
 
+void PhysicalChunkAllocator::_refillCache(PhysicalCpuCache *cache, int order) {
+	auto magazine = &cache->magazines[order];
+	assert(!magazine->count);
+
+	auto lock = frg::guard(&_mutex);
+
+	for(size_t i = 0; i < PhysicalCpuCache::batchSize(order); i++) {
+		auto physical = _allocateFromBuddy(order, 64);
+		if(physical == static_cast<PhysicalAddr>(-1))
+			break;
+		magazine->chunks[magazine->count++] = physical;
+	}
+
+	cache->numRefills.fetch_add(1, std::memory_order_relaxed);
+	cache->numCachedPages.fetch_add(magazine->count << order, std::memory_order_relaxed);
+}
+
+void PhysicalChunkAllocator::_drainCache(PhysicalCpuCache *cache, int order, size_t n) {
+	auto magazine = &cache->magazines[order];
+	assert(n <= magazine->count);
+
+	// Return the least recently freed chunks; the ones at the top are more likely to be cache-hot.
+	{
+		auto lock = frg::guard(&_mutex);
+		for(size_t i = 0; i < n; i++)
+			_freeToBuddy(magazine->chunks[i], order);
+	}
+
+	memmove(magazine->chunks, magazine->chunks + n,
+			(magazine->count - n) * sizeof(PhysicalAddr));
+	magazine->count -= n;
+
+	cache->numDrains.fetch_add(1, std::memory_order_relaxed);
+	cache->numCachedPages.fetch_sub(n << order, std::memory_order_relaxed);
+}
+
 } // namespace thor
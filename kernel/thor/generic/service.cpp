@@ -706,6 +706,7 @@ namespace posix {
 					mbusHandle,
 					nullptr,
 					reinterpret_cast<HelHandle *>(clientFileTable),
+					nullptr,
 					nullptr
 				};
 
@@ -12,6 +12,29 @@ namespace thor {
 
 struct VirtualSpace;
 
+// Tries to map a kHugePageSize page at the cursor's position and advances the cursor on success.
+// This only succeeds if the range is suitably aligned and backed by a huge page of the view.
+template<typename Cursor>
+bool mapHugeByCursor(Cursor &c, MemoryView *view, uintptr_t offset,
+		size_t remaining, PageFlags flags) {
+	if constexpr (!kHugePagesSupported) {
+		return false;
+	}else{
+		if((c.virtualAddress() & (kHugePageSize - 1)) || (offset & (kHugePageSize - 1)))
+			return false;
+		if(remaining < kHugePageSize)
+			return false;
+
+		auto hugeRange = view->peekHugeRange(offset);
+		if(hugeRange.template get<0>() == PhysicalAddr(-1))
+			return false;
+		if(!c.map2m(hugeRange.template get<0>(), flags, hugeRange.template get<1>()))
+			return false;
+		c.moveTo(c.virtualAddress() + kHugePageSize);
+		return true;
+	}
+}
+
 template<typename Cursor, typename PageSpace>
 frg::expected<Error> mapPresentPagesByCursor(PageSpace *ps, VirtualAddr va,
 		MemoryView *view, uintptr_t offset, size_t size, PageFlags flags) {
@@ -22,6 +45,9 @@ frg::expected<Error> mapPresentPagesByCursor(PageSpace *ps, VirtualAddr va,
 	Cursor c{ps, va};
 	while(c.virtualAddress() < va + size) {
 		auto progress = c.virtualAddress() - va;
+		if(mapHugeByCursor(c, view, offset + progress, size - progress, flags))
+			continue;
+
 		auto physicalRange = view->peekRange(offset + progress);
 		if(physicalRange.template get<0>() == PhysicalAddr(-1)) {
 			c.advance4k();
@@ -46,6 +72,18 @@ frg::expected<Error> remapPresentPagesByCursor(PageSpace *ps, VirtualAddr va,
 	while(c.virtualAddress() < va + size) {
 		auto progress = c.virtualAddress() - va;
 
+		// Huge pages that are covered entirely are remapped as a whole; otherwise, they are split.
+		if constexpr (kHugePagesSupported) {
+			if(c.isHuge() && !(c.virtualAddress() & (kHugePageSize - 1))
+					&& size - progress >= kHugePageSize) {
+				auto status = c.unmap2m();
+				if(status & page_status::dirty)
+					view->markDirty(offset + progress, kHugePageSize);
+				if(mapHugeByCursor(c, view, offset + progress, size - progress, flags))
+					continue;
+			}
+		}
+
 		auto status = c.unmap4k();
 		if((status & page_status::present) && (status & page_status::dirty)) {
 			view->markDirty(offset + progress, kPageSize);
@@ -85,6 +123,52 @@ frg::expected<Error> faultPageByCursor(PageSpace *ps, VirtualAddr va,
 	return {};
 }
 
+template<typename Cursor, typename PageSpace>
+frg::expected<Error> faultHugePageByCursor(PageSpace *ps, VirtualAddr va,
+		MemoryView *view, uintptr_t offset, PageFlags flags) {
+	assert(!(va & (kHugePageSize - 1)));
+	assert(!(offset & (kHugePageSize - 1)));
+
+	if constexpr (!kHugePagesSupported) {
+		return Error::fault;
+	}else{
+		Cursor c{ps, va};
+		if(c.isHuge())
+			return {}; // Spurious fault.
+		if(!mapHugeByCursor(c, view, offset, kHugePageSize, flags))
+			return Error::fault;
+		return {};
+	}
+}
+
+template<typename Cursor, typename PageSpace>
+frg::expected<Error> mapResidentPagesByCursor(PageSpace *ps, VirtualAddr va,
+		MemoryView *view, uintptr_t offset, size_t size, PageFlags flags) {
+	assert(!(va & (kPageSize - 1)));
+	assert(!(offset & (kPageSize - 1)));
+	assert(!(size & (kPageSize - 1)));
+
+	Cursor c{ps, va};
+	while(c.virtualAddress() < va + size) {
+		if(c.isPresent()) {
+			c.advance4k();
+			continue;
+		}
+
+		auto progress = c.virtualAddress() - va;
+		auto physicalRange = view->peekRange(offset + progress);
+		if(physicalRange.template get<0>() == PhysicalAddr(-1)) {
+			c.advance4k();
+			continue;
+		}
+		assert(!(physicalRange.template get<0>() & (kPageSize - 1)));
+
+		c.map4k(physicalRange.template get<0>(), flags, physicalRange.template get<1>());
+		c.advance4k();
+	}
+	return {};
+}
+
 template<typename Cursor, typename PageSpace>
 frg::expected<Error> cleanPagesByCursor(PageSpace *ps, VirtualAddr va,
 		MemoryView *view, uintptr_t offset, size_t size) {
@@ -117,6 +201,16 @@ frg::expected<Error> unmapPagesByCursor(PageSpace *ps, VirtualAddr va,
 	while(c.findPresent(va + size)) {
 		auto progress = c.virtualAddress() - va;
 
+		// Huge pages that are covered entirely are unmapped as a whole; otherwise, they are split.
+		if(c.isHuge() && !(c.virtualAddress() & (kHugePageSize - 1))
+				&& size - progress >= kHugePageSize) {
+			auto status = c.unmap2m();
+			if(status & page_status::dirty)
+				view->markDirty(offset + progress, kHugePageSize);
+			c.moveTo(c.virtualAddress() + kHugePageSize);
+			continue;
+		}
+
 		auto status = c.unmap4k();
 		assert(status & page_status::present);
 		if(status & page_status::dirty)
@@ -152,6 +246,16 @@ struct VirtualOperations {
 	virtual frg::expected<Error> faultPage(VirtualAddr va, MemoryView *view,
 			uintptr_t offset, PageFlags flags);
 
+	// Maps a kHugePageSize page at va if the view backs it by a huge page.
+	// Returns Error::fault if that is not possible; callers then fall back to faultPage().
+	virtual frg::expected<Error> faultHugePage(VirtualAddr va, MemoryView *view,
+			uintptr_t offset, PageFlags flags);
+
+	// Like mapPresentPages() but skips pages that are already mapped.
+	// Used to map resident neighbours of a faulting page (i.e., for fault-around).
+	virtual frg::expected<Error> mapResidentPages(VirtualAddr va, MemoryView *view,
+			uintptr_t offset, size_t size, PageFlags flags);
+
 	virtual frg::expected<Error> cleanPages(VirtualAddr va, MemoryView *view,
 			uintptr_t offset, size_t size);
 
@@ -294,7 +398,8 @@ enum MappingFlags : uint32_t {
 	protWrite = 0x20,
 	protExecute = 0x40,
 
-	dontRequireBacking = 0x100
+	dontRequireBacking = 0x100,
+	noFaultAround = 0x200
 };
 
 struct TouchVirtualResult {
@@ -477,7 +582,8 @@ public:
 		kMapProtExecute = 0x20,
 		kMapPopulate = 0x200,
 		kMapDontRequireBacking = 0x400,
-		kMapFixedNoReplace = 0x800
+		kMapFixedNoReplace = 0x800,
+		kMapNoFaultAround = 0x1000
 	};
 
 	enum FaultFlags : uint32_t {
@@ -551,6 +657,21 @@ public:
 		);
 	}
 
+	// Pins (a prefix of) a range such that its physical pages remain valid
+	// until unpinRange() is called. The pinned range never crosses mappings,
+	// hence it may be shorter than requested.
+	struct PinnedRange {
+		PhysicalAddr physicalAt(uintptr_t pointer);
+
+		smarter::shared_ptr<Mapping> mapping;
+		uintptr_t address = 0;
+		size_t size = 0;
+	};
+
+	coroutine<frg::expected<Error, PinnedRange>> pinRange(uintptr_t address, size_t size,
+			smarter::shared_ptr<WorkQueue> wq);
+	void unpinRange(PinnedRange &range);
+
 	// ----------------------------------------------------------------------------------
 	// GlobalFutex support.
 	// ----------------------------------------------------------------------------------
@@ -693,6 +814,18 @@ struct AddressSpace final : VirtualSpace, smarter::crtp_counter<AddressSpace, Bi
 					va, view, offset, flags);
 		}
 
+		frg::expected<Error> faultHugePage(VirtualAddr va, MemoryView *view,
+				uintptr_t offset, PageFlags flags) override {
+			return faultHugePageByCursor<ClientPageSpace::Cursor>(&space_->pageSpace_,
+					va, view, offset, flags);
+		}
+
+		frg::expected<Error> mapResidentPages(VirtualAddr va, MemoryView *view,
+				uintptr_t offset, size_t size, PageFlags flags) override {
+			return mapResidentPagesByCursor<ClientPageSpace::Cursor>(&space_->pageSpace_,
+					va, view, offset, size, flags);
+		}
+
 		frg::expected<Error> cleanPages(VirtualAddr va, MemoryView *view,
 				uintptr_t offset, size_t size) override {
 			return cleanPagesByCursor<ClientPageSpace::Cursor>(&space_->pageSpace_,
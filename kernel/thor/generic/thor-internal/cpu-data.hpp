@@ -3,7 +3,9 @@
 #include <thor-internal/arch/cpu.hpp>
 #include <thor-internal/executor-context.hpp>
 #include <thor-internal/kernel-locks.hpp>
+#include <thor-internal/physical.hpp>
 #include <thor-internal/schedule.hpp>
+#include <thor-internal/timer.hpp>
 
 namespace thor {
 
@@ -29,17 +31,24 @@ struct CpuData : public PlatformCpuData {
 	UniqueKernelStack detachedStack;
 	UniqueKernelStack idleStack;
 	Scheduler scheduler;
+	LocalTimerEngine timerEngine;
 	bool haveVirtualization;
 
 	int cpuIndex;
+	// NUMA node (e.g., ACPI proximity domain) that this CPU belongs to.
+	int numaNode = 0;
 
 	ExecutorContext *executorContext = nullptr;
 	KernelFiber *activeFiber;
 	KernelFiber *wqFiber = nullptr;
 	smarter::shared_ptr<WorkQueue> generalWorkQueue;
 	std::atomic<uint64_t> heartbeat;
+	PhysicalCpuCache physicalCache;
 
 	unsigned int irqEntropySeq = 0;
+	// Odd while this CPU is inside a Universe::ReadGuard.
+	std::atomic<uint64_t> universeReadSeq{0};
+	unsigned int universeReadDepth = 0;
 	std::atomic<ProfileMechanism> profileMechanism{};
 	// TODO: This should be a unique_ptr instead.
 	SingleContextRecordRing *localProfileRing = nullptr;
@@ -4,6 +4,7 @@
 #include <frg/vector.hpp>
 #include <thor-internal/arch/ints.hpp>
 #include <thor-internal/cancel.hpp>
+#include <thor-internal/error.hpp>
 #include <thor-internal/kernel_heap.hpp>
 #include <thor-internal/memory-view.hpp>
 
@@ -105,6 +106,19 @@ public:
 
 	bool validSize(size_t size);
 
+	// Adds chunks that live in a new memory object (returned to the caller).
+	frg::expected<Error, smarter::shared_ptr<ImmediateMemory>> addChunks(unsigned int numChunks);
+
+	struct Stats {
+		uint64_t numElements;
+		uint64_t numBatches;
+		uint64_t numWakes;
+		uint64_t numStalls;
+		uint64_t numChunks;
+	};
+
+	Stats getStats();
+
 	void setupChunk(size_t index, smarter::shared_ptr<AddressSpace, BindableHandle> space, void *pointer);
 
 	void submit(IpcNode *node);
@@ -174,7 +188,13 @@ private:
 	unsigned int _ringShift;
 	size_t _chunkSize;
 
-	frg::vector<size_t, KernelAlloc> _chunkOffsets;
+	struct Chunk {
+		smarter::shared_ptr<ImmediateMemory> memory;
+		size_t offset;
+	};
+
+	// Protected by _mutex.
+	frg::vector<Chunk, KernelAlloc> _chunks;
 
 	// Index into the queue that we are currently processing.
 	int _currentIndex;
@@ -195,6 +215,11 @@ private:
 	// Stores whether any nodes are in the queue.
 	// Written only when _mutex is held (but read outside of _mutex).
 	std::atomic<bool> _anyNodes;
+
+	std::atomic<uint64_t> _numElements{0};
+	std::atomic<uint64_t> _numBatches{0};
+	std::atomic<uint64_t> _numWakes{0};
+	std::atomic<uint64_t> _numStalls{0};
 };
 
 } // namespace thor
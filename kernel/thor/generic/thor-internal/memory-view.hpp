@@ -303,6 +303,11 @@ public:
 	// Result stays valid until the range is evicted.
 	virtual frg::tuple<PhysicalAddr, CachingMode> peekRange(uintptr_t offset) = 0;
 
+	// Like peekRange() but only succeeds if the kHugePageSize bytes starting at offset
+	// are backed by contiguous, kHugePageSize-aligned physical memory.
+	// offset needs to be aligned to kHugePageSize.
+	virtual frg::tuple<PhysicalAddr, CachingMode> peekHugeRange(uintptr_t offset);
+
 	// Makes a range of memory available for peekRange().
 	virtual coroutine<frg::expected<Error>>
 	touchRange(uintptr_t offset, size_t size, FetchFlags flags, smarter::shared_ptr<WorkQueue> wq);
@@ -757,6 +762,21 @@ struct ImmediateMemory final : MemoryView, GlobalFutexSpace {
 		}
 	}
 
+	void readImmediate(uintptr_t offset, void *pointer, size_t size) {
+		size_t progress = 0;
+		while(progress < size) {
+			auto misalign = (offset + progress) & (kPageSize - 1);
+			auto chunk = frg::min(size - progress, kPageSize - misalign);
+
+			auto index = (offset + progress) >> kPageShift;
+			assert(index < _physicalPages.size());
+			PageAccessor accessor{_physicalPages[index]};
+			memcpy(reinterpret_cast<std::byte *>(pointer) + progress,
+					reinterpret_cast<std::byte *>(accessor.get()) + misalign, chunk);
+			progress += chunk;
+		}
+	}
+
 public:
 	// Contract: set by the code that constructs this object.
 	smarter::borrowed_ptr<ImmediateMemory> selfPtr;
@@ -805,6 +825,7 @@ struct AllocatedMemory final : MemoryView, GlobalFutexSpace {
 	Error lockRange(uintptr_t offset, size_t size) override;
 	void unlockRange(uintptr_t offset, size_t size) override;
 	frg::tuple<PhysicalAddr, CachingMode> peekRange(uintptr_t offset) override;
+	frg::tuple<PhysicalAddr, CachingMode> peekHugeRange(uintptr_t offset) override;
 	coroutine<frg::expected<Error, PhysicalRange>>
 			fetchRange(uintptr_t offset, FetchFlags flags,
 			smarter::shared_ptr<WorkQueue> wq) override;
@@ -818,11 +839,28 @@ public:
 	// Contract: set by the code that constructs this object.
 	smarter::borrowed_ptr<AllocatedMemory> selfPtr;
 private:
+	// For chunk sizes below kHugePageSize, chunks are grouped into kHugePageSize groups.
+	// The first fetchRange() in a group tries to back the entire group by a single
+	// contiguous allocation; if that fails, the group is backed by individual chunks.
+	enum class GroupState : uint8_t {
+		unknown,
+		huge,
+		small
+	};
+
+	// Must be called with _mutex held.
+	bool _hugeGroupEligible(size_t group);
+	// Must be called with _mutex held. Re-validates the group since the lock was dropped
+	// while physical was zeroed. Returns false if the group cannot use physical anymore.
+	bool _installHugeGroup(size_t group, PhysicalAddr physical);
+
 	frg::ticket_spinlock _mutex;
 
 	frg::vector<PhysicalAddr, KernelAlloc> _physicalChunks;
+	frg::vector<GroupState, KernelAlloc> _groupStates;
 	int _addressBits;
 	size_t _chunkSize, _chunkAlign;
+	bool _allowHuge;
 };
 
 struct ManagedSpace : CacheBundle {
@@ -879,6 +917,10 @@ struct ManagedSpace : CacheBundle {
 		ManagedSpace *self;
 	};
 
+	// Size of the first and the largest readahead window of a sequential stream.
+	static constexpr size_t initialReadaheadPages = 4;
+	static constexpr size_t maxReadaheadPages = (size_t{2} << 20) >> kPageShift;
+
 	ManagedSpace(size_t length, bool readahead);
 	~ManagedSpace();
 
@@ -890,6 +932,10 @@ struct ManagedSpace : CacheBundle {
 	void _progressManagement(ManageList &pending);
 	void _progressMonitors(MonitorList &pending);
 
+	// Called with mutex held when page index is accessed through the FrontalMemory.
+	// missing indicates that the page was neither present nor already being initialized.
+	void _updateReadahead(size_t index, bool missing);
+
 	smarter::borrowed_ptr<ManagedSpace> selfPtr;
 
 	frg::ticket_spinlock mutex;
@@ -899,6 +945,12 @@ struct ManagedSpace : CacheBundle {
 	size_t numPages;
 	bool readahead;
 
+	// Current readahead window (in pages). Accessing _readaheadMarker means that
+	// the consumer caught up with the window and we start reading the next one.
+	size_t _readaheadStart = 0;
+	size_t _readaheadSize = 0;
+	size_t _readaheadMarker = ~size_t{0};
+
 	EvictionQueue _evictQueue;
 
 	frg::intrusive_list<
@@ -25,6 +25,45 @@ public:
 	void *access(PhysicalAddr physical);
 };
 
+// Per-CPU cache of free physical chunks of small orders.
+// PhysicalChunkAllocator serves allocations from this cache without taking its global lock;
+// the cache is refilled from (and drained to) the buddy allocator in batches.
+// Only accessed by the owning CPU with IRQs disabled; the statistics can be read by any CPU.
+struct PhysicalCpuCache {
+	static constexpr int numOrders = 3;
+	static constexpr size_t maxCapacity = 64;
+
+	// Higher orders hold fewer chunks to bound the amount of memory sitting in caches.
+	static constexpr size_t capacity(int order) {
+		return maxCapacity >> order;
+	}
+
+	static constexpr size_t batchSize(int order) {
+		return capacity(order) / 2;
+	}
+
+	struct Magazine {
+		PhysicalAddr chunks[maxCapacity];
+		size_t count = 0;
+	};
+
+	Magazine magazines[numOrders];
+
+	std::atomic<uint64_t> numHits{0};
+	std::atomic<uint64_t> numMisses{0};
+	std::atomic<uint64_t> numRefills{0};
+	std::atomic<uint64_t> numDrains{0};
+	std::atomic<size_t> numCachedPages{0};
+};
+
+struct PhysicalCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t refills = 0;
+	uint64_t drains = 0;
+	size_t cachedPages = 0;
+};
+
 class PhysicalChunkAllocator {
 	typedef frg::ticket_spinlock Mutex;
 public:
@@ -36,27 +75,60 @@ public:
 	PhysicalAddr allocate(size_t size, int addressBits = 64);
 	void free(PhysicalAddr address, size_t size);
 
+	// Tags all regions that overlap the given range with a NUMA node.
+	// Regions are not split; a region that spans multiple nodes is tagged
+	// with the node that covers most of it.
+	// Intended to be called with information from firmware tables (e.g., ACPI SRAT).
+	void setNodeOfRange(PhysicalAddr base, size_t length, int node);
+
+	// Sums up the statistics of all per-CPU caches.
+	PhysicalCacheStats collectCacheStats();
+
 	size_t numTotalPages() {
 		return _totalPages.load(std::memory_order_relaxed);
 	}
 	size_t numUsedPages() {
 		return _usedPages.load(std::memory_order_relaxed);
 	}
+	// Note that this includes pages that are held by per-CPU caches.
 	size_t numFreePages() {
 		return _freePages.load(std::memory_order_relaxed);
 	}
 
 private:
+	// Grows the region table; it is stored in memory taken from the already known regions.
+	// Only called during boot, before the allocator is used concurrently.
+	bool _growRegionTable();
+
+	// The following functions must be called with _mutex held.
+	PhysicalAddr _allocateFromBuddy(int order, int addressBits);
+	void _freeToBuddy(PhysicalAddr address, int order);
+
+	// The following functions must be called with IRQs disabled.
+	void _refillCache(PhysicalCpuCache *cache, int order);
+	void _drainCache(PhysicalCpuCache *cache, int order, size_t n);
+
 	Mutex _mutex;
 
 	struct Region {
 		PhysicalAddr physicalBase;
 		PhysicalAddr regionSize;
 		BuddyAccessor buddyAccessor;
+		int node = 0;
+		// Number of bytes of the region that are covered by node.
+		size_t nodeOverlap = 0;
 	};
 
-	Region _allRegions[8];
+	static constexpr int numInlineRegions = 8;
+
+	// The region table starts out in _inlineRegions and moves to physical memory
+	// once more regions are bootstrapped.
+	Region _inlineRegions[numInlineRegions];
+	Region *_allRegions = _inlineRegions;
 	int _numRegions = 0;
+	int _regionCapacity = numInlineRegions;
+	PhysicalAddr _regionTablePhysical = static_cast<PhysicalAddr>(-1);
+	int _regionTableOrder = 0;
 
 	std::atomic<size_t> _totalPages{0};
 	std::atomic<size_t> _usedPages{0};
@@ -14,6 +14,7 @@
 namespace thor {
 
 struct PrecisionTimerEngine;
+struct LocalTimerEngine;
 
 struct ClockSource {
 	virtual uint64_t currentNanos() = 0;
@@ -31,6 +32,7 @@ protected:
 	~AlarmSink() = default;
 };
 
+// arm() programs the alarm of the calling CPU and the alarm fires on that CPU.
 struct AlarmTracker {
 	AlarmTracker()
 	: _sink{nullptr} { }
@@ -74,11 +76,17 @@ struct PrecisionTimerNode {
 	};
 
 	friend struct CompareTimer;
-	friend struct PrecisionTimerEngine;
+	friend struct LocalTimerEngine;
 
 	PrecisionTimerNode()
 	: _engine{nullptr}, _cancelCb{this} { }
 
+	// Allows the timer to elapse up to slack nanoseconds after its deadline.
+	// This lets the engine serve nearby deadlines by a single alarm.
+	void setSlack(uint64_t slack) {
+		_slack = slack;
+	}
+
 	void setup(uint64_t deadline, Worklet *elapsed) {
 		_deadline = deadline;
 		_elapsed = elapsed;
@@ -97,12 +105,18 @@ struct PrecisionTimerNode {
 	frg::pairing_heap_hook<PrecisionTimerNode> hook;
 
 private:
+	// Latest point in time at which the timer elapses.
+	uint64_t _latest() const {
+		return _deadline + _slack;
+	}
+
 	uint64_t _deadline;
+	uint64_t _slack = 0;
 	async::cancellation_token _cancelToken;
 	Worklet *_elapsed;
 
-	// TODO: If we allow timer engines to be destructed, this needs to be refcounted.
-	PrecisionTimerEngine *_engine;
+	// Engine of the CPU that the timer was installed on.
+	LocalTimerEngine *_engine;
 
 	TimerState _state = TimerState::none;
 	bool _wasCancelled = false;
@@ -111,21 +125,79 @@ private:
 
 struct CompareTimer {
 	bool operator() (const PrecisionTimerNode *a, const PrecisionTimerNode *b) const {
-		return a->_deadline > b->_deadline;
+		return a->_latest() > b->_latest();
 	}
 };
 
-struct PrecisionTimerEngine final : private AlarmSink {
+struct TimerStats {
+	uint64_t alarmsFired = 0;
+	uint64_t timersExpired = 0;
+};
+
+// Each CPU has its own timer queue. Timers are queued on the CPU that installs them,
+// hence installing timers and processing alarms only takes CPU-local locks.
+// Only cancellation may touch the queue of a remote CPU.
+struct LocalTimerEngine {
+	friend struct PrecisionTimerEngine;
 	friend struct PrecisionTimerNode;
 
 private:
 	using Mutex = frg::ticket_spinlock;
 
 public:
+	LocalTimerEngine() = default;
+
+	LocalTimerEngine(const LocalTimerEngine &) = delete;
+
+	LocalTimerEngine &operator= (const LocalTimerEngine &) = delete;
+
+	TimerStats getStats() {
+		return {
+			.alarmsFired = _alarmsFired.load(std::memory_order_relaxed),
+			.timersExpired = _timersExpired.load(std::memory_order_relaxed)
+		};
+	}
+
+private:
+	// The following functions must be called on the CPU that owns this engine
+	// (except for cancelTimer()).
+	void installTimer(PrecisionTimerNode *timer);
+
+	void cancelTimer(PrecisionTimerNode *timer);
+
+	void firedAlarm();
+
+	void _progress();
+
+	Mutex _mutex;
+
+	frg::pairing_heap<
+		PrecisionTimerNode,
+		frg::locate_member<
+			PrecisionTimerNode,
+			frg::pairing_heap_hook<PrecisionTimerNode>,
+			&PrecisionTimerNode::hook
+		>,
+		CompareTimer
+	> _timerQueue;
+
+	size_t _activeTimers = 0;
+
+	std::atomic<uint64_t> _alarmsFired{0};
+	std::atomic<uint64_t> _timersExpired{0};
+};
+
+struct PrecisionTimerEngine final : private AlarmSink {
+	friend struct LocalTimerEngine;
+
 	PrecisionTimerEngine(ClockSource *clock, AlarmTracker *alarm);
-	
+
+	// Installs the timer on the engine of the current CPU.
 	void installTimer(PrecisionTimerNode *timer);
 
+	// Sums up the statistics of all CPUs.
+	TimerStats getStats();
+
 	// ----------------------------------------------------------------------------------
 	// Sender boilerplate for sleep()
 	// ----------------------------------------------------------------------------------
@@ -145,6 +217,7 @@ public:
 		PrecisionTimerEngine *self;
 		uint64_t deadline;
 		async::cancellation_token cancellation;
+		uint64_t slack = 0;
 	};
 
 	SleepSender sleep(uint64_t deadline, async::cancellation_token cancellation = {}) {
@@ -155,6 +228,11 @@ public:
 		return {this, systemClockSource()->currentNanos() + nanos, cancellation};
 	}
 
+	// Like sleepFor() but the sleep may last up to slack nanoseconds longer.
+	SleepSender sleepWithSlack(uint64_t nanos, uint64_t slack) {
+		return {this, systemClockSource()->currentNanos() + nanos, {}, slack};
+	}
+
 	template<typename R>
 	struct SleepOperation {
 		SleepOperation(SleepSender s, R receiver)
@@ -170,6 +248,7 @@ public:
 				async::execution::set_value(op->receiver_);
 			}, WorkQueue::generalQueue());
 			node_.setup(s_.deadline, &worklet_);
+			node_.setSlack(s_.slack);
 			s_.self->installTimer(&node_);
 		}
 
@@ -188,29 +267,10 @@ public:
 	// ----------------------------------------------------------------------------------
 
 private:
-	void cancelTimer(PrecisionTimerNode *timer);
-
-	void firedAlarm();
-
-private:
-	void _progress();
+	void firedAlarm() override;
 
 	ClockSource *_clock;
 	AlarmTracker *_alarm;
-
-	Mutex _mutex;
-
-	frg::pairing_heap<
-		PrecisionTimerNode,
-		frg::locate_member<
-			PrecisionTimerNode,
-			frg::pairing_heap_hook<PrecisionTimerNode>,
-			&PrecisionTimerNode::hook
-		>,
-		CompareTimer
-	> _timerQueue;
-	
-	size_t _activeTimers;
 };
 
 inline void PrecisionTimerNode::CancelFunctor::operator() () {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <frg/variant.hpp>
 #include <assert.h>
 #include <smarter.hpp>
@@ -240,11 +241,40 @@ typedef frg::variant<
 // Universe.
 // --------------------------------------------------------
 
+// Entry of the descriptor table. Nodes are only freed after a grace period
+// such that lock-free readers can safely dereference them.
+struct DescriptorNode {
+	DescriptorNode(Handle handle, AnyDescriptor descriptor)
+	: handle{handle}, descriptor{std::move(descriptor)} { }
+
+	Handle handle;
+	AnyDescriptor descriptor;
+};
+
+// Open addressing table with linear probing. The capacity is a power of two.
+struct DescriptorTable {
+	size_t capacity;
+	std::atomic<DescriptorNode *> *slots;
+};
+
 struct Universe {
 public:
 	typedef frg::ticket_spinlock Lock;
 	typedef frg::unique_lock<frg::ticket_spinlock> Guard;
 
+	// Read-side critical section that allows descriptor lookups without taking the lock.
+	// IRQs must be disabled while the guard is alive. Readers must not block,
+	// fault or acquire Universe::lock since writers wait for all readers to leave.
+	struct ReadGuard {
+		ReadGuard();
+
+		ReadGuard(const ReadGuard &) = delete;
+
+		~ReadGuard();
+
+		ReadGuard &operator= (const ReadGuard &) = delete;
+	};
+
 	Universe();
 	~Universe();
 
@@ -252,17 +282,28 @@ public:
 
 	AnyDescriptor *getDescriptor(Guard &guard, Handle handle);
 
+	// The returned pointer is only valid until the ReadGuard is destructed.
+	AnyDescriptor *getDescriptor(ReadGuard &guard, Handle handle);
+
 	frg::optional<AnyDescriptor> detachDescriptor(Guard &guard, Handle handle);
 
 	Lock lock;
 
 private:
-	frg::hash_map<
-		Handle,
-		AnyDescriptor,
-		frg::hash<Handle>,
-		KernelAlloc
-	> _descriptorMap;
+	// Waits until all CPUs have left the read-side critical sections
+	// that they were in when this function was called.
+	static void _synchronize();
+
+	static DescriptorTable *_allocateTable(size_t capacity);
+	static void _freeTable(DescriptorTable *table);
+
+	// Moves all live nodes into a fresh table, dropping tombstones on the way.
+	void _rebuildTable(size_t capacity);
+
+	// All fields except for _table are protected by the lock.
+	std::atomic<DescriptorTable *> _table;
+	size_t _numUsed;
+	size_t _numTombstones;
 
 	Handle _nextHandle;
 };
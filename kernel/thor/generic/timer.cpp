@@ -16,21 +16,41 @@ PrecisionTimerEngine::PrecisionTimerEngine(ClockSource *clock, AlarmTracker *ala
 }
 
 void PrecisionTimerEngine::installTimer(PrecisionTimerNode *timer) {
+	// Disable IRQs such that we cannot be migrated while we access the local engine.
+	auto irq_lock = frg::guard(&irqMutex());
+	getCpuData()->timerEngine.installTimer(timer);
+}
+
+TimerStats PrecisionTimerEngine::getStats() {
+	TimerStats stats;
+	for(int i = 0; i < getCpuCount(); i++) {
+		auto local = getCpuData(i)->timerEngine.getStats();
+		stats.alarmsFired += local.alarmsFired;
+		stats.timersExpired += local.timersExpired;
+	}
+	return stats;
+}
+
+void PrecisionTimerEngine::firedAlarm() {
+	// The alarm always fires on the CPU that armed it.
+	getCpuData()->timerEngine.firedAlarm();
+}
+
+void LocalTimerEngine::installTimer(PrecisionTimerNode *timer) {
+	assert(!intsAreEnabled());
 	assert(!timer->_engine);
 	timer->_engine = this;
 
-	auto irq_lock = frg::guard(&irqMutex());
 	auto lock = frg::guard(&_mutex);
 	assert(timer->_state == TimerState::none);
 
 	if(logTimers) {
-		auto current = _clock->currentNanos();
+		auto current = systemClockSource()->currentNanos();
 		infoLogger() << "thor: Setting timer at " << timer->_deadline
-				<< " (counter is " << current << ")" << frg::endlog;
+				<< " (slack " << timer->_slack << ", counter is " << current << ")"
+				<< frg::endlog;
 	}
 
-//	infoLogger() << "thor: Active timers: " << _activeTimers << frg::endlog;
-
 	if(!timer->_cancelCb.try_set(timer->_cancelToken)) {
 		timer->_wasCancelled = true;
 		timer->_state = TimerState::retired;
@@ -45,10 +65,12 @@ void PrecisionTimerEngine::installTimer(PrecisionTimerNode *timer) {
 	_progress();
 }
 
-void PrecisionTimerEngine::cancelTimer(PrecisionTimerNode *timer) {
+void LocalTimerEngine::cancelTimer(PrecisionTimerNode *timer) {
 	auto irq_lock = frg::guard(&irqMutex());
 	auto lock = frg::guard(&_mutex);
 
+	// We do not re-arm the alarm here since this may run on a remote CPU.
+	// At worst, the alarm fires without any timer being due.
 	if(timer->_state == TimerState::queued) {
 		_timerQueue.remove(timer);
 		_activeTimers--;
@@ -61,24 +83,33 @@ void PrecisionTimerEngine::cancelTimer(PrecisionTimerNode *timer) {
 	WorkQueue::post(timer->_elapsed);
 }
 
-void PrecisionTimerEngine::firedAlarm() {
+void LocalTimerEngine::firedAlarm() {
 	auto irq_lock = frg::guard(&irqMutex());
 	auto lock = frg::guard(&_mutex);
 
+	_alarmsFired.fetch_add(1, std::memory_order_relaxed);
 	_progress();
 }
 
 // This function is somewhat complicated because we have to avoid a race between
 // the comparator setup and the main counter.
-void PrecisionTimerEngine::_progress() {
-	auto current = _clock->currentNanos();
+//
+// The queue is ordered by the latest point in time at which timers elapse
+// (i.e., the deadline plus slack) and the alarm is armed for the top of the queue.
+// When it fires, we also complete all timers whose deadline already passed;
+// this coalesces timers with slack into fewer alarms.
+// Like Linux' hrtimers, we stop at the first timer whose deadline did not pass yet,
+// even if timers further down in the queue are already due.
+void LocalTimerEngine::_progress() {
+	auto alarm = generalTimerEngine()->_alarm;
+	auto current = systemClockSource()->currentNanos();
 	do {
 		// Process all timers that elapsed in the past.
 		if(logProgress)
 			infoLogger() << "thor: Processing timers until " << current << frg::endlog;
 		while(true) {
 			if(_timerQueue.empty()) {
-				_alarm->arm(0);
+				alarm->arm(0);
 				return;
 			}
 
@@ -89,6 +120,7 @@ void PrecisionTimerEngine::_progress() {
 			assert(timer->_state == TimerState::queued);
 			_timerQueue.pop();
 			_activeTimers--;
+			_timersExpired.fetch_add(1, std::memory_order_relaxed);
 			if(logProgress)
 				infoLogger() << "thor: Timer completed" << frg::endlog;
 			if(timer->_cancelCb.try_reset()) {
@@ -102,9 +134,9 @@ void PrecisionTimerEngine::_progress() {
 
 		// Setup the comparator and iterate if there was a race.
 		assert(!_timerQueue.empty());
-		_alarm->arm(_timerQueue.top()->_deadline);
-		current = _clock->currentNanos();
-	} while(_timerQueue.top()->_deadline <= current);
+		alarm->arm(_timerQueue.top()->_latest());
+		current = systemClockSource()->currentNanos();
+	} while(_timerQueue.top()->_latest() <= current);
 }
 
 ClockSource *systemClockSource() {
@@ -1,37 +1,208 @@
+#include <thor-internal/arch/ints.hpp>
+#include <thor-internal/cpu-data.hpp>
 #include <thor-internal/universe.hpp>
 
 namespace thor {
 
 namespace {
 	constexpr bool logCleanup = false;
+
+	constexpr size_t initialTableCapacity = 64;
+
+	// Marks slots of detached descriptors. Lookups continue probing past tombstones.
+	DescriptorNode *const tombstone = reinterpret_cast<DescriptorNode *>(uintptr_t{1});
+
+	// Handles are allocated sequentially, hence masking already spreads them evenly.
+	size_t slotOf(DescriptorTable *table, Handle handle, size_t probe) {
+		return (static_cast<size_t>(handle) + probe) & (table->capacity - 1);
+	}
+
+	DescriptorNode *findNode(DescriptorTable *table, Handle handle) {
+		for(size_t i = 0; i < table->capacity; i++) {
+			auto node = table->slots[slotOf(table, handle, i)].load(std::memory_order_acquire);
+			if(!node)
+				return nullptr;
+			if(node != tombstone && node->handle == handle)
+				return node;
+		}
+		return nullptr;
+	}
+}
+
+Universe::ReadGuard::ReadGuard() {
+	assert(!intsAreEnabled());
+	auto cpuData = getCpuData();
+	if(cpuData->universeReadDepth++)
+		return;
+
+	auto seq = cpuData->universeReadSeq.load(std::memory_order_relaxed);
+	cpuData->universeReadSeq.store(seq + 1, std::memory_order_relaxed);
+	// Order the store above before all loads from the table.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+Universe::ReadGuard::~ReadGuard() {
+	auto cpuData = getCpuData();
+	assert(cpuData->universeReadDepth);
+	if(--cpuData->universeReadDepth)
+		return;
+
+	auto seq = cpuData->universeReadSeq.load(std::memory_order_relaxed);
+	cpuData->universeReadSeq.store(seq + 1, std::memory_order_release);
 }
 
 Universe::Universe()
-: _descriptorMap{frg::hash<Handle>{}, *kernelAlloc}, _nextHandle{1} { }
+: _table{_allocateTable(initialTableCapacity)}, _numUsed{0}, _numTombstones{0},
+		_nextHandle{1} { }
 
 Universe::~Universe() {
 	if(logCleanup)
 		infoLogger() << "\e[31mthor: Universe is deallocated\e[39m" << frg::endlog;
+
+	// No readers can exist anymore since nobody holds a reference to the universe.
+	auto table = _table.load(std::memory_order_relaxed);
+	for(size_t i = 0; i < table->capacity; i++) {
+		auto node = table->slots[i].load(std::memory_order_relaxed);
+		if(node && node != tombstone)
+			frg::destruct(*kernelAlloc, node);
+	}
+	_freeTable(table);
 }
 
 Handle Universe::attachDescriptor(Guard &guard, AnyDescriptor descriptor) {
 	assert(guard.protects(&lock));
 
+	// Keep the load factor (including tombstones) below 3/4.
+	auto table = _table.load(std::memory_order_relaxed);
+	if(4 * (_numUsed + _numTombstones + 1) > 3 * table->capacity) {
+		auto capacity = table->capacity;
+		if(4 * (_numUsed + 1) > capacity)
+			capacity *= 2;
+		_rebuildTable(capacity);
+		table = _table.load(std::memory_order_relaxed);
+	}
+
 	Handle handle = _nextHandle++;
-	_descriptorMap.insert(handle, std::move(descriptor));
+	auto node = frg::construct<DescriptorNode>(*kernelAlloc, handle, std::move(descriptor));
+
+	for(size_t i = 0; ; i++) {
+		assert(i < table->capacity);
+		auto &slot = table->slots[slotOf(table, handle, i)];
+		auto current = slot.load(std::memory_order_relaxed);
+		if(current && current != tombstone)
+			continue;
+		if(current == tombstone)
+			_numTombstones--;
+		// Publish the fully constructed node to readers.
+		slot.store(node, std::memory_order_release);
+		break;
+	}
+	_numUsed++;
+
 	return handle;
 }
 
 AnyDescriptor *Universe::getDescriptor(Guard &guard, Handle handle) {
 	assert(guard.protects(&lock));
 
-	return _descriptorMap.get(handle);
+	auto node = findNode(_table.load(std::memory_order_relaxed), handle);
+	if(!node)
+		return nullptr;
+	return &node->descriptor;
+}
+
+AnyDescriptor *Universe::getDescriptor(ReadGuard &, Handle handle) {
+	auto node = findNode(_table.load(std::memory_order_acquire), handle);
+	if(!node)
+		return nullptr;
+	return &node->descriptor;
 }
 
 frg::optional<AnyDescriptor> Universe::detachDescriptor(Guard &guard, Handle handle) {
 	assert(guard.protects(&lock));
 
-	return _descriptorMap.remove(handle);
+	auto table = _table.load(std::memory_order_relaxed);
+	for(size_t i = 0; i < table->capacity; i++) {
+		auto &slot = table->slots[slotOf(table, handle, i)];
+		auto node = slot.load(std::memory_order_relaxed);
+		if(!node)
+			return frg::null_opt;
+		if(node == tombstone || node->handle != handle)
+			continue;
+
+		slot.store(tombstone, std::memory_order_relaxed);
+		_numUsed--;
+		_numTombstones++;
+
+		// Readers may still access the descriptor until the grace period ends.
+		_synchronize();
+
+		frg::optional<AnyDescriptor> descriptor{std::move(node->descriptor)};
+		frg::destruct(*kernelAlloc, node);
+		return descriptor;
+	}
+	return frg::null_opt;
+}
+
+void Universe::_synchronize() {
+	// A writer cannot wait for its own read-side critical section.
+	assert(!getCpuData()->universeReadDepth);
+
+	// Pairs with the fence in ReadGuard: either the reader observes our prior stores
+	// or we observe that the reader is inside its critical section.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	for(int i = 0; i < getCpuCount(); i++) {
+		auto cpuData = getCpuData(i);
+		auto seq = cpuData->universeReadSeq.load(std::memory_order_acquire);
+		if(!(seq & 1))
+			continue;
+		// Readers never block, so this wait is short.
+		while(cpuData->universeReadSeq.load(std::memory_order_acquire) == seq)
+			;
+	}
+}
+
+DescriptorTable *Universe::_allocateTable(size_t capacity) {
+	assert(!(capacity & (capacity - 1)));
+
+	auto slots = static_cast<std::atomic<DescriptorNode *> *>(
+			kernelAlloc->allocate(capacity * sizeof(std::atomic<DescriptorNode *>)));
+	for(size_t i = 0; i < capacity; i++)
+		new (&slots[i]) std::atomic<DescriptorNode *>{nullptr};
+
+	return frg::construct<DescriptorTable>(*kernelAlloc, capacity, slots);
+}
+
+void Universe::_freeTable(DescriptorTable *table) {
+	kernelAlloc->deallocate(table->slots,
+			table->capacity * sizeof(std::atomic<DescriptorNode *>));
+	frg::destruct(*kernelAlloc, table);
+}
+
+void Universe::_rebuildTable(size_t capacity) {
+	auto oldTable = _table.load(std::memory_order_relaxed);
+	auto newTable = _allocateTable(capacity);
+
+	for(size_t i = 0; i < oldTable->capacity; i++) {
+		auto node = oldTable->slots[i].load(std::memory_order_relaxed);
+		if(!node || node == tombstone)
+			continue;
+		for(size_t j = 0; ; j++) {
+			auto &slot = newTable->slots[slotOf(newTable, node->handle, j)];
+			if(slot.load(std::memory_order_relaxed))
+				continue;
+			slot.store(node, std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	_table.store(newTable, std::memory_order_release);
+	_numTombstones = 0;
+
+	// Readers may still probe the old table until the grace period ends.
+	_synchronize();
+	_freeTable(oldTable);
 }
 
 } // namespace thor
@@ -248,6 +248,11 @@ initgraph::Stage *getNsAvailableStage() {
 	return &s;
 }
 
+initgraph::Stage *getApsBootedStage() {
+	static initgraph::Stage s{&globalInitEngine, "acpi.aps-booted"};
+	return &s;
+}
+
 static initgraph::Task initTablesTask{&globalInitEngine, "acpi.init-tables",
 	initgraph::Entails{getTablesDiscoveredStage()},
 	[] {
@@ -399,6 +404,7 @@ static initgraph::Task enterAcpiModeTask{&globalInitEngine, "acpi.enter-acpi-mod
 
 static initgraph::Task bootApsTask{&globalInitEngine, "acpi.boot-aps",
 	initgraph::Requires{&enterAcpiModeTask},
+	initgraph::Entails{getApsBootedStage()},
 	[] {
 		bootOtherProcessors();
 	}
@@ -0,0 +1,136 @@
+#include <thor-internal/cpu-data.hpp>
+#include <thor-internal/debug.hpp>
+#include <thor-internal/main.hpp>
+#include <thor-internal/physical.hpp>
+#include <thor-internal/acpi/acpi.hpp>
+
+#include <lai/core.h>
+
+namespace thor {
+namespace acpi {
+
+// As for the MADT, we mark all SRAT structs as [[gnu::packed]].
+
+struct [[gnu::packed]] SratHeader {
+	uint32_t reserved1;
+	uint64_t reserved2;
+};
+
+struct [[gnu::packed]] SratGenericEntry {
+	uint8_t type;
+	uint8_t length;
+};
+
+struct [[gnu::packed]] SratLocalApicEntry {
+	SratGenericEntry generic;
+	uint8_t proximityDomainLow;
+	uint8_t localApicId;
+	uint32_t flags;
+	uint8_t localSapicEid;
+	uint8_t proximityDomainHigh[3];
+	uint32_t clockDomain;
+};
+
+struct [[gnu::packed]] SratMemoryEntry {
+	SratGenericEntry generic;
+	uint32_t proximityDomain;
+	uint16_t reserved1;
+	uint64_t baseAddress;
+	uint64_t length;
+	uint32_t reserved2;
+	uint32_t flags;
+	uint64_t reserved3;
+};
+
+struct [[gnu::packed]] SratLocalX2ApicEntry {
+	SratGenericEntry generic;
+	uint16_t reserved1;
+	uint32_t proximityDomain;
+	uint32_t x2ApicId;
+	uint32_t flags;
+	uint32_t clockDomain;
+	uint32_t reserved2;
+};
+
+namespace srat_flags {
+	static constexpr uint32_t enabled = 1;
+};
+
+template<typename F>
+void walkSrat(F fn) {
+	void *sratWindow = laihost_scan("SRAT", 0);
+	if(!sratWindow)
+		return;
+	auto srat = reinterpret_cast<acpi_header_t *>(sratWindow);
+
+	size_t offset = sizeof(acpi_header_t) + sizeof(SratHeader);
+	while(offset < srat->length) {
+		auto generic = (SratGenericEntry *)((uint8_t *)srat + offset);
+		if(!generic->length)
+			break;
+		fn(generic);
+		offset += generic->length;
+	}
+}
+
+static initgraph::Task discoverMemoryAffinityTask{&globalInitEngine, "acpi.discover-memory-affinity",
+	initgraph::Requires{getTablesDiscoveredStage()},
+	[] {
+		walkSrat([] (SratGenericEntry *generic) {
+			if(generic->type != 1) // Memory affinity.
+				return;
+			auto entry = (SratMemoryEntry *)generic;
+			if(!(entry->flags & srat_flags::enabled))
+				return;
+
+			uint64_t base = entry->baseAddress;
+			uint64_t length = entry->length;
+			infoLogger() << "thor: Memory at 0x" << frg::hex_fmt{base}
+					<< " (size 0x" << frg::hex_fmt{length} << ")"
+					<< " belongs to proximity domain " << entry->proximityDomain
+					<< frg::endlog;
+			physicalAllocator->setNodeOfRange(base, length, entry->proximityDomain);
+		});
+	}
+};
+
+#ifdef __x86_64__
+static initgraph::Task discoverCpuAffinityTask{&globalInitEngine, "acpi.discover-cpu-affinity",
+	initgraph::Requires{getApsBootedStage()},
+	[] {
+		walkSrat([] (SratGenericEntry *generic) {
+			uint32_t apicId;
+			uint32_t domain;
+			if(generic->type == 0) { // Local APIC affinity.
+				auto entry = (SratLocalApicEntry *)generic;
+				if(!(entry->flags & srat_flags::enabled))
+					return;
+				apicId = entry->localApicId;
+				domain = entry->proximityDomainLow
+						| (uint32_t(entry->proximityDomainHigh[0]) << 8)
+						| (uint32_t(entry->proximityDomainHigh[1]) << 16)
+						| (uint32_t(entry->proximityDomainHigh[2]) << 24);
+			}else if(generic->type == 2) { // Local x2APIC affinity.
+				auto entry = (SratLocalX2ApicEntry *)generic;
+				if(!(entry->flags & srat_flags::enabled))
+					return;
+				apicId = entry->x2ApicId;
+				domain = entry->proximityDomain;
+			}else{
+				return;
+			}
+
+			for(int i = 0; i < getCpuCount(); i++) {
+				auto cpuData = getCpuData(i);
+				if(static_cast<uint32_t>(cpuData->localApicId) != apicId)
+					continue;
+				infoLogger() << "thor: CPU #" << i << " belongs to proximity domain "
+						<< domain << frg::endlog;
+				cpuData->numaNode = domain;
+			}
+		});
+	}
+};
+#endif
+
+} } // namespace thor::acpi
@@ -23,5 +23,6 @@ namespace acpi {
 
 initgraph::Stage *getTablesDiscoveredStage();
 initgraph::Stage *getNsAvailableStage();
+initgraph::Stage *getApsBootedStage();
 
 } } // namespace thor::acpi
@@ -148,6 +148,24 @@ async::result<ReadEntriesResult> File::ptReadEntries(void *object) {
 	return self->readEntries();
 }
 
+async::result<protocols::fs::ReadResult>
+File::ptReadEntriesBatch(void *object, void *buffer, size_t length) {
+	auto self = static_cast<File *>(object);
+	auto result = co_await self->readEntriesBatch(buffer, length);
+	if(!result) {
+		switch(result.error()) {
+		case Error::illegalArguments:
+			co_return protocols::fs::Error::illegalArguments;
+		case Error::illegalOperationTarget:
+			co_return protocols::fs::Error::illegalOperationTarget;
+		default:
+			assert(!"Unexpected error from readEntriesBatch()");
+			__builtin_unreachable();
+		}
+	}
+	co_return result.value();
+}
+
 async::result<frg::expected<protocols::fs::Error>> File::ptTruncate(void *object, size_t size) {
 	auto self = static_cast<File *>(object);
 	return self->truncate(size);
@@ -344,6 +362,11 @@ async::result<ReadEntriesResult> File::readEntries() {
 	throw std::runtime_error("posix: Object has no File::readEntries()");
 }
 
+async::result<frg::expected<Error, size_t>> File::readEntriesBatch(void *, size_t) {
+	// Clients fall back to PT_READ_ENTRIES.
+	co_return Error::illegalOperationTarget;
+}
+
 async::result<protocols::fs::RecvResult>
 File::recvMsg(Process *, uint32_t, void *, size_t,
 		void *, size_t, size_t) {
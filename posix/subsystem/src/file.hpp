@@ -132,6 +132,9 @@ public:
 	static async::result<protocols::fs::ReadEntriesResult>
 	ptReadEntries(void *object);
 
+	static async::result<protocols::fs::ReadResult>
+	ptReadEntriesBatch(void *object, void *buffer, size_t length);
+
 	static async::result<frg::expected<protocols::fs::Error>>
 	ptTruncate(void *object, size_t size);
 
@@ -197,6 +200,7 @@ public:
 		.write = &ptWrite,
 		.pwrite = &ptPwrite,
 		.readEntries = &ptReadEntries,
+		.readEntriesBatch = &ptReadEntriesBatch,
 		.accessMemory = &ptAccessMemory,
 		.truncate = &ptTruncate,
 		.fallocate = &ptAllocate,
@@ -303,6 +307,10 @@ public:
 
 	virtual FutureMaybe<ReadEntriesResult> readEntries();
 
+	// Fills the buffer with protocols::fs::PackedDirent records, see PT_READ_ENTRIES_BATCH.
+	virtual async::result<frg::expected<Error, size_t>>
+	readEntriesBatch(void *buffer, size_t max_length);
+
 	virtual async::result<protocols::fs::RecvResult>
 		recvMsg(Process *process, uint32_t flags,
 			void *data, size_t max_length,
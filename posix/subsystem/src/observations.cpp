@@ -95,6 +95,57 @@ void dumpRegisters(std::shared_ptr<Process> proc) {
 	}
 }
 
+namespace {
+
+struct ExecArguments {
+	std::string path;
+	std::vector<std::string> args;
+	std::vector<std::string> env;
+};
+
+// Splits an area of null-terminated strings.
+std::vector<std::string> parseStringArea(const std::string &area) {
+	std::vector<std::string> strings;
+	size_t k = 0;
+	while(k < area.size()) {
+		auto d = area.find(char(0), k);
+		assert(d != std::string::npos);
+		strings.push_back(area.substr(k, d - k));
+		k = d + 1;
+	}
+	return strings;
+}
+
+// Loads the path, arguments and environment of an execve()-like supercall.
+async::result<ExecArguments> loadExecArguments(std::shared_ptr<Process> self,
+		uintptr_t *gprs) {
+	std::string path;
+	path.resize(gprs[kHelRegArg1]);
+	auto loadPath = co_await helix_ng::readMemory(self->vmContext()->getSpace(),
+			gprs[kHelRegArg0], gprs[kHelRegArg1], path.data());
+	HEL_CHECK(loadPath.error());
+
+	std::string args_area;
+	args_area.resize(gprs[kHelRegArg3]);
+	auto loadArgs = co_await helix_ng::readMemory(self->vmContext()->getSpace(),
+			gprs[kHelRegArg2], gprs[kHelRegArg3], args_area.data());
+	HEL_CHECK(loadArgs.error());
+
+	std::string env_area;
+	env_area.resize(gprs[kHelRegArg5]);
+	auto loadEnv = co_await helix_ng::readMemory(self->vmContext()->getSpace(),
+			gprs[kHelRegArg4], gprs[kHelRegArg5], env_area.data());
+	HEL_CHECK(loadEnv.error());
+
+	co_return ExecArguments{
+		std::move(path),
+		parseStringArea(args_area),
+		parseStringArea(env_area)
+	};
+}
+
+} // anonymous namespace
+
 async::result<void> observeThread(std::shared_ptr<Process> self,
 		std::shared_ptr<Generation> generation) {
 	auto thread = self->threadDescriptor();
@@ -147,7 +198,8 @@ async::result<void> observeThread(std::shared_ptr<Process> self,
 				self->fileContext()->clientMbusLane(),
 				self->clientThreadPage(),
 				static_cast<HelHandle *>(self->clientFileTable()),
-				self->clientClkTrackerPage()
+				self->clientClkTrackerPage(),
+				self->clientIdentityPage()
 			};
 
 			if(logRequests)
@@ -210,50 +262,11 @@ async::result<void> observeThread(std::shared_ptr<Process> self,
 			uintptr_t gprs[kHelNumGprs];
 			HEL_CHECK(helLoadRegisters(thread.getHandle(), kHelRegsGeneral, &gprs));
 
-			std::string path;
-			path.resize(gprs[kHelRegArg1]);
-			auto loadPath = co_await helix_ng::readMemory(self->vmContext()->getSpace(),
-					gprs[kHelRegArg0], gprs[kHelRegArg1], path.data());
-			HEL_CHECK(loadPath.error());
-
-			std::string args_area;
-			args_area.resize(gprs[kHelRegArg3]);
-			auto loadArgs = co_await helix_ng::readMemory(self->vmContext()->getSpace(),
-					gprs[kHelRegArg2], gprs[kHelRegArg3], args_area.data());
-			HEL_CHECK(loadArgs.error());
-
-			std::string env_area;
-			env_area.resize(gprs[kHelRegArg5]);
-			auto loadEnv = co_await helix_ng::readMemory(self->vmContext()->getSpace(),
-					gprs[kHelRegArg4], gprs[kHelRegArg5], env_area.data());
-			HEL_CHECK(loadEnv.error());
+			auto [path, args, env] = co_await loadExecArguments(self, gprs);
 
 			if(logRequests || logPaths)
 				std::cout << "posix: execve path: " << path << std::endl;
 
-			// Parse both the arguments and the environment areas.
-			size_t k;
-
-			std::vector<std::string> args;
-			k = 0;
-			while(k < args_area.size()) {
-				auto d = args_area.find(char(0), k);
-				assert(d != std::string::npos);
-				args.push_back(args_area.substr(k, d - k));
-//				std::cout << "arg: " << args.back() << std::endl;
-				k = d + 1;
-			}
-
-			std::vector<std::string> env;
-			k = 0;
-			while(k < env_area.size()) {
-				auto d = env_area.find(char(0), k);
-				assert(d != std::string::npos);
-				env.push_back(env_area.substr(k, d - k));
-//				std::cout << "env: " << env.back() << std::endl;
-				k = d + 1;
-			}
-
 			auto error = co_await Process::exec(self,
 					path, std::move(args), std::move(env));
 			if(error == Error::noSuchFile) {
@@ -270,6 +283,32 @@ async::result<void> observeThread(std::shared_ptr<Process> self,
 				HEL_CHECK(helResume(thread.getHandle()));
 			}else
 				assert(error == Error::success);
+		}else if(observe.observation() == kHelObserveSuperCall + posix::superSpawn) {
+			if(logRequests)
+				std::cout << "posix: spawn supercall" << std::endl;
+			uintptr_t gprs[kHelNumGprs];
+			HEL_CHECK(helLoadRegisters(thread.getHandle(), kHelRegsGeneral, &gprs));
+
+			auto [path, args, env] = co_await loadExecArguments(self, gprs);
+
+			if(logRequests || logPaths)
+				std::cout << "posix: spawn path: " << path << std::endl;
+
+			auto spawnResult = co_await Process::spawn(self,
+					path, std::move(args), std::move(env));
+
+			gprs[kHelRegError] = kHelErrNone;
+			if(spawnResult) {
+				gprs[kHelRegOut0] = 0;
+				gprs[kHelRegOut1] = spawnResult.value()->pid();
+			}else if(spawnResult.error() == Error::noSuchFile) {
+				gprs[kHelRegOut0] = ENOENT;
+			}else{
+				assert(spawnResult.error() == Error::badExecutable);
+				gprs[kHelRegOut0] = ENOEXEC;
+			}
+			HEL_CHECK(helStoreRegisters(thread.getHandle(), kHelRegsGeneral, &gprs));
+			HEL_CHECK(helResume(thread.getHandle()));
 		}else if(observe.observation() == kHelObserveSuperCall + posix::superExit) {
 			if(logRequests)
 				std::cout << "posix: EXIT supercall" << std::endl;
@@ -1,3 +1,4 @@
+#include <algorithm>
 
 #include <signal.h>
 #include <string.h>
@@ -34,42 +35,51 @@ std::shared_ptr<VmContext> VmContext::create() {
 std::shared_ptr<VmContext> VmContext::clone(std::shared_ptr<VmContext> original) {
 	auto context = std::make_shared<VmContext>();
 
-	HelHandle space;
-	HEL_CHECK(helCreateSpace(&space));
-	context->_space = helix::UniqueDescriptor(space);
-
+	// Fork and map the areas using as few system calls as possible.
+	std::vector<HelForkArea> forkAreas;
+	forkAreas.reserve(original->_areaTree.size());
 	for(const auto &entry : original->_areaTree) {
 		const auto &[address, area] = entry;
 
-		helix::UniqueDescriptor copyView;
+		HelForkArea forkArea{};
 		if(area.copyOnWrite) {
-			HelHandle copyHandle;
-			HEL_CHECK(helForkMemory(area.copyView.getHandle(), &copyHandle));
-			copyView = helix::UniqueDescriptor{copyHandle};
-
-			void *pointer;
-			HelError error = helMapMemory(copyView.getHandle(), context->_space.getHandle(),
-					reinterpret_cast<void *>(address),
-					0, area.areaSize, area.nativeFlags, &pointer);
-			if(error != kHelErrNone && error != kHelErrAlreadyExists) {
-				HEL_CHECK(error);
-			}
+			forkArea.memory = area.copyView.getHandle();
+			forkArea.flags = kHelForkAreaCopyOnWrite;
+			forkArea.offset = 0;
 		}else{
-			void *pointer;
-			HEL_CHECK(helMapMemory(area.fileView.getHandle(), context->_space.getHandle(),
-					reinterpret_cast<void *>(address),
-					area.offset, area.areaSize, area.nativeFlags, &pointer));
+			forkArea.memory = area.fileView.getHandle();
+			forkArea.offset = area.offset;
 		}
+		forkArea.mapFlags = area.nativeFlags;
+		forkArea.pointer = reinterpret_cast<void *>(address);
+		forkArea.size = area.areaSize;
+		forkAreas.push_back(forkArea);
+	}
+
+	HelHandle space = kHelNullHandle;
+	size_t numForked = 0;
+	do {
+		auto n = std::min(forkAreas.size() - numForked, kHelMaxForkAreas);
+		HEL_CHECK(helForkSpace(forkAreas.data() + numForked, n, &space));
+		numForked += n;
+	} while(numForked < forkAreas.size());
+	context->_space = helix::UniqueDescriptor(space);
+
+	size_t i = 0;
+	for(const auto &entry : original->_areaTree) {
+		const auto &[address, area] = entry;
 
 		Area copy;
 		copy.copyOnWrite = area.copyOnWrite;
 		copy.areaSize = area.areaSize;
 		copy.nativeFlags = area.nativeFlags;
 		copy.fileView = area.fileView.dup();
-		copy.copyView = std::move(copyView);
+		if(area.copyOnWrite)
+			copy.copyView = helix::UniqueDescriptor{forkAreas[i].forkedMemory};
 		copy.file = area.file;
 		copy.offset = area.offset;
 		context->_areaTree.emplace(address, std::move(copy));
+		i++;
 	}
 
 	return context;
@@ -888,6 +898,40 @@ bool Process::checkOrRequestSignalRaise() {
 	return false;
 }
 
+void Process::updateIdentityPage() {
+	// The page does not exist yet while the process is being set up.
+	if(!_identityPageMapping)
+		return;
+	auto page = reinterpret_cast<posix::IdentityPage *>(_identityPageMapping.get());
+
+	int32_t pgid = 0;
+	int32_t sid = 0;
+	if(_pgPointer) {
+		pgid = _pgPointer->getHull()->getPid();
+		if(auto session = _pgPointer->getSession(); session)
+			sid = session->getSessionId();
+	}
+
+	// Start the seqlock write.
+	auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_RELAXED);
+	assert(!(seqlock & 1));
+	__atomic_store_n(&page->seqlock, seqlock + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	// Perform the actual update.
+	__atomic_store_n(&page->pid, pid(), __ATOMIC_RELAXED);
+	__atomic_store_n(&page->ppid, _parent ? _parent->pid() : 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->uid, _uid, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->euid, _euid, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->gid, _gid, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->egid, _egid, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->pgid, pgid, __ATOMIC_RELAXED);
+	__atomic_store_n(&page->sid, sid, __ATOMIC_RELAXED);
+
+	// Complete the seqlock write.
+	__atomic_store_n(&page->seqlock, seqlock + 2, __ATOMIC_RELEASE);
+}
+
 async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 	auto hull = std::make_shared<PidHull>(1);
 	auto process = std::make_shared<Process>(std::move(hull), nullptr);
@@ -907,6 +951,11 @@ async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 	process->_threadPageMemory = helix::UniqueDescriptor{thread_memory};
 	process->_threadPageMapping = helix::Mapping{process->_threadPageMemory, 0, 0x1000};
 
+	HelHandle identity_memory;
+	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &identity_memory));
+	process->_identityPageMemory = helix::UniqueDescriptor{identity_memory};
+	process->_identityPageMapping = helix::Mapping{process->_identityPageMemory, 0, 0x1000};
+
 	// The initial signal mask allows all signals.
 	process->_signalMask = 0;
 
@@ -919,6 +968,10 @@ async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 			process->_vmContext->getSpace().getHandle(),
 			nullptr, 0, 0x1000, kHelMapProtRead | kHelMapProtWrite,
 			&process->_clientThreadPage));
+	HEL_CHECK(helMapMemory(process->_identityPageMemory.getHandle(),
+			process->_vmContext->getSpace().getHandle(),
+			nullptr, 0, 0x1000, kHelMapProtRead,
+			&process->_clientIdentityPage));
 	HEL_CHECK(helMapMemory(process->_fileContext->fileTableMemory().getHandle(),
 			process->_vmContext->getSpace().getHandle(),
 			nullptr, 0, 0x1000, kHelMapProtRead,
@@ -933,6 +986,7 @@ async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 	process->_gid = 0;
 	process->_egid = 0;
 	process->_hull->initializeProcess(process.get());
+	process->updateIdentityPage();
 
 	// TODO: Do not pass an empty argument vector?
 	auto execOutcome = co_await execute(process->_fsContext->getRoot(),
@@ -962,16 +1016,8 @@ async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 	co_return process;
 }
 
-std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
-	auto hull = std::make_shared<PidHull>(nextPid++);
-	auto process = std::make_shared<Process>(std::move(hull), original.get());
-	process->_path = original->path();
-	process->_name = original->name();
-	process->_vmContext = VmContext::clone(original->_vmContext);
-	process->_fsContext = FsContext::clone(original->_fsContext);
-	process->_fileContext = FileContext::clone(original->_fileContext);
-	process->_signalContext = SignalContext::clone(original->_signalContext);
-
+helix::UniqueLane Process::setupChild_(const std::shared_ptr<Process> &process,
+		Process *original) {
 	original->_pgPointer->reassociateProcess(process.get());
 
 	HelHandle thread_memory;
@@ -979,7 +1025,12 @@ std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
 	process->_threadPageMemory = helix::UniqueDescriptor{thread_memory};
 	process->_threadPageMapping = helix::Mapping{process->_threadPageMemory, 0, 0x1000};
 
-	// Signal masks are copied on fork().
+	HelHandle identity_memory;
+	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &identity_memory));
+	process->_identityPageMemory = helix::UniqueDescriptor{identity_memory};
+	process->_identityPageMapping = helix::Mapping{process->_identityPageMemory, 0, 0x1000};
+
+	// Signal masks are inherited through both fork() and exec().
 	process->_signalMask = original->_signalMask;
 
 	auto [server_lane, client_lane] = helix::createStream();
@@ -991,6 +1042,10 @@ std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
 			process->_vmContext->getSpace().getHandle(),
 			nullptr, 0, 0x1000, kHelMapProtRead | kHelMapProtWrite,
 			&process->_clientThreadPage));
+	HEL_CHECK(helMapMemory(process->_identityPageMemory.getHandle(),
+			process->_vmContext->getSpace().getHandle(),
+			nullptr, 0, 0x1000, kHelMapProtRead,
+			&process->_clientIdentityPage));
 	HEL_CHECK(helMapMemory(process->_fileContext->fileTableMemory().getHandle(),
 			process->_vmContext->getSpace().getHandle(),
 			nullptr, 0, 0x1000, kHelMapProtRead,
@@ -1000,19 +1055,35 @@ std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
 			nullptr, 0, 0x1000, kHelMapProtRead,
 			&process->_clientClkTrackerPage));
 
-	process->_clientAuxBegin = original->_clientAuxBegin;
-	process->_clientAuxEnd = original->_clientAuxEnd;
 	process->_uid = original->_uid;
 	process->_euid = original->_euid;
 	process->_gid = original->_gid;
 	process->_egid = original->_egid;
 	original->_children.push_back(process);
 	process->_hull->initializeProcess(process.get());
-	process->_didExecute = false;
+	process->updateIdentityPage();
 
 	auto procfs_root = std::static_pointer_cast<procfs::DirectoryNode>(getProcfs()->getTarget());
 	process->_procfs_dir = procfs_root->createProcDirectory(std::to_string(process->_hull->getPid()), process.get());
 
+	return std::move(server_lane);
+}
+
+std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
+	auto hull = std::make_shared<PidHull>(nextPid++);
+	auto process = std::make_shared<Process>(std::move(hull), original.get());
+	process->_path = original->path();
+	process->_name = original->name();
+	process->_vmContext = VmContext::clone(original->_vmContext);
+	process->_fsContext = FsContext::clone(original->_fsContext);
+	process->_fileContext = FileContext::clone(original->_fileContext);
+	process->_signalContext = SignalContext::clone(original->_signalContext);
+
+	auto server_lane = setupChild_(process, original.get());
+	process->_clientAuxBegin = original->_clientAuxBegin;
+	process->_clientAuxEnd = original->_clientAuxEnd;
+	process->_didExecute = false;
+
 	HelHandle new_thread;
 	HEL_CHECK(helCreateThread(process->fileContext()->getUniverse().getHandle(),
 			process->vmContext()->getSpace().getHandle(), kHelAbiSystemV,
@@ -1045,6 +1116,11 @@ std::shared_ptr<Process> Process::clone(std::shared_ptr<Process> original, void
 	process->_threadPageMemory = helix::UniqueDescriptor{thread_memory};
 	process->_threadPageMapping = helix::Mapping{process->_threadPageMemory, 0, 0x1000};
 
+	HelHandle identity_memory;
+	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &identity_memory));
+	process->_identityPageMemory = helix::UniqueDescriptor{identity_memory};
+	process->_identityPageMapping = helix::Mapping{process->_identityPageMemory, 0, 0x1000};
+
 	// Signal masks are copied on clone().
 	process->_signalMask = original->_signalMask;
 
@@ -1057,6 +1133,10 @@ std::shared_ptr<Process> Process::clone(std::shared_ptr<Process> original, void
 			process->_vmContext->getSpace().getHandle(),
 			nullptr, 0, 0x1000, kHelMapProtRead | kHelMapProtWrite,
 			&process->_clientThreadPage));
+	HEL_CHECK(helMapMemory(process->_identityPageMemory.getHandle(),
+			process->_vmContext->getSpace().getHandle(),
+			nullptr, 0, 0x1000, kHelMapProtRead,
+			&process->_clientIdentityPage));
 
 	process->_clientFileTable = original->_clientFileTable;
 	process->_clientClkTrackerPage = original->_clientClkTrackerPage;
@@ -1069,6 +1149,7 @@ std::shared_ptr<Process> Process::clone(std::shared_ptr<Process> original, void
 	process->_egid = original->_egid;
 	original->_children.push_back(process);
 	process->_hull->initializeProcess(process.get());
+	process->updateIdentityPage();
 	process->_didExecute = false;
 
 	auto procfs_root = std::static_pointer_cast<procfs::DirectoryNode>(getProcfs()->getTarget());
@@ -1108,12 +1189,17 @@ async::result<Error> Process::exec(std::shared_ptr<Process> process,
 	client_lane.release();
 
 	void *exec_thread_page;
+	void *exec_identity_page;
 	void *exec_clk_tracker_page;
 	void *exec_client_table;
 	HEL_CHECK(helMapMemory(process->_threadPageMemory.getHandle(),
 			exec_vm_context->getSpace().getHandle(),
 			nullptr, 0, 0x1000, kHelMapProtRead | kHelMapProtWrite,
 			&exec_thread_page));
+	HEL_CHECK(helMapMemory(process->_identityPageMemory.getHandle(),
+			exec_vm_context->getSpace().getHandle(),
+			nullptr, 0, 0x1000, kHelMapProtRead,
+			&exec_identity_page));
 	HEL_CHECK(helMapMemory(clk::trackerPageMemory().getHandle(),
 			exec_vm_context->getSpace().getHandle(),
 			nullptr, 0, 0x1000, kHelMapProtRead,
@@ -1146,6 +1232,7 @@ async::result<Error> Process::exec(std::shared_ptr<Process> process,
 	process->_vmContext = std::move(exec_vm_context);
 	process->_signalContext->resetHandlers();
 	process->_clientThreadPage = exec_thread_page;
+	process->_clientIdentityPage = exec_identity_page;
 	process->_clientPosixLane = exec_posix_lane;
 	process->_clientFileTable = exec_client_table;
 	process->_clientClkTrackerPage = exec_clk_tracker_page;
@@ -1161,6 +1248,50 @@ async::result<Error> Process::exec(std::shared_ptr<Process> process,
 	co_return Error::success;
 }
 
+async::result<frg::expected<Error, std::shared_ptr<Process>>>
+Process::spawn(std::shared_ptr<Process> original,
+		std::string path, std::vector<std::string> args, std::vector<std::string> env) {
+	auto vmContext = VmContext::create();
+	auto fileContext = FileContext::clone(original->_fileContext);
+
+	// Load the executable before the process is created so that we can fail cleanly.
+	auto execResult = FRG_CO_TRY(co_await execute(original->_fsContext->getRoot(),
+			original->_fsContext->getWorkingDirectory(),
+			path, std::move(args), std::move(env), vmContext,
+			fileContext->getUniverse(),
+			fileContext->clientMbusLane(), original.get()));
+
+	auto hull = std::make_shared<PidHull>(nextPid++);
+	auto process = std::make_shared<Process>(std::move(hull), original.get());
+	size_t pos = path.rfind('/');
+	assert(pos != std::string::npos);
+	process->_name = path.substr(pos + 1);
+	process->_path = std::move(path);
+	process->_vmContext = std::move(vmContext);
+	process->_fsContext = FsContext::clone(original->_fsContext);
+	process->_fileContext = std::move(fileContext);
+	process->_signalContext = SignalContext::clone(original->_signalContext);
+
+	// Perform the pre-exec() work that fork() + exec() would do in the child.
+	process->_fileContext->closeOnExec();
+	process->_signalContext->resetHandlers();
+
+	auto server_lane = setupChild_(process, original.get());
+	process->_clientAuxBegin = execResult.auxBegin;
+	process->_clientAuxEnd = execResult.auxEnd;
+	process->_didExecute = true;
+
+	process->_threadDescriptor = std::move(execResult.thread);
+	process->_posixLane = std::move(server_lane);
+
+	auto generation = std::make_shared<Generation>();
+	process->_currentGeneration = generation;
+	helResume(process->_threadDescriptor.getHandle());
+	async::detach(serve(process, std::move(generation)));
+
+	co_return process;
+}
+
 void Process::retire(Process *process) {
 	assert(process->_parent);
 	process->_parent->_childrenUsage.userTime += process->_generationUsage.userTime;
@@ -1258,6 +1389,7 @@ void ProcessGroup::reassociateProcess(Process *process) {
 	}
 	process->_pgPointer = shared_from_this();
 	members_.push_back(*process);
+	process->updateIdentityPage();
 }
 
 void ProcessGroup::dropProcess(Process *process) {
@@ -1298,6 +1430,8 @@ std::shared_ptr<ProcessGroup> TerminalSession::spawnProcessGroup(Process *groupL
 	group->sessionPointer_ = shared_from_this();
 	groups_.push_back(*group);
 	group->hull_->initializeProcessGroup(group.get());
+	// The session ID was not known yet when the leader joined the group.
+	groupLeader->updateIdentityPage();
 	return group;
 }
 
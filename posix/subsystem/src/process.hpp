@@ -381,9 +381,21 @@ struct Process : std::enable_shared_from_this<Process> {
 	static async::result<Error> exec(std::shared_ptr<Process> process,
 			std::string path, std::vector<std::string> args, std::vector<std::string> env);
 
+	// Like fork() followed by exec() in the child, but without copying the address space.
+	static async::result<frg::expected<Error, std::shared_ptr<Process>>>
+	spawn(std::shared_ptr<Process> parent,
+			std::string path, std::vector<std::string> args, std::vector<std::string> env);
+
 	// Called when the PID is released (by waitpid()).
 	static void retire(Process *process);
 
+private:
+	// Sets up the state that fork() and spawn() children share: the thread and identity
+	// pages, the posix lane, the client mappings and the credentials.
+	// Returns the server side of the posix lane.
+	static helix::UniqueLane setupChild_(const std::shared_ptr<Process> &process,
+			Process *original);
+
 public:
 	Process(std::shared_ptr<PidHull> hull, Process *parent);
 
@@ -414,9 +426,11 @@ public:
 		if(_uid == 0 || _euid == 0) {
 			_uid = uid;
 			_euid = uid;
+			updateIdentityPage();
 			return Error::success;
 		} else if(uid == _uid) {
 			_uid = uid;
+			updateIdentityPage();
 			return Error::success;
 		}
 		return Error::accessDenied;
@@ -432,6 +446,7 @@ public:
 		}
 		if(_uid == 0 || _euid == 0 || euid == _uid) {
 			_euid = euid;
+			updateIdentityPage();
 			return Error::success;
 		}
 		return Error::accessDenied;
@@ -448,9 +463,11 @@ public:
 		if(_gid == 0 || _egid == 0) {
 			_gid = gid;
 			_egid = gid;
+			updateIdentityPage();
 			return Error::success;
 		} else if(gid == _gid) {
 			_egid = gid;
+			updateIdentityPage();
 			return Error::success;
 		}
 		return Error::accessDenied;
@@ -466,6 +483,7 @@ public:
 		}
 		if(_gid == 0 || _egid == 0 || _gid == egid || _egid == egid) {
 			_egid = egid;
+			updateIdentityPage();
 			return Error::success;
 		}
 		return Error::accessDenied;
@@ -519,6 +537,7 @@ public:
 	void *clientThreadPage() { return _clientThreadPage; }
 	void *clientFileTable() { return _clientFileTable; }
 	void *clientClkTrackerPage() { return _clientClkTrackerPage; }
+	void *clientIdentityPage() { return _clientIdentityPage; }
 	void *clientAuxBegin() { return _clientAuxBegin; }
 	void *clientAuxEnd() { return _clientAuxEnd; }
 
@@ -526,6 +545,10 @@ public:
 		return reinterpret_cast<ThreadPage *>(_threadPageMapping.get());
 	}
 
+	// Publishes the current IDs of the process to its identity page.
+	// Must be called whenever one of the IDs changes.
+	void updateIdentityPage();
+
 	// Like checkOrRequestSignalRaise() but only check if raising is possible.
 	bool checkSignalRaise();
 
@@ -601,10 +624,14 @@ private:
 	helix::UniqueDescriptor _threadPageMemory;
 	helix::Mapping _threadPageMapping;
 
+	helix::UniqueDescriptor _identityPageMemory;
+	helix::Mapping _identityPageMapping;
+
 	HelHandle _clientPosixLane;
 	void *_clientThreadPage;
 	void *_clientFileTable;
 	void *_clientClkTrackerPage;
+	void *_clientIdentityPage;
 	// Pointers to the aux vector in the client.
 	void *_clientAuxBegin = nullptr;
 	void *_clientAuxEnd = nullptr;
@@ -7,6 +7,7 @@
 #include "device.hpp"
 #include "procfs.hpp"
 #include "process.hpp"
+#include "requests.hpp"
 
 #include <bitset>
 
@@ -234,6 +235,7 @@ std::shared_ptr<Link> DirectoryNode::createRootDirectory() {
 	the_node->_entries.insert(std::move(self_thread_link));
 
 	the_node->directMkregular("uptime", std::make_shared<UptimeNode>());
+	the_node->directMkregular("posix-requests", std::make_shared<RequestStatsNode>());
 
 	auto sysLink = the_node->directMkdir("sys");
 	auto sys = std::static_pointer_cast<DirectoryNode>(sysLink->getTarget());
@@ -367,6 +369,17 @@ async::result<void> UptimeNode::store(std::string) {
 	co_return;
 }
 
+async::result<std::string> RequestStatsNode::show() {
+	// Managarm specific: per-request counters and latency histograms of this subsystem.
+	co_return formatRequestStats();
+}
+
+async::result<void> RequestStatsNode::store(std::string) {
+	// TODO: proper error reporting.
+	std::cout << "posix: Can't store to a /proc/posix-requests file" << std::endl;
+	co_return;
+}
+
 async::result<std::string> OstypeNode::show() {
 	// See man 5 proc for more details.
 	// Based on the man page from Linux man-pages 6.01, updated on 2022-10-09.
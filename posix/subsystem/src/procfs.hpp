@@ -219,6 +219,13 @@ struct UptimeNode final : RegularNode {
 	async::result<void> store(std::string) override;
 };
 
+struct RequestStatsNode final : RegularNode {
+	RequestStatsNode() {}
+
+	async::result<std::string> show() override;
+	async::result<void> store(std::string) override;
+};
+
 struct OstypeNode final : RegularNode {
 	OstypeNode() {}
 
@@ -7,6 +7,9 @@
 #include <sys/timerfd.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <array>
+#include <bit>
+#include <sstream>
 
 #include <helix/timer.hpp>
 
@@ -31,3327 +34,3733 @@
 
 #include "debug-options.hpp"
 
-async::result<void> serveRequests(std::shared_ptr<Process> self,
-		std::shared_ptr<Generation> generation) {
-	async::cancellation_token cancellation = generation->cancelServe;
+namespace {
 
-	async::cancellation_callback cancel_callback{cancellation, [&] {
-		HEL_CHECK(helShutdownLane(self->posixLane().getHandle()));
-	}};
+// State of the request that is currently being served.
+struct RequestContext {
+	template<typename Message = managarm::posix::SvrResponse>
+	async::result<void> sendErrorResponse(managarm::posix::Errors err) {
+		Message resp;
+		resp.set_error(err);
 
-	while(true) {
-		auto [accept, recv_head] = co_await helix_ng::exchangeMsgs(
-				self->posixLane(),
-				helix_ng::accept(
-					helix_ng::recvInline()
-				)
+		auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
 			);
 
-		if(accept.error() == kHelErrLaneShutdown)
-			break;
-		HEL_CHECK(accept.error());
+		HEL_CHECK(send_resp.error());
+	}
 
-		if(recv_head.error() == kHelErrBufferTooSmall) {
-			std::cout << "posix: Rejecting request due to RecvInline overflow" << std::endl;
-			continue;
-		}
-		HEL_CHECK(recv_head.error());
+	std::shared_ptr<Process> self;
+	helix::UniqueDescriptor conversation;
+	helix_ng::RecvInlineResult &recvHead;
+	bragi::preamble preamble;
+};
+
+// Request handlers return false if we should stop serving requests of the process,
+// e.g., because the request could not be decoded.
+using RequestHandler = async::result<bool> (*)(RequestContext &ctx);
+using CntRequestHandler = async::result<bool> (*)(RequestContext &ctx,
+		managarm::posix::CntRequest &req);
+
+async::result<bool> handleGetPid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetPidRequest>(ctx.recvHead);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
+	if(logRequests)
+		std::cout << "posix: GET_PID" << std::endl;
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(ctx.self->pid());
+
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+		ctx.conversation,
+		helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+	);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
 
-		auto conversation = accept.descriptor();
+async::result<bool> handleGetPpid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetPpidRequest>(ctx.recvHead);
 
-		auto sendErrorResponse = [&conversation]<typename Message = managarm::posix::SvrResponse>(managarm::posix::Errors err) -> async::result<void> {
-			Message resp;
-			resp.set_error(err);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	if(logRequests)
+		std::cout << "posix: GET_PPID" << std::endl;
 
-			HEL_CHECK(send_resp.error());
-		};
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(ctx.self->getParent()->pid());
 
-		auto preamble = bragi::read_preamble(recv_head);
-		assert(!preamble.error());
-		recv_head.reset();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-		managarm::posix::CntRequest req;
-		if (preamble.id() == managarm::posix::CntRequest::message_id) {
-			auto o = bragi::parse_head_only<managarm::posix::CntRequest>(recv_head);
-			if (!o) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			req = *o;
-		}
+async::result<bool> handleGetUid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetUidRequest>(ctx.recvHead);
 
-		if(preamble.id() == bragi::message_id<managarm::posix::GetPidRequest>) {
-			auto req = bragi::parse_head_only<managarm::posix::GetPidRequest>(recv_head);
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
-			if(logRequests)
-				std::cout << "posix: GET_PID" << std::endl;
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(self->pid());
+	if(logRequests)
+		std::cout << "posix: GET_UID" << std::endl;
 
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-			);
-			HEL_CHECK(sendResp.error());
-		}else if(preamble.id() == managarm::posix::GetPpidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::GetPpidRequest>(recv_head);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_uid(ctx.self->uid());
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			if(logRequests)
-				std::cout << "posix: GET_PPID" << std::endl;
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(self->getParent()->pid());
+async::result<bool> handleSetUid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::SetUidRequest>(ctx.recvHead);
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetUidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::GetUidRequest>(recv_head);
+	if(logRequests)
+		std::cout << "posix: SET_UID" << std::endl;
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	Error err = ctx.self->setUid(req->uid());
+	if(err == Error::accessDenied) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
+	} else if(err == Error::illegalArguments) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	}
+	co_return true;
+}
 
-			if(logRequests)
-				std::cout << "posix: GET_UID" << std::endl;
+async::result<bool> handleGetEuid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetEuidRequest>(ctx.recvHead);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_uid(self->uid());
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	if(logRequests)
+		std::cout << "posix: GET_EUID" << std::endl;
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SetUidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::SetUidRequest>(recv_head);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_uid(ctx.self->euid());
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			if(logRequests)
-				std::cout << "posix: SET_UID" << std::endl;
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			Error err = self->setUid(req->uid());
-			if(err == Error::accessDenied) {
-				co_await sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
-			} else if(err == Error::illegalArguments) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
-				co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-			}
-		}else if(preamble.id() == managarm::posix::GetEuidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::GetEuidRequest>(recv_head);
+async::result<bool> handleSetEuid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::SetEuidRequest>(ctx.recvHead);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(logRequests)
-				std::cout << "posix: GET_EUID" << std::endl;
+	if(logRequests)
+		std::cout << "posix: SET_EUID" << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_uid(self->euid());
+	Error err = ctx.self->setEuid(req->uid());
+	if(err == Error::accessDenied) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
+	} else if(err == Error::illegalArguments) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	}
+	co_return true;
+}
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+async::result<bool> handleGetGid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetGidRequest>(ctx.recvHead);
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SetEuidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::SetEuidRequest>(recv_head);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if(logRequests)
+		std::cout << "posix: GET_GID" << std::endl;
 
-			if(logRequests)
-				std::cout << "posix: SET_EUID" << std::endl;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_uid(ctx.self->gid());
 
-			Error err = self->setEuid(req->uid());
-			if(err == Error::accessDenied) {
-				co_await sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
-			} else if(err == Error::illegalArguments) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
-				co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-			}
-		}else if(preamble.id() == managarm::posix::GetGidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::GetGidRequest>(recv_head);
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			if(logRequests)
-				std::cout << "posix: GET_GID" << std::endl;
+async::result<bool> handleGetEgid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetEgidRequest>(ctx.recvHead);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_uid(self->gid());
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	if(logRequests)
+		std::cout << "posix: GET_EGID" << std::endl;
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetEgidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::GetEgidRequest>(recv_head);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_uid(ctx.self->egid());
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			if(logRequests)
-				std::cout << "posix: GET_EGID" << std::endl;
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_uid(self->egid());
+async::result<bool> handleSetGid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::SetGidRequest>(ctx.recvHead);
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SetGidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::SetGidRequest>(recv_head);
+	if(logRequests)
+		std::cout << "posix: SET_GID" << std::endl;
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	Error err = ctx.self->setGid(req->uid());
+	if(err == Error::accessDenied) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
+	} else if(err == Error::illegalArguments) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	}
+	co_return true;
+}
 
-			if(logRequests)
-				std::cout << "posix: SET_GID" << std::endl;
+async::result<bool> handleSetEgid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::SetEgidRequest>(ctx.recvHead);
 
-			Error err = self->setGid(req->uid());
-			if(err == Error::accessDenied) {
-				co_await sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
-			} else if(err == Error::illegalArguments) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
-				co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-			}
-		}else if(preamble.id() == managarm::posix::SetEgidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::SetEgidRequest>(recv_head);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if(logRequests)
+		std::cout << "posix: SET_EGID" << std::endl;
 
-			if(logRequests)
-				std::cout << "posix: SET_EGID" << std::endl;
+	Error err = ctx.self->setEgid(req->uid());
+	if(err == Error::accessDenied) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
+	} else if(err == Error::illegalArguments) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	}
+	co_return true;
+}
 
-			Error err = self->setEgid(req->uid());
-			if(err == Error::accessDenied) {
-				co_await sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
-			} else if(err == Error::illegalArguments) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
-				co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-			}
-		}else if(preamble.id() == managarm::posix::WaitIdRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::WaitIdRequest>(recv_head);
+async::result<bool> handleWaitId(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::WaitIdRequest>(ctx.recvHead);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(logRequests)
-				std::cout << "posix: WAIT_ID" << std::endl;
+	if(logRequests)
+		std::cout << "posix: WAIT_ID" << std::endl;
 
-			if(req->flags() & ~(WNOHANG | WCONTINUED | WEXITED | WSTOPPED | WNOWAIT)) {
-				std::cout << "posix: WAIT_ID invalid flags: " << req->flags() << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(req->flags() & ~(WNOHANG | WCONTINUED | WEXITED | WSTOPPED | WNOWAIT)) {
+		std::cout << "posix: WAIT_ID invalid flags: " << req->flags() << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			if(req->flags() & WSTOPPED)
-				std::cout << "\e[31mposix: WAIT_ID flag WSTOPPED is silently ignored\e[39m" << std::endl;
+	if(req->flags() & WSTOPPED)
+		std::cout << "\e[31mposix: WAIT_ID flag WSTOPPED is silently ignored\e[39m" << std::endl;
+
+	if(req->flags() & WCONTINUED)
+		std::cout << "\e[31mposix: WAIT_ID flag WCONTINUED is silently ignored\e[39m" << std::endl;
+
+	if(req->flags() & WNOWAIT)
+		std::cout << "\e[31mposix: WAIT_ID flag WNOWAIT is silently ignored\e[39m" << std::endl;
+
+	TerminationState state;
+	int pid;
+	if(req->idtype() == P_PID) {
+		pid = co_await ctx.self->wait(req->id(), req->flags() & WNOHANG, &state);
+	} else if(req->idtype() == P_ALL) {
+		pid = co_await ctx.self->wait(-1, req->flags() & WNOHANG, &state);
+	} else {
+		std::cout << "\e[31mposix: WAIT_ID idtype other than P_PID and P_ALL are not implemented\e[39m" << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			if(req->flags() & WCONTINUED)
-				std::cout << "\e[31mposix: WAIT_ID flag WCONTINUED is silently ignored\e[39m" << std::endl;
+	helix::SendBuffer send_resp;
+
+	managarm::posix::WaitIdResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(pid);
+	resp.set_uid(ctx.self->findProcess(pid)->uid());
+
+	if(auto byExit = std::get_if<TerminationByExit>(&state); byExit) {
+		resp.set_sig_status(W_EXITCODE(byExit->code, 0));
+		resp.set_sig_code(CLD_EXITED);
+	}else if(auto bySignal = std::get_if<TerminationBySignal>(&state); bySignal) {
+		resp.set_sig_status(W_EXITCODE(0, bySignal->signo));
+		resp.set_sig_code(CLD_KILLED);
+	}else{
+		resp.set_sig_status(0);
+		resp.set_sig_code(0);
+		assert(std::holds_alternative<std::monostate>(state));
+	}
 
-			if(req->flags() & WNOWAIT)
-				std::cout << "\e[31mposix: WAIT_ID flag WNOWAIT is silently ignored\e[39m" << std::endl;
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+		ctx.conversation,
+		helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+	);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
 
-			TerminationState state;
-			int pid;
-			if(req->idtype() == P_PID) {
-				pid = co_await self->wait(req->id(), req->flags() & WNOHANG, &state);
-			} else if(req->idtype() == P_ALL) {
-				pid = co_await self->wait(-1, req->flags() & WNOHANG, &state);
-			} else {
-				std::cout << "\e[31mposix: WAIT_ID idtype other than P_PID and P_ALL are not implemented\e[39m" << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+async::result<bool> handleWait(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: WAIT" << std::endl;
 
-			helix::SendBuffer send_resp;
+	if(req.flags() & ~(WNOHANG | WUNTRACED | WCONTINUED)) {
+		std::cout << "posix: WAIT invalid flags: " << req.flags() << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			managarm::posix::WaitIdResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(pid);
-			resp.set_uid(self->findProcess(pid)->uid());
+	if(req.flags() & WUNTRACED)
+		std::cout << "\e[31mposix: WAIT flag WUNTRACED is silently ignored\e[39m" << std::endl;
 
-			if(auto byExit = std::get_if<TerminationByExit>(&state); byExit) {
-				resp.set_sig_status(W_EXITCODE(byExit->code, 0));
-				resp.set_sig_code(CLD_EXITED);
-			}else if(auto bySignal = std::get_if<TerminationBySignal>(&state); bySignal) {
-				resp.set_sig_status(W_EXITCODE(0, bySignal->signo));
-				resp.set_sig_code(CLD_KILLED);
-			}else{
-				resp.set_sig_status(0);
-				resp.set_sig_code(0);
-				assert(std::holds_alternative<std::monostate>(state));
-			}
+	if(req.flags() & WCONTINUED)
+		std::cout << "\e[31mposix: WAIT flag WCONTINUED is silently ignored\e[39m" << std::endl;
 
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-			);
-			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::WAIT) {
-			if(logRequests)
-				std::cout << "posix: WAIT" << std::endl;
-
-			if(req.flags() & ~(WNOHANG | WUNTRACED | WCONTINUED)) {
-				std::cout << "posix: WAIT invalid flags: " << req.flags() << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	TerminationState state;
+	auto pid = co_await ctx.self->wait(req.pid(), req.flags() & WNOHANG, &state);
 
-			if(req.flags() & WUNTRACED)
-				std::cout << "\e[31mposix: WAIT flag WUNTRACED is silently ignored\e[39m" << std::endl;
+	helix::SendBuffer send_resp;
 
-			if(req.flags() & WCONTINUED)
-				std::cout << "\e[31mposix: WAIT flag WCONTINUED is silently ignored\e[39m" << std::endl;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(pid);
 
-			TerminationState state;
-			auto pid = co_await self->wait(req.pid(), req.flags() & WNOHANG, &state);
+	uint32_t mode = 0;
+	if(auto byExit = std::get_if<TerminationByExit>(&state); byExit) {
+		mode |= W_EXITCODE(byExit->code, 0);
+	}else if(auto bySignal = std::get_if<TerminationBySignal>(&state); bySignal) {
+		mode |= W_EXITCODE(0, bySignal->signo);
+	}else{
+		assert(std::holds_alternative<std::monostate>(state));
+	}
+	resp.set_mode(mode);
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			helix::SendBuffer send_resp;
+async::result<bool> handleGetResourceUsage(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GET_RESOURCE_USAGE" << std::endl;
+
+	HelThreadStats stats;
+	HEL_CHECK(helQueryThreadStats(ctx.self->threadDescriptor().getHandle(), &stats));
+
+	int32_t mode = static_cast<int32_t>(req.mode());
+	uint64_t user_time;
+	if(mode == RUSAGE_SELF) {
+		user_time = stats.userTime;
+	}else if(mode == RUSAGE_CHILDREN) {
+		user_time = ctx.self->accumulatedUsage().userTime;
+	}else{
+		std::cout << "\e[31mposix: GET_RESOURCE_USAGE mode is not supported\e[39m"
+				<< std::endl;
+		user_time = 0;
+		// TODO: Return an error response.
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(pid);
-
-			uint32_t mode = 0;
-			if(auto byExit = std::get_if<TerminationByExit>(&state); byExit) {
-				mode |= W_EXITCODE(byExit->code, 0);
-			}else if(auto bySignal = std::get_if<TerminationBySignal>(&state); bySignal) {
-				mode |= W_EXITCODE(0, bySignal->signo);
-			}else{
-				assert(std::holds_alternative<std::monostate>(state));
-			}
-			resp.set_mode(mode);
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GET_RESOURCE_USAGE) {
-			if(logRequests)
-				std::cout << "posix: GET_RESOURCE_USAGE" << std::endl;
-
-			HelThreadStats stats;
-			HEL_CHECK(helQueryThreadStats(self->threadDescriptor().getHandle(), &stats));
-
-			int32_t mode = static_cast<int32_t>(req.mode());
-			uint64_t user_time;
-			if(mode == RUSAGE_SELF) {
-				user_time = stats.userTime;
-			}else if(mode == RUSAGE_CHILDREN) {
-				user_time = self->accumulatedUsage().userTime;
-			}else{
-				std::cout << "\e[31mposix: GET_RESOURCE_USAGE mode is not supported\e[39m"
-						<< std::endl;
-				user_time = 0;
-				// TODO: Return an error response.
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_ru_user_time(user_time);
 
-			helix::SendBuffer send_resp;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_ru_user_time(user_time);
+async::result<bool> handleVmMap(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::VmMapRequest>(ctx.recvHead);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
+	if(logRequests)
+		std::cout << "posix: VM_MAP size: " << (void *)(size_t)req->size() << std::endl;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == bragi::message_id<managarm::posix::VmMapRequest>) {
-			auto req = bragi::parse_head_only<managarm::posix::VmMapRequest>(recv_head);
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
-			if(logRequests)
-				std::cout << "posix: VM_MAP size: " << (void *)(size_t)req->size() << std::endl;
+	// TODO: Validate req->flags().
 
-			// TODO: Validate req->flags().
+	if(req->mode() & ~(PROT_READ | PROT_WRITE | PROT_EXEC)) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			if(req->mode() & ~(PROT_READ | PROT_WRITE | PROT_EXEC)) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(req->rel_offset() & 0xFFF) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			if(req->rel_offset() & 0xFFF) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	uint32_t nativeFlags = 0;
+
+	if(req->mode() & PROT_READ)
+		nativeFlags |= kHelMapProtRead;
+	if(req->mode() & PROT_WRITE)
+		nativeFlags |= kHelMapProtWrite;
+	if(req->mode() & PROT_EXEC)
+		nativeFlags |= kHelMapProtExecute;
+
+	if(req->flags() & MAP_FIXED_NOREPLACE)
+		nativeFlags |= kHelMapFixedNoReplace;
+	else if(req->flags() & MAP_FIXED)
+		nativeFlags |= kHelMapFixed;
+
+	bool copyOnWrite;
+	if((req->flags() & (MAP_PRIVATE | MAP_SHARED)) == MAP_PRIVATE) {
+		copyOnWrite = true;
+	}else if((req->flags() & (MAP_PRIVATE | MAP_SHARED)) == MAP_SHARED) {
+		copyOnWrite = false;
+	}else{
+		throw std::runtime_error("posix: Handle illegal flags in VM_MAP");
+	}
 
-			uint32_t nativeFlags = 0;
-
-			if(req->mode() & PROT_READ)
-				nativeFlags |= kHelMapProtRead;
-			if(req->mode() & PROT_WRITE)
-				nativeFlags |= kHelMapProtWrite;
-			if(req->mode() & PROT_EXEC)
-				nativeFlags |= kHelMapProtExecute;
-
-			if(req->flags() & MAP_FIXED_NOREPLACE)
-				nativeFlags |= kHelMapFixedNoReplace;
-			else if(req->flags() & MAP_FIXED)
-				nativeFlags |= kHelMapFixed;
-
-			bool copyOnWrite;
-			if((req->flags() & (MAP_PRIVATE | MAP_SHARED)) == MAP_PRIVATE) {
-				copyOnWrite = true;
-			}else if((req->flags() & (MAP_PRIVATE | MAP_SHARED)) == MAP_SHARED) {
-				copyOnWrite = false;
-			}else{
-				throw std::runtime_error("posix: Handle illegal flags in VM_MAP");
-			}
+	uintptr_t hint = req->address_hint();
 
-			uintptr_t hint = req->address_hint();
+	frg::expected<Error, void *> result;
+	if(req->flags() & MAP_ANONYMOUS) {
+		assert(!req->rel_offset());
 
-			frg::expected<Error, void *> result;
-			if(req->flags() & MAP_ANONYMOUS) {
-				assert(!req->rel_offset());
+		if(copyOnWrite) {
+			result = co_await ctx.self->vmContext()->mapFile(hint,
+					{}, nullptr,
+					0, req->size(), true, nativeFlags);
+		}else{
+			HelHandle handle;
+			HEL_CHECK(helAllocateMemory(req->size(), 0, nullptr, &handle));
 
-				if(copyOnWrite) {
-					result = co_await self->vmContext()->mapFile(hint,
-							{}, nullptr,
-							0, req->size(), true, nativeFlags);
-				}else{
-					HelHandle handle;
-					HEL_CHECK(helAllocateMemory(req->size(), 0, nullptr, &handle));
+			result = co_await ctx.self->vmContext()->mapFile(hint,
+					helix::UniqueDescriptor{handle}, nullptr,
+					0, req->size(), false, nativeFlags);
+		}
+	}else{
+		auto file = ctx.self->fileContext()->getFile(req->fd());
+		assert(file && "Illegal FD for VM_MAP");
+		auto memory = co_await file->accessMemory();
+		assert(memory);
+		result = co_await ctx.self->vmContext()->mapFile(hint,
+				std::move(memory), std::move(file),
+				req->rel_offset(), req->size(), copyOnWrite, nativeFlags);
+	}
 
-					result = co_await self->vmContext()->mapFile(hint,
-							helix::UniqueDescriptor{handle}, nullptr,
-							0, req->size(), false, nativeFlags);
-				}
-			}else{
-				auto file = self->fileContext()->getFile(req->fd());
-				assert(file && "Illegal FD for VM_MAP");
-				auto memory = co_await file->accessMemory();
-				assert(memory);
-				result = co_await self->vmContext()->mapFile(hint,
-						std::move(memory), std::move(file),
-						req->rel_offset(), req->size(), copyOnWrite, nativeFlags);
-			}
+	if(!result) {
+		assert(result.error() == Error::alreadyExists || result.error() == Error::noMemory);
+		if(result.error() == Error::alreadyExists)
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
+		else if(result.error() == Error::noMemory)
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_MEMORY);
+		co_return true;
+	}
 
-			if(!result) {
-				assert(result.error() == Error::alreadyExists || result.error() == Error::noMemory);
-				if(result.error() == Error::alreadyExists)
-					co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-				else if(result.error() == Error::noMemory)
-					co_await sendErrorResponse(managarm::posix::Errors::NO_MEMORY);
-				continue;
-			}
+	void *address = result.unwrap();
 
-			void *address = result.unwrap();
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_offset(reinterpret_cast<uintptr_t>(address));
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_offset(reinterpret_cast<uintptr_t>(address));
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+		ctx.conversation,
+		helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+	);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
 
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-			);
-			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_REMAP) {
-			if(logRequests)
-				std::cout << "posix: VM_REMAP" << std::endl;
+async::result<bool> handleVmRemap(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: VM_REMAP" << std::endl;
 
-			helix::SendBuffer send_resp;
+	helix::SendBuffer send_resp;
 
-			auto address = co_await self->vmContext()->remapFile(
-					reinterpret_cast<void *>(req.address()), req.size(), req.new_size());
+	auto address = co_await ctx.self->vmContext()->remapFile(
+			reinterpret_cast<void *>(req.address()), req.size(), req.new_size());
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_offset(reinterpret_cast<uintptr_t>(address));
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_offset(reinterpret_cast<uintptr_t>(address));
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_PROTECT) {
-			if(logRequests)
-				std::cout << "posix: VM_PROTECT" << std::endl;
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			if(req.mode() & ~(PROT_READ | PROT_WRITE | PROT_EXEC)) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+async::result<bool> handleVmProtect(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: VM_PROTECT" << std::endl;
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+
+	if(req.mode() & ~(PROT_READ | PROT_WRITE | PROT_EXEC)) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return true;
+	}
 
-			uint32_t native_flags = 0;
-			if(req.mode() & PROT_READ)
-				native_flags |= kHelMapProtRead;
-			if(req.mode() & PROT_WRITE)
-				native_flags |= kHelMapProtWrite;
-			if(req.mode() & PROT_EXEC)
-				native_flags |= kHelMapProtExecute;
+	uint32_t native_flags = 0;
+	if(req.mode() & PROT_READ)
+		native_flags |= kHelMapProtRead;
+	if(req.mode() & PROT_WRITE)
+		native_flags |= kHelMapProtWrite;
+	if(req.mode() & PROT_EXEC)
+		native_flags |= kHelMapProtExecute;
+
+	co_await ctx.self->vmContext()->protectFile(
+			reinterpret_cast<void *>(req.address()), req.size(), native_flags);
+
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			co_await self->vmContext()->protectFile(
-					reinterpret_cast<void *>(req.address()), req.size(), native_flags);
+async::result<bool> handleVmUnmap(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: VM_UNMAP address: " << (void *)req.address()
+				<< ", size: " << (void *)(size_t)req.size() << std::endl;
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_UNMAP) {
-			if(logRequests)
-				std::cout << "posix: VM_UNMAP address: " << (void *)req.address()
-						<< ", size: " << (void *)(size_t)req.size() << std::endl;
+	helix::SendBuffer send_resp;
 
-			helix::SendBuffer send_resp;
+	ctx.self->vmContext()->unmapFile(reinterpret_cast<void *>(req.address()), req.size());
 
-			self->vmContext()->unmapFile(reinterpret_cast<void *>(req.address()), req.size());
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::MountRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+async::result<bool> handleMount(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			auto req = bragi::parse_head_tail<managarm::posix::MountRequest>(recv_head, tail);
+	auto req = bragi::parse_head_tail<managarm::posix::MountRequest>(ctx.recvHead, tail);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(logRequests)
-				std::cout << "posix: MOUNT " << req->fs_type() << " on " << req->path()
-						<< " to " << req->target_path() << std::endl;
-
-			auto resolveResult = co_await resolve(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req->target_path(), self.get());
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
-			auto target = resolveResult.value();
-
-			if(req->fs_type() == "procfs") {
-				co_await target.first->mount(target.second, getProcfs());
-			}else if(req->fs_type() == "sysfs") {
-				co_await target.first->mount(target.second, getSysfs());
-			}else if(req->fs_type() == "devtmpfs") {
-				co_await target.first->mount(target.second, getDevtmpfs());
-			}else if(req->fs_type() == "tmpfs") {
-				co_await target.first->mount(target.second, tmp_fs::createRoot());
-			}else if(req->fs_type() == "devpts") {
-				co_await target.first->mount(target.second, pts::getFsRoot());
-			}else{
-				assert(req->fs_type() == "ext2");
-				auto sourceResult = co_await resolve(self->fsContext()->getRoot(),
-						self->fsContext()->getWorkingDirectory(), req->path(), self.get());
-				if(!sourceResult) {
-					if(sourceResult.error() == protocols::fs::Error::fileNotFound) {
-						co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-						continue;
-					} else if(sourceResult.error() == protocols::fs::Error::notDirectory) {
-						co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-						co_return;
-					}
-				}
-				auto source = sourceResult.value();
-				assert(source.second);
-				assert(source.second->getTarget()->getType() == VfsType::blockDevice);
-				auto device = blockRegistry.get(source.second->getTarget()->readDevice());
-				auto link = co_await device->mount();
-				co_await target.first->mount(target.second, std::move(link));
+	if(logRequests)
+		std::cout << "posix: MOUNT " << req->fs_type() << " on " << req->path()
+				<< " to " << req->target_path() << std::endl;
+
+	auto resolveResult = co_await resolve(ctx.self->fsContext()->getRoot(),
+			ctx.self->fsContext()->getWorkingDirectory(), req->target_path(), ctx.self.get());
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
+	auto target = resolveResult.value();
+
+	if(req->fs_type() == "procfs") {
+		co_await target.first->mount(target.second, getProcfs());
+	}else if(req->fs_type() == "sysfs") {
+		co_await target.first->mount(target.second, getSysfs());
+	}else if(req->fs_type() == "devtmpfs") {
+		co_await target.first->mount(target.second, getDevtmpfs());
+	}else if(req->fs_type() == "tmpfs") {
+		co_await target.first->mount(target.second, tmp_fs::createRoot());
+	}else if(req->fs_type() == "devpts") {
+		co_await target.first->mount(target.second, pts::getFsRoot());
+	}else{
+		assert(req->fs_type() == "ext2");
+		auto sourceResult = co_await resolve(ctx.self->fsContext()->getRoot(),
+				ctx.self->fsContext()->getWorkingDirectory(), req->path(), ctx.self.get());
+		if(!sourceResult) {
+			if(sourceResult.error() == protocols::fs::Error::fileNotFound) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+				co_return true;
+			} else if(sourceResult.error() == protocols::fs::Error::notDirectory) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+				co_return true;
+			} else {
+				std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+				co_return false;
 			}
+		}
+		auto source = sourceResult.value();
+		assert(source.second);
+		assert(source.second->getTarget()->getType() == VfsType::blockDevice);
+		auto device = blockRegistry.get(source.second->getTarget()->readDevice());
+		auto link = co_await device->mount();
+		co_await target.first->mount(target.second, std::move(link));
+	}
 
-			if(logRequests)
-				std::cout << "posix:     MOUNT succeeds" << std::endl;
-
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	if(logRequests)
+		std::cout << "posix:     MOUNT succeeds" << std::endl;
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-						conversation,
-						helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-					);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::CHROOT) {
-			if(logRequests)
-				std::cout << "posix: CHROOT" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			auto pathResult = co_await resolve(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.path(), self.get());
-			if(!pathResult) {
-				if(pathResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(pathResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
-			auto path = pathResult.value();
-			self->fsContext()->changeRoot(path);
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				ctx.conversation,
+				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+			);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::CHDIR) {
-			if(logRequests)
-				std::cout << "posix: CHDIR" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			auto pathResult = co_await resolve(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.path(), self.get());
-			if(!pathResult) {
-				if(pathResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(pathResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
-			auto path = pathResult.value();
-			self->fsContext()->changeWorkingDirectory(path);
+async::result<bool> handleChroot(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: CHROOT" << std::endl;
+
+	helix::SendBuffer send_resp;
+
+	auto pathResult = co_await resolve(ctx.self->fsContext()->getRoot(),
+			ctx.self->fsContext()->getWorkingDirectory(), req.path(), ctx.self.get());
+	if(!pathResult) {
+		if(pathResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(pathResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
+	auto path = pathResult.value();
+	ctx.self->fsContext()->changeRoot(path);
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<bool> handleChdir(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: CHDIR" << std::endl;
+
+	helix::SendBuffer send_resp;
+
+	auto pathResult = co_await resolve(ctx.self->fsContext()->getRoot(),
+			ctx.self->fsContext()->getWorkingDirectory(), req.path(), ctx.self.get());
+	if(!pathResult) {
+		if(pathResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(pathResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
+	auto path = pathResult.value();
+	ctx.self->fsContext()->changeWorkingDirectory(path);
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::FCHDIR) {
-			if(logRequests)
-				std::cout << "posix: CHDIR" << std::endl;
+async::result<bool> handleFchdir(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: CHDIR" << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+	helix::SendBuffer send_resp;
 
-			auto file = self->fileContext()->getFile(req.fd());
+	auto file = ctx.self->fileContext()->getFile(req.fd());
 
-			if(!file) {
-				resp.set_error(managarm::posix::Errors::NO_SUCH_FD);
+	if(!file) {
+		resp.set_error(managarm::posix::Errors::NO_SUCH_FD);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return true;
+	}
 
-			self->fsContext()->changeWorkingDirectory({file->associatedMount(),
-					file->associatedLink()});
+	ctx.self->fsContext()->changeWorkingDirectory({file->associatedMount(),
+			file->associatedLink()});
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::AccessAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto req = bragi::parse_head_tail<managarm::posix::AccessAtRequest>(recv_head, tail);
+async::result<bool> handleAccessAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			if(!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	auto req = bragi::parse_head_tail<managarm::posix::AccessAtRequest>(ctx.recvHead, tail);
 
-			if(logRequests || logPaths)
-				std::cout << "posix: ACCESSAT " << req->path() << std::endl;
+	if(!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
+	if(logRequests || logPaths)
+		std::cout << "posix: ACCESSAT " << req->path() << std::endl;
+
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+
+	if(req->flags()) {
+		if(req->flags() & AT_SYMLINK_NOFOLLOW) {
+			std::cout << "posix: ACCESSAT flag handling AT_SYMLINK_NOFOLLOW is unimplemented" << std::endl;
+		} else if(req->flags() & AT_EACCESS) {
+			std::cout << "posix: ACCESSAT flag handling AT_EACCESS is unimplemented" << std::endl;
+		} else {
+			std::cout << "posix: ACCESSAT unknown flag is unimplemented: " << req->flags() << std::endl;
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+			co_return true;
+		}
+	}
 
-			if(req->flags()) {
-				if(req->flags() & AT_SYMLINK_NOFOLLOW) {
-					std::cout << "posix: ACCESSAT flag handling AT_SYMLINK_NOFOLLOW is unimplemented" << std::endl;
-				} else if(req->flags() & AT_EACCESS) {
-					std::cout << "posix: ACCESSAT flag handling AT_EACCESS is unimplemented" << std::endl;
-				} else {
-					std::cout << "posix: ACCESSAT unknown flag is unimplemented: " << req->flags() << std::endl;
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-					continue;
-				}
-			}
+	if(req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-			if(req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+		if(!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-				if(!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	auto pathResult = co_await resolve(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+	if(!pathResult) {
+		if(pathResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(pathResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			auto pathResult = co_await resolve(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-			if(!pathResult) {
-				if(pathResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(pathResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::MkdirAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+async::result<bool> handleMkdirAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			auto req = bragi::parse_head_tail<managarm::posix::MkdirAtRequest>(recv_head, tail);
+	auto req = bragi::parse_head_tail<managarm::posix::MkdirAtRequest>(ctx.recvHead, tail);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(logRequests || logPaths)
-				std::cout << "posix: MKDIRAT " << req->path() << std::endl;
+	if(logRequests || logPaths)
+		std::cout << "posix: MKDIRAT " << req->path() << std::endl;
 
-			if(!req->path().size()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(!req->path().size()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
 
-			if(req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+	if(req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-			auto resolveResult = co_await resolver.resolve(resolvePrefix);
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+	auto resolveResult = co_await resolver.resolve(resolvePrefix);
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			if(!resolver.hasComponent()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-				continue;
-			}
+	if(!resolver.hasComponent()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
+		co_return true;
+	}
 
-			auto parent = resolver.currentLink()->getTarget();
-			auto existsResult = co_await parent->getLink(resolver.nextComponent());
-			assert(existsResult);
-			auto exists = existsResult.value();
-			if(exists) {
-				co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-				continue;
-			}
+	auto parent = resolver.currentLink()->getTarget();
+	auto existsResult = co_await parent->getLink(resolver.nextComponent());
+	assert(existsResult);
+	auto exists = existsResult.value();
+	if(exists) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
+		co_return true;
+	}
 
-			auto result = co_await parent->mkdir(resolver.nextComponent());
+	auto result = co_await parent->mkdir(resolver.nextComponent());
 
-			if(auto error = std::get_if<Error>(&result); error) {
-				assert(*error == Error::illegalOperationTarget);
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(auto error = std::get_if<Error>(&result); error) {
+		assert(*error == Error::illegalOperationTarget);
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::MkfifoAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-			auto req = bragi::parse_head_tail<managarm::posix::MkfifoAtRequest>(recv_head, tail);
+async::result<bool> handleMkfifoAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	auto req = bragi::parse_head_tail<managarm::posix::MkfifoAtRequest>(ctx.recvHead, tail);
 
-			if(logRequests || logPaths)
-				std::cout << "posix: MKFIFOAT " << req->fd() << " " << req->path() << std::endl;
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if (!req->path().size()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(logRequests || logPaths)
+		std::cout << "posix: MKFIFOAT " << req->fd() << " " << req->path() << std::endl;
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+	if (!req->path().size()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			if (req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	if (req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-			auto resolveResult = co_await resolver.resolve(resolvePrefix | resolveNoTrailingSlash);
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			auto parent = resolver.currentLink()->getTarget();
-			if(co_await parent->getLink(resolver.nextComponent())) {
-				co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-				continue;
-			}
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+	auto resolveResult = co_await resolver.resolve(resolvePrefix | resolveNoTrailingSlash);
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			auto result = co_await parent->mkfifo(resolver.nextComponent(), req->mode());
-			if(!result) {
-				std::cout << "posix: Unexpected failure from mkfifo()" << std::endl;
-				co_return;
-			}
+	auto parent = resolver.currentLink()->getTarget();
+	if(co_await parent->getLink(resolver.nextComponent())) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
+		co_return true;
+	}
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::LinkAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	auto result = co_await parent->mkfifo(resolver.nextComponent(), req->mode());
+	if(!result) {
+		std::cout << "posix: Unexpected failure from mkfifo()" << std::endl;
+		co_return false;
+	}
 
-			auto req = bragi::parse_head_tail<managarm::posix::LinkAtRequest>(recv_head, tail);
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-			if(logRequests)
-				std::cout << "posix: LINKAT" << std::endl;
+async::result<bool> handleLinkAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			if(req->flags() & ~(AT_EMPTY_PATH | AT_SYMLINK_FOLLOW)) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	auto req = bragi::parse_head_tail<managarm::posix::LinkAtRequest>(ctx.recvHead, tail);
 
-			if(req->flags() & AT_EMPTY_PATH) {
-				std::cout << "posix: AT_EMPTY_PATH is unimplemented for linkat" << std::endl;
-			}
+	if(logRequests)
+		std::cout << "posix: LINKAT" << std::endl;
 
-			if(req->flags() & AT_SYMLINK_FOLLOW) {
-				std::cout << "posix: AT_SYMLINK_FOLLOW is unimplemented for linkat" << std::endl;
-			}
+	if(req->flags() & ~(AT_EMPTY_PATH | AT_SYMLINK_FOLLOW)) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
+	if(req->flags() & AT_EMPTY_PATH) {
+		std::cout << "posix: AT_EMPTY_PATH is unimplemented for linkat" << std::endl;
+	}
 
-			if(req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+	if(req->flags() & AT_SYMLINK_FOLLOW) {
+		std::cout << "posix: AT_SYMLINK_FOLLOW is unimplemented for linkat" << std::endl;
+	}
 
-				if(!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if(req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-			auto resolveResult = co_await resolver.resolve();
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+		if(!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-			if (req->newfd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->newfd());
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-				if(!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+	auto resolveResult = co_await resolver.resolve();
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if (req->newfd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->newfd());
 
-			PathResolver new_resolver;
-			new_resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->target_path(), self.get());
-			auto new_resolveResult = co_await new_resolver.resolve(
-					resolvePrefix | resolveNoTrailingSlash);
-			if(!new_resolveResult) {
-				if(new_resolveResult.error() == protocols::fs::Error::illegalOperationTarget) {
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_OPERATION_TARGET);
-					continue;
-				} else if(new_resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(new_resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+		if(!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-			auto target = resolver.currentLink()->getTarget();
-			auto directory = new_resolver.currentLink()->getTarget();
-			assert(target->superblock() == directory->superblock()); // Hard links across mount points are not allowed, return EXDEV
-			auto result = co_await directory->link(new_resolver.nextComponent(), target);
-			if(!result) {
-				std::cout << "posix: Unexpected failure from link()" << std::endl;
-				co_return;
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::SymlinkAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	PathResolver new_resolver;
+	new_resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->target_path(), ctx.self.get());
+	auto new_resolveResult = co_await new_resolver.resolve(
+			resolvePrefix | resolveNoTrailingSlash);
+	if(!new_resolveResult) {
+		if(new_resolveResult.error() == protocols::fs::Error::illegalOperationTarget) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_OPERATION_TARGET);
+			co_return true;
+		} else if(new_resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(new_resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			auto req = bragi::parse_head_tail<managarm::posix::SymlinkAtRequest>(recv_head, tail);
+	auto target = resolver.currentLink()->getTarget();
+	auto directory = new_resolver.currentLink()->getTarget();
+	assert(target->superblock() == directory->superblock()); // Hard links across mount points are not allowed, return EXDEV
+	auto result = co_await directory->link(new_resolver.nextComponent(), target);
+	if(!result) {
+		std::cout << "posix: Unexpected failure from link()" << std::endl;
+		co_return false;
+	}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-			if(logRequests || logPaths)
-				std::cout << "posix: SYMLINK " << req->path() << std::endl;
+async::result<bool> handleSymlinkAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			ViewPath relativeTo;
-			smarter::shared_ptr<File, FileHandle> file;
+	auto req = bragi::parse_head_tail<managarm::posix::SymlinkAtRequest>(ctx.recvHead, tail);
 
-			if (!req->path().size()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(req->fd() == AT_FDCWD) {
-				relativeTo = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	if(logRequests || logPaths)
+		std::cout << "posix: SYMLINK " << req->path() << std::endl;
 
-				relativeTo = {file->associatedMount(), file->associatedLink()};
-			}
+	ViewPath relativeTo;
+	smarter::shared_ptr<File, FileHandle> file;
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relativeTo, req->path(), self.get());
-			auto resolveResult = co_await resolver.resolve(
-					resolvePrefix | resolveNoTrailingSlash);
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+	if (!req->path().size()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			auto parent = resolver.currentLink()->getTarget();
-			auto result = co_await parent->symlink(resolver.nextComponent(), req->target_path());
-			if(auto error = std::get_if<Error>(&result); error) {
-				assert(*error == Error::illegalOperationTarget);
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(req->fd() == AT_FDCWD) {
+		relativeTo = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+		relativeTo = {file->associatedMount(), file->associatedLink()};
+	}
 
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-			);
-			HEL_CHECK(sendResp.error());
-		}else if(preamble.id() == managarm::posix::RenameAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			relativeTo, req->path(), ctx.self.get());
+	auto resolveResult = co_await resolver.resolve(
+			resolvePrefix | resolveNoTrailingSlash);
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			auto req = bragi::parse_head_tail<managarm::posix::RenameAtRequest>(recv_head, tail);
+	auto parent = resolver.currentLink()->getTarget();
+	auto result = co_await parent->symlink(resolver.nextComponent(), req->target_path());
+	if(auto error = std::get_if<Error>(&result); error) {
+		assert(*error == Error::illegalOperationTarget);
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			if(logRequests || logPaths)
-				std::cout << "posix: RENAMEAT " << req->path()
-						<< " to " << req->target_path() << std::endl;
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+		ctx.conversation,
+		helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+	);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
+async::result<bool> handleRenameAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			if (req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+	auto req = bragi::parse_head_tail<managarm::posix::RenameAtRequest>(ctx.recvHead, tail);
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if(logRequests || logPaths)
+		std::cout << "posix: RENAMEAT " << req->path()
+				<< " to " << req->target_path() << std::endl;
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-			auto resolveResult = co_await resolver.resolve();
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::isDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
 
-			if (req->newfd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->newfd());
+	if (req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			// TODO: Add resolveNoTrailingSlash if source is not a directory?
-			PathResolver new_resolver;
-			new_resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->target_path(), self.get());
-			auto new_resolveResult = co_await new_resolver.resolve(resolvePrefix);
-			if(!new_resolveResult) {
-				if(new_resolveResult.error() == protocols::fs::Error::isDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
-					continue;
-				} else if(new_resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(new_resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+	auto resolveResult = co_await resolver.resolve();
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::isDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			auto superblock = resolver.currentLink()->getTarget()->superblock();
-			auto directory = new_resolver.currentLink()->getTarget();
-			assert(superblock == directory->superblock());
-			auto result = co_await superblock->rename(resolver.currentLink().get(),
-					directory.get(), new_resolver.nextComponent());
-			if(!result) {
-				assert(result.error() == Error::alreadyExists);
-				co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-				continue;
-			}
+	if (req->newfd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->newfd());
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::FstatAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-			auto req = bragi::parse_head_tail<managarm::posix::FstatAtRequest>(recv_head, tail);
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	// TODO: Add resolveNoTrailingSlash if source is not a directory?
+	PathResolver new_resolver;
+	new_resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->target_path(), ctx.self.get());
+	auto new_resolveResult = co_await new_resolver.resolve(resolvePrefix);
+	if(!new_resolveResult) {
+		if(new_resolveResult.error() == protocols::fs::Error::isDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
+			co_return true;
+		} else if(new_resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(new_resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			if(logRequests)
-				std::cout << "posix: FSTATAT request" << std::endl;
+	auto superblock = resolver.currentLink()->getTarget()->superblock();
+	auto directory = new_resolver.currentLink()->getTarget();
+	assert(superblock == directory->superblock());
+	auto result = co_await superblock->rename(resolver.currentLink().get(),
+			directory.get(), new_resolver.nextComponent());
+	if(!result) {
+		assert(result.error() == Error::alreadyExists);
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
+		co_return true;
+	}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-			if (req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+async::result<bool> handleFstatAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	auto req = bragi::parse_head_tail<managarm::posix::FstatAtRequest>(ctx.recvHead, tail);
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if (req->flags() & AT_EMPTY_PATH) {
-				target_link = file->associatedLink();
-			} else {
-				PathResolver resolver;
-				resolver.setup(self->fsContext()->getRoot(),
-						relative_to, req->path(), self.get());
-
-				ResolveFlags resolveFlags = 0;
-				if (req->flags() & AT_SYMLINK_NOFOLLOW)
-				    resolveFlags |= resolveDontFollow;
-
-				auto resolveResult = co_await resolver.resolve(resolveFlags);
-				if(!resolveResult) {
-					if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-						co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-						continue;
-					} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-						co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-						co_return;
-					}
-				}
+	if(logRequests)
+		std::cout << "posix: FSTATAT request" << std::endl;
 
-				target_link = resolver.currentLink();
-			}
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
 
-			// This catches cases where associatedLink is called on a file, but the file doesn't implement that.
-			// Instead of blowing up, return ENOENT.
-			if(target_link == nullptr) {
-				co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-				continue;
-			}
+	if (req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-			auto statsResult = co_await target_link->getTarget()->getStats();
-			assert(statsResult);
-			auto stats = statsResult.value();
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			DeviceId devnum;
-			switch(target_link->getTarget()->getType()) {
-			case VfsType::regular:
-				resp.set_file_type(managarm::posix::FileType::FT_REGULAR);
-				break;
-			case VfsType::directory:
-				resp.set_file_type(managarm::posix::FileType::FT_DIRECTORY);
-				break;
-			case VfsType::symlink:
-				resp.set_file_type(managarm::posix::FileType::FT_SYMLINK);
-				break;
-			case VfsType::charDevice:
-				resp.set_file_type(managarm::posix::FileType::FT_CHAR_DEVICE);
-				devnum = target_link->getTarget()->readDevice();
-				resp.set_ref_devnum(makedev(devnum.first, devnum.second));
-				break;
-			case VfsType::blockDevice:
-				resp.set_file_type(managarm::posix::FileType::FT_BLOCK_DEVICE);
-				devnum = target_link->getTarget()->readDevice();
-				resp.set_ref_devnum(makedev(devnum.first, devnum.second));
-				break;
-			case VfsType::socket:
-				resp.set_file_type(managarm::posix::FileType::FT_SOCKET);
-				break;
-			case VfsType::fifo:
-				resp.set_file_type(managarm::posix::FileType::FT_FIFO);
-				break;
-			default:
-				assert(target_link->getTarget()->getType() == VfsType::null);
+	if (req->flags() & AT_EMPTY_PATH) {
+		target_link = file->associatedLink();
+	} else {
+		PathResolver resolver;
+		resolver.setup(ctx.self->fsContext()->getRoot(),
+				relative_to, req->path(), ctx.self.get());
+
+		ResolveFlags resolveFlags = 0;
+		if (req->flags() & AT_SYMLINK_NOFOLLOW)
+		    resolveFlags |= resolveDontFollow;
+
+		auto resolveResult = co_await resolver.resolve(resolveFlags);
+		if(!resolveResult) {
+			if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+				co_return true;
+			} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+				co_return true;
+			} else {
+				std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+				co_return false;
 			}
+		}
 
-			if(stats.mode & ~0xFFFu)
-				std::cout << "\e[31m" "posix: FsNode::getStats() returned illegal mode of "
-						<< stats.mode << "\e[39m" << std::endl;
-
-			resp.set_fs_inode(stats.inodeNumber);
-			resp.set_mode(stats.mode);
-			resp.set_num_links(stats.numLinks);
-			resp.set_uid(stats.uid);
-			resp.set_gid(stats.gid);
-			resp.set_file_size(stats.fileSize);
-			resp.set_atime_secs(stats.atimeSecs);
-			resp.set_atime_nanos(stats.atimeNanos);
-			resp.set_mtime_secs(stats.mtimeSecs);
-			resp.set_mtime_nanos(stats.mtimeNanos);
-			resp.set_ctime_secs(stats.ctimeSecs);
-			resp.set_ctime_nanos(stats.ctimeNanos);
-
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+		target_link = resolver.currentLink();
+	}
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::FchmodAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	// This catches cases where associatedLink is called on a file, but the file doesn't implement that.
+	// Instead of blowing up, return ENOENT.
+	if(target_link == nullptr) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+		co_return true;
+	}
 
-			auto req = bragi::parse_head_tail<managarm::posix::FchmodAtRequest>(recv_head, tail);
+	auto statsResult = co_await target_link->getTarget()->getStats();
+	assert(statsResult);
+	auto stats = statsResult.value();
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	DeviceId devnum;
+	switch(target_link->getTarget()->getType()) {
+	case VfsType::regular:
+		resp.set_file_type(managarm::posix::FileType::FT_REGULAR);
+		break;
+	case VfsType::directory:
+		resp.set_file_type(managarm::posix::FileType::FT_DIRECTORY);
+		break;
+	case VfsType::symlink:
+		resp.set_file_type(managarm::posix::FileType::FT_SYMLINK);
+		break;
+	case VfsType::charDevice:
+		resp.set_file_type(managarm::posix::FileType::FT_CHAR_DEVICE);
+		devnum = target_link->getTarget()->readDevice();
+		resp.set_ref_devnum(makedev(devnum.first, devnum.second));
+		break;
+	case VfsType::blockDevice:
+		resp.set_file_type(managarm::posix::FileType::FT_BLOCK_DEVICE);
+		devnum = target_link->getTarget()->readDevice();
+		resp.set_ref_devnum(makedev(devnum.first, devnum.second));
+		break;
+	case VfsType::socket:
+		resp.set_file_type(managarm::posix::FileType::FT_SOCKET);
+		break;
+	case VfsType::fifo:
+		resp.set_file_type(managarm::posix::FileType::FT_FIFO);
+		break;
+	default:
+		assert(target_link->getTarget()->getType() == VfsType::null);
+	}
 
-			if(logRequests)
-				std::cout << "posix: FCHMODAT request" << std::endl;
+	if(stats.mode & ~0xFFFu)
+		std::cout << "\e[31m" "posix: FsNode::getStats() returned illegal mode of "
+				<< stats.mode << "\e[39m" << std::endl;
+
+	resp.set_fs_inode(stats.inodeNumber);
+	resp.set_mode(stats.mode);
+	resp.set_num_links(stats.numLinks);
+	resp.set_uid(stats.uid);
+	resp.set_gid(stats.gid);
+	resp.set_file_size(stats.fileSize);
+	resp.set_atime_secs(stats.atimeSecs);
+	resp.set_atime_nanos(stats.atimeNanos);
+	resp.set_mtime_secs(stats.mtimeSecs);
+	resp.set_mtime_nanos(stats.mtimeNanos);
+	resp.set_ctime_secs(stats.ctimeSecs);
+	resp.set_ctime_nanos(stats.ctimeNanos);
+
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
+
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+async::result<bool> handleFchmodAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			if(req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+	auto req = bragi::parse_head_tail<managarm::posix::FchmodAtRequest>(ctx.recvHead, tail);
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	if(logRequests)
+		std::cout << "posix: FCHMODAT request" << std::endl;
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
 
-			if(req->flags()) {
-				if(req->flags() & AT_SYMLINK_NOFOLLOW) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_SUPPORTED);
-					continue;
-				} else if(req->flags() & AT_EMPTY_PATH) {
-					// Allowed, managarm extension
-				} else {
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-					continue;
-				}
-			}
+	if(req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-			if(req->flags() & AT_EMPTY_PATH) {
-				target_link = file->associatedLink();
-			} else {
-				PathResolver resolver;
-				resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-
-				auto resolveResult = co_await resolver.resolve();
-
-				if(!resolveResult) {
-					if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-						co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-						continue;
-					} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-						co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-						co_return;
-					}
-				}
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-				target_link = resolver.currentLink();
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			co_await target_link->getTarget()->chmod(req->mode());
+	if(req->flags()) {
+		if(req->flags() & AT_SYMLINK_NOFOLLOW) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_SUPPORTED);
+			co_return true;
+		} else if(req->flags() & AT_EMPTY_PATH) {
+			// Allowed, managarm extension
+		} else {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+			co_return true;
+		}
+	}
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::UtimensAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	if(req->flags() & AT_EMPTY_PATH) {
+		target_link = file->associatedLink();
+	} else {
+		PathResolver resolver;
+		resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+
+		auto resolveResult = co_await resolver.resolve();
+
+		if(!resolveResult) {
+			if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+				co_return true;
+			} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+				co_return true;
+			} else {
+				std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+				co_return false;
+			}
+		}
 
-			auto req = bragi::parse_head_tail<managarm::posix::UtimensAtRequest>(recv_head, tail);
+		target_link = resolver.currentLink();
+	}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	co_await target_link->getTarget()->chmod(req->mode());
 
-			if(logRequests || logPaths)
-				std::cout << "posix: UTIMENSAT " << req->path() << std::endl;
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-			ViewPath relativeTo;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsNode> target = nullptr;
+async::result<bool> handleUtimensAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			if(!req->path().size()) {
-				target = self->fileContext()->getFile(req->fd())->associatedLink()->getTarget();
-			} else {
-				if(req->flags() & ~AT_SYMLINK_NOFOLLOW) {
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-					continue;
-				}
+	auto req = bragi::parse_head_tail<managarm::posix::UtimensAtRequest>(ctx.recvHead, tail);
 
-				if(req->flags() & AT_SYMLINK_NOFOLLOW) {
-					std::cout << "posix: AT_SYMLINK_FOLLOW is unimplemented for utimensat" << std::endl;
-				}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-				if(req->fd() == AT_FDCWD) {
-					relativeTo = self->fsContext()->getWorkingDirectory();
-				} else {
-					file = self->fileContext()->getFile(req->fd());
-					if (!file) {
-						co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-						continue;
-					}
+	if(logRequests || logPaths)
+		std::cout << "posix: UTIMENSAT " << req->path() << std::endl;
 
-					relativeTo = {file->associatedMount(), file->associatedLink()};
-				}
+	ViewPath relativeTo;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsNode> target = nullptr;
 
-				PathResolver resolver;
-				resolver.setup(self->fsContext()->getRoot(),
-						relativeTo, req->path(), self.get());
-				auto resolveResult = co_await resolver.resolve();
-				if(!resolveResult) {
-					if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-						co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-						continue;
-					} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-						co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-						co_return;
-					}
-				}
+	if(!req->path().size()) {
+		target = ctx.self->fileContext()->getFile(req->fd())->associatedLink()->getTarget();
+	} else {
+		if(req->flags() & ~AT_SYMLINK_NOFOLLOW) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+			co_return true;
+		}
+
+		if(req->flags() & AT_SYMLINK_NOFOLLOW) {
+			std::cout << "posix: AT_SYMLINK_FOLLOW is unimplemented for utimensat" << std::endl;
+		}
 
-				target = resolver.currentLink()->getTarget();
+		if(req->fd() == AT_FDCWD) {
+			relativeTo = ctx.self->fsContext()->getWorkingDirectory();
+		} else {
+			file = ctx.self->fileContext()->getFile(req->fd());
+			if (!file) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+				co_return true;
 			}
 
-			co_await target->utimensat(req->atimeSec(), req->atimeNsec(), req->mtimeSec(), req->mtimeNsec());
-
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(req.request_type() == managarm::posix::CntReqType::READLINK) {
-			if(logRequests || logPaths)
-				std::cout << "posix: READLINK path: " << req.path() << std::endl;
-
-			helix::SendBuffer send_resp;
-			helix::SendBuffer send_data;
-
-			auto pathResult = co_await resolve(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.path(), self.get(), resolveDontFollow);
-			if(!pathResult) {
-				if(pathResult.error() == protocols::fs::Error::fileNotFound) {
-					managarm::posix::SvrResponse resp;
-					resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
-
-					auto ser = resp.SerializeAsString();
-					auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-							helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-							helix::action(&send_data, nullptr, 0));
-					co_await transmit.async_wait();
-					HEL_CHECK(send_resp.error());
-					continue;
-				} else if(pathResult.error() == protocols::fs::Error::notDirectory) {
-					managarm::posix::SvrResponse resp;
-					resp.set_error(managarm::posix::Errors::NOT_A_DIRECTORY);
-
-					auto ser = resp.SerializeAsString();
-					auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-							helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-							helix::action(&send_data, nullptr, 0));
-					co_await transmit.async_wait();
-					HEL_CHECK(send_resp.error());
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
+			relativeTo = {file->associatedMount(), file->associatedLink()};
+		}
+
+		PathResolver resolver;
+		resolver.setup(ctx.self->fsContext()->getRoot(),
+				relativeTo, req->path(), ctx.self.get());
+		auto resolveResult = co_await resolver.resolve();
+		if(!resolveResult) {
+			if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+				co_return true;
+			} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+				co_return true;
+			} else {
+				std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+				co_return false;
 			}
-			auto path = pathResult.value();
+		}
 
-			auto result = co_await path.second->getTarget()->readSymlink(path.second.get(), self.get());
-			if(auto error = std::get_if<Error>(&result); error) {
-				assert(*error == Error::illegalOperationTarget);
+		target = resolver.currentLink()->getTarget();
+	}
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	co_await target->utimensat(req->atimeSec(), req->atimeNsec(), req->mtimeSec(), req->mtimeNsec());
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-						helix::action(&send_data, nullptr, 0));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}else{
-				auto &target = std::get<std::string>(result);
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<bool> handleReadlink(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: READLINK path: " << req.path() << std::endl;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-						helix::action(&send_data, target.data(), target.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}
-		}else if(preamble.id() == bragi::message_id<managarm::posix::OpenAtRequest>) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recvTail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recvTail.error());
-
-			auto req = bragi::parse_head_tail<managarm::posix::OpenAtRequest>(recv_head, tail);
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
-			if(logRequests || logPaths)
-				std::cout << "posix: OPENAT path: " << req->path() << std::endl;
-
-			if((req->flags() & ~(managarm::posix::OpenFlags::OF_CREATE
-					| managarm::posix::OpenFlags::OF_EXCLUSIVE
-					| managarm::posix::OpenFlags::OF_NONBLOCK
-					| managarm::posix::OpenFlags::OF_CLOEXEC
-					| managarm::posix::OpenFlags::OF_TRUNC
-					| managarm::posix::OpenFlags::OF_RDONLY
-					| managarm::posix::OpenFlags::OF_WRONLY
-					| managarm::posix::OpenFlags::OF_RDWR
-					| managarm::posix::OpenFlags::OF_PATH
-					| managarm::posix::OpenFlags::OF_NOCTTY
-					| managarm::posix::OpenFlags::OF_APPEND))) {
-				std::cout << "posix: OPENAT flags not recognized: " << req->flags() << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	helix::SendBuffer send_resp;
+	helix::SendBuffer send_data;
 
-			SemanticFlags semantic_flags = 0;
-			if(req->flags() & managarm::posix::OpenFlags::OF_NONBLOCK)
-				semantic_flags |= semanticNonBlock;
+	auto pathResult = co_await resolve(ctx.self->fsContext()->getRoot(),
+			ctx.self->fsContext()->getWorkingDirectory(), req.path(), ctx.self.get(), resolveDontFollow);
+	if(!pathResult) {
+		if(pathResult.error() == protocols::fs::Error::fileNotFound) {
+			managarm::posix::SvrResponse resp;
+			resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+
+			auto ser = resp.SerializeAsString();
+			auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+					helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+					helix::action(&send_data, nullptr, 0));
+			co_await transmit.async_wait();
+			HEL_CHECK(send_resp.error());
+			co_return true;
+		} else if(pathResult.error() == protocols::fs::Error::notDirectory) {
+			managarm::posix::SvrResponse resp;
+			resp.set_error(managarm::posix::Errors::NOT_A_DIRECTORY);
 
-			if (req->flags() & managarm::posix::OpenFlags::OF_RDONLY)
-				semantic_flags |= semanticRead;
-			else if (req->flags() & managarm::posix::OpenFlags::OF_WRONLY)
-				semantic_flags |= semanticWrite;
-			else if (req->flags() & managarm::posix::OpenFlags::OF_RDWR)
-				semantic_flags |= semanticRead | semanticWrite;
+			auto ser = resp.SerializeAsString();
+			auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+					helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+					helix::action(&send_data, nullptr, 0));
+			co_await transmit.async_wait();
+			HEL_CHECK(send_resp.error());
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
+	auto path = pathResult.value();
+
+	auto result = co_await path.second->getTarget()->readSymlink(path.second.get(), ctx.self.get());
+	if(auto error = std::get_if<Error>(&result); error) {
+		assert(*error == Error::illegalOperationTarget);
+
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+				helix::action(&send_data, nullptr, 0));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}else{
+		auto &target = std::get<std::string>(result);
+
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+				helix::action(&send_data, target.data(), target.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}
+	co_return true;
+}
 
-			if(req->flags() & managarm::posix::OpenFlags::OF_APPEND)
-				semantic_flags |= semanticAppend;
+async::result<bool> handleOpenAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recvTail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recvTail.error());
+
+	auto req = bragi::parse_head_tail<managarm::posix::OpenAtRequest>(ctx.recvHead, tail);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
+	if(logRequests || logPaths)
+		std::cout << "posix: OPENAT path: " << req->path() << std::endl;
+
+	if((req->flags() & ~(managarm::posix::OpenFlags::OF_CREATE
+			| managarm::posix::OpenFlags::OF_EXCLUSIVE
+			| managarm::posix::OpenFlags::OF_NONBLOCK
+			| managarm::posix::OpenFlags::OF_CLOEXEC
+			| managarm::posix::OpenFlags::OF_TRUNC
+			| managarm::posix::OpenFlags::OF_RDONLY
+			| managarm::posix::OpenFlags::OF_WRONLY
+			| managarm::posix::OpenFlags::OF_RDWR
+			| managarm::posix::OpenFlags::OF_PATH
+			| managarm::posix::OpenFlags::OF_NOCTTY
+			| managarm::posix::OpenFlags::OF_APPEND))) {
+		std::cout << "posix: OPENAT flags not recognized: " << req->flags() << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+	SemanticFlags semantic_flags = 0;
+	if(req->flags() & managarm::posix::OpenFlags::OF_NONBLOCK)
+		semantic_flags |= semanticNonBlock;
 
-			if(req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+	if (req->flags() & managarm::posix::OpenFlags::OF_RDONLY)
+		semantic_flags |= semanticRead;
+	else if (req->flags() & managarm::posix::OpenFlags::OF_WRONLY)
+		semantic_flags |= semanticWrite;
+	else if (req->flags() & managarm::posix::OpenFlags::OF_RDWR)
+		semantic_flags |= semanticRead | semanticWrite;
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	if(req->flags() & managarm::posix::OpenFlags::OF_APPEND)
+		semantic_flags |= semanticAppend;
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-			if(req->flags() & managarm::posix::OpenFlags::OF_CREATE) {
-				auto resolveResult = co_await resolver.resolve(
-						resolvePrefix | resolveNoTrailingSlash);
-				if(!resolveResult) {
-					if(resolveResult.error() == protocols::fs::Error::isDirectory) {
-						// TODO: Verify additional constraints for sending EISDIR.
-						co_await sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
-						continue;
-					} else if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-						co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-						continue;
-					} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-						co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-						co_return;
-					}
-				}
+	if(req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-				if(logRequests)
-					std::cout << "posix: Creating file " << req->path() << std::endl;
-
-				auto directory = resolver.currentLink()->getTarget();
-				auto tailResult = co_await directory->getLink(resolver.nextComponent());
-				assert(tailResult);
-				auto tail = tailResult.value();
-				if(tail) {
-					if(req->flags() & managarm::posix::OpenFlags::OF_EXCLUSIVE) {
-						co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-						continue;
-					}else{
-						auto fileResult = co_await tail->getTarget()->open(
-											resolver.currentView(), std::move(tail),
-											semantic_flags);
-						assert(fileResult);
-						file = fileResult.value();
-						assert(file);
-					}
-				}else{
-					assert(directory->superblock());
-					auto node = co_await directory->superblock()->createRegular();
-					if (!node) {
-						co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-						continue;
-					}
-					auto chmodResult = co_await node->chmod(req->mode());
-					if (chmodResult != Error::success) {
-						std::cout << "posix: chmod failed when creating file for OpenAtRequest!" << std::endl;
-						co_await sendErrorResponse(managarm::posix::Errors::INTERNAL_ERROR);
-						continue;
-					}
-					// Due to races, link() can fail here.
-					// TODO: Implement a version of link() that eithers links the new node
-					// or returns the current node without failing.
-					auto linkResult = co_await directory->link(resolver.nextComponent(), node);
-					assert(linkResult);
-					auto link = linkResult.value();
-					auto fileResult = co_await node->open(resolver.currentView(), std::move(link),
-										semantic_flags);
-					assert(fileResult);
-					file = fileResult.value();
-					assert(file);
-				}
-			}else{
-				auto resolveResult = co_await resolver.resolve();
-				if(!resolveResult) {
-					if(resolveResult.error() == protocols::fs::Error::isDirectory) {
-						// TODO: Verify additional constraints for sending EISDIR.
-						co_await sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
-						continue;
-					} else if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-						co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-						continue;
-					} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-						co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-						co_return;
-					}
-				}
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-				auto target = resolver.currentLink()->getTarget();
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-				if(req->flags() & managarm::posix::OpenFlags::OF_PATH) {
-					auto dummyFile = smarter::make_shared<DummyFile>(resolver.currentView(), resolver.currentLink());
-					DummyFile::serve(dummyFile);
-					file = File::constructHandle(std::move(dummyFile));
-				} else {
-					auto fileResult = co_await target->open(resolver.currentView(), resolver.currentLink(), semantic_flags);
-					if(!fileResult) {
-						if(fileResult.error() == Error::noBackingDevice) {
-							co_await sendErrorResponse(managarm::posix::Errors::NO_BACKING_DEVICE);
-							continue;
-						} else if(fileResult.error() == Error::illegalArguments) {
-							co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-							continue;
-						} else {
-							std::cout << "posix: Unexpected failure from open()" << std::endl;
-							co_return;
-						}
-					}
-					assert(fileResult);
-					file = fileResult.value();
-				}
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+	if(req->flags() & managarm::posix::OpenFlags::OF_CREATE) {
+		auto resolveResult = co_await resolver.resolve(
+				resolvePrefix | resolveNoTrailingSlash);
+		if(!resolveResult) {
+			if(resolveResult.error() == protocols::fs::Error::isDirectory) {
+				// TODO: Verify additional constraints for sending EISDIR.
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
+				co_return true;
+			} else if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+				co_return true;
+			} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+				co_return true;
+			} else {
+				std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+				co_return false;
 			}
+		}
 
-			if(!file) {
-				if(logRequests)
-					std::cout << "posix:     OPEN failed: file not found" << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-				continue;
+		if(logRequests)
+			std::cout << "posix: Creating file " << req->path() << std::endl;
+
+		auto directory = resolver.currentLink()->getTarget();
+		auto tailResult = co_await directory->getLink(resolver.nextComponent());
+		assert(tailResult);
+		auto tail = tailResult.value();
+		if(tail) {
+			if(req->flags() & managarm::posix::OpenFlags::OF_EXCLUSIVE) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
+				co_return true;
+			}else{
+				auto fileResult = co_await tail->getTarget()->open(
+									resolver.currentView(), std::move(tail),
+									semantic_flags);
+				assert(fileResult);
+				file = fileResult.value();
+				assert(file);
+			}
+		}else{
+			assert(directory->superblock());
+			auto node = co_await directory->superblock()->createRegular();
+			if (!node) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+				co_return true;
+			}
+			auto chmodResult = co_await node->chmod(req->mode());
+			if (chmodResult != Error::success) {
+				std::cout << "posix: chmod failed when creating file for OpenAtRequest!" << std::endl;
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::INTERNAL_ERROR);
+				co_return true;
+			}
+			// Due to races, link() can fail here.
+			// TODO: Implement a version of link() that eithers links the new node
+			// or returns the current node without failing.
+			auto linkResult = co_await directory->link(resolver.nextComponent(), node);
+			assert(linkResult);
+			auto link = linkResult.value();
+			auto fileResult = co_await node->open(resolver.currentView(), std::move(link),
+								semantic_flags);
+			assert(fileResult);
+			file = fileResult.value();
+			assert(file);
+		}
+	}else{
+		auto resolveResult = co_await resolver.resolve();
+		if(!resolveResult) {
+			if(resolveResult.error() == protocols::fs::Error::isDirectory) {
+				// TODO: Verify additional constraints for sending EISDIR.
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
+				co_return true;
+			} else if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+				co_return true;
+			} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+				co_return true;
+			} else {
+				std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+				co_return false;
 			}
+		}
 
-			if(file->isTerminal() &&
-				!(req->flags() & managarm::posix::OpenFlags::OF_NOCTTY) &&
-				self->pgPointer()->getSession()->getSessionId() == (pid_t)self->pid() &&
-				self->pgPointer()->getSession()->getControllingTerminal() == nullptr) {
-				// POSIX 1003.1-2017 11.1.3
-				auto cts = co_await file->getControllingTerminal();
-				if(!cts) {
-					std::cout << "posix: Unable to get controlling terminal (" << (int)cts.error() << ")" << std::endl;
+		auto target = resolver.currentLink()->getTarget();
+
+		if(req->flags() & managarm::posix::OpenFlags::OF_PATH) {
+			auto dummyFile = smarter::make_shared<DummyFile>(resolver.currentView(), resolver.currentLink());
+			DummyFile::serve(dummyFile);
+			file = File::constructHandle(std::move(dummyFile));
+		} else {
+			auto fileResult = co_await target->open(resolver.currentView(), resolver.currentLink(), semantic_flags);
+			if(!fileResult) {
+				if(fileResult.error() == Error::noBackingDevice) {
+					co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_BACKING_DEVICE);
+					co_return true;
+				} else if(fileResult.error() == Error::illegalArguments) {
+					co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+					co_return true;
 				} else {
-					cts.value()->assignSessionOf(self.get());
+					std::cout << "posix: Unexpected failure from open()" << std::endl;
+					co_return false;
 				}
 			}
+			assert(fileResult);
+			file = fileResult.value();
+		}
+	}
 
-			if(req->flags() & managarm::posix::OpenFlags::OF_TRUNC) {
-				auto result = co_await file->truncate(0);
-				assert(result || result.error() == protocols::fs::Error::illegalOperationTarget);
-			}
-			int fd = self->fileContext()->attachFile(file,
-					req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+	if(!file) {
+		if(logRequests)
+			std::cout << "posix:     OPEN failed: file not found" << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+		co_return true;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
-
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
-			HEL_CHECK(sendResp.error());
-		}else if(preamble.id() == bragi::message_id<managarm::posix::CloseRequest>) {
-			auto req = bragi::parse_head_only<managarm::posix::CloseRequest>(recv_head);
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
-			if(logRequests)
-				std::cout << "posix: CLOSE file descriptor " << req->fd() << std::endl;
+	if(file->isTerminal() &&
+		!(req->flags() & managarm::posix::OpenFlags::OF_NOCTTY) &&
+		ctx.self->pgPointer()->getSession()->getSessionId() == (pid_t)ctx.self->pid() &&
+		ctx.self->pgPointer()->getSession()->getControllingTerminal() == nullptr) {
+		// POSIX 1003.1-2017 11.1.3
+		auto cts = co_await file->getControllingTerminal();
+		if(!cts) {
+			std::cout << "posix: Unable to get controlling terminal (" << (int)cts.error() << ")" << std::endl;
+		} else {
+			cts.value()->assignSessionOf(ctx.self.get());
+		}
+	}
 
-			auto closeErr = self->fileContext()->closeFile(req->fd());
+	if(req->flags() & managarm::posix::OpenFlags::OF_TRUNC) {
+		auto result = co_await file->truncate(0);
+		assert(result || result.error() == protocols::fs::Error::illegalOperationTarget);
+	}
+	int fd = ctx.self->fileContext()->attachFile(file,
+			req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(fd);
+
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
 
-			if(closeErr != Error::success) {
-				if(closeErr == Error::noSuchFile) {
-					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
-					continue;
-				} else {
-					std::cout << "posix: Unhandled error returned from closeFile" << std::endl;
-					break;
-				}
-			}
+async::result<bool> handleClose(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::CloseRequest>(ctx.recvHead);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
+	if(logRequests)
+		std::cout << "posix: CLOSE file descriptor " << req->fd() << std::endl;
+
+	auto closeErr = ctx.self->fileContext()->closeFile(req->fd());
+
+	if(closeErr != Error::success) {
+		if(closeErr == Error::noSuchFile) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+			co_return true;
+		} else {
+			std::cout << "posix: Unhandled error returned from closeFile" << std::endl;
+			co_return false;
+		}
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
-			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::DUP) {
-			if(logRequests)
-				std::cout << "posix: DUP" << std::endl;
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
 
-			auto file = self->fileContext()->getFile(req.fd());
+async::result<bool> handleDup(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: DUP" << std::endl;
 
-			if (!file) {
-				helix::SendBuffer send_resp;
+	auto file = ctx.self->fileContext()->getFile(req.fd());
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::BAD_FD);
+	if (!file) {
+		helix::SendBuffer send_resp;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::BAD_FD);
 
-			if(req.flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC)) {
-				helix::SendBuffer send_resp;
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return true;
+	}
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	if(req.flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC)) {
+		helix::SendBuffer send_resp;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
 
-			int newfd = self->fileContext()->attachFile(file,
-					req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return true;
+	}
 
-			helix::SendBuffer send_resp;
+	int newfd = ctx.self->fileContext()->attachFile(file,
+			req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(newfd);
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::DUP2) {
-			if(logRequests)
-				std::cout << "posix: DUP2" << std::endl;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(newfd);
 
-			auto file = self->fileContext()->getFile(req.fd());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			if (!file || req.newfd() < 0) {
-				helix::SendBuffer send_resp;
+async::result<bool> handleDup2(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: DUP2" << std::endl;
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::BAD_FD);
+	auto file = ctx.self->fileContext()->getFile(req.fd());
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	if (!file || req.newfd() < 0) {
+		helix::SendBuffer send_resp;
 
-			if(req.flags()) {
-				helix::SendBuffer send_resp;
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::BAD_FD);
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return true;
+	}
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	if(req.flags()) {
+		helix::SendBuffer send_resp;
 
-			self->fileContext()->attachFile(req.newfd(), file);
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
 
-			helix::SendBuffer send_resp;
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return true;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	ctx.self->fileContext()->attachFile(req.newfd(), file);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == bragi::message_id<managarm::posix::IsTtyRequest>) {
-			auto req = bragi::parse_head_only<managarm::posix::IsTtyRequest>(recv_head);
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
-			if(logRequests)
-				std::cout << "posix: IS_TTY" << std::endl;
+	helix::SendBuffer send_resp;
 
-			auto file = self->fileContext()->getFile(req->fd());
-			if(!file) {
-				co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
-				continue;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			helix::SendBuffer send_resp;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_mode(file->isTerminal());
+async::result<bool> handleIsTty(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::IsTtyRequest>(ctx.recvHead);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
+	if(logRequests)
+		std::cout << "posix: IS_TTY" << std::endl;
 
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
-			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TTY_NAME) {
-			if(logRequests)
-				std::cout << "posix: TTY_NAME" << std::endl;
+	auto file = ctx.self->fileContext()->getFile(req->fd());
+	if(!file) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+		co_return true;
+	}
 
-			helix::SendBuffer send_resp;
+	helix::SendBuffer send_resp;
 
-			std::cout << "\e[31mposix: Fix TTY_NAME\e[39m" << std::endl;
-			managarm::posix::SvrResponse resp;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_mode(file->isTerminal());
 
-			auto file = self->fileContext()->getFile(req.fd());
-			if(!file) {
-			    co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
-			    continue;
-			}
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
 
-			auto ttynameResult = co_await file->ttyname();
-			if(!ttynameResult) {
-			    assert(ttynameResult.error() == Error::notTerminal);
-			    co_await sendErrorResponse(managarm::posix::Errors::NOT_A_TTY);
-			    continue;
-			}
+async::result<bool> handleTtyName(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: TTY_NAME" << std::endl;
 
-			resp.set_path(ttynameResult.value());
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GETCWD) {
-			if(logRequests)
-				std::cout << "posix: GETCWD" << std::endl;
+	std::cout << "\e[31mposix: Fix TTY_NAME\e[39m" << std::endl;
+	managarm::posix::SvrResponse resp;
 
-			std::string path = self->fsContext()->getWorkingDirectory().getPath(
-					self->fsContext()->getRoot());
+	auto file = ctx.self->fileContext()->getFile(req.fd());
+	if(!file) {
+	    co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+	    co_return true;
+	}
 
-			helix::SendBuffer send_resp;
-			helix::SendBuffer send_path;
+	auto ttynameResult = co_await file->ttyname();
+	if(!ttynameResult) {
+	    assert(ttynameResult.error() == Error::notTerminal);
+	    co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_TTY);
+	    co_return true;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_size(path.size());
+	resp.set_path(ttynameResult.value());
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-					helix::action(&send_path, path.data(),
-							std::min(static_cast<size_t>(req.size()), path.size() + 1)));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-			HEL_CHECK(send_path.error());
-		}else if(preamble.id() == managarm::posix::UnlinkAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto req = bragi::parse_head_tail<managarm::posix::UnlinkAtRequest>(recv_head, tail);
+async::result<bool> handleGetcwd(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GETCWD" << std::endl;
+
+	std::string path = ctx.self->fsContext()->getWorkingDirectory().getPath(
+			ctx.self->fsContext()->getRoot());
+
+	helix::SendBuffer send_resp;
+	helix::SendBuffer send_path;
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_size(path.size());
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+			helix::action(&send_path, path.data(),
+					std::min(static_cast<size_t>(req.size()), path.size() + 1)));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	HEL_CHECK(send_path.error());
+	co_return true;
+}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+async::result<bool> handleUnlinkAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			if(logRequests || logPaths)
-				std::cout << "posix: UNLINKAT path: " << req->path() << std::endl;
+	auto req = bragi::parse_head_tail<managarm::posix::UnlinkAtRequest>(ctx.recvHead, tail);
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(req->flags()) {
-				if(req->flags() & AT_REMOVEDIR) {
-					std::cout << "posix: UNLINKAT flag AT_REMOVEDIR handling unimplemented" << std::endl;
-				} else {
-					std::cout << "posix: UNLINKAT flag handling unimplemented with unknown flag: " << req->flags() << std::endl;
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				}
-			}
+	if(logRequests || logPaths)
+		std::cout << "posix: UNLINKAT path: " << req->path() << std::endl;
 
-			if(req->fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->fd());
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	if(req->flags()) {
+		if(req->flags() & AT_REMOVEDIR) {
+			std::cout << "posix: UNLINKAT flag AT_REMOVEDIR handling unimplemented" << std::endl;
+		} else {
+			std::cout << "posix: UNLINKAT flag handling unimplemented with unknown flag: " << req->flags() << std::endl;
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		}
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if(req->fd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->fd());
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-
-			auto resolveResult = co_await resolver.resolve();
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::isDirectory) {
-					// TODO: Only when AT_REMOVEDIR is not specified, fix this when flag handling is implemented.
-					co_await sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+		if (!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-			target_link = resolver.currentLink();
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			auto owner = target_link->getOwner();
-			if(!owner) {
-				co_await sendErrorResponse(managarm::posix::Errors::RESOURCE_IN_USE);
-				continue;
-			}
-			auto result = co_await owner->unlink(target_link->getName());
-			if(!result) {
-				if(result.error() == Error::noSuchFile) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				}else{
-					std::cout << "posix: Unexpected failure from unlink()" << std::endl;
-					co_return;
-				}
-			}
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+
+	auto resolveResult = co_await resolver.resolve();
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::isDirectory) {
+			// TODO: Only when AT_REMOVEDIR is not specified, fix this when flag handling is implemented.
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::IS_DIRECTORY);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::RmdirRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	target_link = resolver.currentLink();
 
-			auto req = bragi::parse_head_tail<managarm::posix::RmdirRequest>(recv_head, tail);
+	auto owner = target_link->getOwner();
+	if(!owner) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::RESOURCE_IN_USE);
+		co_return true;
+	}
+	auto result = co_await owner->unlink(target_link->getName());
+	if(!result) {
+		if(result.error() == Error::noSuchFile) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		}else{
+			std::cout << "posix: Unexpected failure from unlink()" << std::endl;
+			co_return false;
+		}
+	}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-			if(logRequests || logPaths)
-				std::cout << "posix: RMDIR " << req->path() << std::endl;
+async::result<bool> handleRmdir(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			std::cout << "\e[31mposix: RMDIR: always removes the directory, even when not empty\e[39m" << std::endl;
-			std::shared_ptr<FsLink> target_link;
+	auto req = bragi::parse_head_tail<managarm::posix::RmdirRequest>(ctx.recvHead, tail);
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(), self->fsContext()->getWorkingDirectory(),
-					req->path(), self.get());
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			auto resolveResult = co_await resolver.resolve();
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+	if(logRequests || logPaths)
+		std::cout << "posix: RMDIR " << req->path() << std::endl;
+
+	std::cout << "\e[31mposix: RMDIR: always removes the directory, even when not empty\e[39m" << std::endl;
+	std::shared_ptr<FsLink> target_link;
+
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(), ctx.self->fsContext()->getWorkingDirectory(),
+			req->path(), ctx.self.get());
+
+	auto resolveResult = co_await resolver.resolve();
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			target_link = resolver.currentLink();
+	target_link = resolver.currentLink();
 
-			auto owner = target_link->getOwner();
-			auto result = co_await owner->rmdir(target_link->getName());
-			if(!result) {
-				std::cout << "posix: Unexpected failure from rmdir()" << std::endl;
-				co_return;
-			}
+	auto owner = target_link->getOwner();
+	auto result = co_await owner->rmdir(target_link->getName());
+	if(!result) {
+		std::cout << "posix: Unexpected failure from rmdir()" << std::endl;
+		co_return false;
+	}
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(req.request_type() == managarm::posix::CntReqType::FD_GET_FLAGS) {
-			if(logRequests)
-				std::cout << "posix: FD_GET_FLAGS" << std::endl;
+	co_await ctx.sendErrorResponse(managarm::posix::Errors::SUCCESS);
+	co_return true;
+}
 
-			helix::SendBuffer send_resp;
+async::result<bool> handleFdGetFlags(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: FD_GET_FLAGS" << std::endl;
 
-			auto descriptor = self->fileContext()->getDescriptor(req.fd());
-			if(!descriptor) {
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::NO_SUCH_FD);
+	helix::SendBuffer send_resp;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	auto descriptor = ctx.self->fileContext()->getDescriptor(req.fd());
+	if(!descriptor) {
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::NO_SUCH_FD);
 
-			int flags = 0;
-			if(descriptor->closeOnExec)
-				flags |= FD_CLOEXEC;
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return true;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_flags(flags);
+	int flags = 0;
+	if(descriptor->closeOnExec)
+		flags |= FD_CLOEXEC;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::FD_SET_FLAGS) {
-			if(logRequests)
-				std::cout << "posix: FD_SET_FLAGS" << std::endl;
-
-			if(req.flags() & ~FD_CLOEXEC) {
-				std::cout << "posix: FD_SET_FLAGS unknown flags: " << req.flags() << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
-			int closeOnExec = req.flags() & FD_CLOEXEC;
-			if(self->fileContext()->setDescriptor(req.fd(), closeOnExec) != Error::success) {
-				co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
-				continue;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_flags(flags);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
-					helix_ng::sendBuffer(ser.data(), ser.size()));
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == bragi::message_id<managarm::posix::IoctlFioclexRequest>) {
-			auto req = bragi::parse_head_only<managarm::posix::IoctlFioclexRequest>(recv_head);
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+async::result<bool> handleFdSetFlags(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: FD_SET_FLAGS" << std::endl;
 
-			if(logRequests)
-				std::cout << "posix: FIOCLEX" << std::endl;
+	if(req.flags() & ~FD_CLOEXEC) {
+		std::cout << "posix: FD_SET_FLAGS unknown flags: " << req.flags() << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
+	int closeOnExec = req.flags() & FD_CLOEXEC;
+	if(ctx.self->fileContext()->setDescriptor(req.fd(), closeOnExec) != Error::success) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+		co_return true;
+	}
 
-			if(self->fileContext()->setDescriptor(req->fd(), true) != Error::success) {
-				co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
-				continue;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(ctx.conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()));
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
-					helix_ng::sendBuffer(ser.data(), ser.size()));
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SIG_ACTION) {
-			if(logRequests)
-				std::cout << "posix: SIG_ACTION" << std::endl;
-
-			if(req.flags() & ~(SA_ONSTACK | SA_SIGINFO | SA_RESETHAND | SA_NODEFER | SA_RESTART | SA_NOCLDSTOP)) {
-				std::cout << "\e[31mposix: Unknown SIG_ACTION flags: 0x"
-						<< std::hex << req.flags()
-						<< std::dec << "\e[39m" << std::endl;
-				assert(!"Flags not implemented");
-			}
+async::result<bool> handleIoctlFioclex(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::IoctlFioclexRequest>(ctx.recvHead);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			helix::SendBuffer send_resp;
+	if(logRequests)
+		std::cout << "posix: FIOCLEX" << std::endl;
 
-			managarm::posix::SvrResponse resp;
+	if(ctx.self->fileContext()->setDescriptor(req->fd(), true) != Error::success) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+		co_return true;
+	}
 
-			if(req.sig_number() <= 0 || req.sig_number() > 64) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			SignalHandler saved_handler;
-			if(req.mode()) {
-				SignalHandler handler;
-				if(req.sig_handler() == uintptr_t(SIG_DFL)) {
-					handler.disposition = SignalDisposition::none;
-				}else if(req.sig_handler() == uintptr_t(SIG_IGN)) {
-					handler.disposition = SignalDisposition::ignore;
-				}else{
-					handler.disposition = SignalDisposition::handle;
-					handler.handlerIp = req.sig_handler();
-				}
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(ctx.conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()));
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-				handler.flags = 0;
-				handler.mask = req.sig_mask();
-				handler.restorerIp = req.sig_restorer();
-
-				if(req.flags() & SA_SIGINFO)
-					handler.flags |= signalInfo;
-				if(req.flags() & SA_RESETHAND)
-					handler.flags |= signalOnce;
-				if(req.flags() & SA_NODEFER)
-					handler.flags |= signalReentrant;
-				if(req.flags() & SA_ONSTACK)
-					handler.flags |= signalOnStack;
-				if(req.flags() & SA_RESTART)
-					std::cout << "\e[31mposix: Ignoring SA_RESTART\e[39m" << std::endl;
-				if(req.flags() & SA_NOCLDSTOP)
-					std::cout << "\e[31mposix: Ignoring SA_NOCLDSTOP\e[39m" << std::endl;
-
-				saved_handler = self->signalContext()->changeHandler(req.sig_number(), handler);
-			}else{
-				saved_handler = self->signalContext()->getHandler(req.sig_number());
-			}
+async::result<bool> handleSigAction(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SIG_ACTION" << std::endl;
 
-			int saved_flags = 0;
-			if(saved_handler.flags & signalInfo)
-				saved_flags |= SA_SIGINFO;
-			if(saved_handler.flags & signalOnce)
-				saved_flags |= SA_RESETHAND;
-			if(saved_handler.flags & signalReentrant)
-				saved_flags |= SA_NODEFER;
-			if(saved_handler.flags & signalOnStack)
-				saved_flags |= SA_ONSTACK;
-
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_flags(saved_flags);
-			resp.set_sig_mask(saved_handler.mask);
-			if(saved_handler.disposition == SignalDisposition::handle) {
-				resp.set_sig_handler(saved_handler.handlerIp);
-				resp.set_sig_restorer(saved_handler.restorerIp);
-			}else if(saved_handler.disposition == SignalDisposition::none) {
-				resp.set_sig_handler((uint64_t)SIG_DFL);
-			}else{
-				assert(saved_handler.disposition == SignalDisposition::ignore);
-				resp.set_sig_handler((uint64_t)SIG_IGN);
-			}
+	if(req.flags() & ~(SA_ONSTACK | SA_SIGINFO | SA_RESETHAND | SA_NODEFER | SA_RESTART | SA_NOCLDSTOP)) {
+		std::cout << "\e[31mposix: Unknown SIG_ACTION flags: 0x"
+				<< std::hex << req.flags()
+				<< std::dec << "\e[39m" << std::endl;
+		assert(!"Flags not implemented");
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::PIPE_CREATE) {
-			if(logRequests)
-				std::cout << "posix: PIPE_CREATE" << std::endl;
+	helix::SendBuffer send_resp;
 
-			assert(!(req.flags() & ~(O_CLOEXEC | O_NONBLOCK)));
+	managarm::posix::SvrResponse resp;
 
-			bool nonBlock = false;
+	if(req.sig_number() <= 0 || req.sig_number() > 64) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return true;
+	}
 
-			if(req.flags() & O_NONBLOCK)
-				nonBlock = true;
+	SignalHandler saved_handler;
+	if(req.mode()) {
+		SignalHandler handler;
+		if(req.sig_handler() == uintptr_t(SIG_DFL)) {
+			handler.disposition = SignalDisposition::none;
+		}else if(req.sig_handler() == uintptr_t(SIG_IGN)) {
+			handler.disposition = SignalDisposition::ignore;
+		}else{
+			handler.disposition = SignalDisposition::handle;
+			handler.handlerIp = req.sig_handler();
+		}
 
-			helix::SendBuffer send_resp;
+		handler.flags = 0;
+		handler.mask = req.sig_mask();
+		handler.restorerIp = req.sig_restorer();
+
+		if(req.flags() & SA_SIGINFO)
+			handler.flags |= signalInfo;
+		if(req.flags() & SA_RESETHAND)
+			handler.flags |= signalOnce;
+		if(req.flags() & SA_NODEFER)
+			handler.flags |= signalReentrant;
+		if(req.flags() & SA_ONSTACK)
+			handler.flags |= signalOnStack;
+		if(req.flags() & SA_RESTART)
+			std::cout << "\e[31mposix: Ignoring SA_RESTART\e[39m" << std::endl;
+		if(req.flags() & SA_NOCLDSTOP)
+			std::cout << "\e[31mposix: Ignoring SA_NOCLDSTOP\e[39m" << std::endl;
+
+		saved_handler = ctx.self->signalContext()->changeHandler(req.sig_number(), handler);
+	}else{
+		saved_handler = ctx.self->signalContext()->getHandler(req.sig_number());
+	}
 
-			auto pair = fifo::createPair(nonBlock);
-			auto r_fd = self->fileContext()->attachFile(std::get<0>(pair),
-					req.flags() & O_CLOEXEC);
-			auto w_fd = self->fileContext()->attachFile(std::get<1>(pair),
-					req.flags() & O_CLOEXEC);
+	int saved_flags = 0;
+	if(saved_handler.flags & signalInfo)
+		saved_flags |= SA_SIGINFO;
+	if(saved_handler.flags & signalOnce)
+		saved_flags |= SA_RESETHAND;
+	if(saved_handler.flags & signalReentrant)
+		saved_flags |= SA_NODEFER;
+	if(saved_handler.flags & signalOnStack)
+		saved_flags |= SA_ONSTACK;
+
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_flags(saved_flags);
+	resp.set_sig_mask(saved_handler.mask);
+	if(saved_handler.disposition == SignalDisposition::handle) {
+		resp.set_sig_handler(saved_handler.handlerIp);
+		resp.set_sig_restorer(saved_handler.restorerIp);
+	}else if(saved_handler.disposition == SignalDisposition::none) {
+		resp.set_sig_handler((uint64_t)SIG_DFL);
+	}else{
+		assert(saved_handler.disposition == SignalDisposition::ignore);
+		resp.set_sig_handler((uint64_t)SIG_IGN);
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.add_fds(r_fd);
-			resp.add_fds(w_fd);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SETSID) {
-			if(logRequests)
-				std::cout << "posix: SETSID" << std::endl;
+async::result<bool> handlePipeCreate(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: PIPE_CREATE" << std::endl;
 
-			managarm::posix::SvrResponse resp;
+	assert(!(req.flags() & ~(O_CLOEXEC | O_NONBLOCK)));
 
-			if(self->pgPointer()->getSession()->getSessionId() == self->pid()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
-				continue;
-			}
+	bool nonBlock = false;
 
-			auto session = TerminalSession::initializeNewSession(self.get());
+	if(req.flags() & O_NONBLOCK)
+		nonBlock = true;
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_sid(session->getSessionId());
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
-					helix_ng::sendBuffer(ser.data(), ser.size()));
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SocketRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::SocketRequest>(recv_head);
+	auto pair = fifo::createPair(nonBlock);
+	auto r_fd = ctx.self->fileContext()->attachFile(std::get<0>(pair),
+			req.flags() & O_CLOEXEC);
+	auto w_fd = ctx.self->fileContext()->attachFile(std::get<1>(pair),
+			req.flags() & O_CLOEXEC);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.add_fds(r_fd);
+	resp.add_fds(w_fd);
 
-			if(logRequests)
-				std::cout << "posix: SOCKET" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-
-			assert(!(req->flags() & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)));
-
-			smarter::shared_ptr<File, FileHandle> file;
-			if(req->domain() == AF_UNIX) {
-				assert(req->socktype() == SOCK_DGRAM || req->socktype() == SOCK_STREAM
-						|| req->socktype() == SOCK_SEQPACKET);
-				assert(!req->protocol());
-
-				file = un_socket::createSocketFile(req->flags() & SOCK_NONBLOCK, req->socktype());
-			}else if(req->domain() == AF_NETLINK) {
-				assert(req->socktype() == SOCK_RAW || req->socktype() == SOCK_DGRAM);
-				// NL_ROUTE gets handled by the netserver.
-				if(req->protocol() == NETLINK_ROUTE)
-					file = co_await extern_socket::createSocket(
-						co_await net::getNetLane(),
-						req->domain(),
-						req->socktype(), req->protocol(),
-						req->flags() & SOCK_NONBLOCK
-					);
-				else
-					file = nl_socket::createSocketFile(req->protocol(), req->flags() & SOCK_NONBLOCK);
-			} else if (req->domain() == AF_INET) {
-				file = co_await extern_socket::createSocket(
-					co_await net::getNetLane(),
-					req->domain(),
-					req->socktype(), req->protocol(),
-					req->flags() & SOCK_NONBLOCK);
-			}else{
-				std::cout << "posix: SOCKET: Handle unknown protocols families, this is: " << req->domain() << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+async::result<bool> handleSetsid(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SETSID" << std::endl;
 
-			auto fd = self->fileContext()->attachFile(file,
-					req->flags() & SOCK_CLOEXEC);
+	managarm::posix::SvrResponse resp;
 
-			resp.set_fd(fd);
+	if(ctx.self->pgPointer()->getSession()->getSessionId() == ctx.self->pid()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
+		co_return true;
+	}
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	auto session = TerminalSession::initializeNewSession(ctx.self.get());
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SockpairRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::SockpairRequest>(recv_head);
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_sid(session->getSessionId());
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(ctx.conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()));
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			if(logRequests)
-				std::cout << "posix: SOCKPAIR" << std::endl;
+async::result<bool> handleSocket(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::SocketRequest>(ctx.recvHead);
 
-			assert(!(req->flags() & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)));
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(req->flags() & SOCK_NONBLOCK)
-				std::cout << "\e[31mposix: socketpair(SOCK_NONBLOCK)"
-						" is not implemented correctly\e[39m" << std::endl;
+	if(logRequests)
+		std::cout << "posix: SOCKET" << std::endl;
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	assert(!(req->flags() & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)));
+
+	smarter::shared_ptr<File, FileHandle> file;
+	if(req->domain() == AF_UNIX) {
+		assert(req->socktype() == SOCK_DGRAM || req->socktype() == SOCK_STREAM
+				|| req->socktype() == SOCK_SEQPACKET);
+		assert(!req->protocol());
+
+		file = un_socket::createSocketFile(req->flags() & SOCK_NONBLOCK, req->socktype());
+	}else if(req->domain() == AF_NETLINK) {
+		assert(req->socktype() == SOCK_RAW || req->socktype() == SOCK_DGRAM);
+		// NL_ROUTE gets handled by the netserver.
+		if(req->protocol() == NETLINK_ROUTE)
+			file = co_await extern_socket::createSocket(
+				co_await net::getNetLane(),
+				req->domain(),
+				req->socktype(), req->protocol(),
+				req->flags() & SOCK_NONBLOCK
+			);
+		else
+			file = nl_socket::createSocketFile(req->protocol(), req->flags() & SOCK_NONBLOCK);
+	} else if (req->domain() == AF_INET) {
+		file = co_await extern_socket::createSocket(
+			co_await net::getNetLane(),
+			req->domain(),
+			req->socktype(), req->protocol(),
+			req->flags() & SOCK_NONBLOCK);
+	}else{
+		std::cout << "posix: SOCKET: Handle unknown protocols families, this is: " << req->domain() << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			if(req->domain() != AF_UNIX) {
-				std::cout << "\e[31mposix: socketpair() with domain " << req->domain() <<
-						" is not implemented correctly\e[39m" << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ADDRESS_FAMILY_NOT_SUPPORTED);
-				continue;
-			}
-			if(req->socktype() != SOCK_DGRAM && req->socktype() != SOCK_STREAM
-					&& req->socktype() != SOCK_SEQPACKET) {
-				std::cout << "\e[31mposix: socketpair() with socktype " << req->socktype() <<
-						" is not implemented correctly\e[39m" << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
-			if(req->protocol() && req->protocol() != PF_UNSPEC) {
-				std::cout << "\e[31mposix: socketpair() with protocol " << req->protocol() <<
-						" is not implemented correctly\e[39m" << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::PROTOCOL_NOT_SUPPORTED);
-				continue;
-			}
+	auto fd = ctx.self->fileContext()->attachFile(file,
+			req->flags() & SOCK_CLOEXEC);
 
-			auto pair = un_socket::createSocketPair(self.get());
-			auto fd0 = self->fileContext()->attachFile(std::get<0>(pair),
-					req->flags() & SOCK_CLOEXEC);
-			auto fd1 = self->fileContext()->attachFile(std::get<1>(pair),
-					req->flags() & SOCK_CLOEXEC);
+	resp.set_fd(fd);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.add_fds(fd0);
-			resp.add_fds(fd1);
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::AcceptRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::AcceptRequest>(recv_head);
+async::result<bool> handleSockpair(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::SockpairRequest>(ctx.recvHead);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(logRequests)
-				std::cout << "posix: ACCEPT" << std::endl;
+	if(logRequests)
+		std::cout << "posix: SOCKPAIR" << std::endl;
 
-			auto sockfile = self->fileContext()->getFile(req->fd());
-			if(!sockfile) {
-				co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-				continue;
-			}
+	assert(!(req->flags() & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)));
 
-			auto newfileResult = co_await sockfile->accept(self.get());
-			if(!newfileResult) {
-				assert(newfileResult.error() == Error::wouldBlock);
-				co_await sendErrorResponse(managarm::posix::Errors::WOULD_BLOCK);
-				continue;
-			}
-			auto newfile = newfileResult.value();
-			auto fd = self->fileContext()->attachFile(std::move(newfile));
+	if(req->flags() & SOCK_NONBLOCK)
+		std::cout << "\e[31mposix: socketpair(SOCK_NONBLOCK)"
+				" is not implemented correctly\e[39m" << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+	if(req->domain() != AF_UNIX) {
+		std::cout << "\e[31mposix: socketpair() with domain " << req->domain() <<
+				" is not implemented correctly\e[39m" << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ADDRESS_FAMILY_NOT_SUPPORTED);
+		co_return true;
+	}
+	if(req->socktype() != SOCK_DGRAM && req->socktype() != SOCK_STREAM
+			&& req->socktype() != SOCK_SEQPACKET) {
+		std::cout << "\e[31mposix: socketpair() with socktype " << req->socktype() <<
+				" is not implemented correctly\e[39m" << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
+	if(req->protocol() && req->protocol() != PF_UNSPEC) {
+		std::cout << "\e[31mposix: socketpair() with protocol " << req->protocol() <<
+				" is not implemented correctly\e[39m" << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::PROTOCOL_NOT_SUPPORTED);
+		co_return true;
+	}
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	auto pair = un_socket::createSocketPair(ctx.self.get());
+	auto fd0 = ctx.self->fileContext()->attachFile(std::get<0>(pair),
+			req->flags() & SOCK_CLOEXEC);
+	auto fd1 = ctx.self->fileContext()->attachFile(std::get<1>(pair),
+			req->flags() & SOCK_CLOEXEC);
 
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_CALL) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_CALL" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			// Since file descriptors may appear multiple times in a poll() call,
-			// we need to de-duplicate them here.
-			std::unordered_map<int, unsigned int> fdsToEvents;
-
-			auto epfile = epoll::createFile();
-			assert(req.fds_size() == req.events_size());
-
-			bool errorOut = false;
-			for(size_t i = 0; i < req.fds_size(); i++) {
-				auto [mapIt, inserted] = fdsToEvents.insert({req.fds(i), 0});
-				if(!inserted)
-					continue;
-
-				auto file = self->fileContext()->getFile(req.fds(i));
-				if(!file) {
-					// poll() is supposed to fail on a per-FD basis.
-					mapIt->second = POLLNVAL;
-					continue;
-				}
-				auto locked = file->weakFile().lock();
-				assert(locked);
-
-				// Translate POLL events to EPOLL events.
-				if(req.events(i) & ~(POLLIN | POLLPRI | POLLOUT | POLLRDHUP | POLLERR | POLLHUP
-						| POLLNVAL | POLLWRNORM)) {
-					std::cout << "\e[31mposix: Unexpected events for poll()\e[39m" << std::endl;
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-					errorOut = true;
-					break;
-				}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.add_fds(fd0);
+	resp.add_fds(fd1);
 
-				unsigned int mask = 0;
-				if(req.events(i) & POLLIN) mask |= EPOLLIN;
-				if(req.events(i) & POLLOUT) mask |= EPOLLOUT;
-				if(req.events(i) & POLLWRNORM) mask |= EPOLLOUT;
-				if(req.events(i) & POLLPRI) mask |= EPOLLPRI;
-				if(req.events(i) & POLLRDHUP) mask |= EPOLLRDHUP;
-				if(req.events(i) & POLLERR) mask |= EPOLLERR;
-				if(req.events(i) & POLLHUP) mask |= EPOLLHUP;
-
-				// addItem() can fail with EEXIST but we check for duplicate FDs above
-				// so that cannot happen here.
-				Error ret = epoll::addItem(epfile.get(), self.get(),
-						std::move(locked), req.fds(i), mask, req.fds(i));
-				assert(ret == Error::success);
-			}
-			if(errorOut)
-				continue;
-
-			struct epoll_event events[16];
-			size_t k;
-			if(req.timeout() < 0) {
-				k = co_await epoll::wait(epfile.get(), events, 16);
-			}else if(!req.timeout()) {
-				// Do not bother to set up a timer for zero timeouts.
-				async::cancellation_event cancel_wait;
-				cancel_wait.cancel();
-				k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
-			}else{
-				assert(req.timeout() > 0);
-				async::cancellation_event cancel_wait;
-				helix::TimeoutCancellation timer{static_cast<uint64_t>(req.timeout()), cancel_wait};
-				k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
-				co_await timer.retire();
-			}
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			// Assigned the returned events to each FD.
-			for(size_t j = 0; j < k; ++j) {
-				auto it = fdsToEvents.find(events[j].data.fd);
-				assert(it != fdsToEvents.end());
-
-				// Translate EPOLL events back to POLL events.
-				assert(!it->second);
-				if(events[j].events & EPOLLIN) it->second |= POLLIN;
-				if(events[j].events & EPOLLOUT) it->second |= POLLOUT;
-				if(events[j].events & EPOLLPRI) it->second |= POLLPRI;
-				if(events[j].events & EPOLLRDHUP) it->second |= POLLRDHUP;
-				if(events[j].events & EPOLLERR) it->second |= POLLERR;
-				if(events[j].events & EPOLLHUP) it->second |= POLLHUP;
-			}
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<bool> handleAccept(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::AcceptRequest>(ctx.recvHead);
 
-			for(size_t i = 0; i < req.fds_size(); ++i) {
-				auto it = fdsToEvents.find(req.fds(i));
-				assert(it != fdsToEvents.end());
-				resp.add_events(it->second);
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_CREATE) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_CREATE" << std::endl;
+	if(logRequests)
+		std::cout << "posix: ACCEPT" << std::endl;
 
-			helix::SendBuffer send_resp;
+	auto sockfile = ctx.self->fileContext()->getFile(req->fd());
+	if(!sockfile) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+		co_return true;
+	}
 
-			assert(!(req.flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC)));
+	auto newfileResult = co_await sockfile->accept(ctx.self.get());
+	if(!newfileResult) {
+		assert(newfileResult.error() == Error::wouldBlock);
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::WOULD_BLOCK);
+		co_return true;
+	}
+	auto newfile = newfileResult.value();
+	auto fd = ctx.self->fileContext()->attachFile(std::move(newfile));
 
-			auto file = epoll::createFile();
-			auto fd = self->fileContext()->attachFile(file,
-					req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(fd);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_ADD) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_ADD" << std::endl;
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			helix::SendBuffer send_resp;
+async::result<bool> handleEpollCall(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_CALL" << std::endl;
 
-			auto epfile = self->fileContext()->getFile(req.fd());
-			auto file = self->fileContext()->getFile(req.newfd());
-			if(!file || !epfile) {
-				co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-				continue;
-			}
+	helix::SendBuffer send_resp;
 
-			auto locked = file->weakFile().lock();
-			assert(locked);
-			Error ret = epoll::addItem(epfile.get(), self.get(),
-					std::move(locked), req.newfd(), req.flags(), req.cookie());
-			if(ret == Error::alreadyExists) {
-				co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-				continue;
-			}
-			assert(ret == Error::success);
+	// Since file descriptors may appear multiple times in a poll() call,
+	// we need to de-duplicate them here.
+	std::unordered_map<int, unsigned int> fdsToEvents;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto epfile = epoll::createFile();
+	assert(req.fds_size() == req.events_size());
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_MODIFY) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_MODIFY" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			auto epfile = self->fileContext()->getFile(req.fd());
-			auto file = self->fileContext()->getFile(req.newfd());
-			assert(epfile && "Illegal FD for EPOLL_MODIFY");
-			assert(file && "Illegal FD for EPOLL_MODIFY item");
-
-			Error ret = epoll::modifyItem(epfile.get(), file.get(), req.newfd(),
-					req.flags(), req.cookie());
-			if(ret == Error::noSuchFile) {
-				co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-				continue;
-			}
-			assert(ret == Error::success);
+	bool errorOut = false;
+	for(size_t i = 0; i < req.fds_size(); i++) {
+		auto [mapIt, inserted] = fdsToEvents.insert({req.fds(i), 0});
+		if(!inserted)
+			continue;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+		auto file = ctx.self->fileContext()->getFile(req.fds(i));
+		if(!file) {
+			// poll() is supposed to fail on a per-FD basis.
+			mapIt->second = POLLNVAL;
+			continue;
+		}
+		auto locked = file->weakFile().lock();
+		assert(locked);
+
+		// Translate POLL events to EPOLL events.
+		if(req.events(i) & ~(POLLIN | POLLPRI | POLLOUT | POLLRDHUP | POLLERR | POLLHUP
+				| POLLNVAL | POLLWRNORM)) {
+			std::cout << "\e[31mposix: Unexpected events for poll()\e[39m" << std::endl;
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+			errorOut = true;
+			break;
+		}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_DELETE) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_DELETE" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			auto epfile = self->fileContext()->getFile(req.fd());
-			auto file = self->fileContext()->getFile(req.newfd());
-			if(!epfile || !file) {
-				std::cout << "posix: Illegal FD for EPOLL_DELETE" << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-				continue;
-			}
+		unsigned int mask = 0;
+		if(req.events(i) & POLLIN) mask |= EPOLLIN;
+		if(req.events(i) & POLLOUT) mask |= EPOLLOUT;
+		if(req.events(i) & POLLWRNORM) mask |= EPOLLOUT;
+		if(req.events(i) & POLLPRI) mask |= EPOLLPRI;
+		if(req.events(i) & POLLRDHUP) mask |= EPOLLRDHUP;
+		if(req.events(i) & POLLERR) mask |= EPOLLERR;
+		if(req.events(i) & POLLHUP) mask |= EPOLLHUP;
+
+		// addItem() can fail with EEXIST but we check for duplicate FDs above
+		// so that cannot happen here.
+		Error ret = epoll::addItem(epfile.get(), ctx.self.get(),
+				std::move(locked), req.fds(i), mask, req.fds(i));
+		assert(ret == Error::success);
+	}
+	if(errorOut)
+		co_return true;
+
+	struct epoll_event events[16];
+	size_t k;
+	if(req.timeout() < 0) {
+		k = co_await epoll::wait(epfile.get(), events, 16);
+	}else if(!req.timeout()) {
+		// Do not bother to set up a timer for zero timeouts.
+		async::cancellation_event cancel_wait;
+		cancel_wait.cancel();
+		k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
+	}else{
+		assert(req.timeout() > 0);
+		async::cancellation_event cancel_wait;
+		helix::TimeoutCancellation timer{static_cast<uint64_t>(req.timeout()), cancel_wait};
+		k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
+		co_await timer.retire();
+	}
 
-			Error ret = epoll::deleteItem(epfile.get(), file.get(), req.newfd(), req.flags());
-			if(ret == Error::noSuchFile) {
-				co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-				continue;
-			}
-			assert(ret == Error::success);
+	// Assigned the returned events to each FD.
+	for(size_t j = 0; j < k; ++j) {
+		auto it = fdsToEvents.find(events[j].data.fd);
+		assert(it != fdsToEvents.end());
+
+		// Translate EPOLL events back to POLL events.
+		assert(!it->second);
+		if(events[j].events & EPOLLIN) it->second |= POLLIN;
+		if(events[j].events & EPOLLOUT) it->second |= POLLOUT;
+		if(events[j].events & EPOLLPRI) it->second |= POLLPRI;
+		if(events[j].events & EPOLLRDHUP) it->second |= POLLRDHUP;
+		if(events[j].events & EPOLLERR) it->second |= POLLERR;
+		if(events[j].events & EPOLLHUP) it->second |= POLLHUP;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_WAIT) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_WAIT request" << std::endl;
-
-			helix::SendBuffer send_resp;
-			helix::SendBuffer send_data;
-			uint64_t former = self->signalMask();
-
-			auto epfile = self->fileContext()->getFile(req.fd());
-			if(!epfile) {
-				co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-				continue;
-			}
-			if(req.sigmask_needed()) {
-				self->setSignalMask(req.sigmask());
-			}
+	for(size_t i = 0; i < req.fds_size(); ++i) {
+		auto it = fdsToEvents.find(req.fds(i));
+		assert(it != fdsToEvents.end());
+		resp.add_events(it->second);
+	}
 
-			struct epoll_event events[16];
-			size_t k;
-			if(req.timeout() < 0) {
-				k = co_await epoll::wait(epfile.get(), events,
-						std::min(req.size(), uint32_t(16)));
-			}else if(!req.timeout()) {
-				// Do not bother to set up a timer for zero timeouts.
-				async::cancellation_event cancel_wait;
-				cancel_wait.cancel();
-				k = co_await epoll::wait(epfile.get(), events,
-						std::min(req.size(), uint32_t(16)), cancel_wait);
-			}else{
-				assert(req.timeout() > 0);
-				async::cancellation_event cancel_wait;
-				helix::TimeoutCancellation timer{static_cast<uint64_t>(req.timeout()), cancel_wait};
-				k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
-				co_await timer.retire();
-			}
-			if(req.sigmask_needed()) {
-				self->setSignalMask(former);
-			}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<bool> handleEpollCreate(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_CREATE" << std::endl;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-					helix::action(&send_data, events, k * sizeof(struct epoll_event)));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TIMERFD_CREATE) {
-			if(logRequests)
-				std::cout << "posix: TIMERFD_CREATE" << std::endl;
+	helix::SendBuffer send_resp;
 
-			helix::SendBuffer send_resp;
+	assert(!(req.flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC)));
 
-			assert(!(req.flags() & ~(TFD_CLOEXEC | TFD_NONBLOCK)));
+	auto file = epoll::createFile();
+	auto fd = ctx.self->fileContext()->attachFile(file,
+			req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
 
-			auto file = timerfd::createFile(req.flags() & TFD_NONBLOCK);
-			auto fd = self->fileContext()->attachFile(file, req.flags() & TFD_CLOEXEC);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(fd);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TIMERFD_SETTIME) {
-			if(logRequests)
-				std::cout << "posix: TIMERFD_SETTIME" << std::endl;
+async::result<bool> handleEpollAdd(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_ADD" << std::endl;
 
-			helix::SendBuffer send_resp;
+	helix::SendBuffer send_resp;
 
-			auto file = self->fileContext()->getFile(req.fd());
-			assert(file && "Illegal FD for TIMERFD_SETTIME");
-			timerfd::setTime(file.get(),
-					{static_cast<time_t>(req.time_secs()), static_cast<long>(req.time_nanos())},
-					{static_cast<time_t>(req.interval_secs()), static_cast<long>(req.interval_nanos())});
+	auto epfile = ctx.self->fileContext()->getFile(req.fd());
+	auto file = ctx.self->fileContext()->getFile(req.newfd());
+	if(!file || !epfile) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+		co_return true;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto locked = file->weakFile().lock();
+	assert(locked);
+	Error ret = epoll::addItem(epfile.get(), ctx.self.get(),
+			std::move(locked), req.newfd(), req.flags(), req.cookie());
+	if(ret == Error::alreadyExists) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
+		co_return true;
+	}
+	assert(ret == Error::success);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SIGNALFD_CREATE) {
-			if(logRequests)
-				std::cout << "posix: SIGNALFD_CREATE" << std::endl;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			helix::SendBuffer send_resp;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			if(req.flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC
-					| managarm::posix::OpenFlags::OF_NONBLOCK)) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+async::result<bool> handleEpollModify(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_MODIFY" << std::endl;
 
-			auto file = createSignalFile(req.sigset(),
-					req.flags() & managarm::posix::OpenFlags::OF_NONBLOCK);
-			auto fd = self->fileContext()->attachFile(file,
-					req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+	helix::SendBuffer send_resp;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+	auto epfile = ctx.self->fileContext()->getFile(req.fd());
+	auto file = ctx.self->fileContext()->getFile(req.newfd());
+	assert(epfile && "Illegal FD for EPOLL_MODIFY");
+	assert(file && "Illegal FD for EPOLL_MODIFY item");
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::InotifyCreateRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::InotifyCreateRequest>(recv_head);
+	Error ret = epoll::modifyItem(epfile.get(), file.get(), req.newfd(),
+			req.flags(), req.cookie());
+	if(ret == Error::noSuchFile) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+		co_return true;
+	}
+	assert(ret == Error::success);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			if(logRequests)
-				std::cout << "posix: INOTIFY_CREATE" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			assert(!(req->flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC | managarm::posix::OpenFlags::OF_NONBLOCK)));
+async::result<bool> handleEpollDelete(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_DELETE" << std::endl;
 
-			// TODO: Implement blocking reads
-			if(!(req->flags() & managarm::posix::OpenFlags::OF_NONBLOCK))
-				std::cout << "posix: INOTIFY_CREATE doesn't do blocking reads" << std::endl;
+	helix::SendBuffer send_resp;
 
-			auto file = inotify::createFile();
-			auto fd = self->fileContext()->attachFile(file,
-					req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+	auto epfile = ctx.self->fileContext()->getFile(req.fd());
+	auto file = ctx.self->fileContext()->getFile(req.newfd());
+	if(!epfile || !file) {
+		std::cout << "posix: Illegal FD for EPOLL_DELETE" << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+		co_return true;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+	Error ret = epoll::deleteItem(epfile.get(), file.get(), req.newfd(), req.flags());
+	if(ret == Error::noSuchFile) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+		co_return true;
+	}
+	assert(ret == Error::success);
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::InotifyAddRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto req = bragi::parse_head_tail<managarm::posix::InotifyAddRequest>(recv_head, tail);
+async::result<bool> handleEpollWait(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_WAIT request" << std::endl;
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	helix::SendBuffer send_resp;
+	helix::SendBuffer send_data;
+	uint64_t former = ctx.self->signalMask();
 
-			managarm::posix::SvrResponse resp;
+	auto epfile = ctx.self->fileContext()->getFile(req.fd());
+	if(!epfile) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+		co_return true;
+	}
+	if(req.sigmask_needed()) {
+		ctx.self->setSignalMask(req.sigmask());
+	}
 
-			if(logRequests || logPaths)
-				std::cout << "posix: INOTIFY_ADD" << req->path() << std::endl;
+	struct epoll_event events[16];
+	size_t k;
+	if(req.timeout() < 0) {
+		k = co_await epoll::wait(epfile.get(), events,
+				std::min(req.size(), uint32_t(16)));
+	}else if(!req.timeout()) {
+		// Do not bother to set up a timer for zero timeouts.
+		async::cancellation_event cancel_wait;
+		cancel_wait.cancel();
+		k = co_await epoll::wait(epfile.get(), events,
+				std::min(req.size(), uint32_t(16)), cancel_wait);
+	}else{
+		assert(req.timeout() > 0);
+		async::cancellation_event cancel_wait;
+		helix::TimeoutCancellation timer{static_cast<uint64_t>(req.timeout()), cancel_wait};
+		k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
+		co_await timer.retire();
+	}
+	if(req.sigmask_needed()) {
+		ctx.self->setSignalMask(former);
+	}
 
-			auto ifile = self->fileContext()->getFile(req->fd());
-			if(!ifile) {
-				co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-				continue;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req->path(), self.get());
-			auto resolveResult = co_await resolver.resolve();
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+			helix::action(&send_data, events, k * sizeof(struct epoll_event)));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			auto wd = inotify::addWatch(ifile.get(), resolver.currentLink()->getTarget(),
-					req->flags());
+async::result<bool> handleTimerfdCreate(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: TIMERFD_CREATE" << std::endl;
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_wd(wd);
+	helix::SendBuffer send_resp;
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	assert(!(req.flags() & ~(TFD_CLOEXEC | TFD_NONBLOCK)));
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::EventfdCreateRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::EventfdCreateRequest>(recv_head);
+	auto file = timerfd::createFile(req.flags() & TFD_NONBLOCK);
+	auto fd = ctx.self->fileContext()->attachFile(file, req.flags() & TFD_CLOEXEC);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(fd);
 
-			if(logRequests)
-				std::cout << "posix: EVENTFD_CREATE" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
+async::result<bool> handleTimerfdSettime(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: TIMERFD_SETTIME" << std::endl;
 
-			if (req->flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC | managarm::posix::OpenFlags::OF_NONBLOCK)) {
-				std::cout << "posix: invalid flag specified (EFD_SEMAPHORE?)" << std::endl;
-				std::cout << "posix: flags specified: " << req->flags() << std::endl;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
+	helix::SendBuffer send_resp;
 
-				auto file = eventfd::createFile(req->initval(), req->flags() & managarm::posix::OpenFlags::OF_NONBLOCK);
-				auto fd = self->fileContext()->attachFile(file,
-						req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+	auto file = ctx.self->fileContext()->getFile(req.fd());
+	assert(file && "Illegal FD for TIMERFD_SETTIME");
+	timerfd::setTime(file.get(),
+			{static_cast<time_t>(req.time_secs()), static_cast<long>(req.time_nanos())},
+			{static_cast<time_t>(req.interval_secs()), static_cast<long>(req.interval_nanos())});
 
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-				resp.set_fd(fd);
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::MknodAtRequest::message_id) {
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+async::result<bool> handleSignalfdCreate(RequestContext &ctx, managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SIGNALFD_CREATE" << std::endl;
 
-			auto req = bragi::parse_head_tail<managarm::posix::MknodAtRequest>(recv_head, tail);
+	helix::SendBuffer send_resp;
 
-			if(!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if(req.flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC
+			| managarm::posix::OpenFlags::OF_NONBLOCK)) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
 
-			if(logRequests || logPaths)
-				std::cout << "posix: MKNODAT for path " << req->path() << " with mode " << req->mode() << " and device " << req->device() << std::endl;
+	auto file = createSignalFile(req.sigset(),
+			req.flags() & managarm::posix::OpenFlags::OF_NONBLOCK);
+	auto fd = ctx.self->fileContext()->attachFile(file,
+			req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(fd);
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
+async::result<bool> handleInotifyCreate(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::InotifyCreateRequest>(ctx.recvHead);
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(!req->path().size()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(logRequests)
+		std::cout << "posix: INOTIFY_CREATE" << std::endl;
 
-			if(req->dirfd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req->dirfd());
+	assert(!(req->flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC | managarm::posix::OpenFlags::OF_NONBLOCK)));
 
-				if(!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	// TODO: Implement blocking reads
+	if(!(req->flags() & managarm::posix::OpenFlags::OF_NONBLOCK))
+		std::cout << "posix: INOTIFY_CREATE doesn't do blocking reads" << std::endl;
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	auto file = inotify::createFile();
+	auto fd = ctx.self->fileContext()->attachFile(file,
+			req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
 
-			// TODO: Add resolveNoTrailingSlash if not making a directory?
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req->path(), self.get());
-			auto resolveResult = co_await resolver.resolve(resolvePrefix);
-			if(!resolveResult) {
-				if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
-					co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-					continue;
-				} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
-					continue;
-				} else {
-					std::cout << "posix: Unexpected failure from resolve()" << std::endl;
-					co_return;
-				}
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(fd);
 
-			auto parent = resolver.currentLink()->getTarget();
-			auto existsResult = co_await parent->getLink(resolver.nextComponent());
-			assert(existsResult);
-			auto exists = existsResult.value();
-			if(exists) {
-				co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-				continue;
-			}
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			VfsType type;
-			DeviceId dev;
-			if(S_ISDIR(req->mode())) {
-				type = VfsType::directory;
-			} else if(S_ISCHR(req->mode())) {
-				type = VfsType::charDevice;
-			} else if(S_ISBLK(req->mode())) {
-				type = VfsType::blockDevice;
-			} else if(S_ISREG(req->mode())) {
-				type = VfsType::regular;
-			} else if(S_ISFIFO(req->mode())) {
-				type = VfsType::fifo;
-			} else if(S_ISLNK(req->mode())) {
-				type = VfsType::symlink;
-			} else if(S_ISSOCK(req->mode())) {
-				type = VfsType::socket;
-			} else {
-				type = VfsType::null;
-			}
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			// TODO: Verify the proper error return here.
-			if(type == VfsType::charDevice || type == VfsType::blockDevice) {
-				dev.first = major(req->device());
-				dev.second = minor(req->device());
-
-				auto result = co_await parent->mkdev(resolver.nextComponent(), type, dev);
-				if(!result) {
-					if(result.error() == Error::illegalOperationTarget) {
-						co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from mkdev()" << std::endl;
-						co_return;
-					}
-				}
-			} else if(type == VfsType::fifo) {
-				auto result = co_await parent->mkfifo(resolver.nextComponent(), req->mode());
-				if(!result) {
-					if(result.error() == Error::illegalOperationTarget) {
-						co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from mkfifo()" << std::endl;
-						co_return;
-					}
-				}
-			} else if(type == VfsType::socket) {
-				auto result = co_await parent->mksocket(resolver.nextComponent());
-				if(!result) {
-					if(result.error() == Error::illegalOperationTarget) {
-						co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-						continue;
-					} else {
-						std::cout << "posix: Unexpected failure from mksocket()" << std::endl;
-						co_return;
-					}
-				}
-			} else {
-				// TODO: Handle regular files.
-				std::cout << "\e[31mposix: Creating regular files with mknod is not supported.\e[39m" << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<bool> handleInotifyAdd(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	auto req = bragi::parse_head_tail<managarm::posix::InotifyAddRequest>(ctx.recvHead, tail);
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetPgidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::GetPgidRequest>(recv_head);
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	managarm::posix::SvrResponse resp;
 
-			if(logRequests)
-				std::cout << "posix: GET_PGID" << std::endl;
+	if(logRequests || logPaths)
+		std::cout << "posix: INOTIFY_ADD" << req->path() << std::endl;
 
-			std::shared_ptr<Process> target;
-			if(req->pid()) {
-				target = Process::findProcess(req->pid());
-				if(!target) {
-					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
-					continue;
-				}
-			} else {
-				target = self;
-			}
+	auto ifile = ctx.self->fileContext()->getFile(req->fd());
+	if(!ifile) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+		co_return true;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(target->pgPointer()->getHull()->getPid());
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			ctx.self->fsContext()->getWorkingDirectory(), req->path(), ctx.self.get());
+	auto resolveResult = co_await resolver.resolve();
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	auto wd = inotify::addWatch(ifile.get(), resolver.currentLink()->getTarget(),
+			req->flags());
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SetPgidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::SetPgidRequest>(recv_head);
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_wd(wd);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
+
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			if(logRequests)
-				std::cout << "posix: SET_PGID" << std::endl;
+async::result<bool> handleEventfdCreate(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::EventfdCreateRequest>(ctx.recvHead);
 
-			std::shared_ptr<Process> target;
-			if(req->pid()) {
-				target = Process::findProcess(req->pid());
-				if(!target) {
-					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
-					continue;
-				}
-			} else {
-				target = self;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(target->pgPointer()->getSession() != self->pgPointer()->getSession()) {
-				co_await sendErrorResponse(managarm::posix::Errors::INSUFFICIENT_PERMISSION);
-				continue;
-			}
+	if(logRequests)
+		std::cout << "posix: EVENTFD_CREATE" << std::endl;
 
-			// We can't change the process group ID of the session leader
-			if(target->pid() == target->pgPointer()->getSession()->getSessionId()) {
-				co_await sendErrorResponse(managarm::posix::Errors::INSUFFICIENT_PERMISSION);
-				continue;
-			}
+	managarm::posix::SvrResponse resp;
 
-			if(target->getParent()->pid() == self->pid()) {
-				if(target->didExecute()) {
-					co_await sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
-					continue;
-				}
-			}
+	if (req->flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC | managarm::posix::OpenFlags::OF_NONBLOCK)) {
+		std::cout << "posix: invalid flag specified (EFD_SEMAPHORE?)" << std::endl;
+		std::cout << "posix: flags specified: " << req->flags() << std::endl;
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+
+		auto file = eventfd::createFile(req->initval(), req->flags() & managarm::posix::OpenFlags::OF_NONBLOCK);
+		auto fd = ctx.self->fileContext()->attachFile(file,
+				req->flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+		resp.set_fd(fd);
+	}
+
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
+
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
+
+async::result<bool> handleMknodAt(RequestContext &ctx) {
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
+
+	auto req = bragi::parse_head_tail<managarm::posix::MknodAtRequest>(ctx.recvHead, tail);
+
+	if(!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
+
+	if(logRequests || logPaths)
+		std::cout << "posix: MKNODAT for path " << req->path() << " with mode " << req->mode() << " and device " << req->device() << std::endl;
+
+	managarm::posix::SvrResponse resp;
+
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+
+	if(!req->path().size()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
+
+	if(req->dirfd() == AT_FDCWD) {
+		relative_to = ctx.self->fsContext()->getWorkingDirectory();
+	} else {
+		file = ctx.self->fileContext()->getFile(req->dirfd());
+
+		if(!file) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::BAD_FD);
+			co_return true;
+		}
 
-			std::shared_ptr<ProcessGroup> group;
-			// If pgid is 0, we're going to set it to the calling process's pid, use the target group.
-			if(req->pgid()) {
-				group = target->pgPointer()->getSession()->getProcessGroupById(req->pgid());
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
+
+	// TODO: Add resolveNoTrailingSlash if not making a directory?
+	PathResolver resolver;
+	resolver.setup(ctx.self->fsContext()->getRoot(),
+			relative_to, req->path(), ctx.self.get());
+	auto resolveResult = co_await resolver.resolve(resolvePrefix);
+	if(!resolveResult) {
+		if(resolveResult.error() == protocols::fs::Error::fileNotFound) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
+			co_return true;
+		} else if(resolveResult.error() == protocols::fs::Error::notDirectory) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NOT_A_DIRECTORY);
+			co_return true;
+		} else {
+			std::cout << "posix: Unexpected failure from resolve()" << std::endl;
+			co_return false;
+		}
+	}
+
+	auto parent = resolver.currentLink()->getTarget();
+	auto existsResult = co_await parent->getLink(resolver.nextComponent());
+	assert(existsResult);
+	auto exists = existsResult.value();
+	if(exists) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
+		co_return true;
+	}
+
+	VfsType type;
+	DeviceId dev;
+	if(S_ISDIR(req->mode())) {
+		type = VfsType::directory;
+	} else if(S_ISCHR(req->mode())) {
+		type = VfsType::charDevice;
+	} else if(S_ISBLK(req->mode())) {
+		type = VfsType::blockDevice;
+	} else if(S_ISREG(req->mode())) {
+		type = VfsType::regular;
+	} else if(S_ISFIFO(req->mode())) {
+		type = VfsType::fifo;
+	} else if(S_ISLNK(req->mode())) {
+		type = VfsType::symlink;
+	} else if(S_ISSOCK(req->mode())) {
+		type = VfsType::socket;
+	} else {
+		type = VfsType::null;
+	}
+
+	// TODO: Verify the proper error return here.
+	if(type == VfsType::charDevice || type == VfsType::blockDevice) {
+		dev.first = major(req->device());
+		dev.second = minor(req->device());
+
+		auto result = co_await parent->mkdev(resolver.nextComponent(), type, dev);
+		if(!result) {
+			if(result.error() == Error::illegalOperationTarget) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				co_return true;
 			} else {
-				group = target->pgPointer();
+				std::cout << "posix: Unexpected failure from mkdev()" << std::endl;
+				co_return false;
 			}
-
-			if(group) {
-				// Found, do permission checking and join
-				group->reassociateProcess(target.get());
+		}
+	} else if(type == VfsType::fifo) {
+		auto result = co_await parent->mkfifo(resolver.nextComponent(), req->mode());
+		if(!result) {
+			if(result.error() == Error::illegalOperationTarget) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				co_return true;
 			} else {
-				// Not found, making it if pgid and pid match, or if pgid is 0, indicating that we should make one
-				if(target->pid() == req->pgid() || !req->pgid()) {
-					target->pgPointer()->getSession()->spawnProcessGroup(target.get());
-				} else {
-					// Doesn't exists, and not requesting a make?
-					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
-					continue;
-				}
+				std::cout << "posix: Unexpected failure from mkfifo()" << std::endl;
+				co_return false;
+			}
+		}
+	} else if(type == VfsType::socket) {
+		auto result = co_await parent->mksocket(resolver.nextComponent());
+		if(!result) {
+			if(result.error() == Error::illegalOperationTarget) {
+				co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				co_return true;
+			} else {
+				std::cout << "posix: Unexpected failure from mksocket()" << std::endl;
+				co_return false;
 			}
+		}
+	} else {
+		// TODO: Handle regular files.
+		std::cout << "\e[31mposix: Creating regular files with mknod is not supported.\e[39m" << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetSidRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::GetSidRequest>(recv_head);
+async::result<bool> handleGetPgid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetPgidRequest>(ctx.recvHead);
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(logRequests)
-				std::cout << "posix: GET_SID on pid " << req->pid() << std::endl;
+	if(logRequests)
+		std::cout << "posix: GET_PGID" << std::endl;
 
-			std::shared_ptr<Process> target;
-			if(req->pid()) {
-				target = Process::findProcess(req->pid());
-				if(!target) {
-					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
-					continue;
-				}
-			} else {
-				target = self;
-			}
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(target->pgPointer()->getSession()->getSessionId());
+	std::shared_ptr<Process> target;
+	if(req->pid()) {
+		target = Process::findProcess(req->pid());
+		if(!target) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
+			co_return true;
+		}
+	} else {
+		target = ctx.self;
+	}
 
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(target->pgPointer()->getHull()->getPid());
 
-			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::MemFdCreateRequest::message_id) {
-			managarm::posix::SvrResponse resp;
-			std::vector<std::byte> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			auto req = bragi::parse_head_tail<managarm::posix::MemFdCreateRequest>(recv_head, tail);
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+async::result<bool> handleSetPgid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::SetPgidRequest>(ctx.recvHead);
 
-			if(logRequests)
-				std::cout << "posix: MEMFD_CREATE " << req->name() << std::endl;
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(req->flags() & ~(MFD_CLOEXEC | MFD_ALLOW_SEALING)) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(logRequests)
+		std::cout << "posix: SET_PGID" << std::endl;
 
-			auto link = SpecialLink::makeSpecialLink(VfsType::regular, 0777);
-			auto memFile = smarter::make_shared<MemoryFile>(nullptr, link, (req->flags() & MFD_ALLOW_SEALING) == true);
-			MemoryFile::serve(memFile);
-			auto file = File::constructHandle(std::move(memFile));
+	std::shared_ptr<Process> target;
+	if(req->pid()) {
+		target = Process::findProcess(req->pid());
+		if(!target) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
+			co_return true;
+		}
+	} else {
+		target = ctx.self;
+	}
 
-			int flags = 0;
+	if(target->pgPointer()->getSession() != ctx.self->pgPointer()->getSession()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::INSUFFICIENT_PERMISSION);
+		co_return true;
+	}
 
-			if(req->flags() & MFD_CLOEXEC) {
-				flags |= managarm::posix::OpenFlags::OF_CLOEXEC;
-			}
+	// We can't change the process group ID of the session leader
+	if(target->pid() == target->pgPointer()->getSession()->getSessionId()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::INSUFFICIENT_PERMISSION);
+		co_return true;
+	}
 
-			int fd = self->fileContext()->attachFile(file, flags);
-
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
-
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-				);
-			HEL_CHECK(sendResp.error());
-		}else if(preamble.id() == managarm::posix::SetAffinityRequest::message_id) {
-			std::vector<uint8_t> tail(preamble.tail_size());
-			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::recvBuffer(tail.data(), tail.size())
-				);
-			HEL_CHECK(recv_tail.error());
-
-			auto req = bragi::parse_head_tail<managarm::posix::SetAffinityRequest>(recv_head, tail);
-			
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if(target->getParent()->pid() == ctx.self->pid()) {
+		if(target->didExecute()) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ACCESS_DENIED);
+			co_return true;
+		}
+	}
 
-			if(logRequests)
-				std::cout << "posix: SET_AFFINITY" << std::endl;
+	std::shared_ptr<ProcessGroup> group;
+	// If pgid is 0, we're going to set it to the calling process's pid, use the target group.
+	if(req->pgid()) {
+		group = target->pgPointer()->getSession()->getProcessGroupById(req->pgid());
+	} else {
+		group = target->pgPointer();
+	}
 
-			auto handle = self->threadDescriptor().getHandle();
+	if(group) {
+		// Found, do permission checking and join
+		group->reassociateProcess(target.get());
+	} else {
+		// Not found, making it if pgid and pid match, or if pgid is 0, indicating that we should make one
+		if(target->pid() == req->pgid() || !req->pgid()) {
+			target->pgPointer()->getSession()->spawnProcessGroup(target.get());
+		} else {
+			// Doesn't exists, and not requesting a make?
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
+			co_return true;
+		}
+	}
 
-			if(self->pid() != req->pid()) {
-				// TODO: permission checking
-				auto target_process = self->findProcess(req->pid());
-				if(target_process == nullptr) {
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-					continue;
-				}
-				handle = target_process->threadDescriptor().getHandle();
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			HelError e = helSetAffinity(handle, req->mask().data(), req->mask().size());
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			if(e == kHelErrIllegalArgs) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			} else if(e != kHelErrNone) {
-				std::cout << "posix: SET_AFFINITY hel call returned unexpected error: " << e << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::INTERNAL_ERROR);
-				continue;
-			}
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<bool> handleGetSid(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetSidRequest>(ctx.recvHead);
 
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
-			);
-			HEL_CHECK(sendResp.error());
-		}else if(preamble.id() == managarm::posix::GetAffinityRequest::message_id) {
-			auto req = bragi::parse_head_only<managarm::posix::GetAffinityRequest>(recv_head);
-			
-			if (!req) {
-				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
-				break;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			if(logRequests)
-				std::cout << "posix: GET_AFFINITY" << std::endl;
+	if(logRequests)
+		std::cout << "posix: GET_SID on pid " << req->pid() << std::endl;
 
-			if(!req->size()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	std::shared_ptr<Process> target;
+	if(req->pid()) {
+		target = Process::findProcess(req->pid());
+		if(!target) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
+			co_return true;
+		}
+	} else {
+		target = ctx.self;
+	}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(target->pgPointer()->getSession()->getSessionId());
 
-			std::vector<uint8_t> affinity(req->size());
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
 
-			auto handle = self->threadDescriptor().getHandle();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
 
-			if(self->pid() != req->pid()) {
-				// TODO: permission checking
-				auto target_process = self->findProcess(req->pid());
-				if(target_process == nullptr) {
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-					continue;
-				}
-				handle = target_process->threadDescriptor().getHandle();
-			}
+async::result<bool> handleMemFdCreate(RequestContext &ctx) {
+	managarm::posix::SvrResponse resp;
+	std::vector<std::byte> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
 
-			size_t actual_size;
-			HelError e = helGetAffinity(handle, affinity.data(), req->size(), &actual_size);
+	auto req = bragi::parse_head_tail<managarm::posix::MemFdCreateRequest>(ctx.recvHead, tail);
 
-			if(e == kHelErrBufferTooSmall) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			} else if(e != kHelErrNone) {
-				std::cout << "posix: GET_AFFINITY hel call returned unexpected error: " << e << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::INTERNAL_ERROR);
-				continue;
-			}
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(self->pid());
+	if(logRequests)
+		std::cout << "posix: MEMFD_CREATE " << req->name() << std::endl;
 
-			auto [sendResp, sendData] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{}),
-				helix_ng::sendBuffer(affinity.data(), affinity.size())
+	if(req->flags() & ~(MFD_CLOEXEC | MFD_ALLOW_SEALING)) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
+
+	auto link = SpecialLink::makeSpecialLink(VfsType::regular, 0777);
+	auto memFile = smarter::make_shared<MemoryFile>(nullptr, link, (req->flags() & MFD_ALLOW_SEALING) == true);
+	MemoryFile::serve(memFile);
+	auto file = File::constructHandle(std::move(memFile));
+
+	int flags = 0;
+
+	if(req->flags() & MFD_CLOEXEC) {
+		flags |= managarm::posix::OpenFlags::OF_CLOEXEC;
+	}
+
+	int fd = ctx.self->fileContext()->attachFile(file, flags);
+
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(fd);
+
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+		);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
+
+async::result<bool> handleSetAffinity(RequestContext &ctx) {
+	std::vector<uint8_t> tail(ctx.preamble.tail_size());
+	auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+			ctx.conversation,
+			helix_ng::recvBuffer(tail.data(), tail.size())
+		);
+	HEL_CHECK(recv_tail.error());
+
+	auto req = bragi::parse_head_tail<managarm::posix::SetAffinityRequest>(ctx.recvHead, tail);
+	
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
+
+	if(logRequests)
+		std::cout << "posix: SET_AFFINITY" << std::endl;
+
+	auto handle = ctx.self->threadDescriptor().getHandle();
+
+	if(ctx.self->pid() != req->pid()) {
+		// TODO: permission checking
+		auto target_process = ctx.self->findProcess(req->pid());
+		if(target_process == nullptr) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+			co_return true;
+		}
+		handle = target_process->threadDescriptor().getHandle();
+	}
+
+	HelError e = helSetAffinity(handle, req->mask().data(), req->mask().size());
+
+	if(e == kHelErrIllegalArgs) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	} else if(e != kHelErrNone) {
+		std::cout << "posix: SET_AFFINITY hel call returned unexpected error: " << e << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::INTERNAL_ERROR);
+		co_return true;
+	}
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+		ctx.conversation,
+		helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+	);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
+
+async::result<bool> handleGetAffinity(RequestContext &ctx) {
+	auto req = bragi::parse_head_only<managarm::posix::GetAffinityRequest>(ctx.recvHead);
+	
+	if (!req) {
+		std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+		co_return false;
+	}
+
+	if(logRequests)
+		std::cout << "posix: GET_AFFINITY" << std::endl;
+
+	if(!req->size()) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	}
+
+	std::vector<uint8_t> affinity(req->size());
+
+	auto handle = ctx.self->threadDescriptor().getHandle();
+
+	if(ctx.self->pid() != req->pid()) {
+		// TODO: permission checking
+		auto target_process = ctx.self->findProcess(req->pid());
+		if(target_process == nullptr) {
+			co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+			co_return true;
+		}
+		handle = target_process->threadDescriptor().getHandle();
+	}
+
+	size_t actual_size;
+	HelError e = helGetAffinity(handle, affinity.data(), req->size(), &actual_size);
+
+	if(e == kHelErrBufferTooSmall) {
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return true;
+	} else if(e != kHelErrNone) {
+		std::cout << "posix: GET_AFFINITY hel call returned unexpected error: " << e << std::endl;
+		co_await ctx.sendErrorResponse(managarm::posix::Errors::INTERNAL_ERROR);
+		co_return true;
+	}
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(ctx.self->pid());
+
+	auto [sendResp, sendData] = co_await helix_ng::exchangeMsgs(
+		ctx.conversation,
+		helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{}),
+		helix_ng::sendBuffer(affinity.data(), affinity.size())
+	);
+	HEL_CHECK(sendResp.error());
+	co_return true;
+}
+
+async::result<bool> handleIllegalRequest(RequestContext &ctx) {
+	std::cout << "posix: Illegal request" << std::endl;
+	helix::SendBuffer send_resp;
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::ILLEGAL_REQUEST);
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(ctx.conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	co_return true;
+}
+
+// Maps message IDs (or CntReqType values) to handlers.
+// Both are small integers, hence we can use them to index into an array.
+template<typename Handler, size_t N>
+struct RequestTable {
+	struct Entry {
+		const char *name = nullptr;
+		Handler handler = nullptr;
+	};
+
+	constexpr void add(uint32_t id, const char *name, Handler handler) {
+		assert(!entries[id].handler);
+		entries[id] = {name, handler};
+	}
+
+	constexpr const Entry *find(uint32_t id) const {
+		if(id >= N || !entries[id].handler)
+			return nullptr;
+		return &entries[id];
+	}
+
+	std::array<Entry, N> entries{};
+};
+
+constexpr auto requestTable = [] {
+	RequestTable<RequestHandler, 64> table;
+	table.add(managarm::posix::GetPidRequest::message_id, "GET_PID", &handleGetPid);
+	table.add(managarm::posix::GetPpidRequest::message_id, "GET_PPID", &handleGetPpid);
+	table.add(managarm::posix::GetUidRequest::message_id, "GET_UID", &handleGetUid);
+	table.add(managarm::posix::SetUidRequest::message_id, "SET_UID", &handleSetUid);
+	table.add(managarm::posix::GetEuidRequest::message_id, "GET_EUID", &handleGetEuid);
+	table.add(managarm::posix::SetEuidRequest::message_id, "SET_EUID", &handleSetEuid);
+	table.add(managarm::posix::GetGidRequest::message_id, "GET_GID", &handleGetGid);
+	table.add(managarm::posix::GetEgidRequest::message_id, "GET_EGID", &handleGetEgid);
+	table.add(managarm::posix::SetGidRequest::message_id, "SET_GID", &handleSetGid);
+	table.add(managarm::posix::SetEgidRequest::message_id, "SET_EGID", &handleSetEgid);
+	table.add(managarm::posix::WaitIdRequest::message_id, "WAIT_ID", &handleWaitId);
+	table.add(managarm::posix::VmMapRequest::message_id, "VM_MAP", &handleVmMap);
+	table.add(managarm::posix::MountRequest::message_id, "MOUNT", &handleMount);
+	table.add(managarm::posix::AccessAtRequest::message_id, "ACCESS_AT", &handleAccessAt);
+	table.add(managarm::posix::MkdirAtRequest::message_id, "MKDIR_AT", &handleMkdirAt);
+	table.add(managarm::posix::MkfifoAtRequest::message_id, "MKFIFO_AT", &handleMkfifoAt);
+	table.add(managarm::posix::LinkAtRequest::message_id, "LINK_AT", &handleLinkAt);
+	table.add(managarm::posix::SymlinkAtRequest::message_id, "SYMLINK_AT", &handleSymlinkAt);
+	table.add(managarm::posix::RenameAtRequest::message_id, "RENAME_AT", &handleRenameAt);
+	table.add(managarm::posix::FstatAtRequest::message_id, "FSTAT_AT", &handleFstatAt);
+	table.add(managarm::posix::FchmodAtRequest::message_id, "FCHMOD_AT", &handleFchmodAt);
+	table.add(managarm::posix::UtimensAtRequest::message_id, "UTIMENS_AT", &handleUtimensAt);
+	table.add(managarm::posix::OpenAtRequest::message_id, "OPEN_AT", &handleOpenAt);
+	table.add(managarm::posix::CloseRequest::message_id, "CLOSE", &handleClose);
+	table.add(managarm::posix::IsTtyRequest::message_id, "IS_TTY", &handleIsTty);
+	table.add(managarm::posix::UnlinkAtRequest::message_id, "UNLINK_AT", &handleUnlinkAt);
+	table.add(managarm::posix::RmdirRequest::message_id, "RMDIR", &handleRmdir);
+	table.add(managarm::posix::IoctlFioclexRequest::message_id, "IOCTL_FIOCLEX", &handleIoctlFioclex);
+	table.add(managarm::posix::SocketRequest::message_id, "SOCKET", &handleSocket);
+	table.add(managarm::posix::SockpairRequest::message_id, "SOCKPAIR", &handleSockpair);
+	table.add(managarm::posix::AcceptRequest::message_id, "ACCEPT", &handleAccept);
+	table.add(managarm::posix::InotifyCreateRequest::message_id, "INOTIFY_CREATE", &handleInotifyCreate);
+	table.add(managarm::posix::InotifyAddRequest::message_id, "INOTIFY_ADD", &handleInotifyAdd);
+	table.add(managarm::posix::EventfdCreateRequest::message_id, "EVENTFD_CREATE", &handleEventfdCreate);
+	table.add(managarm::posix::MknodAtRequest::message_id, "MKNOD_AT", &handleMknodAt);
+	table.add(managarm::posix::GetPgidRequest::message_id, "GET_PGID", &handleGetPgid);
+	table.add(managarm::posix::SetPgidRequest::message_id, "SET_PGID", &handleSetPgid);
+	table.add(managarm::posix::GetSidRequest::message_id, "GET_SID", &handleGetSid);
+	table.add(managarm::posix::MemFdCreateRequest::message_id, "MEM_FD_CREATE", &handleMemFdCreate);
+	table.add(managarm::posix::SetAffinityRequest::message_id, "SET_AFFINITY", &handleSetAffinity);
+	table.add(managarm::posix::GetAffinityRequest::message_id, "GET_AFFINITY", &handleGetAffinity);
+	return table;
+}();
+
+constexpr auto cntRequestTable = [] {
+	RequestTable<CntRequestHandler, 128> table;
+	table.add(managarm::posix::CntReqType::WAIT, "WAIT", &handleWait);
+	table.add(managarm::posix::CntReqType::GET_RESOURCE_USAGE, "GET_RESOURCE_USAGE", &handleGetResourceUsage);
+	table.add(managarm::posix::CntReqType::VM_REMAP, "VM_REMAP", &handleVmRemap);
+	table.add(managarm::posix::CntReqType::VM_PROTECT, "VM_PROTECT", &handleVmProtect);
+	table.add(managarm::posix::CntReqType::VM_UNMAP, "VM_UNMAP", &handleVmUnmap);
+	table.add(managarm::posix::CntReqType::CHROOT, "CHROOT", &handleChroot);
+	table.add(managarm::posix::CntReqType::CHDIR, "CHDIR", &handleChdir);
+	table.add(managarm::posix::CntReqType::FCHDIR, "FCHDIR", &handleFchdir);
+	table.add(managarm::posix::CntReqType::READLINK, "READLINK", &handleReadlink);
+	table.add(managarm::posix::CntReqType::DUP, "DUP", &handleDup);
+	table.add(managarm::posix::CntReqType::DUP2, "DUP2", &handleDup2);
+	table.add(managarm::posix::CntReqType::TTY_NAME, "TTY_NAME", &handleTtyName);
+	table.add(managarm::posix::CntReqType::GETCWD, "GETCWD", &handleGetcwd);
+	table.add(managarm::posix::CntReqType::FD_GET_FLAGS, "FD_GET_FLAGS", &handleFdGetFlags);
+	table.add(managarm::posix::CntReqType::FD_SET_FLAGS, "FD_SET_FLAGS", &handleFdSetFlags);
+	table.add(managarm::posix::CntReqType::SIG_ACTION, "SIG_ACTION", &handleSigAction);
+	table.add(managarm::posix::CntReqType::PIPE_CREATE, "PIPE_CREATE", &handlePipeCreate);
+	table.add(managarm::posix::CntReqType::SETSID, "SETSID", &handleSetsid);
+	table.add(managarm::posix::CntReqType::EPOLL_CALL, "EPOLL_CALL", &handleEpollCall);
+	table.add(managarm::posix::CntReqType::EPOLL_CREATE, "EPOLL_CREATE", &handleEpollCreate);
+	table.add(managarm::posix::CntReqType::EPOLL_ADD, "EPOLL_ADD", &handleEpollAdd);
+	table.add(managarm::posix::CntReqType::EPOLL_MODIFY, "EPOLL_MODIFY", &handleEpollModify);
+	table.add(managarm::posix::CntReqType::EPOLL_DELETE, "EPOLL_DELETE", &handleEpollDelete);
+	table.add(managarm::posix::CntReqType::EPOLL_WAIT, "EPOLL_WAIT", &handleEpollWait);
+	table.add(managarm::posix::CntReqType::TIMERFD_CREATE, "TIMERFD_CREATE", &handleTimerfdCreate);
+	table.add(managarm::posix::CntReqType::TIMERFD_SETTIME, "TIMERFD_SETTIME", &handleTimerfdSettime);
+	table.add(managarm::posix::CntReqType::SIGNALFD_CREATE, "SIGNALFD_CREATE", &handleSignalfdCreate);
+	return table;
+}();
+
+// Bucket i of the latency histogram counts requests that took less than
+// 2^(firstLatencyShift + i) ns. The last bucket counts all slower requests.
+constexpr int firstLatencyShift = 10;
+constexpr int numLatencyBuckets = 24;
+
+// Like all other subsystem state, the statistics are only touched from the global dispatcher thread.
+struct RequestStats {
+	void record(uint64_t ns) {
+		count++;
+		totalNs += ns;
+		maxNs = std::max(maxNs, ns);
+		auto bucket = static_cast<int>(std::bit_width(ns >> firstLatencyShift));
+		histogram[std::min(bucket, numLatencyBuckets - 1)]++;
+	}
+
+	uint64_t count = 0;
+	uint64_t totalNs = 0;
+	uint64_t maxNs = 0;
+	std::array<uint64_t, numLatencyBuckets> histogram{};
+};
+
+std::array<RequestStats, 64> requestStats;
+std::array<RequestStats, 128> cntRequestStats;
+RequestStats illegalRequestStats;
+
+} // anonymous namespace
+
+std::string formatRequestStats() {
+	std::stringstream stream;
+	stream << "request count total_ns max_ns";
+	for(int i = 0; i < numLatencyBuckets - 1; i++)
+		stream << " <" << (uint64_t{1} << (firstLatencyShift + i));
+	stream << " >=" << (uint64_t{1} << (firstLatencyShift + numLatencyBuckets - 2)) << "\n";
+
+	auto show = [&] (const char *name, const RequestStats &stats) {
+		stream << name << " " << stats.count << " " << stats.totalNs << " " << stats.maxNs;
+		for(auto n : stats.histogram)
+			stream << " " << n;
+		stream << "\n";
+	};
+
+	for(size_t i = 0; i < requestStats.size(); i++) {
+		if(auto entry = requestTable.find(i); entry)
+			show(entry->name, requestStats[i]);
+	}
+	for(size_t i = 0; i < cntRequestStats.size(); i++) {
+		if(auto entry = cntRequestTable.find(i); entry)
+			show(entry->name, cntRequestStats[i]);
+	}
+	show("ILLEGAL", illegalRequestStats);
+	return stream.str();
+}
+
+async::result<void> serveRequests(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation) {
+	async::cancellation_token cancellation = generation->cancelServe;
+
+	async::cancellation_callback cancel_callback{cancellation, [&] {
+		HEL_CHECK(helShutdownLane(self->posixLane().getHandle()));
+	}};
+
+	while(true) {
+		auto [accept, recv_head] = co_await helix_ng::exchangeMsgs(
+				self->posixLane(),
+				helix_ng::accept(
+					helix_ng::recvInline()
+				)
 			);
-			HEL_CHECK(sendResp.error());
-		}else{
-			std::cout << "posix: Illegal request" << std::endl;
-			helix::SendBuffer send_resp;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::ILLEGAL_REQUEST);
+		if(accept.error() == kHelErrLaneShutdown)
+			break;
+		HEL_CHECK(accept.error());
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
+		if(recv_head.error() == kHelErrBufferTooSmall) {
+			std::cout << "posix: Rejecting request due to RecvInline overflow" << std::endl;
+			continue;
+		}
+		HEL_CHECK(recv_head.error());
+
+		auto preamble = bragi::read_preamble(recv_head);
+		assert(!preamble.error());
+		recv_head.reset();
+
+		RequestContext ctx{
+			.self = self,
+			.conversation = accept.descriptor(),
+			.recvHead = recv_head,
+			.preamble = preamble
+		};
+
+		uint64_t startTime;
+		HEL_CHECK(helGetClock(&startTime));
+
+		RequestStats *stats;
+		bool keepServing;
+		if(preamble.id() == managarm::posix::CntRequest::message_id) {
+			auto req = bragi::parse_head_only<managarm::posix::CntRequest>(recv_head);
+			if (!req) {
+				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				break;
+			}
+
+			if(auto entry = cntRequestTable.find(req->request_type()); entry) {
+				stats = &cntRequestStats[req->request_type()];
+				keepServing = co_await entry->handler(ctx, *req);
+			}else{
+				stats = &illegalRequestStats;
+				keepServing = co_await handleIllegalRequest(ctx);
+			}
+		}else{
+			if(auto entry = requestTable.find(preamble.id()); entry) {
+				stats = &requestStats[preamble.id()];
+				keepServing = co_await entry->handler(ctx);
+			}else{
+				stats = &illegalRequestStats;
+				keepServing = co_await handleIllegalRequest(ctx);
+			}
 		}
+
+		uint64_t endTime;
+		HEL_CHECK(helGetClock(&endTime));
+		stats->record(endTime - startTime);
+
+		if(!keepServing)
+			break;
 	}
 
 	if(logCleanup)
@@ -4,3 +4,6 @@
 
 async::result<void> serveRequests(std::shared_ptr<Process> self,
 		std::shared_ptr<Generation> generation);
+
+// Returns per-request counters and latency histograms, as shown in /proc/posix-requests.
+std::string formatRequestStats();
@@ -1,3 +1,4 @@
+#include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <set>
@@ -245,6 +246,8 @@ public:
 	void handleClose() override;
 
 	FutureMaybe<ReadEntriesResult> readEntries() override;
+	async::result<frg::expected<Error, size_t>>
+	readEntriesBatch(void *buffer, size_t max_length) override;
 	helix::BorrowedDescriptor getPassthroughLane() override;
 
 private:
@@ -676,6 +679,43 @@ DirectoryFile::readEntries() {
 	}
 }
 
+async::result<frg::expected<Error, size_t>>
+DirectoryFile::readEntriesBatch(void *buffer, size_t max_length) {
+	protocols::fs::DirentWriter writer{buffer, max_length};
+	while(_iter != _node->_entries.end()) {
+		auto target = (*_iter)->getTarget();
+		uint64_t inode;
+		if(auto node = std::dynamic_pointer_cast<Node>(target); node) {
+			inode = node->inodeNumber();
+		}else{
+			auto stats = co_await target->getStats();
+			assert(stats);
+			inode = stats.value().inodeNumber;
+		}
+
+		uint8_t type;
+		switch(target->getType()) {
+		case VfsType::directory: type = DT_DIR; break;
+		case VfsType::regular: type = DT_REG; break;
+		case VfsType::symlink: type = DT_LNK; break;
+		case VfsType::charDevice: type = DT_CHR; break;
+		case VfsType::blockDevice: type = DT_BLK; break;
+		case VfsType::socket: type = DT_SOCK; break;
+		case VfsType::fifo: type = DT_FIFO; break;
+		default: type = DT_UNKNOWN;
+		}
+
+		// Leave the entry for the next request if it does not fit.
+		if(!writer.append(inode, type, (*_iter)->getName()))
+			break;
+		_iter++;
+	}
+
+	if(!writer.size() && _iter != _node->_entries.end())
+		co_return Error::illegalArguments;
+	co_return writer.size();
+}
+
 helix::BorrowedDescriptor DirectoryFile::getPassthroughLane() {
 	return _passthrough;
 }
@@ -3,13 +3,16 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <optional>
 #include <unordered_map>
+#include <utility>
 
 #include <async/result.hpp>
 #include <async/cancellation.hpp>
 #include <boost/variant.hpp>
 #include <frg/expected.hpp>
 #include <helix/ipc.hpp>
+#include <helix/memory.hpp>
 #include <protocols/fs/common.hpp>
 
 // EVENTUALLY: use std::variant instead of boost::variant!
@@ -39,12 +42,39 @@ struct File {
 
 	async::result<helix::UniqueDescriptor> accessMemory();
 
+	// Returns the page cache and the page that contains its CacheHeader.
+	async::result<frg::expected<Error, std::pair<helix::UniqueDescriptor, helix::UniqueDescriptor>>>
+	accessCache();
+
 private:
 	helix::UniqueDescriptor _lane;
 };
 
+// Reads directly from the page cache that PT_ACCESS_CACHE hands out.
+// Pages that are not resident are fetched by the kernel on access.
+struct CachedReader {
+	CachedReader(helix::UniqueDescriptor memory, helix::UniqueDescriptor header);
+
+	// Returns std::nullopt if the file size changed concurrently;
+	// callers should retry or fall back to IPC in this case.
+	std::optional<size_t> pread(uint64_t offset, void *buffer, size_t length);
+
+private:
+	std::optional<size_t> _readLocked(uint64_t offset, void *buffer, size_t length);
+
+	CacheHeader *_header() {
+		return reinterpret_cast<CacheHeader *>(_headerMapping.get());
+	}
+
+	helix::UniqueDescriptor _memory;
+	helix::UniqueDescriptor _headerMemory;
+	helix::Mapping _headerMapping;
+	helix::Mapping _mapping;
+};
+
 } // namespace _detail
 
 using _detail::File;
+using _detail::CachedReader;
 
 } } // namespace protocols::fs
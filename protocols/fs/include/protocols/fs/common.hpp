@@ -1,8 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <optional>
 #include <string.h>
 #include <string>
+#include <string_view>
 #include <sys/socket.h>
 #include <variant>
 #include <vector>
@@ -71,6 +73,69 @@ using ReadResult = std::variant<Error, size_t>;
 
 using ReadEntriesResult = std::optional<std::string>;
 
+// Record format of PT_READ_ENTRIES_BATCH. The name follows the header (without a NUL terminator)
+// and each record is padded to a multiple of 8 bytes.
+struct PackedDirent {
+	uint64_t inode;
+	uint16_t recordLength;
+	uint16_t nameLength;
+	uint8_t type; // One of the DT_* constants.
+	uint8_t reserved[3];
+};
+
+static_assert(sizeof(PackedDirent) == 16);
+
+struct DirentWriter {
+	DirentWriter(void *buffer, size_t max_size)
+	: _buffer{static_cast<char *>(buffer)}, _maxSize{max_size}, _offset{0} { }
+
+	// Returns false if the entry does not fit into the remaining buffer.
+	bool append(uint64_t inode, uint8_t type, std::string_view name) {
+		size_t length = (sizeof(PackedDirent) + name.size() + 7) & ~size_t(7);
+		if(_offset + length > _maxSize)
+			return false;
+
+		PackedDirent h;
+		memset(&h, 0, sizeof(PackedDirent));
+		h.inode = inode;
+		h.recordLength = length;
+		h.nameLength = name.size();
+		h.type = type;
+
+		memcpy(_buffer + _offset, &h, sizeof(PackedDirent));
+		memcpy(_buffer + _offset + sizeof(PackedDirent), name.data(), name.size());
+		memset(_buffer + _offset + sizeof(PackedDirent) + name.size(), 0,
+				length - sizeof(PackedDirent) - name.size());
+		_offset += length;
+		return true;
+	}
+
+	size_t size() {
+		return _offset;
+	}
+
+private:
+	char *_buffer;
+	size_t _maxSize;
+	size_t _offset;
+};
+
+// Header of the shared page that PT_ACCESS_CACHE returns along with the page cache.
+// The server increments seq before and after it changes the file size, i.e., seq is odd
+// while an update is in progress. Readers copy data out of the page cache and retry
+// (or fall back to IPC) if seq changed in the meantime.
+// Readers increment readers before they load seq and decrement it once they are done;
+// before the server shrinks the page cache, it waits until no reader is active.
+// The kernel does not support read-only views of memory objects, hence clients can map
+// the header writable. Servers must therefore hand out a separate header to each open
+// file and only use its readers field to delay truncation by a bounded amount of time.
+// A header is only kept up to date while the file is open.
+struct CacheHeader {
+	std::atomic<uint64_t> seq;
+	std::atomic<uint64_t> fileSize;
+	std::atomic<uint32_t> readers;
+};
+
 using PollResult = std::tuple<uint64_t, int, int>;
 using PollWaitResult = std::tuple<uint64_t, int>;
 using PollStatusResult = std::tuple<uint64_t, int>;
@@ -30,6 +30,13 @@ enum class FileType {
 	symlink
 };
 
+struct CacheAccess {
+	// Page cache of the file.
+	helix::BorrowedDescriptor memory;
+	// Page that contains a CacheHeader. Must not be shared among open files.
+	helix::BorrowedDescriptor header;
+};
+
 struct FileStats {
 	int linkCount;
 	uint64_t fileSize;
@@ -86,10 +93,20 @@ struct FileOperations {
 		readEntries = f;
 		return *this;
 	}
+	constexpr FileOperations &withReadEntriesBatch(async::result<ReadResult> (*f)(void *object,
+			void *buffer, size_t length)) {
+		readEntriesBatch = f;
+		return *this;
+	}
 	constexpr FileOperations &withAccessMemory(async::result<helix::BorrowedDescriptor>(*f)(void *object)) {
 		accessMemory = f;
 		return *this;
 	}
+	constexpr FileOperations &withAccessCache(async::result<frg::expected<Error, CacheAccess>>
+			(*f)(void *object)) {
+		accessCache = f;
+		return *this;
+	}
 	constexpr FileOperations &withTruncate(async::result<frg::expected<protocols::fs::Error>> (*f)(void *object,
 			size_t size)) {
 		truncate = f;
@@ -158,7 +175,11 @@ struct FileOperations {
 	async::result<frg::expected<protocols::fs::Error, size_t>> (*pwrite)(void *object, int64_t offset, const char *credentials,
 			const void *buffer, size_t length);
 	async::result<ReadEntriesResult> (*readEntries)(void *object);
+	// Fills the buffer with PackedDirent records. Returns zero at the end of the directory
+	// and Error::illegalArguments if the next entry does not fit into the buffer.
+	async::result<ReadResult> (*readEntriesBatch)(void *object, void *buffer, size_t length);
 	async::result<helix::BorrowedDescriptor>(*accessMemory)(void *object);
+	async::result<frg::expected<Error, CacheAccess>> (*accessCache)(void *object);
 	async::result<frg::expected<protocols::fs::Error>> (*truncate)(void *object, size_t size);
 	async::result<frg::expected<protocols::fs::Error>> (*fallocate)(void *object, int64_t offset, size_t size);
 	async::result<void> (*ioctl)(void *object, uint32_t id, helix_ng::RecvInlineResult req,
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <iostream>
 
 #include "fs.bragi.hpp"
@@ -201,5 +202,87 @@ async::result<helix::UniqueDescriptor> File::accessMemory() {
 	co_return recv_memory.descriptor();
 }
 
+async::result<frg::expected<Error, std::pair<helix::UniqueDescriptor, helix::UniqueDescriptor>>>
+File::accessCache() {
+	managarm::fs::CntRequest req;
+	req.set_req_type(managarm::fs::CntReqType::PT_ACCESS_CACHE);
+
+	auto ser = req.SerializeAsString();
+	uint8_t buffer[128];
+
+	auto [offer, send_req, recv_resp] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::want_lane,
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::recvBuffer(buffer, 128)
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(recv_resp.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(buffer, recv_resp.actualLength());
+	if(resp.error() == managarm::fs::Errors::ILLEGAL_OPERATION_TARGET)
+		co_return Error::illegalOperationTarget;
+	assert(resp.error() == managarm::fs::Errors::SUCCESS);
+
+	// The server pushes the descriptors after the response.
+	auto [pull_memory, pull_header] =
+		co_await helix_ng::exchangeMsgs(
+			offer.descriptor(),
+			helix_ng::pullDescriptor(),
+			helix_ng::pullDescriptor()
+		);
+	HEL_CHECK(pull_memory.error());
+	HEL_CHECK(pull_header.error());
+
+	co_return std::make_pair(pull_memory.descriptor(), pull_header.descriptor());
+}
+
+CachedReader::CachedReader(helix::UniqueDescriptor memory, helix::UniqueDescriptor header)
+: _memory{std::move(memory)}, _headerMemory{std::move(header)},
+		_headerMapping{_headerMemory, 0, 0x1000, kHelMapProtRead} { }
+
+std::optional<size_t> CachedReader::pread(uint64_t offset, void *buffer, size_t length) {
+	// Pairs with the fence in the server's truncation path: either the server sees us
+	// as a reader and delays the shrink, or we see the reduced file size.
+	_header()->readers.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	auto result = _readLocked(offset, buffer, length);
+
+	_header()->readers.fetch_sub(1, std::memory_order_release);
+	return result;
+}
+
+std::optional<size_t> CachedReader::_readLocked(uint64_t offset, void *buffer, size_t length) {
+	auto seq = _header()->seq.load(std::memory_order_acquire);
+	if(seq & 1)
+		return std::nullopt;
+	auto size = _header()->fileSize.load(std::memory_order_relaxed);
+
+	size_t chunk = 0;
+	if(offset < size) {
+		chunk = std::min(length, static_cast<size_t>(size - offset));
+
+		// Grow the mapping along with the file.
+		auto mapSize = (size + 0xFFF) & ~uint64_t(0xFFF);
+		if(_mapping.size() < mapSize)
+			_mapping = helix::Mapping{_memory, 0, mapSize,
+					kHelMapProtRead | kHelMapDontRequireBacking};
+
+		memcpy(buffer, reinterpret_cast<char *>(_mapping.get()) + offset, chunk);
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if(_header()->seq.load(std::memory_order_relaxed) != seq)
+		return std::nullopt;
+	return chunk;
+}
+
 } } // namespace protocol::fs
 
@@ -413,6 +413,56 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 			conversation,
 			helix_ng::sendBuffer(ser.data(), ser.size()));
 		HEL_CHECK(send_resp.error());
+	}else if(req.req_type() == managarm::fs::CntReqType::PT_READ_ENTRIES_BATCH) {
+		if(!file_ops->readEntriesBatch) {
+			managarm::fs::SvrResponse resp;
+			resp.set_error(managarm::fs::Errors::ILLEGAL_OPERATION_TARGET);
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+			co_return;
+		}
+
+		std::string data;
+		data.resize(req.size());
+		auto res = co_await file_ops->readEntriesBatch(file.get(), data.data(), req.size());
+
+		managarm::fs::SvrResponse resp;
+		auto error = std::get_if<Error>(&res);
+		if(error) {
+			resp.set_error(mapFsError(*error));
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+		}else if(!std::get<size_t>(res)) {
+			resp.set_error(managarm::fs::Errors::END_OF_FILE);
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+		}else{
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp, send_data] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::sendBuffer(data.data(), std::get<size_t>(res))
+			);
+			HEL_CHECK(send_resp.error());
+			HEL_CHECK(send_data.error());
+		}
 	}else if(req.req_type() == managarm::fs::CntReqType::MMAP) {
 		if(!file_ops->accessMemory) {
 			managarm::fs::SvrResponse resp;
@@ -440,6 +490,47 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 		);
 		HEL_CHECK(send_resp.error());
 		HEL_CHECK(push_memory.error());
+	}else if(req.req_type() == managarm::fs::CntReqType::PT_ACCESS_CACHE) {
+		if(!file_ops->accessCache) {
+			managarm::fs::SvrResponse resp;
+			resp.set_error(managarm::fs::Errors::ILLEGAL_OPERATION_TARGET);
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+			co_return;
+		}
+
+		auto result = co_await file_ops->accessCache(file.get());
+		if(!result) {
+			managarm::fs::SvrResponse resp;
+			resp.set_error(mapFsError(result.error()));
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+			co_return;
+		}
+
+		managarm::fs::SvrResponse resp;
+		resp.set_error(managarm::fs::Errors::SUCCESS);
+
+		auto ser = resp.SerializeAsString();
+		auto [send_resp, push_memory, push_header] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()),
+			helix_ng::pushDescriptor(result.value().memory),
+			helix_ng::pushDescriptor(result.value().header)
+		);
+		HEL_CHECK(send_resp.error());
+		HEL_CHECK(push_memory.error());
+		HEL_CHECK(push_header.error());
 	}else if(req.req_type() == managarm::fs::CntReqType::PT_TRUNCATE) {
 		if(!file_ops->truncate) {
 			managarm::fs::SvrResponse resp;
@@ -4,6 +4,7 @@
 
 #include <async/result.hpp>
 #include <helix/ipc.hpp>
+#include <helix/memory.hpp>
 #include <ostrace.bragi.hpp>
 
 namespace protocols::ostrace {
@@ -11,7 +12,11 @@ namespace protocols::ostrace {
 enum class EventId : uint64_t { };
 enum class ItemId : uint64_t { };
 
+struct Event;
+
 struct Context {
+	friend struct Event;
+
 	Context();
 	Context(helix::UniqueLane lane, bool enabled);
 
@@ -27,9 +32,21 @@ struct Context {
 	async::result<EventId> announceEvent(std::string_view name);
 	async::result<ItemId> announceItem(std::string_view name);
 
+	// Asks the kernel for a ring that events are written to directly.
+	// Without a ring, each event is sent to the kernel individually.
+	async::result<void> openRing();
+
 private:
+	// Returns false if there is no ring. Records are dropped if the ring is full.
+	bool writeToRing_(managarm::ostrace::EventRecord &record);
+
 	helix::UniqueLane lane_;
 	bool enabled_;
+
+	// The kernel stops draining the ring once this lane is closed.
+	helix::UniqueLane ringLane_;
+	helix::Mapping ringMapping_;
+	size_t ringSize_ = 0;
 };
 
 struct Event {
@@ -42,7 +59,7 @@ struct Event {
 private:
 	Context *ctx_;
 	bool live_; // Whether we emit an event at all.
-	managarm::ostrace::EmitEventReq req_;
+	managarm::ostrace::EventRecord rec_;
 };
 
 async::result<Context> createContext();
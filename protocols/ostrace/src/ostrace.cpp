@@ -1,4 +1,7 @@
+#include <atomic>
+
 #include <async/oneshot-event.hpp>
+#include <bragi/helpers-all.hpp>
 #include <bragi/helpers-std.hpp>
 #include <frg/std_compat.hpp>
 #include <protocols/mbus/client.hpp>
@@ -7,6 +10,30 @@
 
 namespace protocols::ostrace {
 
+namespace {
+
+constexpr size_t pageSize = 0x1000;
+
+// Layout of the ring that the kernel shares with us.
+// This must match the definition in thor's ostrace.cpp.
+struct RingHeader {
+	alignas(64) std::atomic<uint64_t> head; // Advanced by producers.
+	alignas(64) std::atomic<uint64_t> tail; // Advanced by the kernel.
+	alignas(64) std::atomic<uint64_t> dropped;
+	uint64_t size;
+};
+
+// Records are aligned to 16 bytes. A record is committed once position is set.
+struct RecordHeader {
+	std::atomic<uint64_t> position;
+	uint32_t extent; // Size of the record including this header.
+	uint32_t length; // Size of the EventRecord. Zero for padding.
+};
+
+static_assert(sizeof(RecordHeader) == 16);
+
+} // anonymous namespace
+
 Context::Context()
 : enabled_{false} { }
 
@@ -65,10 +92,109 @@ async::result<ItemId> Context::announceItem(std::string_view name) {
 	co_return ItemId{resp.id()};
 }
 
+async::result<void> Context::openRing() {
+	if(!enabled_ || ringMapping_)
+		co_return;
+
+	managarm::ostrace::OpenRingReq req;
+
+	auto [offer, sendReq, recvResp, pullMemory] =
+		co_await helix_ng::exchangeMsgs(
+			lane_,
+			helix_ng::offer(
+				helix_ng::want_lane,
+				helix_ng::sendBragiHeadOnly(req, frg::stl_allocator{}),
+				helix_ng::recvInline(),
+				helix_ng::pullDescriptor()
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(sendReq.error());
+	HEL_CHECK(recvResp.error());
+
+	auto maybeResp = bragi::parse_head_only<managarm::ostrace::Response>(recvResp);
+	recvResp.reset();
+	assert(maybeResp);
+	auto &resp = maybeResp.value();
+	if(resp.error() == managarm::ostrace::Error::OSTRACE_GLOBALLY_DISABLED)
+		co_return;
+	assert(resp.error() == managarm::ostrace::Error::SUCCESS);
+	HEL_CHECK(pullMemory.error());
+
+	auto memory = pullMemory.descriptor();
+	size_t size;
+	{
+		helix::Mapping headerMapping{memory, 0, pageSize, kHelMapProtRead};
+		size = reinterpret_cast<RingHeader *>(headerMapping.get())->size;
+	}
+	assert(size && !(size & (size - 1)));
+
+	ringLane_ = helix::UniqueLane{offer.descriptor()};
+	ringMapping_ = helix::Mapping{memory, 0, pageSize + size};
+	ringSize_ = size;
+}
+
+bool Context::writeToRing_(managarm::ostrace::EventRecord &record) {
+	if(!ringMapping_)
+		return false;
+
+	auto base = reinterpret_cast<std::byte *>(ringMapping_.get());
+	auto ringHeader = reinterpret_cast<RingHeader *>(base);
+	auto ring = base + pageSize;
+
+	auto tailSize = record.size_of_tail();
+	auto length = 8 + tailSize;
+	auto extent = (sizeof(RecordHeader) + length + 15) & ~size_t(15);
+	if(extent > ringSize_) {
+		ringHeader->dropped.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Reserve space for the record. If the record does not fit into the remainder of
+	// the ring, we also reserve the remainder and fill it with padding.
+	auto position = ringHeader->head.load(std::memory_order_relaxed);
+	size_t padding;
+	do {
+		auto offset = position & (ringSize_ - 1);
+		padding = (offset + extent > ringSize_) ? ringSize_ - offset : 0;
+
+		// Pairs with the release store of the kernel once it is done with the records.
+		auto tail = ringHeader->tail.load(std::memory_order_acquire);
+		if(position + padding + extent - tail > ringSize_) {
+			// Tracing must not block, hence we drop the record if the kernel falls behind.
+			ringHeader->dropped.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	} while(!ringHeader->head.compare_exchange_weak(position, position + padding + extent,
+			std::memory_order_relaxed));
+
+	if(padding) {
+		auto paddingHeader = reinterpret_cast<RecordHeader *>(
+				ring + (position & (ringSize_ - 1)));
+		paddingHeader->extent = padding;
+		paddingHeader->length = 0;
+		paddingHeader->position.store(position, std::memory_order_release);
+		position += padding;
+	}
+
+	auto recordHeader = reinterpret_cast<RecordHeader *>(ring + (position & (ringSize_ - 1)));
+	auto data = reinterpret_cast<char *>(recordHeader + 1);
+	bool encodeSuccess = bragi::write_head_tail(record,
+			frg::span<char>(data, 8),
+			frg::span<char>(data + 8, tailSize));
+	assert(encodeSuccess);
+
+	recordHeader->extent = extent;
+	recordHeader->length = length;
+	recordHeader->position.store(position, std::memory_order_release);
+	return true;
+}
+
 Event::Event(Context *ctx, EventId id)
 : ctx_{ctx} {
 	live_ = ctx->isActive();
-	req_.set_id(static_cast<uint64_t>(id));
+	rec_.set_id(static_cast<uint64_t>(id));
 }
 
 void Event::withCounter(ItemId id, int64_t value) {
@@ -78,18 +204,29 @@ void Event::withCounter(ItemId id, int64_t value) {
 	managarm::ostrace::CounterItem item;
 	item.set_id(static_cast<uint64_t>(id));
 	item.set_value(value);
-	req_.add_ctrs(std::move(item));
+	rec_.add_ctrs(std::move(item));
 }
 
 async::result<void> Event::emit() {
 	if(!live_)
 		co_return;
 
+	uint64_t ts;
+	HEL_CHECK(helGetClock(&ts));
+	rec_.set_ts(ts);
+	if(ctx_->writeToRing_(rec_))
+		co_return;
+
+	managarm::ostrace::EmitEventReq req;
+	req.set_id(rec_.id());
+	for(size_t i = 0; i < rec_.ctrs_size(); ++i)
+		req.add_ctrs(rec_.ctrs(i));
+
 	auto [offer, sendReq, recvResp] =
 		co_await helix_ng::exchangeMsgs(
 			ctx_->getLane(),
 			helix_ng::offer(
-				helix_ng::sendBragiHeadOnly(req_, frg::stl_allocator{}),
+				helix_ng::sendBragiHeadOnly(req, frg::stl_allocator{}),
 				helix_ng::recvInline()
 			)
 		);
@@ -131,7 +268,7 @@ async::result<Context> createContext() {
 
 	// Perform the negotiation request.
 
-	managarm::ostrace::AnnounceItemReq req;
+	managarm::ostrace::NegotiateReq req;
 
 	auto [offer, sendReq, recvResp] =
 		co_await helix_ng::exchangeMsgs(
@@ -155,7 +292,9 @@ async::result<Context> createContext() {
 		co_return Context{std::move(lane), false};
 
 	assert(resp.error() == managarm::ostrace::Error::SUCCESS);
-	co_return Context{std::move(lane), true};
+	Context ctx{std::move(lane), true};
+	co_await ctx.openRing();
+	co_return std::move(ctx);
 }
 
 } // namespace protocols::ostrace
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <hel.h>
+#include <stdint.h>
 
 namespace posix {
 
@@ -10,6 +11,22 @@ struct ManagarmProcessData {
 	void *threadPage;
 	HelHandle *fileTable;
 	void *clockTrackerPage;
+	void *identityPage;
+};
+
+// Read-only page that allows clients to query their own IDs without IPC.
+// Written by the POSIX subsystem; readers have to retry while the seqlock is odd
+// or if it changed during the read.
+struct IdentityPage {
+	uint64_t seqlock;
+	int32_t pid;
+	int32_t ppid;
+	int32_t uid;
+	int32_t euid;
+	int32_t gid;
+	int32_t egid;
+	int32_t pgid;
+	int32_t sid;
 };
 
 struct ManagarmServerData {
@@ -41,8 +41,37 @@ enum EtherType : uint16_t {
 	ETHER_TYPE_ARP = 0x0806,
 };
 
-// TODO(arsen): Expose interface for csum offloading, constructing frames, and
-// other features of NICs
+enum Offload : uint32_t {
+	//! The NIC can insert L4 checksums into outgoing frames
+	OFFLOAD_TX_CHECKSUM = 1 << 0,
+	//! The NIC validates L4 checksums of incoming frames
+	OFFLOAD_RX_CHECKSUM = 1 << 1,
+	//! The NIC can segment outgoing TCP/IPv4 frames (implies OFFLOAD_TX_CHECKSUM)
+	OFFLOAD_TSO4 = 1 << 2,
+};
+
+//! Describes the work that the NIC should perform on an outgoing frame.
+//! All offsets are relative to the start of the ethernet frame.
+struct TxOffload {
+	//! The L4 checksum needs to be computed starting at checksumStart
+	//! and stored at checksumStart + checksumOffset. The checksum field
+	//! must already contain the (non-complemented) pseudo-header sum.
+	bool needsChecksum = false;
+	uint16_t checksumStart = 0;
+	uint16_t checksumOffset = 0;
+
+	//! If non-zero, the payload following headerLength bytes of headers is
+	//! split into TCP segments of at most segmentSize bytes.
+	uint16_t segmentSize = 0;
+	uint16_t headerLength = 0;
+};
+
+struct RxInfo {
+	//! The NIC has verified the L4 checksum of this frame.
+	bool checksumValid = false;
+};
+
+// TODO(arsen): Expose interface for constructing frames and other features of NICs
 struct Link {
 	struct AllocatedBuffer {
 		arch::dma_buffer frame;
@@ -52,9 +81,13 @@ struct Link {
 	Link(unsigned int mtu, arch::dma_pool *dmaPool);
 	virtual ~Link() = default;
 	//! Receives an entire frame from the network
-	virtual async::result<void> receive(arch::dma_buffer_view) = 0;
+	virtual async::result<RxInfo> receive(arch::dma_buffer_view) = 0;
 	//! Sends an entire ethernet frame
 	virtual async::result<void> send(const arch::dma_buffer_view) = 0;
+	//! Sends an entire ethernet frame, performing the requested offloads.
+	//! The default implementation computes the checksum in software.
+	virtual async::result<void> send(const arch::dma_buffer_view, TxOffload offload);
+	uint32_t offloads();
 	arch::dma_pool *dmaPool();
 	AllocatedBuffer allocateFrame(MacAddress to, EtherType type,
 		size_t payloadSize);
@@ -71,6 +104,7 @@ protected:
 	arch::dma_pool *dmaPool_;
 	MacAddress mac_;
 	int index_;
+	uint32_t offloads_ = 0;
 };
 
 async::detached runDevice(std::shared_ptr<Link> dev);
@@ -1,6 +1,7 @@
 #include "checksum.hpp"
 
 #include <arch/bit.hpp>
+#include <cstring>
 
 void Checksum::update(uint16_t word)  {
 	state_ += word;
@@ -12,20 +13,64 @@ void Checksum::update(uint16_t word)  {
 void Checksum::update(const void *data, size_t size) {
 	using namespace arch;
 	auto iter = static_cast<const unsigned char*>(data);
-	if (size % 2 != 0) {
-		size--;
-		update(iter[size] << 8);
+
+	// The one's complement sum is independent of byte order (RFC 1071), so we can
+	// sum native-endian 64-bit words with end-around carry and swap the result once.
+	uint64_t sum = 0;
+	auto add = [&] (uint64_t word) {
+		sum += word;
+		if (sum < word)
+			sum++;
+	};
+
+	for (; size >= 32; iter += 32, size -= 32) {
+		uint64_t words[4];
+		std::memcpy(words, iter, 32);
+		add(words[0]);
+		add(words[1]);
+		add(words[2]);
+		add(words[3]);
+	}
+	for (; size >= 8; iter += 8, size -= 8) {
+		uint64_t word;
+		std::memcpy(&word, iter, 8);
+		add(word);
+	}
+	if (size >= 4) {
+		uint32_t word;
+		std::memcpy(&word, iter, 4);
+		add(word);
+		iter += 4;
+		size -= 4;
 	}
-	auto end = iter + size;
-	for (; iter < end; iter += 2) {
-		update(iter[0] << 8 | iter[1]);
+	if (size >= 2) {
+		uint16_t word;
+		std::memcpy(&word, iter, 2);
+		add(word);
+		iter += 2;
+		size -= 2;
 	}
+
+	// Fold the 64-bit sum into 16 bits.
+	sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+	sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	update(convert_endian<endian::big, endian::native>(static_cast<uint16_t>(sum)));
+
+	// A trailing odd byte is padded with zero on the right.
+	if (size)
+		update(static_cast<uint16_t>(iter[0] << 8));
 }
 
 void Checksum::update(arch::dma_buffer_view view) {
 	update(view.data(), view.size());
 }
 
+uint16_t Checksum::fold() {
+	return state_;
+}
+
 uint16_t Checksum::finalize() {
 	auto state_ = this->state_;
 	return ~state_;
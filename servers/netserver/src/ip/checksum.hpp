@@ -7,6 +7,9 @@ struct Checksum {
 	void update(uint16_t word);
 	void update(const void *mem, size_t size);
 	void update(arch::dma_buffer_view area);
+	// Returns the sum without complementing it.
+	// This is the partial checksum that NICs expect when offloading checksums.
+	uint16_t fold();
 	uint16_t finalize();
 
 private:
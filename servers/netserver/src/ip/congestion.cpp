@@ -0,0 +1,164 @@
+#include "congestion.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Initial window as specified in RFC 6928.
+uint32_t initialWindow(uint32_t mss) {
+	return std::min(10 * mss, std::max(2 * mss, uint32_t{14600}));
+}
+
+// RFC 5681 with the fast recovery modifications of RFC 6582.
+struct NewReno final : CongestionControl {
+	NewReno(uint32_t mss)
+	: mss_{mss}, cwnd_{initialWindow(mss)} { }
+
+	void onAck(uint32_t ackedBytes, uint64_t, uint64_t) override {
+		if(cwnd_ < ssthresh_) {
+			// Slow start, using appropriate byte counting (RFC 3465) with L = 1 SMSS.
+			cwnd_ += std::min(ackedBytes, mss_);
+			return;
+		}
+
+		// Congestion avoidance: grow by one segment per window of acknowledged data.
+		bytesAcked_ += ackedBytes;
+		if(bytesAcked_ >= cwnd_) {
+			bytesAcked_ -= cwnd_;
+			cwnd_ += mss_;
+		}
+	}
+
+	void onEnterRecovery(uint32_t inFlight) override {
+		ssthresh_ = std::max(inFlight / 2, 2 * mss_);
+		cwnd_ = ssthresh_ + 3 * mss_;
+		bytesAcked_ = 0;
+	}
+
+	void onDupAck() override {
+		cwnd_ += mss_;
+	}
+
+	void onPartialAck(uint32_t ackedBytes) override {
+		// Deflate the window by the amount of new data and add back one segment.
+		cwnd_ -= std::min(ackedBytes, cwnd_);
+		cwnd_ += mss_;
+	}
+
+	void onExitRecovery() override {
+		cwnd_ = ssthresh_;
+	}
+
+	void onTimeout(uint32_t inFlight) override {
+		ssthresh_ = std::max(inFlight / 2, 2 * mss_);
+		cwnd_ = mss_;
+		bytesAcked_ = 0;
+	}
+
+	uint32_t window() override {
+		return cwnd_;
+	}
+
+private:
+	uint32_t mss_;
+	uint32_t cwnd_;
+	uint32_t ssthresh_ = UINT32_MAX;
+	uint32_t bytesAcked_ = 0;
+};
+
+// RFC 9438. The window is tracked in units of segments.
+struct Cubic final : CongestionControl {
+	static constexpr double c = 0.4;
+	static constexpr double beta = 0.7;
+	static constexpr double alpha = 3 * (1 - beta) / (1 + beta);
+
+	Cubic(uint32_t mss)
+	: mss_{mss}, cwnd_{static_cast<double>(initialWindow(mss)) / mss} { }
+
+	void onAck(uint32_t ackedBytes, uint64_t now, uint64_t srtt) override {
+		double acked = static_cast<double>(ackedBytes) / mss_;
+		if(cwnd_ < ssthresh_) {
+			cwnd_ += std::min(acked, 1.0);
+			return;
+		}
+
+		if(!epochStart_) {
+			epochStart_ = now;
+			if(cwnd_ < wMax_) {
+				k_ = std::cbrt((wMax_ - cwnd_) / c);
+			}else{
+				k_ = 0;
+				wMax_ = cwnd_;
+			}
+			wEst_ = cwnd_;
+		}
+
+		// Window that standard TCP would reach, used in the Reno-friendly region.
+		wEst_ += alpha * acked / cwnd_;
+
+		double t = static_cast<double>(now - epochStart_ + srtt) / 1'000'000'000;
+		double target = c * std::pow(t - k_, 3) + wMax_;
+		target = std::clamp(target, cwnd_, 1.5 * cwnd_);
+
+		if(target < wEst_) {
+			cwnd_ = wEst_;
+		}else{
+			cwnd_ += (target - cwnd_) / cwnd_ * acked;
+		}
+	}
+
+	void onEnterRecovery(uint32_t) override {
+		reduce();
+	}
+
+	void onDupAck() override { }
+
+	void onPartialAck(uint32_t) override { }
+
+	void onExitRecovery() override {
+		cwnd_ = ssthresh_;
+	}
+
+	void onTimeout(uint32_t) override {
+		reduce();
+		cwnd_ = 1;
+	}
+
+	uint32_t window() override {
+		return static_cast<uint32_t>(cwnd_ * mss_);
+	}
+
+private:
+	void reduce() {
+		// Fast convergence: release bandwidth if the window keeps shrinking.
+		if(cwnd_ < wMax_)
+			wMax_ = cwnd_ * (1 + beta) / 2;
+		else
+			wMax_ = cwnd_;
+		ssthresh_ = std::max(cwnd_ * beta, 2.0);
+		cwnd_ = ssthresh_;
+		epochStart_ = 0;
+	}
+
+	uint32_t mss_;
+	double cwnd_;
+	double ssthresh_ = HUGE_VAL;
+	double wMax_ = 0;
+	double wEst_ = 0;
+	double k_ = 0;
+	uint64_t epochStart_ = 0;
+};
+
+} // anonymous namespace
+
+std::unique_ptr<CongestionControl> makeCongestionControl(CongestionAlgorithm algorithm,
+		uint32_t mss) {
+	switch(algorithm) {
+	case CongestionAlgorithm::newReno:
+		return std::make_unique<NewReno>(mss);
+	case CongestionAlgorithm::cubic:
+		return std::make_unique<Cubic>(mss);
+	}
+	return nullptr;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+enum class CongestionAlgorithm {
+	newReno,
+	cubic,
+};
+
+// Interface between the TCP sender and a congestion control algorithm.
+// All sizes are in bytes, all times are in nanoseconds.
+struct CongestionControl {
+	virtual ~CongestionControl() = default;
+
+	// New data was acknowledged outside of loss recovery.
+	virtual void onAck(uint32_t ackedBytes, uint64_t now, uint64_t srtt) = 0;
+	// Loss was detected by duplicate ACKs, the sender enters fast recovery.
+	virtual void onEnterRecovery(uint32_t inFlight) = 0;
+	// A further duplicate ACK arrived during fast recovery.
+	virtual void onDupAck() = 0;
+	// An ACK during fast recovery covered some, but not all, outstanding data.
+	virtual void onPartialAck(uint32_t ackedBytes) = 0;
+	// All data that was outstanding when recovery started has been acknowledged.
+	virtual void onExitRecovery() = 0;
+	// The retransmission timer expired.
+	virtual void onTimeout(uint32_t inFlight) = 0;
+
+	// Current congestion window.
+	virtual uint32_t window() = 0;
+};
+
+std::unique_ptr<CongestionControl> makeCongestionControl(CongestionAlgorithm algorithm,
+		uint32_t mss);
@@ -258,7 +258,7 @@ bool Ip4::hasIp(uint32_t addr) {
 }
 
 async::result<protocols::fs::Error> Ip4::sendFrame(Ip4TargetInfo ti,
-		void *data, size_t len, uint16_t proto) {
+		void *data, size_t len, uint16_t proto, nic::TxOffload offload) {
 	using arch::convert_endian;
 	using arch::endian;
 
@@ -266,14 +266,21 @@ async::result<protocols::fs::Error> Ip4::sendFrame(Ip4TargetInfo ti,
 	// calculate header size
 	size_t header_size = sizeof(Ip4Packet::Header);
 	size_t packet_size = len + header_size;
+	// segmented packets only need to fit into the MTU after segmentation
+	size_t wire_size = packet_size;
+	if (offload.segmentSize)
+		wire_size = header_size + offload.headerLength + offload.segmentSize;
+	if (packet_size > 0xFFFF) {
+		co_return protocols::fs::Error::messageSize;
+	}
 	// TODO(arsen): options
-	if (ti.route.mtu != 0 && ti.route.mtu < packet_size) {
+	if (ti.route.mtu != 0 && ti.route.mtu < wire_size) {
 		std::cout << "netserver: cant fragment 1" << std::endl;
 		co_return protocols::fs::Error::messageSize;
 	}
 
 	auto &target = ti.link;
-	if (target->mtu < packet_size) {
+	if (target->mtu < wire_size) {
 		std::cout << "netserver: cant fragment 2" << std::endl;
 		co_return protocols::fs::Error::messageSize;
 	}
@@ -314,18 +321,29 @@ async::result<protocols::fs::Error> Ip4::sendFrame(Ip4TargetInfo ti,
 	std::memcpy(fb.payload.data(), &hdr, sizeof(hdr));
 	std::memcpy(fb.payload.subview(header_size).byte_data(), data, len);
 
-	co_await target->send(std::move(fb.frame));
+	if (offload.needsChecksum || offload.segmentSize) {
+		// offsets passed in are relative to the L4 header, make them frame-relative
+		auto l4Offset = reinterpret_cast<uint8_t *>(fb.payload.data())
+			- reinterpret_cast<uint8_t *>(fb.frame.data()) + header_size;
+		offload.checksumStart += l4Offset;
+		offload.headerLength += l4Offset;
+		co_await target->send(std::move(fb.frame), offload);
+	} else {
+		co_await target->send(std::move(fb.frame));
+	}
 	co_return protocols::fs::Error::none;
 }
 
 void Ip4::feedPacket(nic::MacAddress, nic::MacAddress,
-		arch::dma_buffer owner, arch::dma_buffer_view frame) {
+		arch::dma_buffer owner, arch::dma_buffer_view frame,
+		bool checksumValid) {
 	Ip4Packet hdr;
 	if (!hdr.parse(std::move(owner), frame)) {
 		std::cout << "netserver: runt, or otherwise invalid, ip4 frame received"
 			<< std::endl;
 		return;
 	}
+	hdr.checksumValid = checksumValid;
 	auto proto = hdr.header.protocol;
 
 	auto begin = sockets.lower_bound(proto);
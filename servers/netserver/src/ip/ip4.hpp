@@ -106,6 +106,8 @@ public:
 	} header;
 	static_assert(sizeof(header) == 20, "bad header size");
 	arch::dma_buffer_view data;
+	// the NIC has already verified the L4 checksum
+	bool checksumValid = false;
 
 	inline arch::dma_buffer_view payload() const {
 		return data.subview(header.ihl * 4);
@@ -131,7 +133,8 @@ struct Ip4 {
 	managarm::fs::Errors serveSocket(helix::UniqueLane lane, int type, int proto, int flags);
 	// frame is a view into the owner buffer, stripping away eth bits
 	void feedPacket(nic::MacAddress dest, nic::MacAddress src,
-		arch::dma_buffer owner, arch::dma_buffer_view frame);
+		arch::dma_buffer owner, arch::dma_buffer_view frame,
+		bool checksumValid = false);
 
 	bool hasIp(uint32_t ip);
 	std::shared_ptr<nic::Link> getLink(uint32_t ip);
@@ -141,9 +144,10 @@ struct Ip4 {
 	std::optional<uint32_t> findLinkIp(uint32_t ipOnNet, nic::Link *link);
 
 	async::result<std::optional<Ip4TargetInfo>> targetByRemote(uint32_t);
+	// offsets in the offload descriptor are relative to the start of data
 	async::result<protocols::fs::Error> sendFrame(Ip4TargetInfo,
 		void*, size_t,
-		uint16_t);
+		uint16_t, nic::TxOffload = {});
 private:
 	std::multimap<int, smarter::shared_ptr<Ip4Socket>> sockets;
 	std::map<CidrAddress, std::weak_ptr<nic::Link>> ips;
@@ -0,0 +1,76 @@
+#include "retransmit.hpp"
+
+#include <algorithm>
+
+void SackScoreboard::add(SackBlock block, uint32_t settledSn, uint32_t highestSn) {
+	if(!seqLt(block.begin, block.end)
+			|| !seqGt(block.end, settledSn)
+			|| seqGt(block.end, highestSn))
+		return;
+	if(seqLt(block.begin, settledSn))
+		block.begin = settledSn;
+
+	// Insert the block, merging it with overlapping or adjacent blocks.
+	auto it = blocks_.begin();
+	while(it != blocks_.end() && seqLt(it->end, block.begin))
+		++it;
+	while(it != blocks_.end() && !seqGt(it->begin, block.end)) {
+		if(seqLt(it->begin, block.begin))
+			block.begin = it->begin;
+		if(seqGt(it->end, block.end))
+			block.end = it->end;
+		it = blocks_.erase(it);
+	}
+	blocks_.insert(it, block);
+}
+
+void SackScoreboard::advance(uint32_t settledSn) {
+	std::erase_if(blocks_, [&] (const SackBlock &block) {
+		return !seqGt(block.end, settledSn);
+	});
+	if(!blocks_.empty() && seqLt(blocks_.front().begin, settledSn))
+		blocks_.front().begin = settledSn;
+}
+
+uint32_t SackScoreboard::sackedBytes() const {
+	uint32_t sacked = 0;
+	for(auto &block : blocks_)
+		sacked += block.end - block.begin;
+	return sacked;
+}
+
+SackBlock SackScoreboard::firstHole(uint32_t settledSn, uint32_t highestSn) const {
+	uint32_t sn = settledSn;
+	for(auto &block : blocks_) {
+		if(!seqGt(block.begin, sn)) {
+			if(seqGt(block.end, sn))
+				sn = block.end;
+			continue;
+		}
+		return {sn, block.begin};
+	}
+	return {sn, seqGt(highestSn, sn) ? highestSn : sn};
+}
+
+void RtoEstimator::sample(uint64_t rtt) {
+	rtt = std::max(rtt, uint64_t{1});
+	if(!srtt_) {
+		srtt_ = rtt;
+		rttvar_ = rtt / 2;
+	}else{
+		uint64_t delta = srtt_ > rtt ? srtt_ - rtt : rtt - srtt_;
+		rttvar_ = (3 * rttvar_ + delta) / 4;
+		srtt_ = (7 * srtt_ + rtt) / 8;
+	}
+	rto_ = std::clamp(srtt_ + std::max(clockGranularity, 4 * rttvar_), minRto, maxRto);
+}
+
+void RtoEstimator::backoff() {
+	rto_ = std::min(2 * rto_, maxRto);
+}
+
+void RtoEstimator::reset() {
+	srtt_ = 0;
+	rttvar_ = 0;
+	rto_ = initialRto;
+}
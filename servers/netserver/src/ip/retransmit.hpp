@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Comparisons of sequence numbers in modular arithmetic.
+inline bool seqLt(uint32_t a, uint32_t b) {
+	return static_cast<int32_t>(a - b) < 0;
+}
+
+inline bool seqGt(uint32_t a, uint32_t b) {
+	return static_cast<int32_t>(a - b) > 0;
+}
+
+struct SackBlock {
+	uint32_t begin;
+	uint32_t end;
+};
+
+// Ranges of outstanding Out-SNs that the remote reported via SACK (RFC 2018).
+// Blocks are disjoint, non-adjacent and sorted.
+struct SackScoreboard {
+	// Merges a block that the remote reported. Blocks that do not cover data in
+	// [settledSn, highestSn) are ignored.
+	void add(SackBlock block, uint32_t settledSn, uint32_t highestSn);
+
+	// Drops everything below a new cumulative ACK.
+	void advance(uint32_t settledSn);
+
+	void clear() {
+		blocks_.clear();
+	}
+
+	uint32_t sackedBytes() const;
+
+	// Returns the first range at or after settledSn that the remote did not SACK,
+	// bounded by highestSn.
+	SackBlock firstHole(uint32_t settledSn, uint32_t highestSn) const;
+
+	const std::vector<SackBlock> &blocks() const {
+		return blocks_;
+	}
+
+private:
+	std::vector<SackBlock> blocks_;
+};
+
+// Retransmission timeout parameters (RFC 6298), in nanoseconds.
+// Like other stacks, we use a lower bound of 200ms instead of the 1s that the RFC suggests.
+constexpr uint64_t initialRto = 1'000'000'000;
+constexpr uint64_t minRto = 200'000'000;
+constexpr uint64_t maxRto = 60'000'000'000;
+constexpr uint64_t clockGranularity = 1'000'000;
+
+// Round-trip time estimation and retransmission timeout (RFC 6298).
+struct RtoEstimator {
+	// Feeds an RTT measurement (Karn's algorithm is up to the caller).
+	void sample(uint64_t rtt);
+
+	// Doubles the timeout after it expired (RFC 6298 5.5).
+	void backoff();
+
+	// Forgets all measurements.
+	void reset();
+
+	uint64_t srtt() const {
+		return srtt_;
+	}
+
+	uint64_t rto() const {
+		return rto_;
+	}
+
+private:
+	uint64_t srtt_ = 0;
+	uint64_t rttvar_ = 0;
+	uint64_t rto_ = initialRto;
+};
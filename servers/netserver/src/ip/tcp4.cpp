@@ -3,7 +3,11 @@
 #include <async/result.hpp>
 #include <arch/bit.hpp>
 #include <arch/variable.hpp>
+#include <helix/timer.hpp>
 #include <protocols/fs/server.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstring>
 #include <deque>
 #include <iomanip>
@@ -18,13 +22,32 @@
 #include <bragi/helpers-std.hpp>
 
 #include "checksum.hpp"
+#include "congestion.hpp"
 #include "ip4.hpp"
+#include "retransmit.hpp"
 #include "tcp4.hpp"
 
 namespace {
 
 constexpr bool debugTcp = false;
 
+constexpr CongestionAlgorithm congestionAlgorithm = CongestionAlgorithm::newReno;
+
+// MSS that is assumed if the remote does not send the MSS option (RFC 9293).
+constexpr uint32_t defaultRemoteMss = 536;
+// Lower bound on the MSS (like Linux) such that options never exceed it.
+constexpr uint32_t minMss = 88;
+constexpr unsigned int dupAckThreshold = 3;
+constexpr size_t maxSackBlocks = 4;
+// TCP header including the maximal amount of options.
+constexpr size_t maxHeaderSize = 60;
+
+uint64_t currentTime() {
+	uint64_t now;
+	HEL_CHECK(helGetClock(&now));
+	return now;
+}
+
 struct stl_allocator {
 	void *allocate(size_t size) {
 		return operator new(size);
@@ -125,12 +148,77 @@ struct TcpHeader {
 
 static_assert(sizeof(TcpHeader) == 20);
 
+enum class TcpOption : uint8_t {
+	end = 0,
+	nop = 1,
+	mss = 2,
+	windowScale = 3,
+	sackPermitted = 4,
+	sack = 5,
+};
+
+struct TcpOptions {
+	std::optional<uint16_t> mss;
+	std::optional<uint8_t> windowScale;
+	bool sackPermitted = false;
+	std::array<SackBlock, maxSackBlocks> sackBlocks;
+	size_t numSackBlocks = 0;
+};
+
 struct TcpPacket {
-	arch::dma_buffer_view payload() {
+	arch::dma_buffer_view payload() const {
 		auto words = header.flags.load() & TcpHeader::headerWords;
 		return packet->payload().subview(words * 4);
 	}
 
+	void parseOptions(arch::dma_buffer_view view) {
+		auto p = reinterpret_cast<const uint8_t *>(view.data());
+		size_t n = view.size();
+		size_t i = 0;
+		while(i < n) {
+			auto kind = static_cast<TcpOption>(p[i]);
+			if(kind == TcpOption::end)
+				break;
+			if(kind == TcpOption::nop) {
+				i++;
+				continue;
+			}
+			if(i + 1 >= n || p[i + 1] < 2 || i + p[i + 1] > n)
+				break;
+			size_t len = p[i + 1];
+			auto data = p + i + 2;
+
+			auto load32 = [] (const uint8_t *q) -> uint32_t {
+				return (uint32_t{q[0]} << 24) | (uint32_t{q[1]} << 16)
+						| (uint32_t{q[2]} << 8) | q[3];
+			};
+			switch(kind) {
+			case TcpOption::mss:
+				if(len == 4)
+					options.mss = (data[0] << 8) | data[1];
+				break;
+			case TcpOption::windowScale:
+				if(len == 3)
+					options.windowScale = std::min(data[0], uint8_t{14});
+				break;
+			case TcpOption::sackPermitted:
+				options.sackPermitted = true;
+				break;
+			case TcpOption::sack:
+				for(size_t j = 0; j + 8 <= len - 2
+						&& options.numSackBlocks < maxSackBlocks; j += 8) {
+					options.sackBlocks[options.numSackBlocks++] = {
+						load32(data + j), load32(data + j + 4)
+					};
+				}
+				break;
+			default:
+				break;
+			}
+			i += len;
+		}
+	}
+
 	bool parse(smarter::shared_ptr<const Ip4Packet> packet) {
 		auto ipPayload = packet->payload();
 		if (ipPayload.size() < sizeof(TcpHeader))
@@ -143,7 +231,7 @@ struct TcpPacket {
 		if (ipPayload.size() < words * 4)
 			return false;
 
-		if (header.checksum.load()) {
+		if (header.checksum.load() && !packet->checksumValid) {
 			PseudoHeader pseudo {
 				.src = packet->header.source,
 				.dst = packet->header.destination,
@@ -158,11 +246,14 @@ struct TcpPacket {
 				return false;
 		}
 
+		parseOptions(ipPayload.subview(sizeof(TcpHeader), words * 4 - sizeof(TcpHeader)));
+
 		this->packet = std::move(packet);
 		return true;
 	}
 
 	TcpHeader header;
+	TcpOptions options;
 	smarter::shared_ptr<const Ip4Packet> packet;
 };
 
@@ -186,7 +277,11 @@ protocols::fs::Error checkAddress(const void *addrPtr, size_t addrLength, TcpEnd
 
 struct Tcp4Socket {
 	Tcp4Socket(Tcp4 *parent, bool nonBlock)
-	: parent_(parent), nonBlock_{nonBlock}, recvRing_{14}, sendRing_{14} {}
+	: parent_(parent), nonBlock_{nonBlock}, recvRing_{17}, sendRing_{17} {
+		// Pick the smallest window scale that can announce the entire receive buffer.
+		while((recvRing_.spaceForEnqueue() >> ourWindowShift_) > 0xFFFF)
+			ourWindowShift_++;
+	}
 
 	~Tcp4Socket() {
 		parent_->unbind(localEp_);
@@ -512,8 +607,42 @@ struct Tcp4Socket {
 
 private:
 	async::result<void> flushOutPackets_();
+	// Waits until flushEvent_ is raised or the retransmission timer expires.
+	async::result<void> waitForFlush_();
+	async::result<bool> sendSegment_(Ip4TargetInfo targetInfo,
+			uint32_t sn, size_t chunk, size_t segmentSize);
 
 	void handleInPacket_(TcpPacket packet);
+	void handleAck_(const TcpPacket &packet);
+	void handleRetransmitTimeout_();
+	void updateSackBlocks_(const TcpOptions &options);
+	// Collects SACK blocks that report the out-of-order data that we hold.
+	size_t collectSackBlocks_(std::array<SackBlock, maxSackBlocks> &blocks);
+	void enqueueReceived_(const void *data, size_t size);
+	void queueOutOfOrder_(uint32_t sn, arch::dma_buffer_view payload);
+	bool drainOutOfOrder_();
+
+	// Receive window that can be announced given the current window scale.
+	uint32_t announceableWindow_() {
+		auto window = std::min(recvRing_.spaceForEnqueue() >> recvWindowShift_, size_t{0xFFFF});
+		return window << recvWindowShift_;
+	}
+
+	// Payload that fits into a segment along with the options that we currently send.
+	size_t sendMss_() {
+		std::array<SackBlock, maxSackBlocks> blocks;
+		auto numBlocks = collectSackBlocks_(blocks);
+		if(!numBlocks)
+			return mss_;
+		return mss_ - (4 + 8 * numBlocks);
+	}
+
+	// Bytes that have been sent but are not yet known to have left the network.
+	uint32_t inFlight_() {
+		uint32_t sacked = sacked_.sackedBytes();
+		uint32_t flushed = localFlushedSn_ - localSettledSn_;
+		return flushed > sacked ? flushed - sacked : 0;
+	}
 
 private:
 	friend struct Tcp4;
@@ -546,6 +675,46 @@ private:
 	uint32_t remoteKnownSn_ = 0;
 	// Size of received window that we announced to the remote side.
 	uint32_t announcedWindow_ = 0;
+	// Highest Out-SN that has ever been flushed (>= localFlushedSn_).
+	// localFlushedSn_ is reset to localSettledSn_ on retransmission timeouts.
+	uint32_t localHighestSn_ = 0;
+	// Send a segment even if there is no new data to acknowledge.
+	bool forceAck_ = false;
+
+	// Options negotiated during the handshake.
+	uint32_t mss_ = defaultRemoteMss;
+	unsigned int ourWindowShift_ = 0;
+	unsigned int sendWindowShift_ = 0;
+	unsigned int recvWindowShift_ = 0;
+	bool sackPermitted_ = false;
+
+	// Round-trip time estimation and retransmission timer (RFC 6298).
+	RtoEstimator rtt_;
+	// Time at which the retransmission timer expires, zero if it is not running.
+	uint64_t rtoDeadline_ = 0;
+	// Karn's algorithm: only time segments that are not retransmitted.
+	bool rttTiming_ = false;
+	uint32_t rttSn_ = 0;
+	uint64_t rttStart_ = 0;
+
+	// Fast retransmit and recovery (RFC 5681, RFC 6582).
+	std::unique_ptr<CongestionControl> congestion_;
+	unsigned int dupAcks_ = 0;
+	bool inRecovery_ = false;
+	uint32_t recoverSn_ = 0;
+	bool retransmitPending_ = false;
+	// Send one byte beyond the remote's window.
+	bool windowProbe_ = false;
+
+	// Ranges of Out-SNs above localSettledSn_ that the remote reported via SACK.
+	SackScoreboard sacked_;
+
+	// Segments that were received out of order, sorted by In-SN.
+	struct OutOfOrderSegment {
+		uint32_t sn;
+		std::vector<char> data;
+	};
+	std::vector<OutOfOrderSegment> reassembly_;
 
 	RingBuffer recvRing_;
 	RingBuffer sendRing_;
@@ -563,6 +732,22 @@ private:
 	async::recurring_event pollEvent_;
 };
 
+async::result<void> Tcp4Socket::waitForFlush_() {
+	if(!rtoDeadline_) {
+		co_await flushEvent_.async_wait();
+		co_return;
+	}
+
+	auto now = currentTime();
+	if(now >= rtoDeadline_)
+		co_return;
+
+	async::cancellation_event ev;
+	helix::TimeoutCancellation timer{rtoDeadline_ - now, ev};
+	co_await flushEvent_.async_wait(ev);
+	co_await timer.retire();
+}
+
 async::result<void> Tcp4Socket::flushOutPackets_() {
 	while(true) {
 		if(connectState_ == ConnectState::none) {
@@ -572,15 +757,20 @@ async::result<void> Tcp4Socket::flushOutPackets_() {
 
 		if(connectState_ == ConnectState::sendSyn) {
 			if(localSettledSn_ != localFlushedSn_) {
-				co_await flushEvent_.async_wait();
-				continue;
+				// The SYN is in flight, retransmit it once the timer expires.
+				if(!rtoDeadline_ || currentTime() < rtoDeadline_) {
+					co_await waitForFlush_();
+					continue;
+				}
+				rtt_.backoff();
+				localFlushedSn_ = localSettledSn_;
+			}else{
+				// Obtain a new random sequence number.
+				auto randomSn = globalPrng();
+				localSettledSn_ = randomSn;
+				localFlushedSn_ = randomSn;
 			}
 
-			// Obtain a new random sequence number.
-			auto randomSn = globalPrng();
-			localSettledSn_ = randomSn;
-			localFlushedSn_ = randomSn;
-
 			// Construct and transmit the initial SYN packet.
 			auto targetInfo = co_await ip4().targetByRemote(remoteEp_.ipAddress);
 			if (!targetInfo) {
@@ -589,20 +779,37 @@ async::result<void> Tcp4Socket::flushOutPackets_() {
 				co_return;
 			}
 
+			// Announce our MSS, window scale (RFC 7323) and SACK support (RFC 2018).
+			mss_ = targetInfo->link->mtu - sizeof(Ip4Packet::Header) - sizeof(TcpHeader);
+			const uint8_t options[] = {
+				static_cast<uint8_t>(TcpOption::mss), 4,
+				static_cast<uint8_t>(mss_ >> 8), static_cast<uint8_t>(mss_),
+				static_cast<uint8_t>(TcpOption::nop),
+				static_cast<uint8_t>(TcpOption::windowScale), 3,
+				static_cast<uint8_t>(ourWindowShift_),
+				static_cast<uint8_t>(TcpOption::nop),
+				static_cast<uint8_t>(TcpOption::nop),
+				static_cast<uint8_t>(TcpOption::sackPermitted), 2,
+			};
+			static_assert(sizeof(options) % 4 == 0);
+
 			std::vector<char> buf;
-			buf.resize(sizeof(TcpHeader));
+			buf.resize(sizeof(TcpHeader) + sizeof(options));
 
+			// The window of SYN segments is never scaled.
+			announcedWindow_ = std::min(recvRing_.spaceForEnqueue(), size_t{0xFFFF});
 			auto header = new (buf.data()) TcpHeader {
 				.srcPort = localEp_.port,
 				.destPort = remoteEp_.port,
 				.seqNumber = localFlushedSn_,
 				.ackNumber = 0,
-				.window = 0,
+				.window = announcedWindow_,
 				.checksum = 0,
 				.urgentPointer = 0
 			};
-			header->flags.store(TcpHeader::headerWords(sizeof(TcpHeader) / 4)
+			header->flags.store(TcpHeader::headerWords(buf.size() / 4)
 					| TcpHeader::synFlag(true));
+			std::memcpy(buf.data() + sizeof(TcpHeader), options, sizeof(options));
 
 			// Fill in the checksum.
 			PseudoHeader pseudo {
@@ -616,6 +823,8 @@ async::result<void> Tcp4Socket::flushOutPackets_() {
 			header->checksum = csum.finalize();
 
 			++localFlushedSn_;
+			localHighestSn_ = localFlushedSn_;
+			rtoDeadline_ = currentTime() + rtt_.rto();
 
 			if(debugTcp)
 				std::cout << "netserver: Sending TCP SYN" << std::endl;
@@ -628,20 +837,37 @@ async::result<void> Tcp4Socket::flushOutPackets_() {
 			}
 		}else{
 			assert(connectState_ == ConnectState::connected);
+			if(rtoDeadline_ && currentTime() >= rtoDeadline_)
+				handleRetransmitTimeout_();
+
 			size_t flushPointer = localFlushedSn_ - localSettledSn_;
 			size_t windowPointer = localWindowSn_ - localSettledSn_;
 
 			size_t bytesAvailable = sendRing_.availableToDequeue();
 			assert(bytesAvailable >= flushPointer);
 
-			// Check whether we need to send a packet.
-			// TODO: Add retransmission here.
-			bool wantData = (bytesAvailable > flushPointer && windowPointer > flushPointer);
-			bool wantAck = (remoteAckedSn_ != remoteKnownSn_);
-			bool wantWindowUpdate = (announcedWindow_ < recvRing_.spaceForEnqueue());
+			// Send a single byte into a zero window to probe it (RFC 9293 3.8.6.1).
+			if(windowProbe_)
+				windowPointer = std::max(windowPointer, flushPointer + 1);
+
+			// Amount of new data that the congestion window allows us to send.
+			size_t congestionSpace = 0;
+			auto inFlight = inFlight_();
+			if(congestion_->window() > inFlight)
+				congestionSpace = congestion_->window() - inFlight;
 
-			if(!wantData && !wantAck && !wantWindowUpdate) {
-				co_await flushEvent_.async_wait();
+			// Check whether we need to send a packet.
+			bool wantData = (bytesAvailable > flushPointer && windowPointer > flushPointer
+					&& congestionSpace);
+			bool wantRetransmit = retransmitPending_;
+			bool wantAck = (remoteAckedSn_ != remoteKnownSn_) || forceAck_;
+			bool wantWindowUpdate = (announcedWindow_ < announceableWindow_());
+
+			if(!wantData && !wantRetransmit && !wantAck && !wantWindowUpdate) {
+				// If the remote closed its window, the timer triggers a window probe.
+				if(!rtoDeadline_ && bytesAvailable > flushPointer && windowPointer <= flushPointer)
+					rtoDeadline_ = currentTime() + rtt_.rto();
+				co_await waitForFlush_();
 				continue;
 			}
 
@@ -653,56 +879,335 @@ async::result<void> Tcp4Socket::flushOutPackets_() {
 				co_return;
 			}
 
-			auto chunk = std::min({
-				bytesAvailable - flushPointer,
-				windowPointer - flushPointer,
-				size_t{1000} // TODO: Perform path MTU discovery.
-			});
-
-			std::vector<char> buf;
-			buf.resize(sizeof(TcpHeader) + chunk);
-
-			auto header = new (buf.data()) TcpHeader {
-				.srcPort = localEp_.port,
-				.destPort = remoteEp_.port,
-				.seqNumber = localFlushedSn_,
-				.ackNumber = remoteKnownSn_,
-				.window = std::min(recvRing_.spaceForEnqueue(), size_t{0xFFFF}),
-				.checksum = 0,
-				.urgentPointer = 0
-			};
-			header->flags.store(TcpHeader::headerWords(sizeof(TcpHeader) / 4)
-					| TcpHeader::ackFlag(true));
-
-			sendRing_.dequeueLookahead(flushPointer, buf.data() + sizeof(TcpHeader), chunk);
+			if(wantRetransmit) {
+				retransmitPending_ = false;
+
+				// Retransmit the first hole that the remote did not SACK.
+				auto hole = sacked_.firstHole(localSettledSn_, localHighestSn_);
+				auto sn = hole.begin;
+
+				auto sendMss = sendMss_();
+				size_t chunk = std::min(size_t{hole.end - hole.begin}, sendMss);
+				if(chunk) {
+					if(debugTcp)
+						std::cout << "netserver: Retransmitting TCP data (" << chunk
+								<< " bytes)" << std::endl;
+					rttTiming_ = false;
+					if(!rtoDeadline_)
+						rtoDeadline_ = currentTime() + rtt_.rto();
+					if(!co_await sendSegment_(std::move(*targetInfo), sn, chunk, sendMss))
+						co_return;
+					continue;
+				}
+			}
 
-			// Fill in the checksum.
-			PseudoHeader pseudo {
-				.src = targetInfo->source,
-				.dst = remoteEp_.ipAddress,
-				.len = buf.size()
-			};
-			Checksum csum;
-			csum.update(&pseudo, sizeof(PseudoHeader));
-			csum.update(buf.data(), buf.size());
-			header->checksum = csum.finalize();
+			// SACK options take space away from the payload of each segment.
+			auto sendMss = sendMss_();
+			size_t chunk = 0;
+			if(wantData) {
+				// With TSO, hand the NIC a single large packet that it splits into segments.
+				size_t maxChunk = sendMss;
+				if (targetInfo->link->offloads() & nic::OFFLOAD_TSO4)
+					maxChunk = 0xFFFF - sizeof(Ip4Packet::Header) - maxHeaderSize;
+
+				chunk = std::min({
+					bytesAvailable - flushPointer,
+					windowPointer - flushPointer,
+					congestionSpace,
+					maxChunk
+				});
+				windowProbe_ = false;
+			}
 
+			auto sn = localFlushedSn_;
 			localFlushedSn_ += chunk;
-			remoteAckedSn_ = remoteKnownSn_;
-			announcedWindow_ = recvRing_.spaceForEnqueue();
+			if(seqGt(localFlushedSn_, localHighestSn_)) {
+				// Time the segment if it carries new data.
+				if(!rttTiming_) {
+					rttTiming_ = true;
+					rttSn_ = localFlushedSn_;
+					rttStart_ = currentTime();
+				}
+				localHighestSn_ = localFlushedSn_;
+			}
+			if(chunk && !rtoDeadline_)
+				rtoDeadline_ = currentTime() + rtt_.rto();
 
 			if(debugTcp)
 				std::cout << "netserver: Sending TCP data (" << chunk << " bytes)" << std::endl;
-			auto error = co_await ip4().sendFrame(std::move(*targetInfo),
-				buf.data(), buf.size(),
-				static_cast<uint16_t>(IpProto::tcp));
-			if (error != protocols::fs::Error::none) {
-				// TODO: Return an error to users.
-				std::cout << "netserver: Could not send TCP packet" << std::endl;
+			if(!co_await sendSegment_(std::move(*targetInfo), sn, chunk, sendMss))
 				co_return;
+		}
+	}
+}
+
+size_t Tcp4Socket::collectSackBlocks_(std::array<SackBlock, maxSackBlocks> &blocks) {
+	size_t numBlocks = 0;
+	if(!sackPermitted_)
+		return 0;
+	for(auto &segment : reassembly_) {
+		uint32_t end = segment.sn + segment.data.size();
+		if(numBlocks && !seqGt(segment.sn, blocks[numBlocks - 1].end)) {
+			if(seqGt(end, blocks[numBlocks - 1].end))
+				blocks[numBlocks - 1].end = end;
+			continue;
+		}
+		if(numBlocks == maxSackBlocks)
+			break;
+		blocks[numBlocks++] = {segment.sn, end};
+	}
+	return numBlocks;
+}
+
+async::result<bool> Tcp4Socket::sendSegment_(Ip4TargetInfo targetInfo,
+		uint32_t sn, size_t chunk, size_t segmentSize) {
+	// Report the out-of-order data that we hold.
+	std::array<SackBlock, maxSackBlocks> blocks;
+	auto numBlocks = collectSackBlocks_(blocks);
+
+	size_t headerSize = sizeof(TcpHeader);
+	if(numBlocks)
+		headerSize += 4 + 8 * numBlocks;
+	assert(headerSize <= maxHeaderSize);
+	// Callers size segments by sendMss_(), i.e., with the same options in mind.
+	assert(headerSize - sizeof(TcpHeader) + segmentSize <= mss_);
+
+	std::vector<char> buf;
+	buf.resize(headerSize + chunk);
+
+	announcedWindow_ = announceableWindow_();
+	auto header = new (buf.data()) TcpHeader {
+		.srcPort = localEp_.port,
+		.destPort = remoteEp_.port,
+		.seqNumber = sn,
+		.ackNumber = remoteKnownSn_,
+		.window = announcedWindow_ >> recvWindowShift_,
+		.checksum = 0,
+		.urgentPointer = 0
+	};
+	header->flags.store(TcpHeader::headerWords(headerSize / 4)
+			| TcpHeader::ackFlag(true));
+
+	if(numBlocks) {
+		auto p = reinterpret_cast<uint8_t *>(buf.data() + sizeof(TcpHeader));
+		auto store32 = [] (uint8_t *q, uint32_t v) {
+			q[0] = v >> 24;
+			q[1] = v >> 16;
+			q[2] = v >> 8;
+			q[3] = v;
+		};
+		p[0] = static_cast<uint8_t>(TcpOption::nop);
+		p[1] = static_cast<uint8_t>(TcpOption::nop);
+		p[2] = static_cast<uint8_t>(TcpOption::sack);
+		p[3] = 2 + 8 * numBlocks;
+		for(size_t i = 0; i < numBlocks; i++) {
+			store32(p + 4 + 8 * i, blocks[i].begin);
+			store32(p + 8 + 8 * i, blocks[i].end);
+		}
+	}
+
+	sendRing_.dequeueLookahead(sn - localSettledSn_, buf.data() + headerSize, chunk);
+
+	// Fill in the checksum.
+	PseudoHeader pseudo {
+		.src = targetInfo.source,
+		.dst = remoteEp_.ipAddress,
+		.len = buf.size()
+	};
+	Checksum csum;
+	csum.update(&pseudo, sizeof(PseudoHeader));
+
+	nic::TxOffload offload;
+	if (targetInfo.link->offloads() & (nic::OFFLOAD_TX_CHECKSUM | nic::OFFLOAD_TSO4)) {
+		// The NIC sums the TCP header and payload on top of the pseudo header.
+		header->checksum = csum.fold();
+		offload.needsChecksum = true;
+		offload.checksumOffset = offsetof(TcpHeader, checksum);
+		if (chunk > segmentSize) {
+			offload.segmentSize = segmentSize;
+			offload.headerLength = headerSize;
+		}
+	} else {
+		csum.update(buf.data(), buf.size());
+		header->checksum = csum.finalize();
+	}
+
+	remoteAckedSn_ = remoteKnownSn_;
+	forceAck_ = false;
+
+	auto error = co_await ip4().sendFrame(std::move(targetInfo),
+		buf.data(), buf.size(),
+		static_cast<uint16_t>(IpProto::tcp), offload);
+	if (error != protocols::fs::Error::none) {
+		// TODO: Return an error to users.
+		std::cout << "netserver: Could not send TCP packet" << std::endl;
+		co_return false;
+	}
+	co_return true;
+}
+
+void Tcp4Socket::handleRetransmitTimeout_() {
+	rtoDeadline_ = 0;
+	if(localFlushedSn_ == localSettledSn_) {
+		// Nothing is outstanding, the remote's window is closed.
+		windowProbe_ = true;
+		rtt_.backoff();
+		return;
+	}
+
+	if(debugTcp)
+		std::cout << "netserver: TCP retransmission timeout" << std::endl;
+	congestion_->onTimeout(inFlight_());
+
+	// Back off the timer (RFC 6298 5.5) and resend everything after the last ACK.
+	rtt_.backoff();
+	rttTiming_ = false;
+	dupAcks_ = 0;
+	inRecovery_ = false;
+	recoverSn_ = localHighestSn_;
+	retransmitPending_ = false;
+	// The remote may discard SACKed data (RFC 2018), so we cannot rely on it anymore.
+	sacked_.clear();
+	localFlushedSn_ = localSettledSn_;
+}
+
+void Tcp4Socket::updateSackBlocks_(const TcpOptions &options) {
+	for(size_t i = 0; i < options.numSackBlocks; i++)
+		sacked_.add(options.sackBlocks[i], localSettledSn_, localHighestSn_);
+}
+
+void Tcp4Socket::enqueueReceived_(const void *data, size_t size) {
+	recvRing_.enqueue(const_cast<void *>(data), size);
+	remoteKnownSn_ += size;
+	if(announcedWindow_ < size) {
+		announcedWindow_ = 0;
+	}else{
+		announcedWindow_ -= size;
+	}
+}
+
+void Tcp4Socket::queueOutOfOrder_(uint32_t sn, arch::dma_buffer_view payload) {
+	// Only keep data that fits into the receive buffer once the hole is filled.
+	size_t offset = sn - remoteKnownSn_;
+	size_t space = recvRing_.spaceForEnqueue();
+	if(offset >= space)
+		return;
+	size_t size = std::min(payload.size(), space - offset);
+
+	size_t queued = 0;
+	for(auto &segment : reassembly_)
+		queued += segment.data.size();
+	if(queued + size > space)
+		return;
+
+	auto it = reassembly_.begin();
+	while(it != reassembly_.end() && seqLt(it->sn, sn))
+		++it;
+	if(it != reassembly_.end() && it->sn == sn && it->data.size() >= size)
+		return;
+
+	auto p = reinterpret_cast<const char *>(payload.data());
+	reassembly_.insert(it, OutOfOrderSegment{sn, std::vector<char>(p, p + size)});
+}
+
+bool Tcp4Socket::drainOutOfOrder_() {
+	bool progress = false;
+	auto it = reassembly_.begin();
+	for(; it != reassembly_.end() && !seqGt(it->sn, remoteKnownSn_); ++it) {
+		size_t skip = remoteKnownSn_ - it->sn;
+		if(skip >= it->data.size())
+			continue;
+		size_t chunk = std::min(it->data.size() - skip, recvRing_.spaceForEnqueue());
+		enqueueReceived_(it->data.data() + skip, chunk);
+		progress = true;
+	}
+	reassembly_.erase(reassembly_.begin(), it);
+	return progress;
+}
+
+void Tcp4Socket::handleAck_(const TcpPacket &packet) {
+	uint32_t ackSn = packet.header.ackNumber.load();
+	uint32_t window = uint32_t{packet.header.window.load()} << sendWindowShift_;
+
+	// Ignore ACKs that are older than what we already know.
+	if(seqLt(ackSn, localSettledSn_))
+		return;
+	if(seqGt(ackSn, localHighestSn_)) {
+		std::cout << "netserver: Rejecting ack-number outside of valid window"
+				<< std::endl;
+		return;
+	}
+
+	if(sackPermitted_)
+		updateSackBlocks_(packet.options);
+
+	uint32_t ackPointer = ackSn - localSettledSn_;
+	if(!ackPointer) {
+		// Duplicate ACKs as defined in RFC 5681.
+		auto flags = packet.header.flags.load();
+		bool isDuplicate = !packet.payload().size()
+				&& !(flags & TcpHeader::synFlag)
+				&& !(flags & TcpHeader::finFlag)
+				&& localSettledSn_ + window == localWindowSn_
+				&& localHighestSn_ != localSettledSn_;
+		localWindowSn_ = localSettledSn_ + window;
+
+		if(isDuplicate) {
+			++dupAcks_;
+			if(inRecovery_) {
+				congestion_->onDupAck();
+			}else if(dupAcks_ == dupAckThreshold && seqGt(ackSn, recoverSn_)) {
+				// Fast retransmit, then continue in fast recovery.
+				inRecovery_ = true;
+				recoverSn_ = localHighestSn_;
+				congestion_->onEnterRecovery(inFlight_());
+				retransmitPending_ = true;
+				rttTiming_ = false;
 			}
 		}
+		flushEvent_.raise();
+		return;
+	}
+
+	auto now = currentTime();
+	localSettledSn_ = ackSn;
+	localWindowSn_ = localSettledSn_ + window;
+	sendRing_.dequeueAdvance(ackPointer);
+	if(seqLt(localFlushedSn_, localSettledSn_))
+		localFlushedSn_ = localSettledSn_;
+	dupAcks_ = 0;
+
+	sacked_.advance(localSettledSn_);
+
+	if(rttTiming_ && !seqLt(ackSn, rttSn_)) {
+		rttTiming_ = false;
+		rtt_.sample(now - rttStart_);
+	}
+
+	if(inRecovery_) {
+		if(seqLt(ackSn, recoverSn_)) {
+			// Partial ACK, the next hole was lost as well (RFC 6582).
+			congestion_->onPartialAck(ackPointer);
+			retransmitPending_ = true;
+		}else{
+			inRecovery_ = false;
+			congestion_->onExitRecovery();
+		}
+	}else{
+		congestion_->onAck(ackPointer, now, rtt_.srtt());
+	}
+
+	// Restart the retransmission timer for the remaining data (RFC 6298 5.2, 5.3).
+	if(localFlushedSn_ == localSettledSn_) {
+		rtoDeadline_ = 0;
+	}else{
+		rtoDeadline_ = now + rtt_.rto();
 	}
+
+	outSeq_ = ++currentSeq_;
+	settleEvent_.raise();
+	flushEvent_.raise();
+	pollEvent_.raise();
 }
 
 void Tcp4Socket::handleInPacket_(TcpPacket packet) {
@@ -729,7 +1234,24 @@ void Tcp4Socket::handleInPacket_(TcpPacket packet) {
 			return;
 		}
 
+		// Window scaling is only used if both sides send the option.
+		auto &options = packet.options;
+		if(options.windowScale) {
+			sendWindowShift_ = *options.windowScale;
+			recvWindowShift_ = ourWindowShift_;
+		}
+		sackPermitted_ = options.sackPermitted;
+		mss_ = std::min(mss_, uint32_t{options.mss.value_or(defaultRemoteMss)});
+		// Leave room for payload next to SACK options, even if the remote's MSS is tiny.
+		mss_ = std::max(mss_, minMss);
+		congestion_ = makeCongestionControl(congestionAlgorithm, mss_);
+
 		++localSettledSn_;
+		localHighestSn_ = localSettledSn_;
+		recoverSn_ = localSettledSn_;
+		rtoDeadline_ = 0;
+		rtt_.reset();
+		// The window of SYN segments is never scaled.
 		localWindowSn_ = localSettledSn_ + packet.header.window.load();
 		remoteAckedSn_ = packet.header.seqNumber.load();
 		remoteKnownSn_ = packet.header.seqNumber.load() + 1; // SYN counts as one byte.
@@ -737,25 +1259,40 @@ void Tcp4Socket::handleInPacket_(TcpPacket packet) {
 		flushEvent_.raise();
 		settleEvent_.raise();
 	}else if(connectState_ == ConnectState::connected) {
-		if(packet.header.seqNumber.load() == remoteKnownSn_) {
+		auto flags = packet.header.flags.load();
+		auto sn = packet.header.seqNumber.load();
+		auto payload = packet.payload();
+
+		// Strip data that we already received.
+		if(seqLt(sn, remoteKnownSn_)) {
+			size_t duplicate = remoteKnownSn_ - sn;
+			if(duplicate < payload.size()) {
+				payload = payload.subview(duplicate);
+				sn = remoteKnownSn_;
+			}else if(payload.size() || (flags & TcpHeader::synFlag)
+					|| (flags & TcpHeader::finFlag)) {
+				// This is a retransmission, the remote probably missed our ACK.
+				forceAck_ = true;
+				flushEvent_.raise();
+			}
+		}
+
+		if(sn == remoteKnownSn_) {
 			bool gotUpdate = false;
 
-			auto payload = packet.payload();
 			size_t chunk = std::min(payload.size(), recvRing_.spaceForEnqueue());
-			if(chunk) {
-				recvRing_.enqueue(payload.data(), chunk);
-				remoteKnownSn_ += chunk;
-				if(announcedWindow_ < chunk) {
-					announcedWindow_ = 0;
-				}else{
-					announcedWindow_ -= chunk;
-				}
+			if(chunk)
+				enqueueReceived_(payload.data(), chunk);
 
+			// The segment might have filled a hole.
+			bool drained = drainOutOfOrder_();
+
+			if(chunk || drained) {
 				inSeq_ = ++currentSeq_;
 				gotUpdate = true;
 			}
 
-			if(packet.header.flags.load() & TcpHeader::finFlag) {
+			if(chunk == payload.size() && !drained && (flags & TcpHeader::finFlag)) {
 				++remoteKnownSn_; // FIN counts as one byte.
 				remoteClosed_ = true;
 
@@ -768,23 +1305,16 @@ void Tcp4Socket::handleInPacket_(TcpPacket packet) {
 				flushEvent_.raise();
 				pollEvent_.raise();
 			}
-		}
+		}else if(seqGt(sn, remoteKnownSn_) && payload.size()) {
+			queueOutOfOrder_(sn, payload);
 
-		if(packet.header.flags.load() & TcpHeader::ackFlag) {
-			size_t validWindow = localFlushedSn_ - localSettledSn_;
-			size_t ackPointer = packet.header.ackNumber.load() - localSettledSn_;
-			if(ackPointer <= validWindow) {
-				localSettledSn_ += ackPointer;
-				localWindowSn_ = localSettledSn_ + packet.header.window.load();
-				sendRing_.dequeueAdvance(ackPointer);
-				outSeq_ = ++currentSeq_;
-				settleEvent_.raise();
-				pollEvent_.raise();
-			}else{
-				std::cout << "netserver: Rejecting ack-number outside of valid window"
-						<< std::endl;
-			}
+			// Send a duplicate ACK right away so that the remote detects the loss.
+			forceAck_ = true;
+			flushEvent_.raise();
 		}
+
+		if(flags & TcpHeader::ackFlag)
+			handleAck_(packet);
 	}
 }
 
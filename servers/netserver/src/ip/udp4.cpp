@@ -8,6 +8,7 @@
 #include <async/queue.hpp>
 #include <arch/bit.hpp>
 #include <protocols/fs/server.hpp>
+#include <cstddef>
 #include <cstring>
 #include <iomanip>
 #include <random>
@@ -79,7 +80,7 @@ struct Udp {
 		if (payload.size() < header.len) {
 			return false;
 		}
-		if (header.chk != 0) {
+		if (header.chk != 0 && !packet->checksumValid) {
 			PseudoHeader phdr;
 			phdr.src = packet->header.source;
 			phdr.dst = packet->header.destination;
@@ -302,9 +303,18 @@ struct Udp4Socket {
 			.len = header.len
 		};
 		chk.update(&psh, sizeof(psh));
-		chk.update(&header, sizeof(header));
-		chk.update(data, len);
-		header.chk = convert_endian<endian::big>(chk.finalize());
+
+		nic::TxOffload offload;
+		if (ti->link->offloads() & nic::OFFLOAD_TX_CHECKSUM) {
+			// The NIC sums the UDP header and payload on top of the pseudo header.
+			offload.needsChecksum = true;
+			offload.checksumOffset = offsetof(Udp::Header, chk);
+			header.chk = convert_endian<endian::big>(chk.fold());
+		} else {
+			chk.update(&header, sizeof(header));
+			chk.update(data, len);
+			header.chk = convert_endian<endian::big>(chk.finalize());
+		}
 
 		std::cout << "netserver:" << std::endl << std::hex
 			<< std::setw(8) << psh.src << std::endl
@@ -316,7 +326,7 @@ struct Udp4Socket {
 			<< std::setw(8) << header.len << std::endl
 			<< std::setw(8) << header.chk << std::endl << std::dec;
 
-		if (header.chk == 0) {
+		if (!offload.needsChecksum && header.chk == 0) {
 			header.chk = ~header.chk;
 		}
 
@@ -325,7 +335,7 @@ struct Udp4Socket {
 
 		auto error = co_await ip4().sendFrame(std::move(*ti),
 			buf.data(), buf.size(),
-			static_cast<uint16_t>(IpProto::udp));
+			static_cast<uint16_t>(IpProto::udp), offload);
 		if (error != protocols::fs::Error::none) {
 			co_return error;
 		}
@@ -2,12 +2,14 @@
 #include <netserver/nic.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <arch/bit.hpp>
 #include <frg/formatting.hpp>
 #include <frg/logging.hpp>
 #include "ip/ip4.hpp"
 #include "ip/arp.hpp"
+#include "ip/checksum.hpp"
 
 namespace {
 
@@ -42,6 +44,28 @@ MacAddress Link::deviceMac() {
 	return mac_;
 }
 
+async::result<void> Link::send(const arch::dma_buffer_view frame, TxOffload offload) {
+	assert(!offload.segmentSize && "Link does not support segmentation offload");
+	if(offload.needsChecksum) {
+		auto data = reinterpret_cast<uint8_t *>(frame.data());
+		auto field = data + offload.checksumStart + offload.checksumOffset;
+
+		// The field holds the pseudo-header sum, so it is covered by the sum below.
+		Checksum csum;
+		csum.update(frame.subview(offload.checksumStart));
+		auto result = csum.finalize();
+		if(!result)
+			result = 0xFFFF;
+		result = arch::convert_endian<arch::endian::big>(result);
+		std::memcpy(field, &result, sizeof(result));
+	}
+	co_await send(frame);
+}
+
+uint32_t Link::offloads() {
+	return offloads_;
+}
+
 arch::dma_pool *Link::dmaPool() {
 	return dmaPool_;
 }
@@ -85,7 +109,7 @@ async::detached runDevice(std::shared_ptr<nic::Link> dev) {
 	using namespace arch;
 	while(true) {
 		dma_buffer frameBuffer { dev->dmaPool(), 1514 };
-		co_await dev->receive(frameBuffer);
+		auto info = co_await dev->receive(frameBuffer);
 		auto capsule = frameBuffer.subview(14);
 		auto data = reinterpret_cast<uint8_t*>(frameBuffer.data());
 		uint16_t ethertype = data[12] << 8 | data[13];
@@ -95,7 +119,7 @@ async::detached runDevice(std::shared_ptr<nic::Link> dev) {
 		switch (ethertype) {
 		case ETHER_TYPE_IP4:
 			ip4().feedPacket(dstsrc[0], dstsrc[1],
-				std::move(frameBuffer), capsule);
+				std::move(frameBuffer), capsule, info.checksumValid);
 			break;
 		case ETHER_TYPE_ARP:
 			neigh4().feedArp(dstsrc[0], capsule, dev);
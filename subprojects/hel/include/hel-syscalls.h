@@ -72,6 +72,20 @@ extern inline __attribute__ (( always_inline )) HelError helCancelAsync(HelHandl
 	return helSyscall2(kHelCallCancelAsync, (HelWord)handle, (HelWord)async_id);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helAddQueueChunks(HelHandle handle,
+		unsigned int numChunks, HelHandle *memoryHandle) {
+	HelWord handle_word;
+	HelError error = helSyscall2_1(kHelCallAddQueueChunks, (HelWord)handle, (HelWord)numChunks,
+			&handle_word);
+	*memoryHandle = (HelHandle)handle_word;
+	return error;
+};
+
+extern inline __attribute__ (( always_inline )) HelError helQueryQueueStats(HelHandle handle,
+		struct HelQueueStats *stats) {
+	return helSyscall2(kHelCallQueryQueueStats, (HelWord)handle, (HelWord)stats);
+};
+
 extern inline __attribute__ (( always_inline )) HelError helAllocateMemory(size_t size,
 		uint32_t flags, struct HelAllocRestrictions *restrictions, HelHandle *handle) {
 	HelWord hel_handle;
@@ -157,6 +171,15 @@ extern inline __attribute__ (( always_inline )) HelError helCreateSpace(HelHandl
 	return error;
 };
 
+extern inline __attribute__ (( always_inline )) HelError helForkSpace(struct HelForkArea *areas,
+		size_t numAreas, HelHandle *handle) {
+	HelWord handle_word;
+	HelError error = helSyscall3_1(kHelCallForkSpace, (HelWord)areas, (HelWord)numAreas,
+			(HelWord)*handle, &handle_word);
+	*handle = (HelHandle)handle_word;
+	return error;
+};
+
 extern inline __attribute__ (( always_inline )) HelError helCreateVirtualizedSpace(HelHandle *handle) {
 	HelWord handle_word;
 	HelError error = helSyscall0_1(kHelCallCreateVirtualizedSpace, &handle_word);
@@ -361,6 +384,16 @@ extern inline __attribute__ (( always_inline )) HelError helSubmitAwaitClock(uin
 	return error;
 };
 
+extern inline __attribute__ (( always_inline )) HelError helSubmitAwaitClockWithSlack(
+		uint64_t counter, uint64_t slack, HelHandle queue, uintptr_t context,
+		uint64_t *async_id) {
+	HelWord async_word;
+	HelError error = helSyscall4_1(kHelCallSubmitAwaitClockWithSlack, (HelWord)counter,
+			(HelWord)slack, (HelWord)queue, (HelWord)context, &async_word);
+	*async_id = (uint64_t)async_word;
+	return error;
+};
+
 extern inline __attribute__ (( always_inline )) HelError helCreateStream(HelHandle *lane1,
 		HelHandle *lane2) {
 	HelWord out_lane1;
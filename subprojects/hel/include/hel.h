@@ -18,7 +18,7 @@
 
 enum {
 	// largest system call number plus 1
-	kHelNumCalls = 104,
+	kHelNumCalls = 108,
 
 	kHelCallLog = 1,
 	kHelCallPanic = 10,
@@ -34,6 +34,8 @@ enum {
 
 	kHelCallCreateQueue = 89,
 	kHelCallCancelAsync = 92,
+	kHelCallAddQueueChunks = 105,
+	kHelCallQueryQueueStats = 106,
 
 	kHelCallAllocateMemory = 51,
 	kHelCallResizeMemory = 83,
@@ -43,6 +45,7 @@ enum {
 	kHelCallCreateSliceView = 88,
 	kHelCallForkMemory = 40,
 	kHelCallCreateSpace = 27,
+	kHelCallForkSpace = 104,
 	kHelCallCreateIndirectMemory = 45,
 	kHelCallAlterMemoryIndirection = 52,
 	kHelCallMapMemory = 44,
@@ -73,6 +76,7 @@ enum {
 	kHelCallWriteFsBase = 41,
 	kHelCallGetClock = 42,
 	kHelCallSubmitAwaitClock = 80,
+	kHelCallSubmitAwaitClockWithSlack = 107,
 	kHelCallCreateVirtualizedCpu = 37,
 	kHelCallRunVirtualizedCpu = 38,
 	kHelCallGetRandomBytes = 101,
@@ -209,6 +213,11 @@ enum {
 	kHelItemWantLane = (1 << 16),
 };
 
+//! Scatter-gather item of a kHelActionSendFromBufferSg action.
+//! For such actions, HelAction::buffer points to an array of HelSgItem
+//! and HelAction::length is the number of items in that array.
+//! The kernel reads the array (and the buffers that it refers to) lazily while the
+//! transfer progresses; both must remain valid until the action completes.
 struct HelSgItem {
 	void *buffer;
 	size_t length;
@@ -252,7 +261,32 @@ enum HelMapFlags {
 	kHelMapProtExecute = 1024,
 	kHelMapDontRequireBacking = 128,
 	kHelMapFixed = 2048,
-	kHelMapFixedNoReplace = 4096
+	kHelMapFixedNoReplace = 4096,
+	// Do not map resident neighbours of faulting pages (e.g., for random access patterns).
+	kHelMapNoFaultAround = 8192
+};
+
+enum HelForkAreaFlags {
+	kHelForkAreaCopyOnWrite = 1
+};
+
+//! Maximum number of areas that a single ::helForkSpace call accepts.
+static const size_t kHelMaxForkAreas = 4096;
+
+struct HelForkArea {
+	//! Handle to the memory object that is mapped.
+	//! If kHelForkAreaCopyOnWrite is set, it must refer to a memory object
+	//! created by ::helCopyOnWrite and it is forked before it is mapped.
+	HelHandle memory;
+	uint32_t flags;
+	//! HelMapFlags. The area is always mapped at @p pointer.
+	uint32_t mapFlags;
+	void *pointer;
+	uintptr_t offset;
+	size_t size;
+	//! Set by the kernel: handle to the forked memory object
+	//! (or kHelNullHandle if kHelForkAreaCopyOnWrite is not set).
+	HelHandle forkedMemory;
 };
 
 enum HelThreadFlags {
@@ -395,6 +429,21 @@ struct HelQueueParameters {
 	size_t chunkSize;
 };
 
+//! Statistics of an IPC queue, see ::helQueryQueueStats.
+struct HelQueueStats {
+	//! Number of elements that were written to the queue.
+	uint64_t numElements;
+	//! Number of times that the progress of a chunk was published.
+	//! Elements that become available at the same time are published together.
+	uint64_t numBatches;
+	//! Number of futex wakes that were issued to user-space.
+	uint64_t numWakes;
+	//! Number of times that elements were pending but no chunk was available.
+	uint64_t numStalls;
+	//! Number of chunks of the queue.
+	uint64_t numChunks;
+};
+
 //! Mask to extract the current queue head.
 static const int kHelHeadMask = 0xFFFFFF;
 
@@ -607,6 +656,27 @@ HEL_C_LINKAGE HelError helCreateQueue(struct HelQueueParameters *params,
 //!    	ID identifying the operation.
 HEL_C_LINKAGE HelError helCancelAsync(HelHandle queueHandle, uint64_t asyncId);
 
+//! Adds chunks to an IPC queue.
+//!
+//! The new chunks are numbered consecutively after the existing ones.
+//! They are stored in a separate memory object that contains
+//! the chunks at the same stride as the queue's own memory.
+//! @param[in] queueHandle
+//!    	Handle to the queue.
+//! @param[in] numChunks
+//!    	Number of chunks to add.
+//! @param[out] memoryHandle
+//!    	Handle to the memory object that contains the new chunks.
+HEL_C_LINKAGE HelError helAddQueueChunks(HelHandle queueHandle, unsigned int numChunks,
+		HelHandle *memoryHandle);
+
+//! Retrieves statistics of an IPC queue.
+//! @param[in] queueHandle
+//!    	Handle to the queue.
+//! @param[out] stats
+//!    	Pointer to a struct that is filled with the statistics.
+HEL_C_LINKAGE HelError helQueryQueueStats(HelHandle queueHandle, struct HelQueueStats *stats);
+
 //! @}
 //! @name Memory Management
 //! @{
@@ -704,6 +774,24 @@ HEL_C_LINKAGE HelError helForkMemory(HelHandle handle, HelHandle *forkedHandle);
 //!     Handle to the new address space.
 HEL_C_LINKAGE HelError helCreateSpace(HelHandle *handle);
 
+//! Creates a virtual address space and populates it with a set of mappings.
+//!
+//! This is equivalent to ::helCreateSpace followed by ::helForkMemory
+//! and ::helMapMemory for each area, but requires only a single system call.
+//! Callers with more than ::kHelMaxForkAreas areas can pass the returned
+//! space back in to add further batches of areas.
+//! @param[in,out] areas
+//!     Array of areas that are mapped into the address space.
+//!     On success, the @p forkedMemory fields are filled in by the kernel.
+//! @param[in] numAreas
+//!     Number of elements in @p areas. At most ::kHelMaxForkAreas.
+//! @param[in,out] handle
+//!     If this is @p kHelNullHandle, a new address space is created and its
+//!     handle is returned. Otherwise, the areas are mapped into the given
+//!     address space; if the call fails, areas that were mapped remain mapped.
+HEL_C_LINKAGE HelError helForkSpace(struct HelForkArea *areas, size_t numAreas,
+		HelHandle *handle);
+
 //! Maps memory objects into an address space.
 //! @param[in] memoryHandle
 //!     Handle to the memory object.
@@ -950,6 +1038,21 @@ HEL_C_LINKAGE HelError helGetClock(uint64_t *counter);
 HEL_C_LINKAGE HelError helSubmitAwaitClock(uint64_t counter,
 		HelHandle queue, uintptr_t context, uint64_t *asyncId);
 
+//! Wait until time passes, allowing the kernel to delay the completion.
+//!
+//! Like ::helSubmitAwaitClock but the operation may complete up to
+//! @p slack nanoseconds after the deadline. The kernel uses this to serve
+//! nearby deadlines by a single timer interrupt.
+//! This is an asynchronous operation.
+//! @param[in] counter
+//!     Deadline (absolute, see ::helGetClock).
+//! @param[in] slack
+//!     Maximal delay (in nanoseconds) after the deadline.
+//! @param[out] asyncId
+//!     ID to identify the asynchronous operation (absolute, see ::helCancelAsync).
+HEL_C_LINKAGE HelError helSubmitAwaitClockWithSlack(uint64_t counter, uint64_t slack,
+		HelHandle queue, uintptr_t context, uint64_t *asyncId);
+
 HEL_C_LINKAGE HelError helCreateVirtualizedCpu(HelHandle handle, HelHandle *out_handle);
 
 HEL_C_LINKAGE HelError helRunVirtualizedCpu(HelHandle handle, struct HelVmexitReason *reason);
@@ -994,6 +1097,10 @@ HEL_C_LINKAGE HelError helCreateStream(HelHandle *lane1, HelHandle *lane2);
 //!     Pointer to array of message items.
 //! @param[in] count
 //!     Number of elements in @p actions.
+//!
+//! Buffers referenced by send actions are generally read after this call returns.
+//! In particular, the scatter-gather list of a kHelActionSendFromBufferSg action
+//! is only read lazily; it must stay valid until the action completes.
 HEL_C_LINKAGE HelError helSubmitAsync(HelHandle handle, const struct HelAction *actions,
 		size_t count, HelHandle queue, uintptr_t context, uint32_t flags);
 
@@ -1,13 +1,19 @@
 #pragma once
 
 #include <assert.h>
+#include <algorithm>
 #include <atomic>
+#include <deque>
 #include <initializer_list>
 #include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <tuple>
 #include <array>
 #include <stdexcept>
 
+#include <async/basic.hpp>
 #include <async/oneshot-event.hpp>
 
 // This is here since ipc-structs.hpp needs ElementHandle
@@ -146,6 +152,12 @@ struct Context {
 	virtual ~Context() = default;
 
 	virtual void complete(ElementHandle element) = 0;
+
+	// Completions of pinned contexts are never stolen by other workers of a DispatcherPool,
+	// i.e., they always run on the thread that owns the queue.
+	virtual bool pinned() {
+		return false;
+	}
 };
 
 struct CurrentDispatcherToken {
@@ -154,42 +166,53 @@ struct CurrentDispatcherToken {
 
 inline constexpr CurrentDispatcherToken currentDispatcher;
 
+struct DispatcherPool;
+
 struct Dispatcher {
 	friend struct ElementHandle;
-
-private:
-	struct Item {
-		Item(HelQueue *queue)
-		: queue(queue), progress(0) { }
-
-		Item(const Item &other) = delete;
-
-		Item &operator= (const Item &other) = delete;
-
-		HelQueue *queue;
-
-		size_t progress;
-	};
+	friend struct DispatcherPool;
 
 public:
 	static constexpr int sizeShift = 9;
+	static constexpr unsigned int maxChunks = 64;
+
+	// Chunks beyond numChunks are added when the kernel runs out of chunks,
+	// up to maxNumChunks. Chunks that are not needed anymore are taken out of rotation.
+	struct Parameters {
+		unsigned int numChunks = 16;
+		unsigned int maxNumChunks = maxChunks;
+		size_t chunkSize = 4096;
+	};
+
+	// After this many chunks were consumed without running out of chunks,
+	// one chunk is taken out of rotation.
+	static constexpr int shrinkInterval = 1024;
 
 	static Dispatcher &global();
 
 	Dispatcher()
 	: _handle{kHelNullHandle}, _queue{nullptr},
-			_activeChunks{0}, _retrieveIndex{0}, _nextIndex{0}, _lastProgress{0} { }
+			_activeChunks{0}, _hadWaiters{false},
+			_retrieveIndex{0}, _nextIndex{0}, _lastProgress{0} { }
 
 	Dispatcher(const Dispatcher &) = delete;
 
 	Dispatcher &operator= (const Dispatcher &) = delete;
 
+	// Changes the queue parameters. Must be called before the queue is created.
+	void configure(Parameters params) {
+		assert(!_handle);
+		assert(params.numChunks > 0 && params.numChunks <= params.maxNumChunks);
+		assert(params.maxNumChunks <= maxChunks);
+		_params = params;
+	}
+
 	HelHandle acquire() {
 		if(!_handle) {
 			HelQueueParameters params {
 				.ringShift = sizeShift,
-				.numChunks = 16,
-				.chunkSize = 4096
+				.numChunks = _params.numChunks,
+				.chunkSize = _params.chunkSize
 			};
 			HEL_CHECK(helCreateQueue(&params, &_handle));
 
@@ -204,47 +227,52 @@ public:
 
 			_queue = reinterpret_cast<HelQueue *>(mapping);
 			auto chunksPtr = reinterpret_cast<std::byte *>(mapping) + chunksOffset;
-			for(unsigned int i = 0; i < 16; ++i)
+			for(unsigned int i = 0; i < params.numChunks; ++i)
 				_chunks[i] = reinterpret_cast<HelChunk *>(chunksPtr + i * reservedPerChunk);
+			_numChunks = params.numChunks;
+			_targetChunks = params.numChunks;
 		}
 
 		return _handle;
 	}
 
-	void wait() {
-		while(true) {
-			// TODO: Initialize all chunks when setting up the queue.
-			if(_retrieveIndex == _nextIndex) {
-				assert(_activeChunks < 16);
-
-				// Reset and enqueue the new chunk.
-				_chunks[_activeChunks]->progressFutex = 0;
-
-				_queue->indexQueue[_nextIndex & ((1 << sizeShift) - 1)] = _activeChunks;
-				_nextIndex = ((_nextIndex + 1) & kHelHeadMask);
-				_wakeHeadFutex();
-
-				_refCounts[_activeChunks] = 1;
-				_activeChunks++;
-				continue;
-			}else if (_hadWaiters && _activeChunks < (1 << sizeShift)) {
-				assert(_activeChunks < 16);
-
-				// Reset and enqueue the new chunk.
-				_chunks[_activeChunks]->progressFutex = 0;
+	void wait();
 
-				_queue->indexQueue[_nextIndex & ((1 << sizeShift) - 1)] = _activeChunks;
-				_nextIndex = ((_nextIndex + 1) & kHelHeadMask);
-				_wakeHeadFutex();
+private:
+	struct ReadyElement {
+		Context *context;
+		ElementHandle handle;
+	};
 
-				_refCounts[_activeChunks] = 1;
-				_activeChunks++;
-				_hadWaiters = false;
+	// Retrieves the next element from our own queue.
+	// If block is false, returns false instead of blocking.
+	bool _retrieve(bool block, ReadyElement &ready) {
+		while(true) {
+			{
+				std::lock_guard lock{_requeueMutex};
+
+				// TODO: Initialize all chunks when setting up the queue.
+				if(_retrieveIndex == _nextIndex) {
+					bool success = _activateChunk();
+					assert(success);
+					continue;
+				}else if (_hadWaiters && _activateChunk()) {
+					_hadWaiters = false;
+				}
 			}
 
 			bool done;
-			_waitProgressFutex(&done);
+			if(!_waitProgressFutex(block, &done))
+				return false;
 			if(done) {
+				{
+					std::lock_guard lock{_requeueMutex};
+					if(++_chunksSinceStall == shrinkInterval) {
+						if(_targetChunks > static_cast<int>(_params.numChunks))
+							_targetChunks--;
+						_chunksSinceStall = 0;
+					}
+				}
 				_surrender(_numberOf(_retrieveIndex));
 
 				_lastProgress = 0;
@@ -257,32 +285,92 @@ public:
 			auto element = reinterpret_cast<HelElement *>(ptr);
 			_lastProgress += sizeof(HelElement) + element->length;
 
-			auto context = reinterpret_cast<Context *>(element->context);
-			_refCounts[_numberOf(_retrieveIndex)]++;
-			context->complete(ElementHandle{this, _numberOf(_retrieveIndex),
-					ptr + sizeof(HelElement)});
-			return;
+			ready.context = reinterpret_cast<Context *>(element->context);
+			_reference(_numberOf(_retrieveIndex));
+			ready.handle = ElementHandle{this, _numberOf(_retrieveIndex),
+					ptr + sizeof(HelElement)};
+			return true;
 		}
 	}
 
-private:
+	// Chunks may be surrendered from other threads if completions were stolen.
 	void _surrender(int cn) {
-		assert(_refCounts[cn] > 0);
-		if(_refCounts[cn]-- > 1)
+		auto count = _refCounts[cn].fetch_sub(1, std::memory_order_acq_rel);
+		assert(count > 0);
+		if(count > 1)
+			return;
+
+		std::lock_guard lock{_requeueMutex};
+		if(_inRotation > _targetChunks) {
+			_parkedChunks[_numParked++] = cn;
+			_inRotation--;
 			return;
+		}
+		_enqueueChunk(cn);
+	}
+
+	// Puts another chunk into rotation, adding chunks to the queue if necessary.
+	// Must be called with _requeueMutex held.
+	bool _activateChunk() {
+		int cn;
+		if(_numParked) {
+			cn = _parkedChunks[--_numParked];
+		}else if(_activeChunks < _numChunks) {
+			cn = _activeChunks++;
+		}else if(_grow()) {
+			cn = _activeChunks++;
+		}else{
+			return false;
+		}
+
+		_enqueueChunk(cn);
+		_inRotation++;
+		_targetChunks = std::max(_targetChunks, _inRotation);
+		_chunksSinceStall = 0;
+		return true;
+	}
+
+	// Must be called with _requeueMutex held.
+	bool _grow() {
+		if(_numChunks >= static_cast<int>(_params.maxNumChunks))
+			return false;
+		unsigned int n = std::min(static_cast<unsigned int>(_numChunks),
+				_params.maxNumChunks - _numChunks);
+
+		HelHandle memory;
+		if(helAddQueueChunks(_handle, n, &memory) != kHelErrNone) {
+			// Do not retry on every wait().
+			_params.maxNumChunks = _numChunks;
+			return false;
+		}
+
+		auto reservedPerChunk = (sizeof(HelChunk) + _params.chunkSize + 63) & ~size_t(63);
+		void *mapping;
+		HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
+				0, (n * reservedPerChunk + 0xFFF) & ~size_t(0xFFF),
+				kHelMapProtRead | kHelMapProtWrite, &mapping));
+		HEL_CHECK(helCloseDescriptor(kHelThisUniverse, memory));
 
-		// Reset and requeue the chunk.
+		auto chunksPtr = reinterpret_cast<std::byte *>(mapping);
+		for(unsigned int i = 0; i < n; ++i)
+			_chunks[_numChunks + i] = reinterpret_cast<HelChunk *>(chunksPtr + i * reservedPerChunk);
+		_numChunks += n;
+		return true;
+	}
+
+	void _reference(int cn) {
+		_refCounts[cn].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Resets and (re)queues a chunk. Must be called with _requeueMutex held.
+	void _enqueueChunk(int cn) {
 		_chunks[cn]->progressFutex = 0;
 
 		_queue->indexQueue[_nextIndex & ((1 << sizeShift) - 1)] = cn;
 		_nextIndex = ((_nextIndex + 1) & kHelHeadMask);
 		_wakeHeadFutex();
 
-		_refCounts[cn] = 1;
-	}
-
-	void _reference(int cn) {
-		_refCounts[cn]++;
+		_refCounts[cn].store(1, std::memory_order_relaxed);
 	}
 
 private:
@@ -303,19 +391,22 @@ private:
 		}
 	}
 
-	void _waitProgressFutex(bool *done) {
+	bool _waitProgressFutex(bool block, bool *done) {
 		while(true) {
 			auto futex = __atomic_load_n(&_retrieveChunk()->progressFutex, __ATOMIC_ACQUIRE);
 			assert(!(futex & ~(kHelProgressMask | kHelProgressWaiters | kHelProgressDone)));
 			do {
 				if(_lastProgress != (futex & kHelProgressMask)) {
 					*done = false;
-					return;
+					return true;
 				}else if(futex & kHelProgressDone) {
 					*done = true;
-					return;
+					return true;
 				}
 
+				if(!block)
+					return false;
+
 				if(futex & kHelProgressWaiters)
 					break; // Waiters bit is already set (in a previous iteration).
 			} while(!__atomic_compare_exchange_n(&_retrieveChunk()->progressFutex, &futex,
@@ -330,10 +421,23 @@ private:
 private:
 	HelHandle _handle;
 	HelQueue *_queue;
-	HelChunk *_chunks[16];
-
+	Parameters _params;
+	HelChunk *_chunks[maxChunks];
+
+	// Protects the fields that are needed to (re)queue chunks.
+	std::mutex _requeueMutex;
+	// Number of chunks that the kernel knows about.
+	int _numChunks = 0;
+	// Chunks [0, _activeChunks) were put into rotation at some point.
 	int _activeChunks;
 	bool _hadWaiters;
+	// Number of chunks in rotation and the number that we aim for.
+	int _inRotation = 0;
+	int _targetChunks = 0;
+	int _chunksSinceStall = 0;
+	// Chunks that were taken out of rotation.
+	int _parkedChunks[maxChunks];
+	int _numParked = 0;
 
 	// Index of the chunk that we are currently retrieving/inserting next.
 	int _retrieveIndex;
@@ -343,9 +447,172 @@ private:
 	int _lastProgress;
 
 	// Per-chunk reference counts.
-	int _refCounts[16];
+	std::atomic<int> _refCounts[maxChunks];
+
+	// The following fields are only used if the dispatcher belongs to a pool.
+	DispatcherPool *_pool = nullptr;
+	// Completions that were retrieved from our queue but did not run yet.
+	// Protected by _readyMutex.
+	std::mutex _readyMutex;
+	std::deque<ReadyElement> _ready;
+	// True while the dispatcher is blocked on its queue.
+	std::atomic<bool> _idle{false};
+};
+
+// Runs one dispatcher (and thus one HelQueue) per worker thread.
+// Each worker first drains its own queue. If stealing is enabled, idle workers take
+// completions that are ready but did not run yet from other workers.
+// Stealing is opt-in: coroutines routinely assume that they keep running on the
+// thread that submitted their operations. With stealing, all code that runs on the pool
+// must be thread-safe; use pinned contexts (e.g., scheduleOn()) to resume coroutines
+// on a specific worker.
+struct DispatcherPool {
+	struct Options {
+		size_t numWorkers = 1;
+		Dispatcher::Parameters parameters{};
+		bool stealing = false;
+	};
+
+	DispatcherPool(Options options)
+	: _options{options}, _workers(options.numWorkers) {
+		assert(options.numWorkers > 0);
+	}
+
+	DispatcherPool(const DispatcherPool &) = delete;
+
+	DispatcherPool &operator= (const DispatcherPool &) = delete;
+
+	// Spawns the worker threads. The calling thread becomes worker 0;
+	// it needs to call async::run_forever(helix::currentDispatcher) itself.
+	void start() {
+		_attach(0);
+		for(size_t i = 1; i < _workers.size(); i++) {
+			// Dispatchers are set up before any other worker can steal from them.
+			std::atomic<bool> ready{false};
+			std::thread{[this, i, &ready] {
+				_attach(i);
+				ready.store(true, std::memory_order_release);
+				ready.notify_one();
+
+				async::run_forever(currentDispatcher);
+			}}.detach();
+			ready.wait(false, std::memory_order_acquire);
+		}
+	}
+
+	size_t numWorkers() {
+		return _workers.size();
+	}
+
+	Dispatcher &worker(size_t i) {
+		assert(_workers[i]);
+		return *_workers[i];
+	}
+
+private:
+	friend struct Dispatcher;
+
+	struct WakeContext final : Context {
+		void complete(ElementHandle) override { }
+
+		bool pinned() override {
+			return true;
+		}
+	};
+
+	void _attach(size_t i) {
+		auto dispatcher = &Dispatcher::global();
+		dispatcher->configure(_options.parameters);
+		dispatcher->acquire();
+		dispatcher->_pool = this;
+		_workers[i] = dispatcher;
+	}
+
+	// Takes a stealable completion from the back of another worker's ready list.
+	bool _steal(Dispatcher *thief, Dispatcher::ReadyElement &ready) {
+		if(!_options.stealing)
+			return false;
+
+		for(auto victim : _workers) {
+			if(victim == thief)
+				continue;
+			std::lock_guard lock{victim->_readyMutex};
+			for(auto it = victim->_ready.rbegin(); it != victim->_ready.rend(); ++it) {
+				if(it->context->pinned())
+					continue;
+				ready = std::move(*it);
+				victim->_ready.erase(std::next(it).base());
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Wakes up one idle worker such that it can steal from us.
+	void _kick(Dispatcher *self) {
+		if(!_options.stealing)
+			return;
+
+		for(auto other : _workers) {
+			if(other == self)
+				continue;
+			if(!other->_idle.exchange(false, std::memory_order_acq_rel))
+				continue;
+			HEL_CHECK(helSubmitAsyncNop(other->_handle,
+					reinterpret_cast<uintptr_t>(static_cast<Context *>(&_wakeContext))));
+			return;
+		}
+	}
+
+	Options _options;
+	std::vector<Dispatcher *> _workers;
+	WakeContext _wakeContext;
 };
 
+inline void Dispatcher::wait() {
+	ReadyElement ready;
+
+	if(!_pool) {
+		_retrieve(true, ready);
+		ready.context->complete(std::move(ready.handle));
+		return;
+	}
+
+	// Move everything that arrived on our queue to the ready list
+	// such that other workers can steal it while we run the first completion.
+	size_t backlog;
+	{
+		ReadyElement next;
+		while(_retrieve(false, next)) {
+			std::lock_guard lock{_readyMutex};
+			_ready.push_back(std::move(next));
+		}
+
+		std::lock_guard lock{_readyMutex};
+		backlog = _ready.size();
+		if(backlog) {
+			ready = std::move(_ready.front());
+			_ready.pop_front();
+		}
+	}
+	if(backlog) {
+		if(backlog > 1)
+			_pool->_kick(this);
+		ready.context->complete(std::move(ready.handle));
+		return;
+	}
+
+	if(_pool->_steal(this, ready)) {
+		ready.context->complete(std::move(ready.handle));
+		return;
+	}
+
+	_idle.store(true, std::memory_order_release);
+	_retrieve(true, ready);
+	_idle.store(false, std::memory_order_relaxed);
+	ready.context->complete(std::move(ready.handle));
+}
+
 inline void CurrentDispatcherToken::wait() {
 	Dispatcher::global().wait();
 }
@@ -670,6 +937,15 @@ struct Submission : private Context {
 		operation->setAsyncId(async_id);
 	}
 
+	Submission(AwaitClock *operation,
+			uint64_t counter, uint64_t slack, Dispatcher &dispatcher)
+	: _result(operation) {
+		uint64_t async_id;
+		HEL_CHECK(helSubmitAwaitClockWithSlack(counter, slack, dispatcher.acquire(),
+				reinterpret_cast<uintptr_t>(context()), &async_id));
+		operation->setAsyncId(async_id);
+	}
+
 	Submission(BorrowedDescriptor space, ProtectMemory *operation,
 			void *pointer, size_t length, uint32_t flags,
 			Dispatcher &dispatcher)
@@ -865,6 +1141,12 @@ inline Submission submitAwaitClock(AwaitClock *operation, uint64_t counter,
 	return {operation, counter, dispatcher};
 }
 
+// The operation may complete up to slack nanoseconds after the deadline.
+inline Submission submitAwaitClock(AwaitClock *operation, uint64_t counter, uint64_t slack,
+		Dispatcher &dispatcher) {
+	return {operation, counter, slack, dispatcher};
+}
+
 inline Submission submitProtectMemory(BorrowedDescriptor memory, ProtectMemory *operation,
 		void *pointer, size_t length, uint32_t flags,
 		Dispatcher &dispatcher) {
@@ -1023,6 +1305,63 @@ inline auto asyncNop() {
 
 // --------------------------------------------------------------------
 
+// Resumes the awaiting coroutine on the thread that owns the given dispatcher.
+template <typename Receiver>
+struct ScheduleOperation : private Context {
+	ScheduleOperation(Dispatcher *dispatcher, Receiver receiver)
+	: dispatcher_{dispatcher}, receiver_{std::move(receiver)} { }
+
+	ScheduleOperation(const ScheduleOperation &) = delete;
+
+	ScheduleOperation &operator= (const ScheduleOperation &) = delete;
+
+	bool start_inline() {
+		if(&Dispatcher::global() == dispatcher_) {
+			async::execution::set_value_inline(receiver_);
+			return true;
+		}
+
+		auto context = static_cast<Context *>(this);
+		HEL_CHECK(helSubmitAsyncNop(dispatcher_->acquire(),
+				reinterpret_cast<uintptr_t>(context)));
+		return false;
+	}
+
+private:
+	void complete(ElementHandle) override {
+		async::execution::set_value_noinline(receiver_);
+	}
+
+	bool pinned() override {
+		return true;
+	}
+
+	Dispatcher *dispatcher_;
+	Receiver receiver_;
+};
+
+struct [[nodiscard]] ScheduleSender {
+	using value_type = void;
+
+	template<typename Receiver>
+	ScheduleOperation<Receiver> connect(Receiver receiver) {
+		return {dispatcher, std::move(receiver)};
+	}
+
+	Dispatcher *dispatcher;
+};
+
+inline async::sender_awaiter<ScheduleSender, void>
+operator co_await (ScheduleSender sender) {
+	return {std::move(sender)};
+}
+
+inline ScheduleSender scheduleOn(Dispatcher &dispatcher) {
+	return {&dispatcher};
+}
+
+// --------------------------------------------------------------------
+
 struct SynchronizeSpaceResult {
 	HelError error() {
 		assert(valid_);
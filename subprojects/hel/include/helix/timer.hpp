@@ -30,14 +30,17 @@ private:
 		uint64_t tick;
 		HEL_CHECK(helGetClock(&tick));
 
+		// Async IDs are local to the queue. On a DispatcherPool with stealing,
+		// cancellation can be requested from a different thread.
+		auto &dispatcher = helix::Dispatcher::global();
 		helix::AwaitClock await;
 		auto &&submit = helix::submitAwaitClock(&await, tick + duration,
-				helix::Dispatcher::global());
+				dispatcher);
 		auto async_id = await.asyncId();
 
 		{
 			async::cancellation_callback cb{_cancelTimer, [&] {
-				HEL_CHECK(helCancelAsync(helix::Dispatcher::global().acquire(),
+				HEL_CHECK(helCancelAsync(dispatcher.acquire(),
 						async_id));
 			}};
 			co_await submit.async_wait();
@@ -77,12 +80,12 @@ private:
 	TimeoutCallback<Functor> _tb;
 };
 
-inline async::result<void> sleepFor(uint64_t duration) {
+inline async::result<void> sleepFor(uint64_t duration, uint64_t slack = 0) {
 	uint64_t tick;
 	HEL_CHECK(helGetClock(&tick));
 
 	helix::AwaitClock await;
-	auto &&submit = helix::submitAwaitClock(&await, tick + duration,
+	auto &&submit = helix::submitAwaitClock(&await, tick + duration, slack,
 			helix::Dispatcher::global());
 	co_await submit.async_wait();
 	HEL_CHECK(await.error());
@@ -99,7 +102,7 @@ async::result<bool> kindaBusyWait(uint64_t timeoutNs, F cond) {
 			co_return true;
 
 		// Sleep for 5ms (TODO: make adaptive?)
-		co_await sleepFor(5'000'000);
+		co_await sleepFor(5'000'000, 1'000'000);
 
 		HEL_CHECK(helGetClock(&currNs));
 	} while (currNs < startNs + timeoutNs);
@@ -0,0 +1,139 @@
+#include <atomic>
+#include <cassert>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <helix/ipc.hpp>
+#include <helix/memory.hpp>
+#include <protocols/fs/client.hpp>
+
+#include "testsuite.hpp"
+
+namespace {
+
+constexpr size_t pageSize = 0x1000;
+constexpr size_t maxPages = 64;
+
+uint8_t pattern(size_t offset) {
+	return (offset / pageSize) * 31 + offset;
+}
+
+// Plays the role of the file system: owns the page cache and its CacheHeader.
+// The publishing order mirrors libblockfs' setFileSize() and truncate().
+struct FakeFile {
+	FakeFile(size_t initialSize) {
+		HelHandle handle;
+		HEL_CHECK(helAllocateMemory(maxPages * pageSize, 0, nullptr, &handle));
+		memory = helix::UniqueDescriptor{handle};
+		HEL_CHECK(helAllocateMemory(pageSize, 0, nullptr, &handle));
+		headerMemory = helix::UniqueDescriptor{handle};
+
+		headerMapping = helix::Mapping{headerMemory, 0, pageSize,
+				kHelMapProtRead | kHelMapProtWrite};
+		header = new (headerMapping.get()) protocols::fs::CacheHeader{};
+
+		helix::Mapping mapping{memory, 0, maxPages * pageSize,
+				kHelMapProtRead | kHelMapProtWrite};
+		auto p = reinterpret_cast<uint8_t *>(mapping.get());
+		for(size_t i = 0; i < maxPages * pageSize; i++)
+			p[i] = pattern(i);
+		size = maxPages * pageSize;
+		publishSize(size);
+
+		truncate(initialSize);
+	}
+
+	void publishSize(size_t newSize) {
+		header->seq.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		header->fileSize.store(newSize, std::memory_order_relaxed);
+		header->seq.fetch_add(1, std::memory_order_release);
+	}
+
+	void truncate(size_t newSize) {
+		auto oldMapSize = (size + pageSize - 1) & ~(pageSize - 1);
+		auto newMapSize = (newSize + pageSize - 1) & ~(pageSize - 1);
+
+		if(newSize < size) {
+			publishSize(newSize);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			while(header->readers.load(std::memory_order_acquire))
+				std::this_thread::yield();
+			HEL_CHECK(helResizeMemory(memory.getHandle(), newMapSize));
+		}else{
+			HEL_CHECK(helResizeMemory(memory.getHandle(), newMapSize));
+			if(newMapSize > oldMapSize) {
+				helix::Mapping mapping{memory, 0, newMapSize,
+						kHelMapProtRead | kHelMapProtWrite};
+				auto p = reinterpret_cast<uint8_t *>(mapping.get());
+				for(size_t i = oldMapSize; i < newMapSize; i++)
+					p[i] = pattern(i);
+			}
+			publishSize(newSize);
+		}
+		size = newSize;
+	}
+
+	protocols::fs::CachedReader makeReader() {
+		return protocols::fs::CachedReader{memory.dup(), headerMemory.dup()};
+	}
+
+	helix::UniqueDescriptor memory;
+	helix::UniqueDescriptor headerMemory;
+	helix::Mapping headerMapping;
+	protocols::fs::CacheHeader *header;
+	size_t size = 0;
+};
+
+} // anonymous namespace
+
+DEFINE_TEST(cached_reader_eof, ([] {
+	FakeFile file{3 * pageSize + 100};
+	auto reader = file.makeReader();
+
+	uint8_t buffer[256];
+	auto result = reader.pread(3 * pageSize, buffer, sizeof(buffer));
+	assert(result && *result == 100);
+	for(size_t i = 0; i < 100; i++)
+		assert(buffer[i] == pattern(3 * pageSize + i));
+
+	result = reader.pread(3 * pageSize + 100, buffer, sizeof(buffer));
+	assert(result && !*result);
+	result = reader.pread(maxPages * pageSize, buffer, sizeof(buffer));
+	assert(result && !*result);
+}))
+
+// Reads must never fault and must never return bytes past the size
+// that was current while they ran, even if the file shrinks concurrently.
+DEFINE_TEST(cached_reader_truncate, ([] {
+	FakeFile file{maxPages * pageSize};
+	auto reader = file.makeReader();
+
+	std::atomic<bool> stop{false};
+	std::thread truncator{[&] {
+		std::mt19937 rng{1};
+		while(!stop.load(std::memory_order_relaxed))
+			file.truncate(rng() % (maxPages * pageSize + 1));
+	}};
+
+	std::mt19937 rng{2};
+	std::vector<uint8_t> buffer(4 * pageSize);
+	for(int i = 0; i < 100000; i++) {
+		auto offset = rng() % (maxPages * pageSize);
+		auto length = rng() % buffer.size() + 1;
+		auto result = reader.pread(offset, buffer.data(), length);
+		// The size changed while we were copying; a real client would retry.
+		if(!result)
+			continue;
+
+		assert(*result <= length);
+		assert(offset + *result <= maxPages * pageSize);
+		for(size_t j = 0; j < *result; j++)
+			assert(buffer[j] == pattern(offset + j));
+	}
+
+	stop.store(true, std::memory_order_relaxed);
+	truncator.join();
+}))
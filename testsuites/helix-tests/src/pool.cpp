@@ -0,0 +1,137 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+#include <async/result.hpp>
+#include <helix/ipc.hpp>
+
+#include "testsuite.hpp"
+
+namespace {
+
+// Starts a pool on a new thread and calls f(pool) on its first worker.
+// The worker threads are never joined; they stay blocked on their queues after the test.
+template<typename F>
+void runOnPool(helix::DispatcherPool::Options options, F f) {
+	std::atomic<bool> finished{false};
+	std::thread{[&] {
+		helix::DispatcherPool pool{options};
+		pool.start();
+		f(pool);
+		finished.store(true, std::memory_order_release);
+		finished.notify_one();
+
+		// Other workers may still reference our dispatcher, keep it alive.
+		while(true)
+			helix::Dispatcher::global().wait();
+	}}.detach();
+	finished.wait(false, std::memory_order_acquire);
+}
+
+struct DoneContext final : helix::Context {
+	void complete(helix::ElementHandle) override {
+		done = true;
+	}
+
+	bool pinned() override {
+		return true;
+	}
+
+	bool done = false;
+};
+
+struct BatchContext final : helix::Context {
+	void complete(helix::ElementHandle) override {
+		// Keep this worker busy such that other workers have a chance to steal.
+		auto start = std::chrono::steady_clock::now();
+		while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds{2})
+			;
+
+		if(std::this_thread::get_id() != owner)
+			stolen.fetch_add(1, std::memory_order_relaxed);
+
+		if(remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			HEL_CHECK(helSubmitAsyncNop(ownerDispatcher->acquire(),
+					reinterpret_cast<uintptr_t>(static_cast<helix::Context *>(doneContext))));
+	}
+
+	bool pinned() override {
+		return pin;
+	}
+
+	bool pin = false;
+	std::thread::id owner;
+	helix::Dispatcher *ownerDispatcher = nullptr;
+	DoneContext *doneContext = nullptr;
+	std::atomic<int> remaining{0};
+	std::atomic<int> stolen{0};
+};
+
+// Submits n completions to the queue of the calling worker and runs until all of them
+// completed. Returns the number of completions that ran on other workers.
+int runBatch(bool pin, int n) {
+	DoneContext done;
+	BatchContext batch;
+	batch.pin = pin;
+	batch.owner = std::this_thread::get_id();
+	batch.ownerDispatcher = &helix::Dispatcher::global();
+	batch.doneContext = &done;
+	batch.remaining.store(n, std::memory_order_relaxed);
+
+	for(int i = 0; i < n; i++)
+		HEL_CHECK(helSubmitAsyncNop(helix::Dispatcher::global().acquire(),
+				reinterpret_cast<uintptr_t>(static_cast<helix::Context *>(&batch))));
+
+	while(!done.done)
+		helix::Dispatcher::global().wait();
+	return batch.stolen.load(std::memory_order_relaxed);
+}
+
+async::result<void> hopBetweenWorkers(helix::DispatcherPool &pool) {
+	auto firstThread = std::this_thread::get_id();
+
+	co_await helix::scheduleOn(pool.worker(1));
+	assert(&helix::Dispatcher::global() == &pool.worker(1));
+	assert(std::this_thread::get_id() != firstThread);
+
+	co_await helix::scheduleOn(pool.worker(0));
+	assert(&helix::Dispatcher::global() == &pool.worker(0));
+	assert(std::this_thread::get_id() == firstThread);
+
+	// Scheduling on the current worker completes inline.
+	co_await helix::scheduleOn(pool.worker(0));
+	assert(std::this_thread::get_id() == firstThread);
+}
+
+} // anonymous namespace
+
+DEFINE_TEST(pool_no_stealing_by_default, ([] {
+	runOnPool({.numWorkers = 2}, [] (helix::DispatcherPool &) {
+		assert(!runBatch(false, 32));
+	});
+}))
+
+DEFINE_TEST(pool_stealing, ([] {
+	runOnPool({.numWorkers = 2, .stealing = true}, [] (helix::DispatcherPool &) {
+		assert(runBatch(false, 32) > 0);
+	});
+}))
+
+DEFINE_TEST(pool_pinned_not_stolen, ([] {
+	runOnPool({.numWorkers = 2, .stealing = true}, [] (helix::DispatcherPool &) {
+		assert(!runBatch(true, 32));
+	});
+}))
+
+DEFINE_TEST(pool_schedule_on, ([] {
+	runOnPool({.numWorkers = 2}, [] (helix::DispatcherPool &pool) {
+		async::run(hopBetweenWorkers(pool), helix::currentDispatcher);
+	});
+}))
+
+DEFINE_TEST(pool_schedule_on_with_stealing, ([] {
+	runOnPool({.numWorkers = 2, .stealing = true}, [] (helix::DispatcherPool &pool) {
+		async::run(hopBetweenWorkers(pool), helix::currentDispatcher);
+	});
+}))
@@ -4,6 +4,8 @@
 #include <async/algorithm.hpp>
 #include <helix/ipc.hpp>
 
+#include <atomic>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -247,6 +249,55 @@ async::result<void> doSendRecvBufferBenchmark(size_t size) {
 	bench.finalizeStatistics();
 }
 
+// Each thread submits on its own lane and queue, all threads share one universe.
+async::result<uint64_t> doSubmitAsyncLoop() {
+	auto [lane1, lane2] = helix::createStream();
+	std::byte sBuf[1]{};
+	std::byte rBuf[1];
+
+	IterationsPerSecondBenchmark timer;
+	uint64_t n = 0;
+	timer.launchRepetition();
+	while(!timer.isRepetitionDone()) {
+		for(int i = 0; i < 100; ++i) {
+			co_await async::when_all(
+				async::transform(
+					helix_ng::exchangeMsgs(lane1, helix_ng::sendBuffer(sBuf, 1)
+				), [&] (auto result) {
+					auto [send] = std::move(result);
+					HEL_CHECK(send.error());
+				}),
+				async::transform(
+					helix_ng::exchangeMsgs(lane2, helix_ng::recvBuffer(rBuf, 1)
+				), [&] (auto result) {
+					auto [recv] = std::move(result);
+					HEL_CHECK(recv.error());
+				})
+			);
+			n += 2;
+		}
+	}
+	co_return n;
+}
+
+void doSubmitAsyncBenchmark(int numThreads) {
+	std::cout << "helSubmitAsync ops, threads = " << numThreads << std::endl;
+
+	IterationsPerSecondBenchmark bench;
+	for(int k = 0; k < 5; ++k) {
+		std::atomic<uint64_t> n{0};
+		std::vector<std::thread> threads;
+		for(int t = 0; t < numThreads; ++t)
+			threads.emplace_back([&] {
+				n += async::run(doSubmitAsyncLoop(), helix::currentDispatcher);
+			});
+		for(auto &thread : threads)
+			thread.join();
+		bench.announceIterations(n.load());
+	}
+	bench.finalizeStatistics();
+}
+
 } // anonymous namespace
 
 int main() {
@@ -264,4 +315,7 @@ int main() {
 	async::run(doSendRecvBufferBenchmark(16 * 1024), helix::currentDispatcher);
 	async::run(doSendRecvBufferBenchmark(64 * 1024), helix::currentDispatcher);
 	async::run(doSendRecvBufferBenchmark(1024 * 1024), helix::currentDispatcher);
+	doSubmitAsyncBenchmark(1);
+	doSubmitAsyncBenchmark(2);
+	doSubmitAsyncBenchmark(4);
 }
@@ -0,0 +1,58 @@
+#include <cassert>
+
+#include "retransmit.hpp"
+#include "testsuite.hpp"
+
+DEFINE_TEST(rtoInitial, ([] {
+	RtoEstimator rtt;
+	assert(rtt.rto() == initialRto);
+	assert(!rtt.srtt());
+}))
+
+DEFINE_TEST(rtoFirstSample, ([] {
+	// RFC 6298 2.2: SRTT = R, RTTVAR = R / 2, RTO = SRTT + 4 * RTTVAR.
+	RtoEstimator rtt;
+	rtt.sample(100'000'000);
+	assert(rtt.srtt() == 100'000'000);
+	assert(rtt.rto() == 300'000'000);
+}))
+
+DEFINE_TEST(rtoSubsequentSamples, ([] {
+	// RFC 6298 2.3 with alpha = 1/8 and beta = 1/4.
+	RtoEstimator rtt;
+	rtt.sample(100'000'000);
+	rtt.sample(200'000'000);
+	// RTTVAR = 3/4 * 50ms + 1/4 * 100ms, SRTT = 7/8 * 100ms + 1/8 * 200ms.
+	assert(rtt.srtt() == 112'500'000);
+	assert(rtt.rto() == 112'500'000 + 4 * 62'500'000);
+}))
+
+DEFINE_TEST(rtoBounds, ([] {
+	RtoEstimator rtt;
+	for(int i = 0; i < 32; i++)
+		rtt.sample(1'000);
+	assert(rtt.rto() == minRto);
+
+	rtt.sample(100'000'000'000);
+	assert(rtt.rto() == maxRto);
+}))
+
+DEFINE_TEST(rtoBackoff, ([] {
+	// RFC 6298 5.5: the timer doubles on each expiry, up to the upper bound.
+	RtoEstimator rtt;
+	rtt.backoff();
+	assert(rtt.rto() == 2 * initialRto);
+	rtt.backoff();
+	assert(rtt.rto() == 4 * initialRto);
+	for(int i = 0; i < 16; i++)
+		rtt.backoff();
+	assert(rtt.rto() == maxRto);
+
+	// A new measurement replaces the backed-off value.
+	rtt.sample(100'000'000);
+	assert(rtt.rto() == 300'000'000);
+
+	rtt.reset();
+	assert(rtt.rto() == initialRto);
+	assert(!rtt.srtt());
+}))
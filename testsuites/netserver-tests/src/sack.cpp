@@ -0,0 +1,80 @@
+#include <cassert>
+
+#include "retransmit.hpp"
+#include "testsuite.hpp"
+
+DEFINE_TEST(sackMergeBlocks, ([] {
+	SackScoreboard sacked;
+	sacked.add({300, 400}, 100, 1000);
+	sacked.add({600, 700}, 100, 1000);
+	assert(sacked.blocks().size() == 2);
+
+	// Adjacent to the first block, overlapping the second one.
+	sacked.add({400, 650}, 100, 1000);
+	assert(sacked.blocks().size() == 1);
+	assert(sacked.blocks()[0].begin == 300);
+	assert(sacked.blocks()[0].end == 700);
+	assert(sacked.sackedBytes() == 400);
+}))
+
+DEFINE_TEST(sackIgnoreInvalidBlocks, ([] {
+	SackScoreboard sacked;
+	// Empty, entirely acknowledged and beyond what was sent.
+	sacked.add({500, 500}, 100, 1000);
+	sacked.add({0, 100}, 100, 1000);
+	sacked.add({900, 1100}, 100, 1000);
+	assert(sacked.blocks().empty());
+
+	// Partially acknowledged blocks are clipped.
+	sacked.add({50, 200}, 100, 1000);
+	assert(sacked.blocks().size() == 1);
+	assert(sacked.blocks()[0].begin == 100);
+	assert(sacked.blocks()[0].end == 200);
+}))
+
+DEFINE_TEST(sackAdvance, ([] {
+	SackScoreboard sacked;
+	sacked.add({200, 300}, 100, 1000);
+	sacked.add({500, 600}, 100, 1000);
+
+	sacked.advance(250);
+	assert(sacked.blocks().size() == 2);
+	assert(sacked.blocks()[0].begin == 250);
+
+	sacked.advance(600);
+	assert(sacked.blocks().empty());
+}))
+
+DEFINE_TEST(sackFirstHole, ([] {
+	SackScoreboard sacked;
+	auto hole = sacked.firstHole(100, 1000);
+	assert(hole.begin == 100 && hole.end == 1000);
+
+	sacked.add({300, 400}, 100, 1000);
+	sacked.add({600, 700}, 100, 1000);
+	hole = sacked.firstHole(100, 1000);
+	assert(hole.begin == 100 && hole.end == 300);
+
+	// Once the first hole is acknowledged, the next one follows the first block.
+	sacked.advance(300);
+	hole = sacked.firstHole(300, 1000);
+	assert(hole.begin == 400 && hole.end == 600);
+
+	// Everything up to the highest SN was SACKed.
+	sacked.add({400, 1000}, 300, 1000);
+	hole = sacked.firstHole(300, 1000);
+	assert(hole.begin == hole.end);
+}))
+
+DEFINE_TEST(sackWraparound, ([] {
+	SackScoreboard sacked;
+	uint32_t settled = 0xFFFF'FF00;
+	uint32_t highest = 0x100;
+	sacked.add({0xFFFF'FF80, 0x10}, settled, highest);
+	sacked.add({0x10, 0x40}, settled, highest);
+	assert(sacked.blocks().size() == 1);
+	assert(sacked.sackedBytes() == 0xC0);
+
+	auto hole = sacked.firstHole(settled, highest);
+	assert(hole.begin == settled && hole.end == 0xFFFF'FF80);
+}))
@@ -4,6 +4,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <iostream>
+#include <map>
+#include <queue>
+#include <vector>
 
 #include <bragi/helpers-std.hpp>
 #include <CLI/App.hpp>
@@ -24,6 +27,12 @@ std::unordered_map<std::string, ExtractMode> stringToExtractMode{
 	{"specific-item", ExtractMode::specificItem},
 };
 
+struct Event {
+	uint64_t ts;
+	uint64_t id;
+	std::vector<std::pair<uint64_t, int64_t>> ctrs;
+};
+
 int main(int argc, char **argv) {
 	ExtractMode mode{};
 	std::string path{"virtio-trace.bin"};
@@ -67,6 +76,11 @@ int main(int argc, char **argv) {
 	std::vector<uint64_t> ts;
 	std::vector<uint64_t> value;
 
+	// Events of each source (i.e., the kernel and each per-process ring) are ordered
+	// by timestamp but the kernel drains the per-process rings asynchronously,
+	// hence the streams are interleaved arbitrarily in the file.
+	std::map<uint64_t, std::vector<Event>> streams;
+
 	auto extractRecord = [&] () -> bool {
 		auto preamble = bragi::read_preamble(buffer);
 		if(preamble.error()) {
@@ -88,18 +102,10 @@ int main(int argc, char **argv) {
 			}
 			auto &record = maybeRecord.value();
 
-			if(record.id() == filteredEventId) {
-				if(mode == ExtractMode::eventOnly) {
-					ts.push_back(record.ts());
-				}else if(mode == ExtractMode::specificItem) {
-					for(size_t i = 0; i < record.ctrs_size(); ++i) {
-						if(record.ctrs(i).id() != desiredItemId)
-							continue;
-						ts.push_back(record.ts());
-						value.push_back(record.ctrs(i).value());
-					}
-				}
-			}
+			Event event{record.ts(), record.id(), {}};
+			for(size_t i = 0; i < record.ctrs_size(); ++i)
+				event.ctrs.push_back({record.ctrs(i).id(), record.ctrs(i).value()});
+			streams[record.source()].push_back(std::move(event));
 		} break;
 		case bragi::message_id<managarm::ostrace::AnnounceEventRecord>: {
 			auto maybeRecord = bragi::parse_head_tail<managarm::ostrace::AnnounceEventRecord>(
@@ -135,6 +141,38 @@ int main(int argc, char **argv) {
 		++nRecords;
 	}
 
+	// Merge the streams by timestamp.
+	using Cursor = std::pair<std::vector<Event> *, size_t>;
+	auto laterCursor = [] (const Cursor &a, const Cursor &b) {
+		return (*a.first)[a.second].ts > (*b.first)[b.second].ts;
+	};
+	std::priority_queue<Cursor, std::vector<Cursor>, decltype(laterCursor)> cursors{laterCursor};
+	for(auto &[source, stream] : streams) {
+		if(!stream.empty())
+			cursors.push({&stream, 0});
+	}
+
+	while(!cursors.empty()) {
+		auto [stream, index] = cursors.top();
+		cursors.pop();
+		if(index + 1 < stream->size())
+			cursors.push({stream, index + 1});
+
+		auto &event = (*stream)[index];
+		if(event.id != filteredEventId)
+			continue;
+		if(mode == ExtractMode::eventOnly) {
+			ts.push_back(event.ts);
+		}else if(mode == ExtractMode::specificItem) {
+			for(auto &[id, ctrValue] : event.ctrs) {
+				if(id != desiredItemId)
+					continue;
+				ts.push_back(event.ts);
+				value.push_back(ctrValue);
+			}
+		}
+	}
+
 	std::cout << "{\n";
 	std::cout << "\"ts\": [";
 	for(size_t i = 0; i < ts.size(); ++i)
@@ -151,5 +189,6 @@ int main(int argc, char **argv) {
 
 	std::cerr << "extracted " << nRecords << " records"
 			<< " (" << buffer.size() << " bytes remain)" << std::endl;
+	std::cerr << "merged events from " << streams.size() << " sources" << std::endl;
 	std::cerr << "found " << ts.size() << " matches" << std::endl;
 }